@@ -2,6 +2,9 @@
 #include "graphics/graphics.h"
 #include "graphics/mesh.h"
 #include "graphics/model.h"
+#include "graphics/particleSystem.h"
+#include "graphics/spriteBatch.h"
+#include "graphics/textureArray.h"
 #include "loaders/font.h"
 #include "loaders/model.h"
 #include "loaders/texture.h"
@@ -14,15 +17,30 @@ map_int_t CompareModes;
 map_int_t DrawModes;
 map_int_t FilterModes;
 map_int_t HorizontalAligns;
+map_int_t MaterialColors;
+map_int_t MaterialTextures;
 map_int_t MatrixTypes;
 map_int_t MeshAttributeTypes;
 map_int_t MeshDrawModes;
 map_int_t MeshUsages;
+map_int_t TextureFormats;
 map_int_t TextureProjections;
 map_int_t VerticalAligns;
 map_int_t Windings;
 map_int_t WrapModes;
 
+static const TextureFormat* textureFormats[] = {
+  &FORMAT_RGB, &FORMAT_RGBA, &FORMAT_R8, &FORMAT_RG8, &FORMAT_R16F, &FORMAT_RG16F, &FORMAT_RGBA16F, &FORMAT_RGBA32F
+};
+
+static const TextureFormat* luax_opttextureformat(lua_State* L, int index, const TextureFormat* fallback) {
+  if (lua_isnoneornil(L, index)) {
+    return fallback;
+  }
+
+  return textureFormats[*(int*) luax_checkenum(L, index, &TextureFormats, "texture format")];
+}
+
 static int luax_optmatrixtype(lua_State* L, int index, MatrixType* type) {
   if (lua_type(L, index) == LUA_TSTRING) {
     *type = *(MatrixType*) luax_checkenum(L, index++, &MatrixTypes, "matrix type");
@@ -63,10 +81,24 @@ static void luax_readvertices(lua_State* L, int index, vec_float_t* points) {
   }
 }
 
-static Texture* luax_readtexture(lua_State* L, int index) {
+static int luax_optflag(lua_State* L, int index, const char* key, int fallback) {
+  if (!lua_istable(L, index)) {
+    return fallback;
+  }
+
+  lua_getfield(L, index, key);
+  int flag = lua_isnil(L, -1) ? fallback : lua_toboolean(L, -1);
+  lua_pop(L, 1);
+  return flag;
+}
+
+static Texture* luax_readtexture(lua_State* L, int index, const TextureFormat* format, int stream, int keepData) {
   Blob* blob = luax_readblob(L, index, "Texture");
-  TextureData* textureData = lovrTextureDataFromBlob(blob);
-  Texture* texture = lovrTextureCreate(textureData);
+  TextureData* textureData = lovrTextureDataFromBlob(blob, format);
+  Texture* texture = lovrTextureCreate(textureData, stream);
+  if (!keepData) {
+    lovrTextureReleaseData(texture);
+  }
   lovrRelease(&blob->ref);
   return texture;
 }
@@ -76,12 +108,17 @@ static Texture* luax_readtexture(lua_State* L, int index) {
 int l_lovrGraphicsInit(lua_State* L) {
   lua_newtable(L);
   luaL_register(L, NULL, lovrGraphics);
+  luax_registertype(L, "DrawList", lovrDrawList);
   luax_registertype(L, "Font", lovrFont);
+  luax_registertype(L, "Material", lovrMaterial);
   luax_registertype(L, "Mesh", lovrMesh);
   luax_registertype(L, "Model", lovrModel);
+  luax_registertype(L, "ParticleSystem", lovrParticleSystem);
   luax_registertype(L, "Shader", lovrShader);
   luax_registertype(L, "Skybox", lovrSkybox);
+  luax_registertype(L, "SpriteBatch", lovrSpriteBatch);
   luax_registertype(L, "Texture", lovrTexture);
+  luax_registertype(L, "TextureArray", lovrTextureArray);
 
   map_init(&BlendAlphaModes);
   map_set(&BlendAlphaModes, "alphamultiply", BLEND_ALPHA_MULTIPLY);
@@ -120,14 +157,27 @@ int l_lovrGraphicsInit(lua_State* L) {
   map_set(&HorizontalAligns, "right", ALIGN_RIGHT);
   map_set(&HorizontalAligns, "center", ALIGN_CENTER);
 
+  map_init(&MaterialColors);
+  map_set(&MaterialColors, "diffuse", COLOR_DIFFUSE);
+  map_set(&MaterialColors, "emissive", COLOR_EMISSIVE);
+
+  map_init(&MaterialTextures);
+  map_set(&MaterialTextures, "diffuse", TEXTURE_DIFFUSE);
+  map_set(&MaterialTextures, "emissive", TEXTURE_EMISSIVE);
+
   map_init(&MatrixTypes);
   map_set(&MatrixTypes, "model", MATRIX_MODEL);
   map_set(&MatrixTypes, "view", MATRIX_VIEW);
 
   map_init(&MeshAttributeTypes);
   map_set(&MeshAttributeTypes, "float", MESH_FLOAT);
+  map_set(&MeshAttributeTypes, "half", MESH_HALF);
   map_set(&MeshAttributeTypes, "byte", MESH_BYTE);
+  map_set(&MeshAttributeTypes, "ubyte", MESH_UBYTE);
+  map_set(&MeshAttributeTypes, "short", MESH_SHORT);
+  map_set(&MeshAttributeTypes, "ushort", MESH_USHORT);
   map_set(&MeshAttributeTypes, "int", MESH_INT);
+  map_set(&MeshAttributeTypes, "packed", MESH_PACKED);
 
   map_init(&MeshDrawModes);
   map_set(&MeshDrawModes, "points", MESH_POINTS);
@@ -140,6 +190,16 @@ int l_lovrGraphicsInit(lua_State* L) {
   map_set(&MeshUsages, "dynamic", MESH_DYNAMIC);
   map_set(&MeshUsages, "stream", MESH_STREAM);
 
+  map_init(&TextureFormats);
+  map_set(&TextureFormats, "rgb", 0);
+  map_set(&TextureFormats, "rgba", 1);
+  map_set(&TextureFormats, "r8", 2);
+  map_set(&TextureFormats, "rg8", 3);
+  map_set(&TextureFormats, "r16f", 4);
+  map_set(&TextureFormats, "rg16f", 5);
+  map_set(&TextureFormats, "rgba16f", 6);
+  map_set(&TextureFormats, "rgba32f", 7);
+
   map_init(&TextureProjections);
   map_set(&TextureProjections, "2d", PROJECTION_ORTHOGRAPHIC);
   map_set(&TextureProjections, "3d", PROJECTION_PERSPECTIVE);
@@ -179,6 +239,11 @@ int l_lovrGraphicsPresent(lua_State* L) {
   return 0;
 }
 
+int l_lovrGraphicsFlush(lua_State* L) {
+  lovrGraphicsFlush();
+  return 0;
+}
+
 int l_lovrGraphicsCreateWindow(lua_State* L) {
   int width = luaL_optnumber(L, 1, 800);
   int height = luaL_optnumber(L, 2, 600);
@@ -368,6 +433,16 @@ int l_lovrGraphicsSetPointSize(lua_State* L) {
   return 0;
 }
 
+int l_lovrGraphicsIsQueueEnabled(lua_State* L) {
+  lua_pushboolean(L, lovrGraphicsIsQueueEnabled());
+  return 1;
+}
+
+int l_lovrGraphicsSetQueueEnabled(lua_State* L) {
+  lovrGraphicsSetQueueEnabled(lua_toboolean(L, 1));
+  return 0;
+}
+
 int l_lovrGraphicsGetShader(lua_State* L) {
   Shader* shader = lovrGraphicsGetShader();
   luax_pushtype(L, Shader, shader);
@@ -380,6 +455,28 @@ int l_lovrGraphicsSetShader(lua_State* L) {
   return 0;
 }
 
+int l_lovrGraphicsGetKeepData(lua_State* L) {
+  lua_pushboolean(L, lovrGraphicsGetKeepData());
+  return 1;
+}
+
+int l_lovrGraphicsSetKeepData(lua_State* L) {
+  lovrGraphicsSetKeepData(lua_toboolean(L, 1));
+  return 0;
+}
+
+int l_lovrGraphicsGetTextureStreamBudget(lua_State* L) {
+  lua_pushinteger(L, lovrGraphicsGetTextureStreamBudget());
+  return 1;
+}
+
+int l_lovrGraphicsSetTextureStreamBudget(lua_State* L) {
+  int budget = luaL_checkinteger(L, 1);
+  luaL_argcheck(L, budget >= 0, 1, "Texture stream budget must be non-negative");
+  lovrGraphicsSetTextureStreamBudget(budget);
+  return 0;
+}
+
 int l_lovrGraphicsGetWinding(lua_State* L) {
   luax_pushenum(L, &Windings, lovrGraphicsGetWinding());
   return 1;
@@ -575,6 +672,13 @@ int l_lovrGraphicsPrint(lua_State* L) {
 
 // Types
 
+int l_lovrGraphicsNewDrawList(lua_State* L) {
+  DrawList* drawList = lovrDrawListCreate();
+  luax_pushtype(L, DrawList, drawList);
+  lovrRelease(&drawList->ref);
+  return 1;
+}
+
 int l_lovrGraphicsNewFont(lua_State* L) {
   Blob* blob = NULL;
   float size;
@@ -598,6 +702,13 @@ int l_lovrGraphicsNewFont(lua_State* L) {
   return 1;
 }
 
+int l_lovrGraphicsNewMaterial(lua_State* L) {
+  Material* material = lovrMaterialCreate();
+  luax_pushtype(L, Material, material);
+  lovrRelease(&material->ref);
+  return 1;
+}
+
 int l_lovrGraphicsNewMesh(lua_State* L) {
   int size;
   int dataIndex = 0;
@@ -629,12 +740,14 @@ int l_lovrGraphicsNewMesh(lua_State* L) {
 
   MeshDrawMode* drawMode = (MeshDrawMode*) luax_optenum(L, drawModeIndex, "fan", &MeshDrawModes, "mesh draw mode");
   MeshUsage* usage = (MeshUsage*) luax_optenum(L, drawModeIndex + 1, "dynamic", &MeshUsages, "mesh usage");
-  Mesh* mesh = lovrMeshCreate(size, format.length ? &format : NULL, *drawMode, *usage);
+  int keepData = luax_optflag(L, drawModeIndex + 2, "keepData", lovrGraphicsGetKeepData());
+  Mesh* mesh = lovrMeshCreate(size, format.length ? &format : NULL, *drawMode, *usage, keepData);
 
   if (dataIndex) {
     int count = lua_objlen(L, dataIndex);
     MeshFormat format = lovrMeshGetVertexFormat(mesh);
     char* vertex = lovrMeshMap(mesh, 0, count, 0, 1);
+    int stride = lovrMeshGetVertexSize(mesh);
 
     for (int i = 0; i < count; i++) {
       lua_rawgeti(L, dataIndex, i + 1);
@@ -642,21 +755,8 @@ int l_lovrGraphicsNewMesh(lua_State* L) {
         return luaL_error(L, "Vertex information should be specified as a table");
       }
 
-      int component = 0;
-      for (int j = 0; j < format.length; j++) {
-        MeshAttribute attribute = format.data[j];
-        for (int k = 0; k < attribute.count; k++) {
-          lua_rawgeti(L, -1, ++component);
-          switch (attribute.type) {
-            case MESH_FLOAT: *((float*) vertex) = luaL_optnumber(L, -1, 0.f); break;
-            case MESH_BYTE: *((unsigned char*) vertex) = luaL_optint(L, -1, 255); break;
-            case MESH_INT: *((int*) vertex) = luaL_optint(L, -1, 0); break;
-          }
-          vertex += sizeof(attribute.type);
-          lua_pop(L, 1);
-        }
-      }
-
+      luax_setvertex(L, -1, vertex, &format);
+      vertex += stride;
       lua_pop(L, 1);
     }
   }
@@ -671,19 +771,38 @@ int l_lovrGraphicsNewModel(lua_State* L) {
   Blob* blob = luax_readblob(L, 1, "Model");
   ModelData* modelData = lovrModelDataCreate(blob);
   Model* model = lovrModelCreate(modelData);
+  int keepData = luax_optflag(L, lua_istable(L, 2) ? 2 : 3, "keepData", lovrGraphicsGetKeepData());
 
-  if (lua_gettop(L) >= 2) {
-    Texture* texture = luax_readtexture(L, 2);
+  if (!lua_isnoneornil(L, 2) && !lua_istable(L, 2)) {
+    Texture* texture = luax_readtexture(L, 2, NULL, 0, keepData);
     lovrModelSetTexture(model, texture);
     lovrRelease(&texture->ref);
   }
 
+  if (!keepData) {
+    lovrModelReleaseData(model);
+  }
+
   luax_pushtype(L, Model, model);
   lovrRelease(&model->ref);
   lovrRelease(&blob->ref);
   return 1;
 }
 
+int l_lovrGraphicsNewParticleSystem(lua_State* L) {
+  int capacity = luaL_optinteger(L, 1, 10000);
+  ParticleSystem* particleSystem = lovrParticleSystemCreate(capacity);
+
+  if (!lua_isnoneornil(L, 2)) {
+    Texture* texture = luax_checktype(L, 2, Texture);
+    lovrParticleSystemSetTexture(particleSystem, texture);
+  }
+
+  luax_pushtype(L, ParticleSystem, particleSystem);
+  lovrRelease(&particleSystem->ref);
+  return 1;
+}
+
 int l_lovrGraphicsNewShader(lua_State* L) {
   for (int i = 0; i < 2; i++) {
     if (lua_isnoneornil(L, i + 1)) continue;
@@ -752,6 +871,20 @@ int l_lovrGraphicsNewSkybox(lua_State* L) {
   return 1;
 }
 
+int l_lovrGraphicsNewSpriteBatch(lua_State* L) {
+  int capacity = luaL_optinteger(L, 1, 1000);
+  SpriteBatch* spriteBatch = lovrSpriteBatchCreate(capacity);
+
+  if (!lua_isnoneornil(L, 2)) {
+    Texture* texture = luax_checktype(L, 2, Texture);
+    lovrSpriteBatchSetTexture(spriteBatch, texture);
+  }
+
+  luax_pushtype(L, SpriteBatch, spriteBatch);
+  lovrRelease(&spriteBatch->ref);
+  return 1;
+}
+
 int l_lovrGraphicsNewTexture(lua_State* L) {
   Texture* texture;
 
@@ -760,10 +893,20 @@ int l_lovrGraphicsNewTexture(lua_State* L) {
     int height = luaL_checknumber(L, 2);
     TextureProjection* projection = luax_optenum(L, 3, "3d", &TextureProjections, "projection");
     int msaa = luaL_optnumber(L, 4, 0);
-    TextureData* textureData = lovrTextureDataGetEmpty(width, height, FORMAT_RGBA);
+    const TextureFormat* format = luax_opttextureformat(L, 5, &FORMAT_RGBA);
+    TextureData* textureData = lovrTextureDataGetEmpty(width, height, *format);
     texture = lovrTextureCreateWithFramebuffer(textureData, *projection, msaa);
   } else {
-    texture = luax_readtexture(L, 1);
+    const TextureFormat* format = NULL;
+    if (lua_istable(L, 2)) {
+      lua_getfield(L, 2, "format");
+      format = luax_opttextureformat(L, -1, NULL);
+      lua_pop(L, 1);
+    }
+
+    int stream = luax_optflag(L, 2, "stream", 0);
+    int keepData = luax_optflag(L, 2, "keepData", lovrGraphicsGetKeepData());
+    texture = luax_readtexture(L, 1, format, stream, keepData);
   }
 
   luax_pushtype(L, Texture, texture);
@@ -771,10 +914,22 @@ int l_lovrGraphicsNewTexture(lua_State* L) {
   return 1;
 }
 
+int l_lovrGraphicsNewTextureArray(lua_State* L) {
+  int width = luaL_checkinteger(L, 1);
+  int height = luaL_checkinteger(L, 2);
+  const TextureFormat* format = luax_opttextureformat(L, 3, &FORMAT_RGBA);
+  int capacity = luaL_optinteger(L, 4, DEFAULT_TEXTURE_ARRAY_CAPACITY);
+  TextureArray* textureArray = lovrTextureArrayCreate(width, height, capacity, *format, format->glType != GL_FLOAT);
+  luax_pushtype(L, TextureArray, textureArray);
+  lovrRelease(&textureArray->ref);
+  return 1;
+}
+
 const luaL_Reg lovrGraphics[] = {
   { "reset", l_lovrGraphicsReset },
   { "clear", l_lovrGraphicsClear },
   { "present", l_lovrGraphicsPresent },
+  { "flush", l_lovrGraphicsFlush },
   { "createWindow", l_lovrGraphicsCreateWindow },
   { "getWidth", l_lovrGraphicsGetWidth },
   { "getHeight", l_lovrGraphicsGetHeight },
@@ -798,8 +953,14 @@ const luaL_Reg lovrGraphics[] = {
   { "setLineWidth", l_lovrGraphicsSetLineWidth },
   { "getPointSize", l_lovrGraphicsGetPointSize },
   { "setPointSize", l_lovrGraphicsSetPointSize },
+  { "isQueueEnabled", l_lovrGraphicsIsQueueEnabled },
+  { "setQueueEnabled", l_lovrGraphicsSetQueueEnabled },
   { "getShader", l_lovrGraphicsGetShader },
   { "setShader", l_lovrGraphicsSetShader },
+  { "getKeepData", l_lovrGraphicsGetKeepData },
+  { "setKeepData", l_lovrGraphicsSetKeepData },
+  { "getTextureStreamBudget", l_lovrGraphicsGetTextureStreamBudget },
+  { "setTextureStreamBudget", l_lovrGraphicsSetTextureStreamBudget },
   { "getWinding", l_lovrGraphicsGetWinding },
   { "setWinding", l_lovrGraphicsSetWinding },
   { "isWireframe", l_lovrGraphicsIsWireframe },
@@ -820,11 +981,16 @@ const luaL_Reg lovrGraphics[] = {
   { "cylinder", l_lovrGraphicsCylinder },
   { "sphere", l_lovrGraphicsSphere },
   { "print", l_lovrGraphicsPrint },
+  { "newDrawList", l_lovrGraphicsNewDrawList },
   { "newFont", l_lovrGraphicsNewFont },
+  { "newMaterial", l_lovrGraphicsNewMaterial },
   { "newMesh", l_lovrGraphicsNewMesh },
   { "newModel", l_lovrGraphicsNewModel },
+  { "newParticleSystem", l_lovrGraphicsNewParticleSystem },
   { "newShader", l_lovrGraphicsNewShader },
   { "newSkybox", l_lovrGraphicsNewSkybox },
+  { "newSpriteBatch", l_lovrGraphicsNewSpriteBatch },
   { "newTexture", l_lovrGraphicsNewTexture },
+  { "newTextureArray", l_lovrGraphicsNewTextureArray },
   { NULL, NULL }
 };
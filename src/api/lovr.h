@@ -24,6 +24,7 @@ extern const luaL_Reg lovrCylinderShape[];
 extern const luaL_Reg lovrBlob[];
 extern const luaL_Reg lovrCollider[];
 extern const luaL_Reg lovrDistanceJoint[];
+extern const luaL_Reg lovrDrawList[];
 extern const luaL_Reg lovrEvent[];
 extern const luaL_Reg lovrFilesystem[];
 extern const luaL_Reg lovrFont[];
@@ -31,9 +32,11 @@ extern const luaL_Reg lovrGraphics[];
 extern const luaL_Reg lovrHeadset[];
 extern const luaL_Reg lovrHingeJoint[];
 extern const luaL_Reg lovrJoint[];
+extern const luaL_Reg lovrMaterial[];
 extern const luaL_Reg lovrMath[];
 extern const luaL_Reg lovrMesh[];
 extern const luaL_Reg lovrModel[];
+extern const luaL_Reg lovrParticleSystem[];
 extern const luaL_Reg lovrPhysics[];
 extern const luaL_Reg lovrRandomGenerator[];
 extern const luaL_Reg lovrShader[];
@@ -42,7 +45,9 @@ extern const luaL_Reg lovrSkybox[];
 extern const luaL_Reg lovrSliderJoint[];
 extern const luaL_Reg lovrSource[];
 extern const luaL_Reg lovrSphereShape[];
+extern const luaL_Reg lovrSpriteBatch[];
 extern const luaL_Reg lovrTexture[];
+extern const luaL_Reg lovrTextureArray[];
 extern const luaL_Reg lovrTimer[];
 extern const luaL_Reg lovrTransform[];
 extern const luaL_Reg lovrWorld[];
@@ -61,18 +66,24 @@ extern map_int_t HeadsetOrigins;
 extern map_int_t HeadsetTypes;
 extern map_int_t HorizontalAligns;
 extern map_int_t JointTypes;
+extern map_int_t MaterialColors;
+extern map_int_t MaterialTextures;
 extern map_int_t MatrixTypes;
 extern map_int_t MeshAttributeTypes;
 extern map_int_t MeshDrawModes;
 extern map_int_t MeshUsages;
 extern map_int_t PolygonWindings;
 extern map_int_t ShapeTypes;
+extern map_int_t TextureFormats;
 extern map_int_t TextureProjections;
 extern map_int_t TimeUnits;
 extern map_int_t VerticalAligns;
 extern map_int_t WrapModes;
 
 void luax_checkmeshformat(lua_State* L, int index, MeshFormat* format);
+int luax_pushvertexattribute(lua_State* L, char** vertex, MeshAttribute attribute);
+void luax_setvertexattribute(lua_State* L, int index, char** vertex, MeshAttribute attribute);
+void luax_setvertex(lua_State* L, int index, char* vertex, MeshFormat* format);
 int luax_readtransform(lua_State* L, int index, mat4 transform, int uniformScale);
 Blob* luax_readblob(lua_State* L, int index, const char* debug);
 int luax_pushshape(lua_State* L, Shape* shape);
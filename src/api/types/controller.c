@@ -2,6 +2,7 @@
 #include "headset/headset.h"
 #include "loaders/model.h"
 #include "loaders/texture.h"
+#include "graphics/graphics.h"
 #include "graphics/model.h"
 
 int l_lovrControllerIsPresent(lua_State* L) {
@@ -72,12 +73,19 @@ int l_lovrControllerNewModel(lua_State* L) {
   ModelData* modelData = lovrHeadsetControllerNewModelData(controller);
   TextureData* textureData = lovrHeadsetControllerNewTextureData(controller);
   if (modelData) {
+    int keepData = lovrGraphicsGetKeepData();
     Model* model = lovrModelCreate(modelData);
     if (textureData) {
-      Texture* texture = lovrTextureCreate(textureData);
+      Texture* texture = lovrTextureCreate(textureData, 0);
+      if (!keepData) {
+        lovrTextureReleaseData(texture);
+      }
       lovrModelSetTexture(model, texture);
       lovrRelease(&texture->ref);
     }
+    if (!keepData) {
+      lovrModelReleaseData(model);
+    }
     luax_pushtype(L, Model, model);
     lovrRelease(&model->ref);
   } else {
@@ -0,0 +1,45 @@
+#include "api/lovr.h"
+#include "graphics/graphics.h"
+#include "graphics/drawList.h"
+
+int l_lovrDrawListRecord(lua_State* L) {
+  DrawList* drawList = luax_checktype(L, 1, DrawList);
+  luaL_checktype(L, 2, LUA_TFUNCTION);
+  lua_settop(L, 2);
+  lovrGraphicsBeginDrawList(drawList);
+  int status = lua_pcall(L, 0, 0, 0);
+  lovrGraphicsEndDrawList();
+  if (status) {
+    return lua_error(L);
+  }
+  return 0;
+}
+
+int l_lovrDrawListDraw(lua_State* L) {
+  DrawList* drawList = luax_checktype(L, 1, DrawList);
+  float transform[16];
+  luax_readtransform(L, 2, transform, 1);
+  lovrDrawListDraw(drawList, transform);
+  return 0;
+}
+
+int l_lovrDrawListClear(lua_State* L) {
+  DrawList* drawList = luax_checktype(L, 1, DrawList);
+  lovrAssert(lovrGraphicsGetDrawList() != drawList, "Can not clear a DrawList while it is being recorded");
+  lovrDrawListClear(drawList);
+  return 0;
+}
+
+int l_lovrDrawListGetCommandCount(lua_State* L) {
+  DrawList* drawList = luax_checktype(L, 1, DrawList);
+  lua_pushinteger(L, lovrDrawListGetCommandCount(drawList));
+  return 1;
+}
+
+const luaL_Reg lovrDrawList[] = {
+  { "record", l_lovrDrawListRecord },
+  { "draw", l_lovrDrawListDraw },
+  { "clear", l_lovrDrawListClear },
+  { "getCommandCount", l_lovrDrawListGetCommandCount },
+  { NULL, NULL }
+};
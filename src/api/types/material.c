@@ -0,0 +1,90 @@
+#include "api/lovr.h"
+#include "graphics/material.h"
+
+int l_lovrMaterialGetColor(lua_State* L) {
+  Material* material = luax_checktype(L, 1, Material);
+  MaterialColor colorType = *(MaterialColor*) luax_optenum(L, 2, "diffuse", &MaterialColors, "material color");
+  Color color = lovrMaterialGetColor(material, colorType);
+  lua_pushinteger(L, color.r);
+  lua_pushinteger(L, color.g);
+  lua_pushinteger(L, color.b);
+  lua_pushinteger(L, color.a);
+  return 4;
+}
+
+int l_lovrMaterialSetColor(lua_State* L) {
+  Material* material = luax_checktype(L, 1, Material);
+  MaterialColor colorType = COLOR_DIFFUSE;
+  int index = 2;
+  if (lua_type(L, index) == LUA_TSTRING) {
+    colorType = *(MaterialColor*) luax_checkenum(L, index, &MaterialColors, "material color");
+    index++;
+  }
+
+  Color color = { 0xff, 0xff, 0xff, 0xff };
+  if (lua_istable(L, index)) {
+    for (int i = 1; i <= 4; i++) {
+      lua_rawgeti(L, index, i);
+    }
+    color.r = luaL_checknumber(L, -4);
+    color.g = luaL_checknumber(L, -3);
+    color.b = luaL_checknumber(L, -2);
+    color.a = luaL_optnumber(L, -1, 255);
+    lua_pop(L, 4);
+  } else if (lua_gettop(L) >= index + 2) {
+    color.r = lua_tointeger(L, index);
+    color.g = lua_tointeger(L, index + 1);
+    color.b = lua_tointeger(L, index + 2);
+    color.a = lua_isnoneornil(L, index + 3) ? 255 : lua_tointeger(L, index + 3);
+  } else {
+    return luaL_error(L, "Invalid color, expected 3 numbers, 4 numbers, or a table");
+  }
+
+  lovrMaterialSetColor(material, colorType, color);
+  return 0;
+}
+
+int l_lovrMaterialGetTexture(lua_State* L) {
+  Material* material = luax_checktype(L, 1, Material);
+  MaterialTexture textureType = *(MaterialTexture*) luax_optenum(L, 2, "diffuse", &MaterialTextures, "material texture");
+  Texture* texture = lovrMaterialGetTexture(material, textureType);
+  luax_pushtype(L, Texture, texture);
+  return 1;
+}
+
+int l_lovrMaterialSetTexture(lua_State* L) {
+  Material* material = luax_checktype(L, 1, Material);
+  MaterialTexture textureType = TEXTURE_DIFFUSE;
+  int index = 2;
+  if (lua_type(L, index) == LUA_TSTRING) {
+    textureType = *(MaterialTexture*) luax_checkenum(L, index, &MaterialTextures, "material texture");
+    index++;
+  }
+  Texture* texture = lua_isnoneornil(L, index) ? NULL : luax_checktype(L, index, Texture);
+  lovrMaterialSetTexture(material, textureType, texture);
+  return 0;
+}
+
+int l_lovrMaterialGetShader(lua_State* L) {
+  Material* material = luax_checktype(L, 1, Material);
+  Shader* shader = lovrMaterialGetShader(material);
+  luax_pushtype(L, Shader, shader);
+  return 1;
+}
+
+int l_lovrMaterialSetShader(lua_State* L) {
+  Material* material = luax_checktype(L, 1, Material);
+  Shader* shader = lua_isnoneornil(L, 2) ? NULL : luax_checktype(L, 2, Shader);
+  lovrMaterialSetShader(material, shader);
+  return 0;
+}
+
+const luaL_Reg lovrMaterial[] = {
+  { "getColor", l_lovrMaterialGetColor },
+  { "setColor", l_lovrMaterialSetColor },
+  { "getTexture", l_lovrMaterialGetTexture },
+  { "setTexture", l_lovrMaterialSetTexture },
+  { "getShader", l_lovrMaterialGetShader },
+  { "setShader", l_lovrMaterialSetShader },
+  { NULL, NULL }
+};
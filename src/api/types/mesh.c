@@ -1,4 +1,7 @@
 #include "api/lovr.h"
+#include "filesystem/blob.h"
+#include <math.h>
+#include <string.h>
 
 void luax_checkmeshformat(lua_State* L, int index, MeshFormat* format) {
   if (!lua_istable(L, index)) {
@@ -9,21 +12,135 @@ void luax_checkmeshformat(lua_State* L, int index, MeshFormat* format) {
   for (int i = 0; i < length; i++) {
     lua_rawgeti(L, index, i + 1);
 
-    if (!lua_istable(L, -1) || lua_objlen(L, -1) != 3) {
-      luaL_error(L, "Expected vertex format specified as tables containing name, data type, and size");
+    if (!lua_istable(L, -1) || lua_objlen(L, -1) < 3 || lua_objlen(L, -1) > 4) {
+      luaL_error(L, "Expected vertex format specified as tables containing name, data type, size, and an optional normalized flag");
       return;
     }
 
     lua_rawgeti(L, -1, 1);
     lua_rawgeti(L, -2, 2);
     lua_rawgeti(L, -3, 3);
+    lua_rawgeti(L, -4, 4);
+
+    const char* name = lua_tostring(L, -4);
+    MeshAttributeType* type = (MeshAttributeType*) luax_checkenum(L, -3, &MeshAttributeTypes, "mesh attribute type");
+    int count = lua_tointeger(L, -2);
+    int normalized = lua_toboolean(L, -1);
+    if (count < 1 || count > 4 || (*type == MESH_PACKED && count != 4)) {
+      luaL_error(L, "Invalid size (%d) for mesh attribute '%s'", count, name);
+      return;
+    }
 
-    const char* name = lua_tostring(L, -3);
-    MeshAttributeType* type = (MeshAttributeType*) luax_checkenum(L, -2, &MeshAttributeTypes, "mesh attribute type");
-    int count = lua_tointeger(L, -1);
-    MeshAttribute attribute = { .name = name, .type = *type, .count = count };
+    MeshAttribute attribute = { .name = name, .type = *type, .count = count, .normalized = normalized };
     vec_push(format, attribute);
-    lua_pop(L, 4);
+    lua_pop(L, 5);
+  }
+}
+
+// Returns the largest value of an integer attribute type, which normalized attributes map to 1
+static double luax_getattributerange(MeshAttributeType type) {
+  switch (type) {
+    case MESH_BYTE: return INT8_MAX;
+    case MESH_UBYTE: return UINT8_MAX;
+    case MESH_SHORT: return INT16_MAX;
+    case MESH_USHORT: return UINT16_MAX;
+    case MESH_INT: return INT32_MAX;
+    default: return 1.;
+  }
+}
+
+// Pushes the components of an attribute and advances the vertex pointer past it
+int luax_pushvertexattribute(lua_State* L, char** vertex, MeshAttribute attribute) {
+  if (attribute.type == MESH_PACKED) {
+    float values[4];
+    lovrMeshUnpackInt1010102(*(uint32_t*) *vertex, values, attribute.normalized);
+    for (int i = 0; i < 4; i++) {
+      lua_pushnumber(L, values[i]);
+    }
+    *vertex += sizeof(uint32_t);
+    return 4;
+  }
+
+  for (int i = 0; i < attribute.count; i++) {
+    double value = 0;
+    switch (attribute.type) {
+      case MESH_FLOAT: value = *(float*) *vertex; *vertex += sizeof(float); break;
+      case MESH_HALF: value = lovrMeshUnpackHalf(*(uint16_t*) *vertex); *vertex += sizeof(uint16_t); break;
+      case MESH_BYTE: value = *(int8_t*) *vertex; *vertex += sizeof(int8_t); break;
+      case MESH_UBYTE: value = *(uint8_t*) *vertex; *vertex += sizeof(uint8_t); break;
+      case MESH_SHORT: value = *(int16_t*) *vertex; *vertex += sizeof(int16_t); break;
+      case MESH_USHORT: value = *(uint16_t*) *vertex; *vertex += sizeof(uint16_t); break;
+      case MESH_INT: value = *(int32_t*) *vertex; *vertex += sizeof(int32_t); break;
+      default: break;
+    }
+
+    if (attribute.normalized) {
+      value = MAX(value / luax_getattributerange(attribute.type), -1.);
+    }
+
+    lua_pushnumber(L, value);
+  }
+
+  return attribute.count;
+}
+
+// Reads the components of an attribute from consecutive stack slots starting at index, and
+// advances the vertex pointer past it.  Missing components are 0, or 1 for unsigned normalized
+// attributes so that colors default to white.
+void luax_setvertexattribute(lua_State* L, int index, char** vertex, MeshAttribute attribute) {
+  index = index > 0 ? index : lua_gettop(L) + index + 1;
+
+  if (attribute.type == MESH_PACKED) {
+    float values[4];
+    for (int i = 0; i < 4; i++) {
+      values[i] = luaL_optnumber(L, index + i, 0.);
+    }
+    *(uint32_t*) *vertex = lovrMeshPackInt1010102(values, attribute.normalized);
+    *vertex += sizeof(uint32_t);
+    return;
+  }
+
+  int isUnsigned = attribute.type == MESH_UBYTE || attribute.type == MESH_USHORT;
+  double fallback = attribute.normalized && isUnsigned ? 1. : 0.;
+  double range = luax_getattributerange(attribute.type);
+  double min = isUnsigned ? 0. : -range - 1.;
+  double normalizedMin = isUnsigned ? 0. : -1.;
+
+  for (int i = 0; i < attribute.count; i++) {
+    double value = luaL_optnumber(L, index + i, fallback);
+
+    if (attribute.type != MESH_FLOAT && attribute.type != MESH_HALF) {
+      if (attribute.normalized) {
+        value = MIN(MAX(value, normalizedMin), 1.) * range;
+      }
+      value = round(value);
+      value = MIN(MAX(value, min), range);
+    }
+
+    switch (attribute.type) {
+      case MESH_FLOAT: *(float*) *vertex = value; *vertex += sizeof(float); break;
+      case MESH_HALF: *(uint16_t*) *vertex = lovrMeshPackHalf(value); *vertex += sizeof(uint16_t); break;
+      case MESH_BYTE: *(int8_t*) *vertex = value; *vertex += sizeof(int8_t); break;
+      case MESH_UBYTE: *(uint8_t*) *vertex = value; *vertex += sizeof(uint8_t); break;
+      case MESH_SHORT: *(int16_t*) *vertex = value; *vertex += sizeof(int16_t); break;
+      case MESH_USHORT: *(uint16_t*) *vertex = value; *vertex += sizeof(uint16_t); break;
+      case MESH_INT: *(int32_t*) *vertex = value; *vertex += sizeof(int32_t); break;
+      default: break;
+    }
+  }
+}
+
+// Writes a vertex from the table at index, which contains the components of every attribute
+void luax_setvertex(lua_State* L, int index, char* vertex, MeshFormat* format) {
+  index = index > 0 ? index : lua_gettop(L) + index + 1;
+  int component = 0;
+  for (int i = 0; i < format->length; i++) {
+    MeshAttribute attribute = format->data[i];
+    for (int j = 0; j < attribute.count; j++) {
+      lua_rawgeti(L, index, ++component);
+    }
+    luax_setvertexattribute(L, -attribute.count, &vertex, attribute);
+    lua_pop(L, attribute.count);
   }
 }
 
@@ -55,6 +172,10 @@ int l_lovrMeshGetVertexFormat(lua_State* L) {
     lua_pushinteger(L, attribute.count);
     lua_rawseti(L, -2, 3);
 
+    // Normalized
+    lua_pushboolean(L, attribute.normalized);
+    lua_rawseti(L, -2, 4);
+
     lua_rawseti(L, -2, i + 1);
   }
   return 1;
@@ -79,6 +200,26 @@ int l_lovrMeshGetVertexCount(lua_State* L) {
   return 1;
 }
 
+// Points to the vertices kept in memory and stays valid as long as the Mesh is alive.  Writes
+// through it are uploaded before the next draw once Mesh:markDirty is called with their range.
+int l_lovrMeshGetPointer(lua_State* L) {
+  Mesh* mesh = luax_checktype(L, 1, Mesh);
+  lua_pushlightuserdata(L, lovrMeshGetPointer(mesh));
+  return 1;
+}
+
+int l_lovrMeshMarkDirty(lua_State* L) {
+  Mesh* mesh = luax_checktype(L, 1, Mesh);
+  int vertexCount = lovrMeshGetVertexCount(mesh);
+  int start = luaL_optinteger(L, 2, 1) - 1;
+  int count = luaL_optinteger(L, 3, vertexCount - start);
+  if (start < 0 || count < 0 || start + count > vertexCount) {
+    return luaL_error(L, "Invalid mesh vertex range: %d vertices starting at %d", count, start + 1);
+  }
+  lovrMeshMarkDirty(mesh, start, count);
+  return 0;
+}
+
 int l_lovrMeshGetVertex(lua_State* L) {
   Mesh* mesh = luax_checktype(L, 1, Mesh);
   int index = luaL_checkint(L, 2) - 1;
@@ -87,17 +228,7 @@ int l_lovrMeshGetVertex(lua_State* L) {
 
   int total = 0;
   for (int i = 0; i < format.length; i++) {
-    MeshAttribute attribute = format.data[i];
-    total += attribute.count;
-    for (int j = 0; j < attribute.count; j++) {
-      switch (attribute.type) {
-        case MESH_FLOAT: lua_pushnumber(L, *((float*) vertex)); break;
-        case MESH_BYTE: lua_pushnumber(L, *((unsigned char*) vertex)); break;
-        case MESH_INT: lua_pushnumber(L, *((int*) vertex)); break;
-      }
-
-      vertex += sizeof(attribute.type);
-    }
+    total += luax_pushvertexattribute(L, &vertex, format.data[i]);
   }
 
   return total;
@@ -125,15 +256,8 @@ int l_lovrMeshSetVertex(lua_State* L) {
 
   for (int i = 0; i < format.length; i++) {
     MeshAttribute attribute = format.data[i];
-    for (int j = 0; j < attribute.count; j++) {
-      switch (attribute.type) {
-        case MESH_FLOAT: *((float*) vertex) = luaL_optnumber(L, arg++, 0.f); break;
-        case MESH_BYTE: *((unsigned char*) vertex) = luaL_optint(L, arg++, 255); break;
-        case MESH_INT: *((int*) vertex) = luaL_optint(L, arg++, 0); break;
-      }
-
-      vertex += sizeof(attribute.type);
-    }
+    luax_setvertexattribute(L, arg, &vertex, attribute);
+    arg += attribute.count;
   }
 
   return 0;
@@ -153,24 +277,11 @@ int l_lovrMeshGetVertexAttribute(lua_State* L) {
 
   char* vertex = lovrMeshMap(mesh, vertexIndex, 1, 1, 0);
 
-  MeshAttribute attribute;
-  for (int i = 0; i <= attributeIndex; i++) {
-    attribute = format.data[i];
-    if (i == attributeIndex) {
-      for (int j = 0; j < attribute.count; j++) {
-        switch (attribute.type) {
-          case MESH_FLOAT: lua_pushnumber(L, *((float*) vertex)); break;
-          case MESH_BYTE: lua_pushinteger(L, *((unsigned char*) vertex)); break;
-          case MESH_INT: lua_pushinteger(L, *((int*) vertex)); break;
-        }
-        vertex += sizeof(attribute.type);
-      }
-    } else {
-      vertex += attribute.count * sizeof(attribute.type);
-    }
+  for (int i = 0; i < attributeIndex; i++) {
+    vertex += lovrMeshAttributeGetSize(format.data[i]);
   }
 
-  return attribute.count;
+  return luax_pushvertexattribute(L, &vertex, format.data[attributeIndex]);
 }
 
 int l_lovrMeshSetVertexAttribute(lua_State* L) {
@@ -187,57 +298,71 @@ int l_lovrMeshSetVertexAttribute(lua_State* L) {
 
   char* vertex = lovrMeshMap(mesh, vertexIndex, 1, 0, 1);
 
-  int arg = 4;
-  for (int i = 0; i <= attributeIndex; i++) {
-    MeshAttribute attribute = format.data[i];
-    if (i == attributeIndex) {
-      for (int j = 0; j < attribute.count; j++) {
-        switch (attribute.type) {
-          case MESH_FLOAT: *((float*) vertex) = luaL_optnumber(L, arg++, 0.f); break;
-          case MESH_BYTE: *((unsigned char*) vertex) = luaL_optint(L, arg++, 255); break;
-          case MESH_INT: *((int*) vertex) = luaL_optint(L, arg++, 0); break;
-        }
-        vertex += sizeof(attribute.type);
-      }
-    } else {
-      vertex += attribute.count * sizeof(attribute.type);
-    }
+  for (int i = 0; i < attributeIndex; i++) {
+    vertex += lovrMeshAttributeGetSize(format.data[i]);
   }
 
+  luax_setvertexattribute(L, 4, &vertex, format.data[attributeIndex]);
   return 0;
 }
 
+int l_lovrMeshGetVertices(lua_State* L) {
+  Mesh* mesh = luax_checktype(L, 1, Mesh);
+  int maxVertices = lovrMeshGetVertexCount(mesh);
+  int start = luaL_optinteger(L, 2, 1) - 1;
+  int count = luaL_optinteger(L, 3, maxVertices - start);
+
+  if (start < 0 || count < 0 || start + count > maxVertices) {
+    return luaL_error(L, "Invalid mesh vertex range (%d, %d)", start + 1, count);
+  }
+
+  size_t size = count * lovrMeshGetVertexSize(mesh);
+  void* data = malloc(size);
+  memcpy(data, lovrMeshMap(mesh, start, count, 1, 0), size);
+  Blob* blob = lovrBlobCreate(data, size, "Mesh vertices");
+  luax_pushtype(L, Blob, blob);
+  lovrRelease(&blob->ref);
+  return 1;
+}
+
 int l_lovrMeshSetVertices(lua_State* L) {
   Mesh* mesh = luax_checktype(L, 1, Mesh);
   MeshFormat format = lovrMeshGetVertexFormat(mesh);
-  luaL_checktype(L, 2, LUA_TTABLE);
-  int vertexCount = lua_objlen(L, 2);
   int start = luaL_optnumber(L, 3, 1) - 1;
   int maxVertices = lovrMeshGetVertexCount(mesh);
 
+  // Blobs are copied directly and must already be in the Mesh's vertex format
+  if (lua_type(L, 2) == LUA_TUSERDATA) {
+    Blob* blob = luax_checktype(L, 2, Blob);
+    int stride = lovrMeshGetVertexSize(mesh);
+
+    if (blob->size % stride != 0) {
+      return luaL_error(L, "Blob size (%d) is not a multiple of the vertex size (%d)", (int) blob->size, stride);
+    }
+
+    int vertexCount = blob->size / stride;
+    if (start < 0 || start + vertexCount > maxVertices) {
+      return luaL_error(L, "Mesh can only hold %d vertices", maxVertices);
+    }
+
+    memcpy(lovrMeshMap(mesh, start, vertexCount, 0, 1), blob->data, blob->size);
+    return 0;
+  }
+
+  luaL_checktype(L, 2, LUA_TTABLE);
+  int vertexCount = lua_objlen(L, 2);
+
   if (start + vertexCount > maxVertices) {
     return luaL_error(L, "Mesh can only hold %d vertices", maxVertices);
   }
 
-  void* vertices = lovrMeshMap(mesh, start, vertexCount, 0, 1);
-  char* vertex = vertices;
+  char* vertex = lovrMeshMap(mesh, start, vertexCount, 0, 1);
+  int stride = lovrMeshGetVertexSize(mesh);
 
   for (int i = 0; i < vertexCount; i++) {
     lua_rawgeti(L, 2, i + 1);
-    int component = 0;
-    for (int j = 0; j < format.length; j++) {
-      MeshAttribute attribute = format.data[j];
-      for (int k = 0; k < attribute.count; k++) {
-        lua_rawgeti(L, -1, ++component);
-        switch (attribute.type) {
-          case MESH_FLOAT: *((float*) vertex) = luaL_optnumber(L, -1, 0.f); break;
-          case MESH_BYTE: *((unsigned char*) vertex) = luaL_optint(L, -1, 255); break;
-          case MESH_INT: *((int*) vertex) = luaL_optint(L, -1, 0); break;
-        }
-        vertex += sizeof(attribute.type);
-        lua_pop(L, 1);
-      }
-    }
+    luax_setvertex(L, -1, vertex, &format);
+    vertex += stride;
     lua_pop(L, 1);
   }
 
@@ -363,6 +488,26 @@ int l_lovrMeshSetTexture(lua_State* L) {
   return 0;
 }
 
+int l_lovrMeshGetTextureArray(lua_State* L) {
+  Mesh* mesh = luax_checktype(L, 1, Mesh);
+  TextureArray* textureArray = lovrMeshGetTextureArray(mesh);
+
+  if (textureArray) {
+    luax_pushtype(L, TextureArray, textureArray);
+  } else {
+    lua_pushnil(L);
+  }
+
+  return 1;
+}
+
+int l_lovrMeshSetTextureArray(lua_State* L) {
+  Mesh* mesh = luax_checktype(L, 1, Mesh);
+  TextureArray* textureArray = lua_isnoneornil(L, 2) ? NULL : luax_checktype(L, 2, TextureArray);
+  lovrMeshSetTextureArray(mesh, textureArray);
+  return 0;
+}
+
 const luaL_Reg lovrMesh[] = {
   { "draw", l_lovrMeshDraw },
   { "getVertexFormat", l_lovrMeshGetVertexFormat },
@@ -371,7 +516,10 @@ const luaL_Reg lovrMesh[] = {
   { "setVertex", l_lovrMeshSetVertex },
   { "getVertexAttribute", l_lovrMeshGetVertexAttribute },
   { "setVertexAttribute", l_lovrMeshSetVertexAttribute },
+  { "getVertices", l_lovrMeshGetVertices },
   { "setVertices", l_lovrMeshSetVertices },
+  { "getPointer", l_lovrMeshGetPointer },
+  { "markDirty", l_lovrMeshMarkDirty },
   { "getVertexMap", l_lovrMeshGetVertexMap },
   { "setVertexMap", l_lovrMeshSetVertexMap },
   { "isAttributeEnabled", l_lovrMeshIsAttributeEnabled },
@@ -382,5 +530,7 @@ const luaL_Reg lovrMesh[] = {
   { "setDrawRange", l_lovrMeshSetDrawRange },
   { "getTexture", l_lovrMeshGetTexture },
   { "setTexture", l_lovrMeshSetTexture },
+  { "getTextureArray", l_lovrMeshGetTextureArray },
+  { "setTextureArray", l_lovrMeshSetTextureArray },
   { NULL, NULL }
 };
@@ -1,5 +1,53 @@
 #include "api/lovr.h"
+#include "graphics/graphics.h"
 #include "graphics/model.h"
+#include "filesystem/blob.h"
+#include "math/transform.h"
+#include <float.h>
+
+static Animator* luax_checkanimator(lua_State* L, Model* model) {
+  Animator* animator = lovrModelGetAnimator(model);
+  if (!animator) {
+    luaL_error(L, "Model has no animations");
+  }
+  return animator;
+}
+
+// Animations can be referred to by name or by index
+static int luax_checkanimation(lua_State* L, int index, Animator* animator) {
+  if (lua_type(L, index) == LUA_TNUMBER) {
+    int animation = lua_tointeger(L, index) - 1;
+    if (animation < 0 || animation >= lovrAnimatorGetAnimationCount(animator)) {
+      return luaL_error(L, "Invalid animation index '%d'", animation + 1);
+    }
+    return animation;
+  }
+
+  const char* name = luaL_checkstring(L, index);
+  int animation = lovrAnimatorFindAnimation(animator, name);
+  if (animation < 0) {
+    return luaL_error(L, "Unknown animation '%s'", name);
+  }
+  return animation;
+}
+
+// Nodes can be referred to by name or by index
+static int luax_checknode(lua_State* L, int index, Model* model) {
+  if (lua_type(L, index) == LUA_TNUMBER) {
+    int node = lua_tointeger(L, index) - 1;
+    if (node < 0 || node >= lovrModelGetNodeCount(model)) {
+      return luaL_error(L, "Invalid node index '%d'", node + 1);
+    }
+    return node;
+  }
+
+  const char* name = luaL_checkstring(L, index);
+  int node = lovrModelFindNode(model, name);
+  if (node < 0) {
+    return luaL_error(L, "Unknown node '%s'", name);
+  }
+  return node;
+}
 
 int l_lovrModelDraw(lua_State* L) {
   Model* model = luax_checktype(L, 1, Model);
@@ -18,11 +66,39 @@ int l_lovrModelGetTexture(lua_State* L) {
 
 int l_lovrModelSetTexture(lua_State* L) {
   Model* model = luax_checktype(L, 1, Model);
-  Texture* texture = luax_checktype(L, 2, Texture);
+  Texture* texture = lua_isnoneornil(L, 2) ? NULL : luax_checktype(L, 2, Texture);
   lovrModelSetTexture(model, texture);
   return 0;
 }
 
+int l_lovrModelGetMaterialCount(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  lua_pushinteger(L, lovrModelGetMaterialCount(model));
+  return 1;
+}
+
+int l_lovrModelGetMaterial(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  int index = luaL_checkinteger(L, 2) - 1;
+  if (index < 0 || index >= lovrModelGetMaterialCount(model)) {
+    return luaL_error(L, "Invalid material index '%d'", index + 1);
+  }
+  Material* material = lovrModelGetMaterial(model, index);
+  luax_pushtype(L, Material, material);
+  return 1;
+}
+
+int l_lovrModelSetMaterial(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  int index = luaL_checkinteger(L, 2) - 1;
+  if (index < 0 || index >= lovrModelGetMaterialCount(model)) {
+    return luaL_error(L, "Invalid material index '%d'", index + 1);
+  }
+  Material* material = luax_checktype(L, 3, Material);
+  lovrModelSetMaterial(model, index, material);
+  return 0;
+}
+
 int l_lovrModelGetAABB(lua_State* L) {
   Model* model = luax_checktype(L, 1, Model);
   float* aabb = lovrModelGetAABB(model);
@@ -32,10 +108,345 @@ int l_lovrModelGetAABB(lua_State* L) {
   return 6;
 }
 
+int l_lovrModelGetLODCount(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  lua_pushinteger(L, lovrModelGetLodCount(model));
+  return 1;
+}
+
+int l_lovrModelGetLOD(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  lua_pushinteger(L, lovrModelGetLod(model) + 1);
+  return 1;
+}
+
+// Levels of detail start at 1 for full detail.  nil picks them automatically based on screen size.
+int l_lovrModelSetLOD(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  if (lua_isnoneornil(L, 2)) {
+    lovrModelSetLod(model, -1);
+    return 0;
+  }
+
+  int lod = luaL_checkinteger(L, 2) - 1;
+  if (lod < 0 || lod >= lovrModelGetLodCount(model)) {
+    return luaL_error(L, "Invalid LOD '%d'", lod + 1);
+  }
+
+  lovrModelSetLod(model, lod);
+  return 0;
+}
+
+int l_lovrModelGetNodeCount(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  lua_pushinteger(L, lovrModelGetNodeCount(model));
+  return 1;
+}
+
+int l_lovrModelGetNodeName(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  int node = luax_checknode(L, 2, model);
+  lua_pushstring(L, lovrModelGetNodeName(model, node));
+  return 1;
+}
+
+int l_lovrModelGetNodeTransform(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  int node = luax_checknode(L, 2, model);
+  float matrix[16];
+  lovrModelGetNodeTransform(model, node, matrix);
+  Transform* transform = lovrTransformCreate(matrix);
+  luax_pushtype(L, Transform, transform);
+  lovrRelease(&transform->ref);
+  return 1;
+}
+
+int l_lovrModelSetNodeTransform(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  int node = luax_checknode(L, 2, model);
+  float transform[16];
+  luax_readtransform(L, 3, transform, 0);
+  lovrModelSetNodeTransform(model, node, transform);
+  return 0;
+}
+
+int l_lovrModelIsNodeVisible(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  int node = luax_checknode(L, 2, model);
+  lua_pushboolean(L, lovrModelIsNodeVisible(model, node));
+  return 1;
+}
+
+int l_lovrModelSetNodeVisible(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  int node = luax_checknode(L, 2, model);
+  lovrModelSetNodeVisible(model, node, lua_toboolean(L, 3));
+  return 0;
+}
+
+int l_lovrModelGetAnimationCount(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = lovrModelGetAnimator(model);
+  lua_pushinteger(L, animator ? lovrAnimatorGetAnimationCount(animator) : 0);
+  return 1;
+}
+
+int l_lovrModelGetAnimationName(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lua_pushstring(L, lovrAnimatorGetAnimationName(animator, animation));
+  return 1;
+}
+
+int l_lovrModelGetAnimationDuration(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lua_pushnumber(L, lovrAnimatorGetDuration(animator, animation));
+  return 1;
+}
+
+int l_lovrModelAnimate(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  float dt = luaL_checknumber(L, 2);
+  lovrGraphicsFlushObject(&model->ref);
+  lovrAnimatorUpdate(animator, dt);
+  return 0;
+}
+
+int l_lovrModelPlay(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lovrGraphicsFlushObject(&model->ref);
+  lovrAnimatorPlay(animator, animation);
+  return 0;
+}
+
+int l_lovrModelStop(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lovrGraphicsFlushObject(&model->ref);
+  lovrAnimatorStop(animator, animation);
+  return 0;
+}
+
+int l_lovrModelIsPlaying(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lua_pushboolean(L, lovrAnimatorIsPlaying(animator, animation));
+  return 1;
+}
+
+int l_lovrModelIsAnimationLooping(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lua_pushboolean(L, lovrAnimatorIsLooping(animator, animation));
+  return 1;
+}
+
+int l_lovrModelSetAnimationLooping(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lovrGraphicsFlushObject(&model->ref);
+  lovrAnimatorSetLooping(animator, animation, lua_toboolean(L, 3));
+  return 0;
+}
+
+int l_lovrModelGetAnimationTime(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lua_pushnumber(L, lovrAnimatorGetTime(animator, animation));
+  return 1;
+}
+
+int l_lovrModelSetAnimationTime(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lovrGraphicsFlushObject(&model->ref);
+  lovrAnimatorSetTime(animator, animation, luaL_checknumber(L, 3));
+  return 0;
+}
+
+int l_lovrModelGetAnimationSpeed(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lua_pushnumber(L, lovrAnimatorGetSpeed(animator, animation));
+  return 1;
+}
+
+int l_lovrModelSetAnimationSpeed(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lovrGraphicsFlushObject(&model->ref);
+  lovrAnimatorSetSpeed(animator, animation, luaL_checknumber(L, 3));
+  return 0;
+}
+
+int l_lovrModelGetAnimationWeight(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lua_pushnumber(L, lovrAnimatorGetWeight(animator, animation));
+  return 1;
+}
+
+int l_lovrModelSetAnimationWeight(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Animator* animator = luax_checkanimator(L, model);
+  int animation = luax_checkanimation(L, 2, animator);
+  lovrGraphicsFlushObject(&model->ref);
+  lovrAnimatorSetWeight(animator, animation, luaL_checknumber(L, 3));
+  return 0;
+}
+
+// Returns a Blob with 3 floats for each vertex of the model in its current pose
+int l_lovrModelGetSkinnedPositions(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  if (!model->isSkinned) {
+    return luaL_error(L, "Model is not skinned");
+  }
+
+  size_t size = 3 * lovrModelGetVertexCount(model) * sizeof(float);
+  float* positions = malloc(size);
+  lovrModelGetSkinnedPositions(model, positions);
+  Blob* blob = lovrBlobCreate(positions, size, "Model positions");
+  luax_pushtype(L, Blob, blob);
+  lovrRelease(&blob->ref);
+  return 1;
+}
+
+int l_lovrModelGetTriangleCount(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  lua_pushinteger(L, lovrModelGetTriangleCount(model));
+  return 1;
+}
+
+// Returns the indices of the vertices of a triangle, as numbered by raycasts
+int l_lovrModelGetTriangle(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  int triangle = luaL_checkinteger(L, 2) - 1;
+  if (triangle < 0 || triangle >= lovrModelGetTriangleCount(model)) {
+    return luaL_error(L, "Invalid triangle index '%d'", triangle + 1);
+  }
+
+  unsigned int vertices[3];
+  lovrModelGetTriangle(model, triangle, vertices);
+  for (int i = 0; i < 3; i++) {
+    lua_pushinteger(L, vertices[i] + 1);
+  }
+  return 3;
+}
+
+// Returns the distance, triangle, barycentric coordinates, and node of the closest hit, or nil
+int l_lovrModelRaycast(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  float origin[3], direction[3];
+  for (int i = 0; i < 3; i++) {
+    origin[i] = luaL_checknumber(L, 2 + i);
+    direction[i] = luaL_checknumber(L, 5 + i);
+  }
+
+  ModelHit hit = { .distance = FLT_MAX };
+  if (!lovrModelRaycast(model, origin, direction, &hit)) {
+    lua_pushnil(L);
+    return 1;
+  }
+
+  lua_pushnumber(L, hit.distance);
+  lua_pushinteger(L, hit.triangle + 1);
+  lua_pushnumber(L, hit.u);
+  lua_pushnumber(L, hit.v);
+  lua_pushinteger(L, hit.node + 1);
+  return 5;
+}
+
+// Rays are read from a Blob with 6 floats for each ray, an origin and a direction.  The hits are
+// written to a Blob, which can be passed in to be reused, with a float distance, int triangle, int
+// node, and float u and v for each ray.  Triangles and nodes start at 1, and are 0 for misses.
+int l_lovrModelRaycastBatch(lua_State* L) {
+  Model* model = luax_checktype(L, 1, Model);
+  Blob* rays = luax_checktype(L, 2, Blob);
+  if (rays->size % (6 * sizeof(float)) != 0) {
+    return luaL_error(L, "Blob size (%d) is not a multiple of the ray size (%d)", (int) rays->size, (int) (6 * sizeof(float)));
+  }
+
+  int count = rays->size / (6 * sizeof(float));
+  size_t size = count * sizeof(ModelHit);
+  Blob* hits = lua_isnoneornil(L, 3) ? NULL : luax_checktype(L, 3, Blob);
+  if (hits) {
+    if (hits->size < size) {
+      return luaL_error(L, "Blob is too small to hold %d hits", count);
+    }
+    lovrRetain(&hits->ref);
+  } else {
+    void* data = malloc(size);
+    lovrAssert(data || size == 0, "Out of memory");
+    hits = lovrBlobCreate(data, size, "Model raycast");
+  }
+
+  ModelHit* data = hits->data;
+  for (int i = 0; i < count; i++) {
+    data[i] = (ModelHit) { .distance = FLT_MAX, .triangle = -1, .node = -1 };
+  }
+
+  lovrModelRaycastBatch(model, rays->data, count, data);
+  for (int i = 0; i < count; i++) {
+    data[i].triangle++;
+    data[i].node++;
+  }
+
+  luax_pushtype(L, Blob, hits);
+  lovrRelease(&hits->ref);
+  return 1;
+}
+
 const luaL_Reg lovrModel[] = {
   { "draw", l_lovrModelDraw },
   { "getTexture", l_lovrModelGetTexture },
   { "setTexture", l_lovrModelSetTexture },
+  { "getMaterialCount", l_lovrModelGetMaterialCount },
+  { "getMaterial", l_lovrModelGetMaterial },
+  { "setMaterial", l_lovrModelSetMaterial },
   { "getAABB", l_lovrModelGetAABB },
+  { "getLODCount", l_lovrModelGetLODCount },
+  { "getLOD", l_lovrModelGetLOD },
+  { "setLOD", l_lovrModelSetLOD },
+  { "getNodeCount", l_lovrModelGetNodeCount },
+  { "getNodeName", l_lovrModelGetNodeName },
+  { "getNodeTransform", l_lovrModelGetNodeTransform },
+  { "setNodeTransform", l_lovrModelSetNodeTransform },
+  { "isNodeVisible", l_lovrModelIsNodeVisible },
+  { "setNodeVisible", l_lovrModelSetNodeVisible },
+  { "getAnimationCount", l_lovrModelGetAnimationCount },
+  { "getAnimationName", l_lovrModelGetAnimationName },
+  { "getAnimationDuration", l_lovrModelGetAnimationDuration },
+  { "animate", l_lovrModelAnimate },
+  { "play", l_lovrModelPlay },
+  { "stop", l_lovrModelStop },
+  { "isPlaying", l_lovrModelIsPlaying },
+  { "isAnimationLooping", l_lovrModelIsAnimationLooping },
+  { "setAnimationLooping", l_lovrModelSetAnimationLooping },
+  { "getAnimationTime", l_lovrModelGetAnimationTime },
+  { "setAnimationTime", l_lovrModelSetAnimationTime },
+  { "getAnimationSpeed", l_lovrModelGetAnimationSpeed },
+  { "setAnimationSpeed", l_lovrModelSetAnimationSpeed },
+  { "getAnimationWeight", l_lovrModelGetAnimationWeight },
+  { "setAnimationWeight", l_lovrModelSetAnimationWeight },
+  { "getSkinnedPositions", l_lovrModelGetSkinnedPositions },
+  { "getTriangleCount", l_lovrModelGetTriangleCount },
+  { "getTriangle", l_lovrModelGetTriangle },
+  { "raycast", l_lovrModelRaycast },
+  { "raycastBatch", l_lovrModelRaycastBatch },
   { NULL, NULL }
 };
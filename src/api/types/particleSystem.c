@@ -0,0 +1,162 @@
+#include "api/lovr.h"
+#include "graphics/particleSystem.h"
+
+int l_lovrParticleSystemDraw(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  float transform[16];
+  luax_readtransform(L, 2, transform, 1);
+  lovrParticleSystemDraw(particleSystem, transform);
+  return 0;
+}
+
+int l_lovrParticleSystemEmit(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  int count = luaL_checkinteger(L, 2);
+  lovrParticleSystemEmit(particleSystem, count);
+  return 0;
+}
+
+int l_lovrParticleSystemUpdate(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  float dt = luaL_checknumber(L, 2);
+  lovrParticleSystemUpdate(particleSystem, dt);
+  return 0;
+}
+
+int l_lovrParticleSystemReset(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  lovrParticleSystemReset(particleSystem);
+  return 0;
+}
+
+int l_lovrParticleSystemGetCount(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  lua_pushinteger(L, lovrParticleSystemGetCount(particleSystem));
+  return 1;
+}
+
+int l_lovrParticleSystemGetCapacity(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  lua_pushinteger(L, lovrParticleSystemGetCapacity(particleSystem));
+  return 1;
+}
+
+int l_lovrParticleSystemSetPosition(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  float x = luaL_checknumber(L, 2);
+  float y = luaL_checknumber(L, 3);
+  float z = luaL_checknumber(L, 4);
+  lovrParticleSystemSetPosition(particleSystem, x, y, z);
+  return 0;
+}
+
+int l_lovrParticleSystemSetDirection(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  float x = luaL_checknumber(L, 2);
+  float y = luaL_checknumber(L, 3);
+  float z = luaL_checknumber(L, 4);
+  float spread = luaL_optnumber(L, 5, 0);
+  lovrParticleSystemSetDirection(particleSystem, x, y, z, spread);
+  return 0;
+}
+
+int l_lovrParticleSystemSetSpeed(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  float min = luaL_checknumber(L, 2);
+  float max = luaL_optnumber(L, 3, min);
+  lovrParticleSystemSetSpeed(particleSystem, min, max);
+  return 0;
+}
+
+int l_lovrParticleSystemSetLifetime(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  float min = luaL_checknumber(L, 2);
+  float max = luaL_optnumber(L, 3, min);
+  lovrParticleSystemSetLifetime(particleSystem, min, max);
+  return 0;
+}
+
+int l_lovrParticleSystemSetGravity(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  float x = luaL_checknumber(L, 2);
+  float y = luaL_checknumber(L, 3);
+  float z = luaL_checknumber(L, 4);
+  lovrParticleSystemSetGravity(particleSystem, x, y, z);
+  return 0;
+}
+
+int l_lovrParticleSystemSetDrag(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  lovrParticleSystemSetDrag(particleSystem, luaL_checknumber(L, 2));
+  return 0;
+}
+
+int l_lovrParticleSystemSetSizes(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  float start = luaL_checknumber(L, 2);
+  float end = luaL_optnumber(L, 3, start);
+  lovrParticleSystemSetSizes(particleSystem, start, end);
+  return 0;
+}
+
+int l_lovrParticleSystemSetColors(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  Color start, end;
+  start.r = luaL_checkinteger(L, 2);
+  start.g = luaL_checkinteger(L, 3);
+  start.b = luaL_checkinteger(L, 4);
+  start.a = luaL_optinteger(L, 5, 255);
+  end.r = luaL_optinteger(L, 6, start.r);
+  end.g = luaL_optinteger(L, 7, start.g);
+  end.b = luaL_optinteger(L, 8, start.b);
+  end.a = luaL_optinteger(L, 9, start.a);
+  lovrParticleSystemSetColors(particleSystem, start, end);
+  return 0;
+}
+
+int l_lovrParticleSystemSetEmissionRate(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  lovrParticleSystemSetEmissionRate(particleSystem, luaL_checknumber(L, 2));
+  return 0;
+}
+
+int l_lovrParticleSystemGetTexture(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  Texture* texture = lovrParticleSystemGetTexture(particleSystem);
+
+  if (texture) {
+    luax_pushtype(L, Texture, texture);
+  } else {
+    lua_pushnil(L);
+  }
+
+  return 1;
+}
+
+int l_lovrParticleSystemSetTexture(lua_State* L) {
+  ParticleSystem* particleSystem = luax_checktype(L, 1, ParticleSystem);
+  Texture* texture = lua_isnoneornil(L, 2) ? NULL : luax_checktype(L, 2, Texture);
+  lovrParticleSystemSetTexture(particleSystem, texture);
+  return 0;
+}
+
+const luaL_Reg lovrParticleSystem[] = {
+  { "draw", l_lovrParticleSystemDraw },
+  { "emit", l_lovrParticleSystemEmit },
+  { "update", l_lovrParticleSystemUpdate },
+  { "reset", l_lovrParticleSystemReset },
+  { "getCount", l_lovrParticleSystemGetCount },
+  { "getCapacity", l_lovrParticleSystemGetCapacity },
+  { "setPosition", l_lovrParticleSystemSetPosition },
+  { "setDirection", l_lovrParticleSystemSetDirection },
+  { "setSpeed", l_lovrParticleSystemSetSpeed },
+  { "setLifetime", l_lovrParticleSystemSetLifetime },
+  { "setGravity", l_lovrParticleSystemSetGravity },
+  { "setDrag", l_lovrParticleSystemSetDrag },
+  { "setSizes", l_lovrParticleSystemSetSizes },
+  { "setColors", l_lovrParticleSystemSetColors },
+  { "setEmissionRate", l_lovrParticleSystemSetEmissionRate },
+  { "getTexture", l_lovrParticleSystemGetTexture },
+  { "setTexture", l_lovrParticleSystemSetTexture },
+  { NULL, NULL }
+};
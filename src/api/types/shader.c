@@ -16,6 +16,7 @@ int l_lovrShaderSend(lua_State* L) {
   GLenum type;
   int size;
   lovrShaderGetUniformType(shader, name, &type, &size);
+  lovrGraphicsFlushObject(&shader->ref);
   lovrGraphicsBindProgram(shader->id);
   float data[16];
   int n;
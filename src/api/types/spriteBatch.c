@@ -0,0 +1,108 @@
+#include "api/lovr.h"
+#include "graphics/spriteBatch.h"
+
+static void luax_readsprite(lua_State* L, int index, mat4 transform, float* uv) {
+  index = luax_readtransform(L, index, transform, 0);
+  uv[0] = luaL_optnumber(L, index++, 0);
+  uv[1] = luaL_optnumber(L, index++, 0);
+  uv[2] = luaL_optnumber(L, index++, 1);
+  uv[3] = luaL_optnumber(L, index++, 1);
+}
+
+int l_lovrSpriteBatchDraw(lua_State* L) {
+  SpriteBatch* spriteBatch = luax_checktype(L, 1, SpriteBatch);
+  float transform[16];
+  luax_readtransform(L, 2, transform, 1);
+  lovrSpriteBatchDraw(spriteBatch, transform);
+  return 0;
+}
+
+int l_lovrSpriteBatchAdd(lua_State* L) {
+  SpriteBatch* spriteBatch = luax_checktype(L, 1, SpriteBatch);
+  float transform[16], uv[4];
+  luax_readsprite(L, 2, transform, uv);
+  lua_pushinteger(L, lovrSpriteBatchAdd(spriteBatch, transform, uv) + 1);
+  return 1;
+}
+
+int l_lovrSpriteBatchSet(lua_State* L) {
+  SpriteBatch* spriteBatch = luax_checktype(L, 1, SpriteBatch);
+  int index = luaL_checkinteger(L, 2) - 1;
+  float transform[16], uv[4];
+  luax_readsprite(L, 3, transform, uv);
+  lovrSpriteBatchSet(spriteBatch, index, transform, uv);
+  return 0;
+}
+
+int l_lovrSpriteBatchClear(lua_State* L) {
+  SpriteBatch* spriteBatch = luax_checktype(L, 1, SpriteBatch);
+  lovrSpriteBatchClear(spriteBatch);
+  return 0;
+}
+
+int l_lovrSpriteBatchGetCount(lua_State* L) {
+  SpriteBatch* spriteBatch = luax_checktype(L, 1, SpriteBatch);
+  lua_pushinteger(L, lovrSpriteBatchGetCount(spriteBatch));
+  return 1;
+}
+
+int l_lovrSpriteBatchGetCapacity(lua_State* L) {
+  SpriteBatch* spriteBatch = luax_checktype(L, 1, SpriteBatch);
+  lua_pushinteger(L, lovrSpriteBatchGetCapacity(spriteBatch));
+  return 1;
+}
+
+int l_lovrSpriteBatchGetColor(lua_State* L) {
+  SpriteBatch* spriteBatch = luax_checktype(L, 1, SpriteBatch);
+  Color color = lovrSpriteBatchGetColor(spriteBatch);
+  lua_pushinteger(L, color.r);
+  lua_pushinteger(L, color.g);
+  lua_pushinteger(L, color.b);
+  lua_pushinteger(L, color.a);
+  return 4;
+}
+
+int l_lovrSpriteBatchSetColor(lua_State* L) {
+  SpriteBatch* spriteBatch = luax_checktype(L, 1, SpriteBatch);
+  Color color;
+  color.r = luaL_checkinteger(L, 2);
+  color.g = luaL_checkinteger(L, 3);
+  color.b = luaL_checkinteger(L, 4);
+  color.a = luaL_optinteger(L, 5, 255);
+  lovrSpriteBatchSetColor(spriteBatch, color);
+  return 0;
+}
+
+int l_lovrSpriteBatchGetTexture(lua_State* L) {
+  SpriteBatch* spriteBatch = luax_checktype(L, 1, SpriteBatch);
+  Texture* texture = lovrSpriteBatchGetTexture(spriteBatch);
+
+  if (texture) {
+    luax_pushtype(L, Texture, texture);
+  } else {
+    lua_pushnil(L);
+  }
+
+  return 1;
+}
+
+int l_lovrSpriteBatchSetTexture(lua_State* L) {
+  SpriteBatch* spriteBatch = luax_checktype(L, 1, SpriteBatch);
+  Texture* texture = lua_isnoneornil(L, 2) ? NULL : luax_checktype(L, 2, Texture);
+  lovrSpriteBatchSetTexture(spriteBatch, texture);
+  return 0;
+}
+
+const luaL_Reg lovrSpriteBatch[] = {
+  { "draw", l_lovrSpriteBatchDraw },
+  { "add", l_lovrSpriteBatchAdd },
+  { "set", l_lovrSpriteBatchSet },
+  { "clear", l_lovrSpriteBatchClear },
+  { "getCount", l_lovrSpriteBatchGetCount },
+  { "getCapacity", l_lovrSpriteBatchGetCapacity },
+  { "getColor", l_lovrSpriteBatchGetColor },
+  { "setColor", l_lovrSpriteBatchSetColor },
+  { "getTexture", l_lovrSpriteBatchGetTexture },
+  { "setTexture", l_lovrSpriteBatchSetTexture },
+  { NULL, NULL }
+};
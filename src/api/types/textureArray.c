@@ -0,0 +1,63 @@
+#include "api/lovr.h"
+#include "graphics/textureArray.h"
+#include "loaders/texture.h"
+
+static TextureData* luax_readlayer(lua_State* L, int index, TextureArray* textureArray) {
+  Blob* blob = luax_readblob(L, index, "Texture");
+  TextureData* textureData = lovrTextureDataFromBlob(blob, &textureArray->format);
+  lovrRelease(&blob->ref);
+  return textureData;
+}
+
+int l_lovrTextureArrayAdd(lua_State* L) {
+  TextureArray* textureArray = luax_checktype(L, 1, TextureArray);
+  TextureData* textureData = luax_readlayer(L, 2, textureArray);
+  int layer = lovrTextureArrayAdd(textureArray, textureData);
+  lovrTextureDataDestroy(textureData);
+  lua_pushinteger(L, layer);
+  return 1;
+}
+
+int l_lovrTextureArraySet(lua_State* L) {
+  TextureArray* textureArray = luax_checktype(L, 1, TextureArray);
+  int layer = luaL_checkinteger(L, 2);
+  TextureData* textureData = luax_readlayer(L, 3, textureArray);
+  lovrTextureArraySet(textureArray, layer, textureData);
+  lovrTextureDataDestroy(textureData);
+  return 0;
+}
+
+int l_lovrTextureArrayGetLayerCount(lua_State* L) {
+  TextureArray* textureArray = luax_checktype(L, 1, TextureArray);
+  lua_pushinteger(L, lovrTextureArrayGetLayerCount(textureArray));
+  return 1;
+}
+
+int l_lovrTextureArrayGetDimensions(lua_State* L) {
+  TextureArray* textureArray = luax_checktype(L, 1, TextureArray);
+  lua_pushnumber(L, lovrTextureArrayGetWidth(textureArray));
+  lua_pushnumber(L, lovrTextureArrayGetHeight(textureArray));
+  return 2;
+}
+
+int l_lovrTextureArrayGetHeight(lua_State* L) {
+  TextureArray* textureArray = luax_checktype(L, 1, TextureArray);
+  lua_pushnumber(L, lovrTextureArrayGetHeight(textureArray));
+  return 1;
+}
+
+int l_lovrTextureArrayGetWidth(lua_State* L) {
+  TextureArray* textureArray = luax_checktype(L, 1, TextureArray);
+  lua_pushnumber(L, lovrTextureArrayGetWidth(textureArray));
+  return 1;
+}
+
+const luaL_Reg lovrTextureArray[] = {
+  { "add", l_lovrTextureArrayAdd },
+  { "set", l_lovrTextureArraySet },
+  { "getLayerCount", l_lovrTextureArrayGetLayerCount },
+  { "getDimensions", l_lovrTextureArrayGetDimensions },
+  { "getHeight", l_lovrTextureArrayGetHeight },
+  { "getWidth", l_lovrTextureArrayGetWidth },
+  { NULL, NULL }
+};
@@ -15,6 +15,9 @@
 #else
 #include <unistd.h>
 #include <pwd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 
 static FilesystemState state;
@@ -171,6 +174,66 @@ int lovrFilesystemMount(const char* path, const char* mountpoint, int append) {
   return !PHYSFS_mount(path, mountpoint, append);
 }
 
+// Maps a file from the save directory into memory.  The mapping is copy-on-write, changes to the
+// memory are never written back to the file.
+void* lovrFilesystemMap(const char* path, size_t* size) {
+  if (!state.savePathFull) {
+    return NULL;
+  }
+
+  char fullPath[LOVR_PATH_MAX];
+  snprintf(fullPath, LOVR_PATH_MAX, "%s/%s", state.savePathFull, path);
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(fullPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return NULL;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+    CloseHandle(file);
+    return NULL;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping) {
+    return NULL;
+  }
+
+  // The view keeps the mapping alive
+  void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!data) {
+    return NULL;
+  }
+
+  *size = (size_t) fileSize.QuadPart;
+  return data;
+#else
+  int fd = open(fullPath, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) || info.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+
+  void* data = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return NULL;
+  }
+
+  *size = info.st_size;
+  return data;
+#endif
+}
+
 void* lovrFilesystemRead(const char* path, size_t* bytesRead) {
 
   // Open file
@@ -238,6 +301,14 @@ int lovrFilesystemSetIdentity(const char* identity) {
   return 0;
 }
 
+void lovrFilesystemUnmap(void* data, size_t size) {
+#ifdef _WIN32
+  UnmapViewOfFile(data);
+#else
+  munmap(data, size);
+#endif
+}
+
 int lovrFilesystemUnmount(const char* path) {
   return !PHYSFS_removeFromSearchPath(path);
 }
@@ -31,10 +31,12 @@ const char* lovrFilesystemGetUserDirectory();
 int lovrFilesystemIsDirectory(const char* path);
 int lovrFilesystemIsFile(const char* path);
 int lovrFilesystemIsFused();
+void* lovrFilesystemMap(const char* path, size_t* size);
 int lovrFilesystemMount(const char* path, const char* mountpoint, int append);
 void* lovrFilesystemRead(const char* path, size_t* bytesRead);
 int lovrFilesystemRemove(const char* path);
 int lovrFilesystemSetIdentity(const char* identity);
 int lovrFilesystemSetSource(const char* source);
+void lovrFilesystemUnmap(void* data, size_t size);
 int lovrFilesystemUnmount(const char* path);
 int lovrFilesystemWrite(const char* path, const char* content, size_t size, int append);
@@ -0,0 +1,312 @@
+#include "graphics/animator.h"
+#include "math/mat4.h"
+#include "math/quat.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+// Each node accumulates a blended translation, rotation, scale, and total weight
+#define CHANNEL_TRANSLATION 0
+#define CHANNEL_ROTATION 4
+#define CHANNEL_SCALE 8
+#define CHANNEL_WEIGHT 12
+#define CHANNEL_STRIDE 16
+
+// Interpolates between the two keyframes surrounding a time, found with a binary search
+static void sampleKeyframes(vec_model_keyframe_t* keyframes, float time, int isRotation, float* result) {
+  int count = keyframes->length;
+  ModelKeyframe* data = keyframes->data;
+
+  if (count == 0) {
+    return;
+  } else if (count == 1 || time <= data[0].time) {
+    memcpy(result, data[0].data, 4 * sizeof(float));
+    return;
+  } else if (time >= data[count - 1].time) {
+    memcpy(result, data[count - 1].data, 4 * sizeof(float));
+    return;
+  }
+
+  int low = 0;
+  int high = count - 1;
+  while (high - low > 1) {
+    int mid = (low + high) / 2;
+    if (data[mid].time <= time) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+
+  ModelKeyframe* a = &data[low];
+  ModelKeyframe* b = &data[high];
+  float t = (time - a->time) / (b->time - a->time);
+  memcpy(result, a->data, 4 * sizeof(float));
+
+  if (isRotation) {
+    quat_slerp(result, b->data, t);
+  } else {
+#ifdef __SSE__
+    __m128 from = _mm_loadu_ps(result);
+    __m128 delta = _mm_sub_ps(_mm_loadu_ps(b->data), from);
+    _mm_storeu_ps(result, _mm_add_ps(from, _mm_mul_ps(delta, _mm_set1_ps(t))));
+#else
+    for (int i = 0; i < 4; i++) {
+      result[i] += (b->data[i] - result[i]) * t;
+    }
+#endif
+  }
+}
+
+static void decompose(mat4 m, float* translation, float* rotation, float* scale) {
+  translation[0] = m[12];
+  translation[1] = m[13];
+  translation[2] = m[14];
+
+  float rotationMatrix[16];
+  mat4_identity(rotationMatrix);
+  for (int i = 0; i < 3; i++) {
+    float* column = &m[4 * i];
+    scale[i] = sqrt(column[0] * column[0] + column[1] * column[1] + column[2] * column[2]);
+    float inverse = scale[i] > 0 ? 1 / scale[i] : 0;
+    rotationMatrix[4 * i + 0] = column[0] * inverse;
+    rotationMatrix[4 * i + 1] = column[1] * inverse;
+    rotationMatrix[4 * i + 2] = column[2] * inverse;
+  }
+
+  quat_fromMat4(rotation, rotationMatrix);
+}
+
+// Adds a weighted sample to a blend.  Rotations are blended with a normalized weighted sum, flipping
+// quaternions into the same hemisphere as the blend so far.
+static void accumulate(float* blend, float* value, float weight, int isRotation) {
+#ifdef __SSE__
+  __m128 b = _mm_loadu_ps(blend);
+  __m128 v = _mm_loadu_ps(value);
+  if (isRotation) {
+    __m128 products = _mm_mul_ps(b, v);
+    __m128 pairs = _mm_add_ps(products, _mm_movehl_ps(products, products));
+    __m128 dot = _mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1)));
+    weight = _mm_cvtss_f32(dot) < 0 ? -weight : weight;
+  }
+
+  _mm_storeu_ps(blend, _mm_add_ps(b, _mm_mul_ps(v, _mm_set1_ps(weight))));
+#else
+  if (isRotation) {
+    float dot = blend[0] * value[0] + blend[1] * value[1] + blend[2] * value[2] + blend[3] * value[3];
+    weight = dot < 0 ? -weight : weight;
+  }
+
+  for (int i = 0; i < 4; i++) {
+    blend[i] += value[i] * weight;
+  }
+#endif
+}
+
+Animator* lovrAnimatorCreate(ModelData* modelData) {
+  Animator* animator = malloc(sizeof(Animator));
+  if (!animator) return NULL;
+
+  animator->modelData = modelData;
+  animator->dirty = 1;
+  vec_init(&animator->states);
+  vec_init(&animator->channels);
+  vec_reserve(&animator->channels, modelData->nodes.length * CHANNEL_STRIDE);
+  animator->channels.length = modelData->nodes.length * CHANNEL_STRIDE;
+
+  for (int i = 0; i < modelData->animations.length; i++) {
+    AnimationState state = {
+      .time = 0,
+      .speed = 1,
+      .weight = 1,
+      .playing = 0,
+      .applied = 0,
+      .looping = 1
+    };
+
+    vec_push(&animator->states, state);
+  }
+
+  return animator;
+}
+
+void lovrAnimatorDestroy(Animator* animator) {
+  vec_deinit(&animator->states);
+  vec_deinit(&animator->channels);
+  free(animator);
+}
+
+void lovrAnimatorUpdate(Animator* animator, float dt) {
+  AnimationState* state; int i;
+  vec_foreach_ptr(&animator->states, state, i) {
+    if (!state->playing) {
+      continue;
+    }
+
+    float duration = animator->modelData->animations.data[i].duration;
+    state->time += dt * state->speed;
+    if (state->looping && duration > 0) {
+      state->time = fmodf(state->time, duration);
+      state->time += state->time < 0 ? duration : 0;
+    } else if (state->time > duration || state->time < 0) {
+      state->time = MIN(MAX(state->time, 0), duration);
+      state->playing = 0;
+    }
+
+    animator->dirty = 1;
+  }
+}
+
+// Animates the local transform of every node.  The transforms passed in are the rest pose, nodes not
+// animated by an applied animation keep them, and they fill in the remainder when weights are below 1.
+void lovrAnimatorEvaluate(Animator* animator, float* transforms) {
+  ModelData* modelData = animator->modelData;
+  float* channels = animator->channels.data;
+  memset(channels, 0, animator->channels.length * sizeof(float));
+
+  for (int a = 0; a < modelData->animations.length; a++) {
+    AnimationState* state = &animator->states.data[a];
+    if (!state->applied || state->weight <= 0) {
+      continue;
+    }
+
+    ModelAnimation* animation = &modelData->animations.data[a];
+    ModelAnimationChannel* channel; int i;
+    vec_foreach_ptr(&animation->channels, channel, i) {
+      float* blend = channels + channel->node * CHANNEL_STRIDE;
+      float translation[4] = { 0, 0, 0, 0 };
+      float rotation[4] = { 0, 0, 0, 1 };
+      float scale[4] = { 1, 1, 1, 0 };
+
+      // Properties without keyframes keep their value from the node
+      if (!channel->positions.length || !channel->rotations.length || !channel->scales.length) {
+        decompose(transforms + 16 * channel->node, translation, rotation, scale);
+      }
+
+      sampleKeyframes(&channel->positions, state->time, 0, translation);
+      sampleKeyframes(&channel->rotations, state->time, 1, rotation);
+      sampleKeyframes(&channel->scales, state->time, 0, scale);
+      accumulate(blend + CHANNEL_TRANSLATION, translation, state->weight, 0);
+      accumulate(blend + CHANNEL_ROTATION, rotation, state->weight, 1);
+      accumulate(blend + CHANNEL_SCALE, scale, state->weight, 0);
+      blend[CHANNEL_WEIGHT] += state->weight;
+    }
+  }
+
+  for (int n = 0; n < modelData->nodes.length; n++) {
+    float* blend = channels + n * CHANNEL_STRIDE;
+    float* transform = transforms + 16 * n;
+    float weight = blend[CHANNEL_WEIGHT];
+
+    if (weight <= 0) {
+      continue;
+    } else if (weight < 1) {
+      float translation[4] = { 0, 0, 0, 0 };
+      float rotation[4];
+      float scale[4] = { 0, 0, 0, 0 };
+      decompose(transform, translation, rotation, scale);
+      accumulate(blend + CHANNEL_TRANSLATION, translation, 1 - weight, 0);
+      accumulate(blend + CHANNEL_ROTATION, rotation, 1 - weight, 1);
+      accumulate(blend + CHANNEL_SCALE, scale, 1 - weight, 0);
+      weight = 1;
+    }
+
+    float* translation = blend + CHANNEL_TRANSLATION;
+    float* scale = blend + CHANNEL_SCALE;
+    mat4_identity(transform);
+    mat4_translate(transform, translation[0] / weight, translation[1] / weight, translation[2] / weight);
+    mat4_rotateQuat(transform, quat_normalize(blend + CHANNEL_ROTATION));
+    mat4_scale(transform, scale[0] / weight, scale[1] / weight, scale[2] / weight);
+  }
+
+  animator->dirty = 0;
+}
+
+int lovrAnimatorGetAnimationCount(Animator* animator) {
+  return animator->modelData->animations.length;
+}
+
+int lovrAnimatorFindAnimation(Animator* animator, const char* name) {
+  ModelAnimation* animation; int i;
+  vec_foreach_ptr(&animator->modelData->animations, animation, i) {
+    if (!strcmp(animation->name, name)) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+const char* lovrAnimatorGetAnimationName(Animator* animator, int animation) {
+  return animator->modelData->animations.data[animation].name;
+}
+
+float lovrAnimatorGetDuration(Animator* animator, int animation) {
+  return animator->modelData->animations.data[animation].duration;
+}
+
+// Playing an animation that finished starts it over
+void lovrAnimatorPlay(Animator* animator, int animation) {
+  AnimationState* state = &animator->states.data[animation];
+  float duration = animator->modelData->animations.data[animation].duration;
+  if (!state->playing && !state->looping) {
+    if (state->speed >= 0 && state->time >= duration) {
+      state->time = 0;
+    } else if (state->speed < 0 && state->time <= 0) {
+      state->time = duration;
+    }
+  }
+
+  state->playing = 1;
+  state->applied = 1;
+  animator->dirty = 1;
+}
+
+void lovrAnimatorStop(Animator* animator, int animation) {
+  AnimationState* state = &animator->states.data[animation];
+  state->playing = 0;
+  state->applied = 0;
+  state->time = 0;
+  animator->dirty = 1;
+}
+
+int lovrAnimatorIsPlaying(Animator* animator, int animation) {
+  return animator->states.data[animation].playing;
+}
+
+int lovrAnimatorIsLooping(Animator* animator, int animation) {
+  return animator->states.data[animation].looping;
+}
+
+void lovrAnimatorSetLooping(Animator* animator, int animation, int looping) {
+  animator->states.data[animation].looping = looping;
+}
+
+float lovrAnimatorGetTime(Animator* animator, int animation) {
+  return animator->states.data[animation].time;
+}
+
+void lovrAnimatorSetTime(Animator* animator, int animation, float time) {
+  animator->states.data[animation].time = time;
+  animator->dirty = 1;
+}
+
+float lovrAnimatorGetSpeed(Animator* animator, int animation) {
+  return animator->states.data[animation].speed;
+}
+
+void lovrAnimatorSetSpeed(Animator* animator, int animation, float speed) {
+  animator->states.data[animation].speed = speed;
+}
+
+float lovrAnimatorGetWeight(Animator* animator, int animation) {
+  return animator->states.data[animation].weight;
+}
+
+void lovrAnimatorSetWeight(Animator* animator, int animation, float weight) {
+  animator->states.data[animation].weight = weight;
+  animator->dirty = 1;
+}
@@ -0,0 +1,45 @@
+#include "loaders/model.h"
+#include "math/math.h"
+#include "util.h"
+
+#pragma once
+
+// Animations that stop on their own stay applied, holding their last frame until they're stopped
+typedef struct {
+  float time;
+  float speed;
+  float weight;
+  int playing;
+  int applied;
+  int looping;
+} AnimationState;
+
+typedef vec_t(AnimationState) vec_animation_state_t;
+
+// Samples and blends the animations of a ModelData into local node transforms
+typedef struct {
+  ModelData* modelData;
+  vec_animation_state_t states;
+  vec_float_t channels;
+  int dirty;
+} Animator;
+
+Animator* lovrAnimatorCreate(ModelData* modelData);
+void lovrAnimatorDestroy(Animator* animator);
+void lovrAnimatorUpdate(Animator* animator, float dt);
+void lovrAnimatorEvaluate(Animator* animator, float* transforms);
+int lovrAnimatorGetAnimationCount(Animator* animator);
+int lovrAnimatorFindAnimation(Animator* animator, const char* name);
+const char* lovrAnimatorGetAnimationName(Animator* animator, int animation);
+float lovrAnimatorGetDuration(Animator* animator, int animation);
+void lovrAnimatorPlay(Animator* animator, int animation);
+void lovrAnimatorStop(Animator* animator, int animation);
+int lovrAnimatorIsPlaying(Animator* animator, int animation);
+int lovrAnimatorIsLooping(Animator* animator, int animation);
+void lovrAnimatorSetLooping(Animator* animator, int animation, int looping);
+float lovrAnimatorGetTime(Animator* animator, int animation);
+void lovrAnimatorSetTime(Animator* animator, int animation, float time);
+float lovrAnimatorGetSpeed(Animator* animator, int animation);
+void lovrAnimatorSetSpeed(Animator* animator, int animation, float speed);
+float lovrAnimatorGetWeight(Animator* animator, int animation);
+void lovrAnimatorSetWeight(Animator* animator, int animation, float weight);
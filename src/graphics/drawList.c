@@ -0,0 +1,291 @@
+#include "graphics/drawList.h"
+#include "graphics/graphics.h"
+#include "graphics/mesh.h"
+#include "graphics/model.h"
+#include "graphics/particleSystem.h"
+#include "graphics/spriteBatch.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define OBJECT(command, T) ((command)->object ? containerof((command)->object, T) : NULL)
+
+// Commands are packed into a byte stream as a header followed by only the fields their type uses.
+// Transforms are left out when they're the identity, and point lists and strings are stored inline.
+// Every field is padded to 8 bytes, so inline data used in place is aligned.
+#define PACK_ALIGNMENT 8
+#define PACK_PADDED(size) (((size) + PACK_ALIGNMENT - 1) & ~((size_t) PACK_ALIGNMENT - 1))
+#define FIELD_MODE 0x01
+#define FIELD_COLOR 0x02
+#define FIELD_OBJECT 0x04
+#define FIELD_TRANSFORM 0x08
+#define FIELD_FLOATS 0x10
+#define FIELD_STRING 0x20
+
+typedef struct {
+  uint8_t type;
+  uint8_t fields;
+  uint8_t paramCount;
+  uint8_t hasTransform;
+} DrawCommandHeader;
+
+static const uint8_t commandFields[DRAW_COMMAND_DRAW_LIST + 1] = {
+  [DRAW_COMMAND_COLOR] = FIELD_COLOR,
+  [DRAW_COMMAND_BLEND_MODE] = FIELD_MODE,
+  [DRAW_COMMAND_CULLING] = FIELD_MODE,
+  [DRAW_COMMAND_DEPTH_TEST] = FIELD_MODE,
+  [DRAW_COMMAND_FONT] = FIELD_OBJECT,
+  [DRAW_COMMAND_SHADER] = FIELD_OBJECT,
+  [DRAW_COMMAND_WINDING] = FIELD_MODE,
+  [DRAW_COMMAND_WIREFRAME] = FIELD_MODE,
+  [DRAW_COMMAND_TRANSLATE] = FIELD_MODE,
+  [DRAW_COMMAND_ROTATE] = FIELD_MODE,
+  [DRAW_COMMAND_SCALE] = FIELD_MODE,
+  [DRAW_COMMAND_TRANSFORM] = FIELD_MODE | FIELD_TRANSFORM,
+  [DRAW_COMMAND_POINTS] = FIELD_FLOATS,
+  [DRAW_COMMAND_LINE] = FIELD_FLOATS,
+  [DRAW_COMMAND_TRIANGLE] = FIELD_MODE,
+  [DRAW_COMMAND_PLANE] = FIELD_MODE | FIELD_OBJECT | FIELD_TRANSFORM,
+  [DRAW_COMMAND_PLANE_FULLSCREEN] = FIELD_OBJECT,
+  [DRAW_COMMAND_BOX] = FIELD_MODE | FIELD_OBJECT | FIELD_TRANSFORM,
+  [DRAW_COMMAND_CYLINDER] = FIELD_MODE,
+  [DRAW_COMMAND_SPHERE] = FIELD_MODE | FIELD_OBJECT | FIELD_TRANSFORM,
+  [DRAW_COMMAND_SKYBOX] = FIELD_OBJECT,
+  [DRAW_COMMAND_PRINT] = FIELD_MODE | FIELD_TRANSFORM | FIELD_STRING,
+  [DRAW_COMMAND_MESH] = FIELD_OBJECT | FIELD_TRANSFORM,
+  [DRAW_COMMAND_MODEL] = FIELD_OBJECT | FIELD_TRANSFORM,
+  [DRAW_COMMAND_SPRITE_BATCH] = FIELD_OBJECT | FIELD_TRANSFORM,
+  [DRAW_COMMAND_PARTICLE_SYSTEM] = FIELD_OBJECT | FIELD_TRANSFORM,
+  [DRAW_COMMAND_DRAW_LIST] = FIELD_OBJECT | FIELD_TRANSFORM
+};
+
+static const uint8_t commandParamCounts[DRAW_COMMAND_DRAW_LIST + 1] = {
+  [DRAW_COMMAND_LINE_WIDTH] = 1,
+  [DRAW_COMMAND_POINT_SIZE] = 1,
+  [DRAW_COMMAND_TRANSLATE] = 3,
+  [DRAW_COMMAND_ROTATE] = 4,
+  [DRAW_COMMAND_SCALE] = 3,
+  [DRAW_COMMAND_TRIANGLE] = 9,
+  [DRAW_COMMAND_CYLINDER] = 8,
+  [DRAW_COMMAND_SKYBOX] = 4,
+  [DRAW_COMMAND_PRINT] = 1
+};
+
+static const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+static void pack(vec_char_t* stream, const void* data, size_t size) {
+  size_t padded = PACK_PADDED(size);
+  lovrAssert(!vec_reserve_po2_(vec_unpack_(stream), stream->length + padded), "Out of memory");
+  memcpy(stream->data + stream->length, data, size);
+  memset(stream->data + stream->length + size, 0, padded - size);
+  stream->length += padded;
+}
+
+static void unpack(vec_char_t* stream, size_t* offset, void* data, size_t size) {
+  memcpy(data, stream->data + *offset, size);
+  *offset += PACK_PADDED(size);
+}
+
+DrawList* lovrDrawListCreate() {
+  DrawList* drawList = lovrAlloc(sizeof(DrawList), lovrDrawListDestroy);
+  if (!drawList) return NULL;
+
+  vec_init(&drawList->commands);
+  drawList->commandCount = 0;
+
+  return drawList;
+}
+
+void lovrDrawListDestroy(const Ref* ref) {
+  DrawList* drawList = containerof(ref, DrawList);
+  lovrDrawListClear(drawList);
+  vec_deinit(&drawList->commands);
+  free(drawList);
+}
+
+void lovrDrawListRecord(DrawList* drawList, DrawCommand* command) {
+  lovrDrawCommandPack(&drawList->commands, command);
+  drawList->commandCount++;
+}
+
+void lovrDrawListClear(DrawList* drawList) {
+  lovrDrawCommandReleaseAll(&drawList->commands);
+  vec_clear(&drawList->commands);
+  drawList->commandCount = 0;
+}
+
+// Replays the recorded calls.  Lists drawn while another list is recording are nested in it.
+void lovrDrawListDraw(DrawList* drawList, mat4 transform) {
+  DrawCommand nested = { .type = DRAW_COMMAND_DRAW_LIST, .object = &drawList->ref };
+  lovrAssert(lovrGraphicsGetDrawList() != drawList, "A DrawList can not be drawn into itself");
+  if (lovrGraphicsRecord(&nested, transform)) {
+    return;
+  }
+
+  lovrGraphicsPush();
+  lovrGraphicsMatrixTransform(MATRIX_MODEL, transform);
+
+  size_t offset = 0;
+  while (offset < (size_t) drawList->commands.length) {
+    DrawCommand command;
+    lovrDrawCommandUnpack(&drawList->commands, &offset, &command);
+    lovrDrawCommandExecute(&command);
+  }
+
+  lovrGraphicsPop();
+}
+
+int lovrDrawListGetCommandCount(DrawList* drawList) {
+  return drawList->commandCount;
+}
+
+// Appends a command to a stream, retaining its object and copying the data it points to
+void lovrDrawCommandPack(vec_char_t* stream, DrawCommand* command) {
+  uint8_t fields = commandFields[command->type];
+  DrawCommandHeader header = {
+    .type = command->type,
+    .fields = fields,
+    .paramCount = commandParamCounts[command->type],
+    .hasTransform = (fields & FIELD_TRANSFORM) && memcmp(command->transform, identity, sizeof(identity))
+  };
+
+  pack(stream, &header, sizeof(header));
+
+  if (fields & FIELD_MODE) {
+    int modes[2] = { command->mode, command->mode2 };
+    pack(stream, modes, sizeof(modes));
+  }
+
+  if (fields & FIELD_COLOR) {
+    pack(stream, &command->color, sizeof(Color));
+  }
+
+  if (fields & FIELD_OBJECT) {
+    pack(stream, &command->object, sizeof(Ref*));
+    if (command->object) {
+      lovrRetain(command->object);
+    }
+  }
+
+  if (header.hasTransform) {
+    pack(stream, command->transform, 16 * sizeof(float));
+  }
+
+  if (header.paramCount > 0) {
+    pack(stream, command->params, header.paramCount * sizeof(float));
+  }
+
+  if (fields & FIELD_FLOATS) {
+    pack(stream, &command->count, sizeof(int));
+    pack(stream, command->data, command->count * sizeof(float));
+  } else if (fields & FIELD_STRING) {
+    int length = strlen(command->data) + 1;
+    pack(stream, &length, sizeof(int));
+    pack(stream, command->data, length);
+  }
+}
+
+// Reads the command at offset and advances past it.  The command's data points into the stream.
+void lovrDrawCommandUnpack(vec_char_t* stream, size_t* offset, DrawCommand* command) {
+  DrawCommandHeader header;
+  unpack(stream, offset, &header, sizeof(header));
+
+  command->type = header.type;
+  command->mode = command->mode2 = 0;
+  command->object = NULL;
+  command->data = NULL;
+  command->count = 0;
+
+  if (header.fields & FIELD_MODE) {
+    int modes[2];
+    unpack(stream, offset, modes, sizeof(modes));
+    command->mode = modes[0];
+    command->mode2 = modes[1];
+  }
+
+  if (header.fields & FIELD_COLOR) {
+    unpack(stream, offset, &command->color, sizeof(Color));
+  }
+
+  if (header.fields & FIELD_OBJECT) {
+    unpack(stream, offset, &command->object, sizeof(Ref*));
+  }
+
+  if (header.hasTransform) {
+    unpack(stream, offset, command->transform, 16 * sizeof(float));
+  } else {
+    memcpy(command->transform, identity, sizeof(identity));
+  }
+
+  if (header.paramCount > 0) {
+    unpack(stream, offset, command->params, header.paramCount * sizeof(float));
+  }
+
+  if (header.fields & (FIELD_FLOATS | FIELD_STRING)) {
+    int size;
+    unpack(stream, offset, &size, sizeof(int));
+    command->count = size;
+    command->data = stream->data + *offset;
+    *offset += PACK_PADDED((header.fields & FIELD_FLOATS) ? size * sizeof(float) : (size_t) size);
+  }
+}
+
+// Releases the objects of every command in a stream
+void lovrDrawCommandReleaseAll(vec_char_t* stream) {
+  size_t offset = 0;
+  while (offset < (size_t) stream->length) {
+    DrawCommand command;
+    lovrDrawCommandUnpack(stream, &offset, &command);
+    if (command.object) {
+      lovrRelease(command.object);
+    }
+  }
+}
+
+int lovrDrawCommandIsDraw(DrawCommand* command) {
+  return command->type >= DRAW_COMMAND_POINTS && command->type != DRAW_COMMAND_DRAW_LIST;
+}
+
+void lovrDrawCommandExecute(DrawCommand* c) {
+  switch (c->type) {
+    case DRAW_COMMAND_COLOR: lovrGraphicsSetColor(c->color); break;
+    case DRAW_COMMAND_BLEND_MODE: lovrGraphicsSetBlendMode(c->mode, c->mode2); break;
+    case DRAW_COMMAND_CULLING: lovrGraphicsSetCullingEnabled(c->mode); break;
+    case DRAW_COMMAND_DEPTH_TEST: lovrGraphicsSetDepthTest(c->mode); break;
+    case DRAW_COMMAND_FONT: lovrGraphicsSetFont(OBJECT(c, Font)); break;
+    case DRAW_COMMAND_LINE_WIDTH: lovrGraphicsSetLineWidth(c->params[0]); break;
+    case DRAW_COMMAND_POINT_SIZE: lovrGraphicsSetPointSize(c->params[0]); break;
+    case DRAW_COMMAND_SHADER: lovrGraphicsSetShader(OBJECT(c, Shader)); break;
+    case DRAW_COMMAND_WINDING: lovrGraphicsSetWinding(c->mode); break;
+    case DRAW_COMMAND_WIREFRAME: lovrGraphicsSetWireframe(c->mode); break;
+    case DRAW_COMMAND_PUSH: lovrGraphicsPush(); break;
+    case DRAW_COMMAND_POP: lovrGraphicsPop(); break;
+    case DRAW_COMMAND_ORIGIN: lovrGraphicsOrigin(); break;
+    case DRAW_COMMAND_TRANSLATE: lovrGraphicsTranslate(c->mode, c->params[0], c->params[1], c->params[2]); break;
+    case DRAW_COMMAND_ROTATE: lovrGraphicsRotate(c->mode, c->params[0], c->params[1], c->params[2], c->params[3]); break;
+    case DRAW_COMMAND_SCALE: lovrGraphicsScale(c->mode, c->params[0], c->params[1], c->params[2]); break;
+    case DRAW_COMMAND_TRANSFORM: lovrGraphicsMatrixTransform(c->mode, c->transform); break;
+    case DRAW_COMMAND_POINTS: lovrGraphicsPoints(c->data, c->count); break;
+    case DRAW_COMMAND_LINE: lovrGraphicsLine(c->data, c->count); break;
+    case DRAW_COMMAND_TRIANGLE: lovrGraphicsTriangle(c->mode, c->params); break;
+    case DRAW_COMMAND_PLANE: lovrGraphicsPlane(c->mode, OBJECT(c, Texture), c->transform); break;
+    case DRAW_COMMAND_PLANE_FULLSCREEN: lovrGraphicsPlaneFullscreen(OBJECT(c, Texture)); break;
+    case DRAW_COMMAND_BOX: lovrGraphicsBox(c->mode, OBJECT(c, Texture), c->transform); break;
+    case DRAW_COMMAND_CYLINDER: {
+      float* p = c->params;
+      lovrGraphicsCylinder(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], c->mode, c->mode2);
+      break;
+    }
+    case DRAW_COMMAND_SPHERE: lovrGraphicsSphere(OBJECT(c, Texture), c->transform, c->mode, NULL); break;
+    case DRAW_COMMAND_SKYBOX: {
+      float* p = c->params;
+      lovrGraphicsSkybox(OBJECT(c, Skybox), p[0], p[1], p[2], p[3]);
+      break;
+    }
+    case DRAW_COMMAND_PRINT: lovrGraphicsPrint(c->data, c->transform, c->params[0], c->mode, c->mode2); break;
+    case DRAW_COMMAND_MESH: lovrMeshDraw(OBJECT(c, Mesh), c->transform); break;
+    case DRAW_COMMAND_MODEL: lovrModelDraw(OBJECT(c, Model), c->transform); break;
+    case DRAW_COMMAND_SPRITE_BATCH: lovrSpriteBatchDraw(OBJECT(c, SpriteBatch), c->transform); break;
+    case DRAW_COMMAND_PARTICLE_SYSTEM: lovrParticleSystemDraw(OBJECT(c, ParticleSystem), c->transform); break;
+    case DRAW_COMMAND_DRAW_LIST: lovrDrawListDraw(OBJECT(c, DrawList), c->transform); break;
+  }
+}
@@ -0,0 +1,73 @@
+#include "math/math.h"
+#include "util.h"
+
+#pragma once
+
+typedef enum {
+  DRAW_COMMAND_COLOR,
+  DRAW_COMMAND_BLEND_MODE,
+  DRAW_COMMAND_CULLING,
+  DRAW_COMMAND_DEPTH_TEST,
+  DRAW_COMMAND_FONT,
+  DRAW_COMMAND_LINE_WIDTH,
+  DRAW_COMMAND_POINT_SIZE,
+  DRAW_COMMAND_SHADER,
+  DRAW_COMMAND_WINDING,
+  DRAW_COMMAND_WIREFRAME,
+  DRAW_COMMAND_PUSH,
+  DRAW_COMMAND_POP,
+  DRAW_COMMAND_ORIGIN,
+  DRAW_COMMAND_TRANSLATE,
+  DRAW_COMMAND_ROTATE,
+  DRAW_COMMAND_SCALE,
+  DRAW_COMMAND_TRANSFORM,
+  DRAW_COMMAND_POINTS,
+  DRAW_COMMAND_LINE,
+  DRAW_COMMAND_TRIANGLE,
+  DRAW_COMMAND_PLANE,
+  DRAW_COMMAND_PLANE_FULLSCREEN,
+  DRAW_COMMAND_BOX,
+  DRAW_COMMAND_CYLINDER,
+  DRAW_COMMAND_SPHERE,
+  DRAW_COMMAND_SKYBOX,
+  DRAW_COMMAND_PRINT,
+  DRAW_COMMAND_MESH,
+  DRAW_COMMAND_MODEL,
+  DRAW_COMMAND_SPRITE_BATCH,
+  DRAW_COMMAND_PARTICLE_SYSTEM,
+  DRAW_COMMAND_DRAW_LIST
+} DrawCommandType;
+
+// Generic storage for the arguments of any recorded call.  object is retained by the list, data
+// (point coordinates or a string) is copied into memory owned by the list.
+typedef struct {
+  DrawCommandType type;
+  int mode;
+  int mode2;
+  Color color;
+  float params[10];
+  float transform[16];
+  Ref* object;
+  void* data;
+  int count;
+} DrawCommand;
+
+// Commands are stored packed, see lovrDrawCommandPack
+typedef struct {
+  Ref ref;
+  vec_char_t commands;
+  int commandCount;
+} DrawList;
+
+DrawList* lovrDrawListCreate();
+void lovrDrawListDestroy(const Ref* ref);
+void lovrDrawListRecord(DrawList* drawList, DrawCommand* command);
+void lovrDrawListClear(DrawList* drawList);
+void lovrDrawListDraw(DrawList* drawList, mat4 transform);
+int lovrDrawListGetCommandCount(DrawList* drawList);
+
+void lovrDrawCommandPack(vec_char_t* stream, DrawCommand* command);
+void lovrDrawCommandUnpack(vec_char_t* stream, size_t* offset, DrawCommand* command);
+void lovrDrawCommandReleaseAll(vec_char_t* stream);
+int lovrDrawCommandIsDraw(DrawCommand* command);
+void lovrDrawCommandExecute(DrawCommand* command);
@@ -49,7 +49,8 @@ Font* lovrFontCreate(FontData* fontData) {
   // Texture
   TextureData* textureData = lovrTextureDataGetBlank(font->atlas.width, font->atlas.height, 0x0, FORMAT_RGB);
   TextureFilter filter = { .mode = FILTER_BILINEAR };
-  font->texture = lovrTextureCreate(textureData);
+  font->texture = lovrTextureCreate(textureData, 0);
+  lovrTextureReleaseData(font->texture);
   lovrTextureSetFilter(font->texture, filter);
   lovrTextureSetWrap(font->texture, WRAP_CLAMP, WRAP_CLAMP);
 
@@ -202,6 +203,7 @@ float lovrFontGetLineHeight(Font* font) {
 }
 
 void lovrFontSetLineHeight(Font* font, float lineHeight) {
+  lovrGraphicsFlushObject(&font->ref);
   font->lineHeight = lineHeight;
 }
 
@@ -224,6 +226,7 @@ float lovrFontGetPixelDensity(Font* font) {
 }
 
 void lovrFontSetPixelDensity(Font* font, float pixelDensity) {
+  lovrGraphicsFlushObject(&font->ref);
   if (pixelDensity <= 0) {
     pixelDensity = font->fontData->height;
   }
@@ -298,9 +301,10 @@ void lovrFontExpandTexture(Font* font) {
     return;
   }
 
-  // Resize the texture storage
-  lovrTextureDataResize(font->texture->textureData, atlas->width, atlas->height, 0x0);
-  lovrTextureRefresh(font->texture);
+  // Resize the texture storage.  Glyphs only ever live on the GPU, so a blank image is uploaded and
+  // then released instead of keeping an empty copy of the atlas around.
+  TextureData* textureData = lovrTextureDataGetBlank(atlas->width, atlas->height, 0x0, FORMAT_RGB);
+  lovrTextureReplaceData(font->texture, textureData);
 
   // Reset the cursor
   atlas->x = atlas->padding;
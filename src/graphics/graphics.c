@@ -1,4 +1,9 @@
 #include "graphics/graphics.h"
+#include "graphics/mesh.h"
+#include "graphics/model.h"
+#include "graphics/particleSystem.h"
+#include "graphics/spriteBatch.h"
+#include "graphics/textureArray.h"
 #include "loaders/texture.h"
 #include "loaders/font.h"
 #include "event/event.h"
@@ -14,6 +19,12 @@
 
 static GraphicsState state;
 
+static void lovrGraphicsSaveDrawState(DrawState* drawState);
+static void lovrGraphicsRestoreDrawState(DrawState* drawState);
+static void lovrGraphicsReleaseDrawState(DrawState* drawState);
+static void lovrGraphicsEnqueue(DrawCommand* command);
+static void lovrGraphicsClearQueue();
+
 static void onCloseWindow(GLFWwindow* window) {
   if (window == state.window) {
     EventType type = EVENT_QUIT;
@@ -30,6 +41,14 @@ void lovrGraphicsInit() {
 }
 
 void lovrGraphicsDestroy() {
+  lovrGraphicsEndDrawList();
+  lovrGraphicsClearQueue();
+  vec_deinit(&state.queue);
+  vec_deinit(&state.queueCommands);
+  vec_deinit(&state.queueStates);
+  vec_deinit(&state.queueTransforms);
+  free(state.queueKeys);
+  free(state.queueScratch);
   lovrGraphicsSetShader(NULL);
   lovrGraphicsSetFont(NULL);
   for (int i = 0; i < DEFAULT_SHADER_COUNT; i++) {
@@ -37,11 +56,19 @@ void lovrGraphicsDestroy() {
   }
   if (state.defaultFont) lovrRelease(&state.defaultFont->ref);
   if (state.defaultTexture) lovrRelease(&state.defaultTexture->ref);
+  glDeleteBuffers(1, &state.defaultPoseBuffer);
+  glDeleteBuffers(1, &state.defaultMaterialBuffer);
   glDeleteVertexArrays(1, &state.streamVAO);
   glDeleteBuffers(1, &state.streamVBO);
   glDeleteBuffers(1, &state.streamIBO);
   vec_deinit(&state.streamData);
   vec_deinit(&state.streamIndices);
+  Texture* texture; int i;
+  vec_foreach(&state.streamingTextures, texture, i) {
+    lovrRelease(&texture->ref);
+  }
+  vec_deinit(&state.streamingTextures);
+  lovrMeshDestroyShared();
 }
 
 void lovrGraphicsReset() {
@@ -61,6 +88,8 @@ void lovrGraphicsReset() {
   lovrGraphicsSetLineWidth(1);
   lovrGraphicsSetPointSize(1);
   lovrGraphicsSetShader(NULL);
+  lovrGraphicsSetTextureStreamBudget(DEFAULT_TEXTURE_STREAM_BUDGET);
+  lovrGraphicsSetKeepData(1);
   lovrGraphicsSetWinding(WINDING_COUNTERCLOCKWISE);
   lovrGraphicsSetWireframe(0);
   lovrGraphicsSetViewport(0, 0, w, h);
@@ -70,11 +99,29 @@ void lovrGraphicsReset() {
 
 void lovrGraphicsClear(int color, int depth) {
   if (!color && !depth) return;
+  lovrGraphicsFlush();
   glClear((color ? GL_COLOR_BUFFER_BIT : 0) | (depth ? GL_DEPTH_BUFFER_BIT : 0));
 }
 
 void lovrGraphicsPresent() {
+  lovrGraphicsFlush();
   glfwSwapBuffers(state.window);
+
+  // Upload finer mipmap levels of streaming textures, up to the per-frame budget
+  size_t budget = state.textureStreamBudget;
+  int i = 0;
+  while (i < state.streamingTextures.length && budget > 0) {
+    Texture* texture = state.streamingTextures.data[i];
+    size_t bytes = lovrTextureStream(texture, budget);
+    budget -= MIN(budget, bytes);
+
+    if (lovrTextureIsStreaming(texture)) {
+      i++;
+    } else {
+      vec_splice(&state.streamingTextures, i, 1);
+      lovrRelease(&texture->ref);
+    }
+  }
 }
 
 void lovrGraphicsPrepare() {
@@ -84,6 +131,14 @@ void lovrGraphicsPrepare() {
     shader = state.defaultShaders[state.defaultShader] = lovrShaderCreateDefault(state.defaultShader);
   }
 
+  if (!state.poseBuffer) {
+    lovrGraphicsBindPose(0, 0);
+  }
+
+  if (!state.materialBuffer) {
+    lovrGraphicsBindMaterial(NULL, 0, 0);
+  }
+
   mat4 model = state.transforms[state.transform][MATRIX_MODEL];
   mat4 view = state.transforms[state.transform][MATRIX_VIEW];
   mat4 projection = state.canvases[state.canvas].projection;
@@ -141,11 +196,14 @@ void lovrGraphicsCreateWindow(int w, int h, int fullscreen, int msaa, const char
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glVertexAttrib4f(LOVR_SHADER_VERTEX_COLOR, 1., 1., 1., 1.);
+  glVertexAttrib4f(LOVR_SHADER_BONE_WEIGHTS, 0., 0., 0., 0.);
   glGenVertexArrays(1, &state.streamVAO);
   glGenBuffers(1, &state.streamVBO);
   glGenBuffers(1, &state.streamIBO);
   vec_init(&state.streamData);
   vec_init(&state.streamIndices);
+  vec_init(&state.streamingTextures);
   lovrGraphicsReset();
   atexit(lovrGraphicsDestroy);
 }
@@ -179,6 +237,9 @@ void lovrGraphicsGetBlendMode(BlendMode* mode, BlendAlphaMode* alphaMode) {
 }
 
 void lovrGraphicsSetBlendMode(BlendMode mode, BlendAlphaMode alphaMode) {
+  DrawCommand command = { .type = DRAW_COMMAND_BLEND_MODE, .mode = mode, .mode2 = alphaMode };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   GLenum srcRGB = mode == BLEND_MULTIPLY ? GL_DST_COLOR : GL_ONE;
 
   if (srcRGB == GL_ONE && alphaMode == BLEND_ALPHA_MULTIPLY) {
@@ -226,6 +287,9 @@ void lovrGraphicsSetBlendMode(BlendMode mode, BlendAlphaMode alphaMode) {
       glBlendFuncSeparate(srcRGB, GL_ZERO, GL_ONE, GL_ZERO);
       break;
   }
+
+  state.blendMode = mode;
+  state.blendAlphaMode = alphaMode;
 }
 
 Color lovrGraphicsGetColor() {
@@ -233,6 +297,9 @@ Color lovrGraphicsGetColor() {
 }
 
 void lovrGraphicsSetColor(Color color) {
+  DrawCommand command = { .type = DRAW_COMMAND_COLOR, .color = color };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   state.color = color;
 }
 
@@ -241,6 +308,9 @@ int lovrGraphicsIsCullingEnabled() {
 }
 
 void lovrGraphicsSetCullingEnabled(int culling) {
+  DrawCommand command = { .type = DRAW_COMMAND_CULLING, .mode = culling };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   if (culling != state.culling) {
     state.culling = culling;
     if (culling) {
@@ -264,6 +334,9 @@ CompareMode lovrGraphicsGetDepthTest() {
 }
 
 void lovrGraphicsSetDepthTest(CompareMode depthTest) {
+  DrawCommand command = { .type = DRAW_COMMAND_DEPTH_TEST, .mode = depthTest };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   if (state.depthTest != depthTest) {
     state.depthTest = depthTest;
     glDepthFunc(depthTest);
@@ -282,13 +355,17 @@ Font* lovrGraphicsGetFont() {
       state.defaultFont = lovrFontCreate(fontData);
     }
 
-    lovrGraphicsSetFont(state.defaultFont);
+    state.font = state.defaultFont;
+    lovrRetain(&state.font->ref);
   }
 
   return state.font;
 }
 
 void lovrGraphicsSetFont(Font* font) {
+  DrawCommand command = { .type = DRAW_COMMAND_FONT, .object = font ? &font->ref : NULL };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   if (state.font) {
     lovrRelease(&state.font->ref);
   }
@@ -321,6 +398,9 @@ float lovrGraphicsGetLineWidth() {
 }
 
 void lovrGraphicsSetLineWidth(float width) {
+  DrawCommand command = { .type = DRAW_COMMAND_LINE_WIDTH, .params = { width } };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   state.lineWidth = width;
   glLineWidth(width);
 }
@@ -330,6 +410,9 @@ float lovrGraphicsGetPointSize() {
 }
 
 void lovrGraphicsSetPointSize(float size) {
+  DrawCommand command = { .type = DRAW_COMMAND_POINT_SIZE, .params = { size } };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
 #ifndef EMSCRIPTEN
   state.pointSize = size;
   glPointSize(size);
@@ -341,6 +424,9 @@ Shader* lovrGraphicsGetShader() {
 }
 
 void lovrGraphicsSetShader(Shader* shader) {
+  DrawCommand command = { .type = DRAW_COMMAND_SHADER, .object = shader ? &shader->ref : NULL };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   if (shader != state.shader) {
     if (state.shader) {
       lovrRelease(&state.shader->ref);
@@ -354,11 +440,30 @@ void lovrGraphicsSetShader(Shader* shader) {
   }
 }
 
+size_t lovrGraphicsGetTextureStreamBudget() {
+  return state.textureStreamBudget;
+}
+
+void lovrGraphicsSetTextureStreamBudget(size_t budget) {
+  state.textureStreamBudget = budget;
+}
+
+int lovrGraphicsGetKeepData() {
+  return state.keepData;
+}
+
+void lovrGraphicsSetKeepData(int keepData) {
+  state.keepData = keepData;
+}
+
 Winding lovrGraphicsGetWinding() {
   return state.winding;
 }
 
 void lovrGraphicsSetWinding(Winding winding) {
+  DrawCommand command = { .type = DRAW_COMMAND_WINDING, .mode = winding };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   state.winding = winding;
   glFrontFace(winding);
 }
@@ -368,6 +473,9 @@ int lovrGraphicsIsWireframe() {
 }
 
 void lovrGraphicsSetWireframe(int wireframe) {
+  DrawCommand command = { .type = DRAW_COMMAND_WIREFRAME, .mode = wireframe };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
 #ifndef EMSCRIPTEN
   if (state.wireframe != wireframe) {
     state.wireframe = wireframe;
@@ -379,6 +487,9 @@ void lovrGraphicsSetWireframe(int wireframe) {
 // Transforms
 
 void lovrGraphicsPush() {
+  DrawCommand command = { .type = DRAW_COMMAND_PUSH };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   if (++state.transform >= MAX_TRANSFORMS) {
     lovrThrow("Unbalanced matrix stack (more pushes than pops?)");
   }
@@ -387,29 +498,47 @@ void lovrGraphicsPush() {
 }
 
 void lovrGraphicsPop() {
+  DrawCommand command = { .type = DRAW_COMMAND_POP };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   if (--state.transform < 0) {
     lovrThrow("Unbalanced matrix stack (more pops than pushes?)");
   }
 }
 
 void lovrGraphicsOrigin() {
+  DrawCommand command = { .type = DRAW_COMMAND_ORIGIN };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   mat4_identity(state.transforms[state.transform][MATRIX_MODEL]);
   mat4_identity(state.transforms[state.transform][MATRIX_VIEW]);
 }
 
 void lovrGraphicsTranslate(MatrixType type, float x, float y, float z) {
+  DrawCommand command = { .type = DRAW_COMMAND_TRANSLATE, .mode = type, .params = { x, y, z } };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   mat4_translate(state.transforms[state.transform][type], x, y, z);
 }
 
 void lovrGraphicsRotate(MatrixType type, float angle, float ax, float ay, float az) {
+  DrawCommand command = { .type = DRAW_COMMAND_ROTATE, .mode = type, .params = { angle, ax, ay, az } };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   mat4_rotate(state.transforms[state.transform][type], angle, ax, ay, az);
 }
 
 void lovrGraphicsScale(MatrixType type, float x, float y, float z) {
+  DrawCommand command = { .type = DRAW_COMMAND_SCALE, .mode = type, .params = { x, y, z } };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   mat4_scale(state.transforms[state.transform][type], x, y, z);
 }
 
 void lovrGraphicsMatrixTransform(MatrixType type, mat4 transform) {
+  DrawCommand command = { .type = DRAW_COMMAND_TRANSFORM, .mode = type };
+  if (lovrGraphicsRecord(&command, transform)) return;
+
   mat4_multiply(state.transforms[state.transform][type], transform);
 }
 
@@ -432,6 +561,7 @@ static void lovrGraphicsDrawPrimitive(GLenum mode, int hasNormals, int hasTexCoo
   unsigned int* indices = state.streamIndices.data;
 
   lovrGraphicsPrepare();
+  lovrGraphicsSetVertexColorArray(0);
   lovrGraphicsBindVertexArray(state.streamVAO);
   lovrGraphicsBindVertexBuffer(state.streamVBO);
   glBufferData(GL_ARRAY_BUFFER, state.streamData.length * sizeof(float), data, GL_STREAM_DRAW);
@@ -463,6 +593,9 @@ static void lovrGraphicsDrawPrimitive(GLenum mode, int hasNormals, int hasTexCoo
 }
 
 void lovrGraphicsPoints(float* points, int count) {
+  DrawCommand command = { .type = DRAW_COMMAND_POINTS, .data = points, .count = count };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   lovrGraphicsBindTexture(NULL);
   lovrGraphicsSetDefaultShader(SHADER_DEFAULT);
   lovrGraphicsSetShapeData(points, count);
@@ -470,6 +603,9 @@ void lovrGraphicsPoints(float* points, int count) {
 }
 
 void lovrGraphicsLine(float* points, int count) {
+  DrawCommand command = { .type = DRAW_COMMAND_LINE, .data = points, .count = count };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   lovrGraphicsBindTexture(NULL);
   lovrGraphicsSetDefaultShader(SHADER_DEFAULT);
   lovrGraphicsSetShapeData(points, count);
@@ -477,6 +613,10 @@ void lovrGraphicsLine(float* points, int count) {
 }
 
 void lovrGraphicsTriangle(DrawMode mode, float* points) {
+  DrawCommand command = { .type = DRAW_COMMAND_TRIANGLE, .mode = mode };
+  memcpy(command.params, points, 9 * sizeof(float));
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   lovrGraphicsBindTexture(NULL);
   lovrGraphicsSetDefaultShader(SHADER_DEFAULT);
 
@@ -499,6 +639,9 @@ void lovrGraphicsTriangle(DrawMode mode, float* points) {
 }
 
 void lovrGraphicsPlane(DrawMode mode, Texture* texture, mat4 transform) {
+  DrawCommand command = { .type = DRAW_COMMAND_PLANE, .mode = mode, .object = texture ? &texture->ref : NULL };
+  if (lovrGraphicsRecord(&command, transform)) return;
+
   lovrGraphicsPush();
   lovrGraphicsMatrixTransform(MATRIX_MODEL, transform);
 
@@ -532,6 +675,9 @@ void lovrGraphicsPlane(DrawMode mode, Texture* texture, mat4 transform) {
 }
 
 void lovrGraphicsPlaneFullscreen(Texture* texture) {
+  DrawCommand command = { .type = DRAW_COMMAND_PLANE_FULLSCREEN, .object = texture ? &texture->ref : NULL };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   float data[] = {
     -1, 1, 0,  0, 1,
     -1, -1, 0, 0, 0,
@@ -546,6 +692,9 @@ void lovrGraphicsPlaneFullscreen(Texture* texture) {
 }
 
 void lovrGraphicsBox(DrawMode mode, Texture* texture, mat4 transform) {
+  DrawCommand command = { .type = DRAW_COMMAND_BOX, .mode = mode, .object = texture ? &texture->ref : NULL };
+  if (lovrGraphicsRecord(&command, transform)) return;
+
   lovrGraphicsSetDefaultShader(SHADER_DEFAULT);
   lovrGraphicsPush();
   lovrGraphicsMatrixTransform(MATRIX_MODEL, transform);
@@ -629,6 +778,14 @@ void lovrGraphicsBox(DrawMode mode, Texture* texture, mat4 transform) {
 }
 
 void lovrGraphicsCylinder(float x1, float y1, float z1, float x2, float y2, float z2, float r1, float r2, int capped, int segments) {
+  DrawCommand command = {
+    .type = DRAW_COMMAND_CYLINDER,
+    .mode = capped,
+    .mode2 = segments,
+    .params = { x1, y1, z1, x2, y2, z2, r1, r2 }
+  };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   float axis[3] = { x1 - x2, y1 - y2, z1 - z2 };
   float n[3] = { x1 - x2, y1 - y2, z1 - z2 };
   float p[3];
@@ -735,6 +892,9 @@ void lovrGraphicsCylinder(float x1, float y1, float z1, float x2, float y2, floa
 }
 
 void lovrGraphicsSphere(Texture* texture, mat4 transform, int segments, Skybox* skybox) {
+  DrawCommand command = { .type = DRAW_COMMAND_SPHERE, .mode = segments, .object = texture ? &texture->ref : NULL };
+  if (lovrGraphicsRecord(&command, transform)) return;
+
   vec_clear(&state.streamData);
   vec_clear(&state.streamIndices);
 
@@ -794,6 +954,9 @@ void lovrGraphicsSphere(Texture* texture, mat4 transform, int segments, Skybox*
 }
 
 void lovrGraphicsSkybox(Skybox* skybox, float angle, float ax, float ay, float az) {
+  DrawCommand command = { .type = DRAW_COMMAND_SKYBOX, .object = &skybox->ref, .params = { angle, ax, ay, az } };
+  if (lovrGraphicsRecord(&command, NULL)) return;
+
   lovrGraphicsPush();
   lovrGraphicsOrigin();
   lovrGraphicsRotate(MATRIX_MODEL, angle, ax, ay, az);
@@ -861,6 +1024,9 @@ void lovrGraphicsSkybox(Skybox* skybox, float angle, float ax, float ay, float a
 }
 
 void lovrGraphicsPrint(const char* str, mat4 transform, float wrap, HorizontalAlign halign, VerticalAlign valign) {
+  DrawCommand command = { .type = DRAW_COMMAND_PRINT, .mode = halign, .mode2 = valign, .data = (void*) str, .params = { wrap } };
+  if (lovrGraphicsRecord(&command, transform)) return;
+
   Font* font = lovrGraphicsGetFont();
   float scale = 1 / font->pixelDensity;
   float offsety;
@@ -876,8 +1042,378 @@ void lovrGraphicsPrint(const char* str, mat4 transform, float wrap, HorizontalAl
   lovrGraphicsPop();
 }
 
+// Recording
+
+DrawList* lovrGraphicsGetDrawList() {
+  return state.drawList;
+}
+
+// While recording, state changes are applied as well as recorded, so the getters report the state
+// the list will have at that point when it's drawn with the current state.  Everything is put back
+// when recording ends.
+void lovrGraphicsBeginDrawList(DrawList* drawList) {
+  lovrAssert(!state.drawList, "Already recording a DrawList");
+  lovrDrawListClear(drawList);
+  lovrRetain(&drawList->ref);
+  lovrGraphicsSaveDrawState(&state.recordState);
+  memcpy(state.recordTransforms, state.transforms, sizeof(state.transforms));
+  state.recordTransform = state.transform;
+  state.drawList = drawList;
+}
+
+void lovrGraphicsEndDrawList() {
+  if (state.drawList) {
+    lovrRelease(&state.drawList->ref);
+    state.drawList = NULL;
+    lovrGraphicsRestoreDrawState(&state.recordState);
+    lovrGraphicsReleaseDrawState(&state.recordState);
+    memcpy(state.transforms, state.recordTransforms, sizeof(state.transforms));
+    state.transform = state.recordTransform;
+  }
+}
+
+// Returns 1 if the command was captured by the active DrawList or the queue and should not be
+// executed.  State changes recorded into a DrawList are executed too, see lovrGraphicsBeginDrawList.
+int lovrGraphicsRecord(DrawCommand* command, mat4 transform) {
+  int queue = state.queueEnabled && lovrDrawCommandIsDraw(command);
+  if (state.flushing || (!state.drawList && !queue)) {
+    return 0;
+  }
+
+  if (transform) {
+    mat4_set(command->transform, transform);
+  } else {
+    mat4_identity(command->transform);
+  }
+
+  if (state.drawList) {
+    lovrDrawListRecord(state.drawList, command);
+    return lovrDrawCommandIsDraw(command) || command->type == DRAW_COMMAND_DRAW_LIST;
+  }
+
+  lovrGraphicsEnqueue(command);
+  return 1;
+}
+
+// Queue
+
+// One bit per object, set when a queued draw uses it, so objects that aren't queued are found quickly
+static uint64_t lovrGraphicsGetObjectBit(Ref* object) {
+  return 1ull << (((uintptr_t) object >> 4) & 63);
+}
+
+static void lovrGraphicsSaveDrawState(DrawState* drawState) {
+  memset(drawState, 0, sizeof(DrawState));
+  drawState->color = state.color;
+  drawState->blendMode = state.blendMode;
+  drawState->blendAlphaMode = state.blendAlphaMode;
+  drawState->culling = state.culling;
+  drawState->depthTest = state.depthTest;
+  drawState->font = state.font;
+  drawState->lineWidth = state.lineWidth;
+  drawState->pointSize = state.pointSize;
+  drawState->shader = state.shader;
+  drawState->winding = state.winding;
+  drawState->wireframe = state.wireframe;
+  if (drawState->font) lovrRetain(&drawState->font->ref);
+  if (drawState->shader) lovrRetain(&drawState->shader->ref);
+}
+
+static void lovrGraphicsRestoreDrawState(DrawState* drawState) {
+  lovrGraphicsSetColor(drawState->color);
+  if (drawState->blendMode != state.blendMode || drawState->blendAlphaMode != state.blendAlphaMode) {
+    lovrGraphicsSetBlendMode(drawState->blendMode, drawState->blendAlphaMode);
+  }
+  lovrGraphicsSetCullingEnabled(drawState->culling);
+  lovrGraphicsSetDepthTest(drawState->depthTest);
+  if (drawState->font != state.font) {
+    lovrGraphicsSetFont(drawState->font);
+  }
+  if (drawState->lineWidth != state.lineWidth) {
+    lovrGraphicsSetLineWidth(drawState->lineWidth);
+  }
+  if (drawState->pointSize != state.pointSize) {
+    lovrGraphicsSetPointSize(drawState->pointSize);
+  }
+  lovrGraphicsSetShader(drawState->shader);
+  if (drawState->winding != state.winding) {
+    lovrGraphicsSetWinding(drawState->winding);
+  }
+  lovrGraphicsSetWireframe(drawState->wireframe);
+}
+
+static void lovrGraphicsReleaseDrawState(DrawState* drawState) {
+  if (drawState->font) lovrRelease(&drawState->font->ref);
+  if (drawState->shader) lovrRelease(&drawState->shader->ref);
+}
+
+static uint32_t lovrGraphicsGetDrawTexture(DrawCommand* command, DrawState* drawState) {
+  Texture* texture = NULL;
+  if (!command->object) {
+    return 0;
+  }
+
+  switch (command->type) {
+    case DRAW_COMMAND_PLANE:
+    case DRAW_COMMAND_BOX:
+    case DRAW_COMMAND_SPHERE:
+      texture = containerof(command->object, Texture);
+      break;
+    case DRAW_COMMAND_PRINT: texture = drawState->font ? drawState->font->texture : NULL; break;
+    case DRAW_COMMAND_MESH: texture = containerof(command->object, Mesh)->texture; break;
+    case DRAW_COMMAND_MODEL: texture = containerof(command->object, Model)->texture; break;
+    case DRAW_COMMAND_SPRITE_BATCH: texture = containerof(command->object, SpriteBatch)->mesh->texture; break;
+    case DRAW_COMMAND_PARTICLE_SYSTEM: texture = containerof(command->object, ParticleSystem)->texture; break;
+    default: break;
+  }
+
+  return texture ? texture->id : 0;
+}
+
+static QueuePass lovrGraphicsGetQueuePass(DrawCommand* command, DrawState* drawState) {
+  if (command->type == DRAW_COMMAND_SKYBOX || command->type == DRAW_COMMAND_PLANE_FULLSCREEN) {
+    return QUEUE_PASS_BACKGROUND;
+  } else if (drawState->depthTest == COMPARE_NONE) {
+    return QUEUE_PASS_UNSORTED;
+  } else if (
+    drawState->color.a < 255 ||
+    (drawState->blendMode != BLEND_ALPHA && drawState->blendMode != BLEND_REPLACE) ||
+    command->type == DRAW_COMMAND_PRINT ||
+    command->type == DRAW_COMMAND_SPRITE_BATCH ||
+    command->type == DRAW_COMMAND_PARTICLE_SYSTEM) {
+    return QUEUE_PASS_TRANSPARENT;
+  } else {
+    return QUEUE_PASS_OPAQUE;
+  }
+}
+
+// Sort keys, from the most significant bit:
+//   opaque:      pass (2) | shader (12) | texture (12) | depth, front to back (24) | 0 (14)
+//   transparent: pass (2) | depth, back to front (24) | shader (12) | texture (12) | 0 (14)
+//   otherwise:   pass (2) | 0 (30) | submission order (32)
+// Opaque draws are grouped by state to minimize binds, and drawn near to far to reduce overdraw.
+static uint64_t lovrGraphicsGetSortKey(DrawCommand* command, DrawState* drawState, QueuePass pass, uint32_t order) {
+  uint64_t key = (uint64_t) pass << 62;
+  if (pass == QUEUE_PASS_BACKGROUND || pass == QUEUE_PASS_UNSORTED) {
+    return key | order;
+  }
+
+  // View space distance of the draw's origin.  Non-negative floats sort the same as their bits.
+  float transform[16];
+  mat4_set(transform, state.transforms[state.transform][MATRIX_VIEW]);
+  mat4_multiply(transform, state.transforms[state.transform][MATRIX_MODEL]);
+  mat4_multiply(transform, command->transform);
+  union { float f; uint32_t u; } distance = { .f = MAX(-transform[14], 0.f) };
+  uint64_t depth = distance.u >> 8;
+
+  uint64_t shader = (drawState->shader ? drawState->shader->id : 0) & 0xfff;
+  uint64_t texture = lovrGraphicsGetDrawTexture(command, drawState) & 0xfff;
+
+  if (pass == QUEUE_PASS_OPAQUE) {
+    return key | (shader << 50) | (texture << 38) | (depth << 14);
+  } else {
+    return key | ((~depth & 0xffffff) << 38) | (shader << 26) | (texture << 14);
+  }
+}
+
+// Background draws cover everything drawn before them, so they're a barrier: the draws queued before
+// one are flushed first, and it's drawn before the ones that come after it.
+static void lovrGraphicsEnqueue(DrawCommand* command) {
+  DrawState drawState;
+  lovrGraphicsSaveDrawState(&drawState);
+  QueuePass pass = lovrGraphicsGetQueuePass(command, &drawState);
+  if (pass == QUEUE_PASS_BACKGROUND) {
+    lovrGraphicsFlush();
+  }
+
+  int count = state.queue.length;
+  if (count >= state.queueCapacity) {
+    state.queueCapacity = MAX(64, 2 * state.queueCapacity);
+    state.queueKeys = realloc(state.queueKeys, state.queueCapacity * sizeof(DrawKey));
+    state.queueScratch = realloc(state.queueScratch, state.queueCapacity * sizeof(DrawKey));
+    lovrAssert(state.queueKeys && state.queueScratch, "Out of memory");
+  }
+
+  state.queueKeys[count].key = lovrGraphicsGetSortKey(command, &drawState, pass, count);
+  state.queueKeys[count].index = count;
+
+  DrawState* lastState = state.queueStates.length > 0 ? &vec_last(&state.queueStates) : NULL;
+  if (lastState && !memcmp(lastState, &drawState, sizeof(DrawState))) {
+    lovrGraphicsReleaseDrawState(&drawState);
+  } else {
+    vec_push(&state.queueStates, drawState);
+  }
+
+  float* transforms = &state.transforms[state.transform][0][0];
+  int transformCount = state.queueTransforms.length / 32;
+  float* lastTransforms = transformCount > 0 ? state.queueTransforms.data + 32 * (transformCount - 1) : NULL;
+  if (!lastTransforms || memcmp(lastTransforms, transforms, 32 * sizeof(float))) {
+    vec_pusharr(&state.queueTransforms, transforms, 32);
+  }
+
+  QueuedDraw draw = {
+    .object = command->object,
+    .type = command->type,
+    .command = state.queueCommands.length,
+    .state = state.queueStates.length - 1,
+    .transform = state.queueTransforms.length / 32 - 1
+  };
+
+  if (command->object) state.queueObjects |= lovrGraphicsGetObjectBit(command->object);
+  if (command->type == DRAW_COMMAND_MODEL) {
+    Model* model = containerof(command->object, Model);
+    for (int i = 0; i < model->materialCount; i++) {
+      state.queueObjects |= lovrGraphicsGetObjectBit(&model->materials[i]->ref);
+    }
+  }
+  if (drawState.font) state.queueObjects |= lovrGraphicsGetObjectBit(&drawState.font->ref);
+  if (drawState.shader) state.queueObjects |= lovrGraphicsGetObjectBit(&drawState.shader->ref);
+  lovrDrawCommandPack(&state.queueCommands, command);
+  vec_push(&state.queue, draw);
+}
+
+// LSD radix sort, one byte at a time.  Bytes that are the same in every key are skipped.
+static DrawKey* lovrGraphicsSortKeys(DrawKey* keys, DrawKey* scratch, int count) {
+  uint32_t histograms[8][256];
+  memset(histograms, 0, sizeof(histograms));
+
+  for (int i = 0; i < count; i++) {
+    for (int b = 0; b < 8; b++) {
+      histograms[b][(keys[i].key >> (8 * b)) & 0xff]++;
+    }
+  }
+
+  for (int b = 0; b < 8; b++) {
+    uint32_t* histogram = histograms[b];
+    int shift = 8 * b;
+
+    if (histogram[(keys[0].key >> shift) & 0xff] == (uint32_t) count) {
+      continue;
+    }
+
+    uint32_t offset = 0;
+    for (int i = 0; i < 256; i++) {
+      uint32_t n = histogram[i];
+      histogram[i] = offset;
+      offset += n;
+    }
+
+    for (int i = 0; i < count; i++) {
+      scratch[histogram[(keys[i].key >> shift) & 0xff]++] = keys[i];
+    }
+
+    DrawKey* temp = keys;
+    keys = scratch;
+    scratch = temp;
+  }
+
+  return keys;
+}
+
+static void lovrGraphicsClearQueue() {
+  DrawState* drawState; int i;
+  vec_foreach_ptr(&state.queueStates, drawState, i) {
+    lovrGraphicsReleaseDrawState(drawState);
+  }
+  lovrDrawCommandReleaseAll(&state.queueCommands);
+  vec_clear(&state.queue);
+  vec_clear(&state.queueCommands);
+  vec_clear(&state.queueStates);
+  vec_clear(&state.queueTransforms);
+  state.queueObjects = 0;
+}
+
+int lovrGraphicsIsQueueEnabled() {
+  return state.queueEnabled;
+}
+
+void lovrGraphicsSetQueueEnabled(int enabled) {
+  if (!enabled) {
+    lovrGraphicsFlush();
+  }
+
+  state.queueEnabled = enabled;
+}
+
+// Sorts and draws everything queued since the last flush.  Called whenever the render target,
+// viewport or projection changes, and before presenting.
+void lovrGraphicsFlush() {
+  int count = state.queue.length;
+  if (state.flushing || count == 0) {
+    return;
+  }
+
+  DrawKey* keys = lovrGraphicsSortKeys(state.queueKeys, state.queueScratch, count);
+
+  DrawState previous;
+  float previousTransforms[2][16];
+  lovrGraphicsSaveDrawState(&previous);
+  memcpy(previousTransforms, state.transforms[state.transform], sizeof(previousTransforms));
+  state.flushing = 1;
+
+  for (int i = 0; i < count; i++) {
+    QueuedDraw* draw = &state.queue.data[keys[i].index];
+    size_t offset = draw->command;
+    DrawCommand command;
+    lovrDrawCommandUnpack(&state.queueCommands, &offset, &command);
+    lovrGraphicsRestoreDrawState(&state.queueStates.data[draw->state]);
+    memcpy(state.transforms[state.transform], state.queueTransforms.data + 32 * draw->transform, sizeof(previousTransforms));
+    lovrDrawCommandExecute(&command);
+  }
+
+  lovrGraphicsRestoreDrawState(&previous);
+  lovrGraphicsReleaseDrawState(&previous);
+  memcpy(state.transforms[state.transform], previousTransforms, sizeof(previousTransforms));
+  state.flushing = 0;
+  lovrGraphicsClearQueue();
+}
+
+// Models are drawn with their materials, the other objects used by draws are their command's object
+static int lovrGraphicsDrawUses(QueuedDraw* draw, Ref* object) {
+  if (draw->object == object) {
+    return 1;
+  }
+
+  if (draw->type == DRAW_COMMAND_MODEL) {
+    Model* model = containerof(draw->object, Model);
+    for (int i = 0; i < model->materialCount; i++) {
+      if (&model->materials[i]->ref == object) {
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+// Queued draws use objects as they are when the queue is flushed, so objects flush the draws that use
+// them before they change.  Textures can be used indirectly by many objects, so they flush the whole
+// queue instead.
+void lovrGraphicsFlushObject(Ref* object) {
+  if (state.flushing || !(state.queueObjects & lovrGraphicsGetObjectBit(object))) {
+    return;
+  }
+
+  DrawState* drawState; int i;
+  vec_foreach_ptr(&state.queueStates, drawState, i) {
+    if ((drawState->font && &drawState->font->ref == object) || (drawState->shader && &drawState->shader->ref == object)) {
+      lovrGraphicsFlush();
+      return;
+    }
+  }
+
+  QueuedDraw* draw;
+  vec_foreach_ptr(&state.queue, draw, i) {
+    if (lovrGraphicsDrawUses(draw, object)) {
+      lovrGraphicsFlush();
+      return;
+    }
+  }
+}
+
 // Internal State
 void lovrGraphicsPushCanvas() {
+  lovrGraphicsFlush();
   if (++state.canvas >= MAX_CANVASES) {
     lovrThrow("Canvas overflow");
   }
@@ -886,6 +1422,7 @@ void lovrGraphicsPushCanvas() {
 }
 
 void lovrGraphicsPopCanvas() {
+  lovrGraphicsFlush();
   if (--state.canvas < 0) {
     lovrThrow("Canvas underflow");
   }
@@ -899,11 +1436,17 @@ mat4 lovrGraphicsGetProjection() {
   return state.canvases[state.canvas].projection;
 }
 
+mat4 lovrGraphicsGetTransform(MatrixType type) {
+  return state.transforms[state.transform][type];
+}
+
 void lovrGraphicsSetProjection(mat4 projection) {
+  lovrGraphicsFlush();
   memcpy(state.canvases[state.canvas].projection, projection, 16 * sizeof(float));
 }
 
 void lovrGraphicsSetViewport(int x, int y, int w, int h) {
+  lovrGraphicsFlush();
   state.canvases[state.canvas].viewport[0] = x;
   state.canvases[state.canvas].viewport[1] = y;
   state.canvases[state.canvas].viewport[2] = w;
@@ -912,6 +1455,7 @@ void lovrGraphicsSetViewport(int x, int y, int w, int h) {
 }
 
 void lovrGraphicsBindFramebuffer(int framebuffer) {
+  lovrGraphicsFlush();
   state.canvases[state.canvas].framebuffer = framebuffer;
   glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 }
@@ -920,13 +1464,18 @@ Texture* lovrGraphicsGetTexture() {
   return state.texture;
 }
 
+// Texture units without a texture use a white pixel
+static Texture* lovrGraphicsGetDefaultTexture() {
+  if (!state.defaultTexture) {
+    state.defaultTexture = lovrTextureCreate(lovrTextureDataGetBlank(1, 1, 0xff, FORMAT_RGBA), 0);
+  }
+
+  return state.defaultTexture;
+}
+
 void lovrGraphicsBindTexture(Texture* texture) {
   if (!texture) {
-    if (!state.defaultTexture) {
-      state.defaultTexture = lovrTextureCreate(lovrTextureDataGetBlank(1, 1, 0xff, FORMAT_RGBA));
-    }
-
-    texture = state.defaultTexture;
+    texture = lovrGraphicsGetDefaultTexture();
   }
 
   if (texture != state.texture) {
@@ -935,12 +1484,98 @@ void lovrGraphicsBindTexture(Texture* texture) {
   }
 }
 
+uint32_t lovrGraphicsGetTextureArray() {
+  return state.textureArray;
+}
+
+void lovrGraphicsBindTextureArray(uint32_t textureArray) {
+  if (state.textureArray != textureArray) {
+    state.textureArray = textureArray;
+    glActiveTexture(GL_TEXTURE0 + TEXTURE_ARRAY_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    glActiveTexture(GL_TEXTURE0);
+  }
+}
+
+// Binds the range of a uniform buffer starting at offset, which holds a PoseBlock, to the pose block.
+// Every shader declares the block, so when nothing is skinned it uses one with skinning turned off
+// (0 restores it).
+void lovrGraphicsBindPose(uint32_t buffer, size_t offset) {
+  if (!buffer) {
+    if (!state.defaultPoseBuffer) {
+      PoseBlock block = { .skinned = 0 };
+      for (int i = 0; i < LOVR_MAX_BONES; i++) {
+        mat4_identity(block.bones[i]);
+      }
+
+      glGenBuffers(1, &state.defaultPoseBuffer);
+      glBindBuffer(GL_UNIFORM_BUFFER, state.defaultPoseBuffer);
+      glBufferData(GL_UNIFORM_BUFFER, sizeof(PoseBlock), &block, GL_STATIC_DRAW);
+    }
+
+    buffer = state.defaultPoseBuffer;
+    offset = 0;
+  }
+
+  if (state.poseBuffer != buffer || state.poseOffset != offset) {
+    state.poseBuffer = buffer;
+    state.poseOffset = offset;
+    glBindBufferRange(GL_UNIFORM_BUFFER, LOVR_SHADER_POSE_BLOCK, buffer, offset, sizeof(PoseBlock));
+  }
+}
+
+// Uses a material's emissive texture and shader, and its colors from the range of a uniform buffer
+// starting at offset, which holds a MaterialBlock.  The diffuse texture is bound like any other
+// texture.  A NULL material restores the default one, which is white and doesn't glow.
+void lovrGraphicsBindMaterial(Material* material, uint32_t buffer, size_t offset) {
+  if (!material) {
+    if (!state.defaultMaterialBuffer) {
+      MaterialBlock block = { .colors = { { 1.f, 1.f, 1.f, 1.f }, { 0.f, 0.f, 0.f, 1.f } } };
+      glGenBuffers(1, &state.defaultMaterialBuffer);
+      glBindBuffer(GL_UNIFORM_BUFFER, state.defaultMaterialBuffer);
+      glBufferData(GL_UNIFORM_BUFFER, sizeof(MaterialBlock), &block, GL_STATIC_DRAW);
+    }
+
+    buffer = state.defaultMaterialBuffer;
+    offset = 0;
+  }
+
+  state.material = material;
+
+  if (state.materialBuffer != buffer || state.materialOffset != offset) {
+    state.materialBuffer = buffer;
+    state.materialOffset = offset;
+    glBindBufferRange(GL_UNIFORM_BUFFER, LOVR_SHADER_MATERIAL_BLOCK, buffer, offset, sizeof(MaterialBlock));
+  }
+
+  Texture* emissive = material ? material->textures[TEXTURE_EMISSIVE] : NULL;
+  emissive = emissive ? emissive : lovrGraphicsGetDefaultTexture();
+  if (state.emissiveTexture != emissive->id) {
+    state.emissiveTexture = emissive->id;
+    glActiveTexture(GL_TEXTURE0 + EMISSIVE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, emissive->id);
+    glActiveTexture(GL_TEXTURE0);
+  }
+}
+
+void lovrGraphicsStreamTexture(Texture* texture) {
+  lovrRetain(&texture->ref);
+  vec_push(&state.streamingTextures, texture);
+}
+
 void lovrGraphicsSetDefaultShader(DefaultShader shader) {
   state.defaultShader = shader;
 }
 
+// The shader set by lovrGraphicsSetShader takes precedence over the shader of the bound material
 Shader* lovrGraphicsGetActiveShader() {
-  return state.shader ? state.shader : state.defaultShaders[state.defaultShader];
+  if (state.shader) {
+    return state.shader;
+  } else if (state.material && state.material->shader) {
+    return state.material->shader;
+  } else {
+    return state.defaultShaders[state.defaultShader];
+  }
 }
 
 void lovrGraphicsBindProgram(uint32_t program) {
@@ -954,6 +1589,9 @@ void lovrGraphicsBindVertexArray(uint32_t vertexArray) {
   if (state.vertexArray != vertexArray) {
     state.vertexArray = vertexArray;
     glBindVertexArray(vertexArray);
+
+    // The index buffer binding is part of the vertex array object, so the cached one is stale
+    state.indexBuffer = ~0u;
   }
 }
 
@@ -970,3 +1608,14 @@ void lovrGraphicsBindIndexBuffer(uint32_t indexBuffer) {
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
   }
 }
+
+// The generic vertex color is undefined after drawing with a color array, so it's restored to white
+// before the next draw that doesn't supply its own colors
+void lovrGraphicsSetVertexColorArray(int enabled) {
+  if (enabled) {
+    state.vertexColorArray = 1;
+  } else if (state.vertexColorArray) {
+    state.vertexColorArray = 0;
+    glVertexAttrib4f(LOVR_SHADER_VERTEX_COLOR, 1., 1., 1., 1.);
+  }
+}
@@ -1,4 +1,6 @@
+#include "graphics/drawList.h"
 #include "graphics/font.h"
+#include "graphics/material.h"
 #include "graphics/shader.h"
 #include "graphics/skybox.h"
 #include "graphics/texture.h"
@@ -10,7 +12,8 @@
 #define MAX_CANVASES 4
 #define MAX_TRANSFORMS 60
 #define INTERNAL_TRANSFORMS 4
-#define DEFAULT_SHADER_COUNT 4
+#define DEFAULT_SHADER_COUNT 6
+#define DEFAULT_TEXTURE_STREAM_BUDGET (4 * 1024 * 1024)
 
 typedef enum {
   BLEND_ALPHA,
@@ -67,6 +70,47 @@ typedef enum {
   MATRIX_VIEW
 } MatrixType;
 
+typedef enum {
+  QUEUE_PASS_BACKGROUND,
+  QUEUE_PASS_OPAQUE,
+  QUEUE_PASS_TRANSPARENT,
+  QUEUE_PASS_UNSORTED
+} QueuePass;
+
+typedef struct {
+  Color color;
+  BlendMode blendMode;
+  BlendAlphaMode blendAlphaMode;
+  int culling;
+  CompareMode depthTest;
+  Font* font;
+  float lineWidth;
+  float pointSize;
+  Shader* shader;
+  Winding winding;
+  int wireframe;
+} DrawState;
+
+typedef vec_t(DrawState) vec_drawstate_t;
+
+// A queued draw is the offset of its packed command and indices of its state and transforms, which
+// are shared with the draws queued before it when they haven't changed.  The object and type are
+// kept to find the draws that use an object before it changes.
+typedef struct {
+  Ref* object;
+  DrawCommandType type;
+  uint32_t command;
+  uint32_t state;
+  uint32_t transform;
+} QueuedDraw;
+
+typedef struct {
+  uint64_t key;
+  uint32_t index;
+} DrawKey;
+
+typedef vec_t(QueuedDraw) vec_queueddraw_t;
+
 typedef struct {
   GLFWwindow* window;
   Shader* defaultShaders[DEFAULT_SHADER_COUNT];
@@ -89,18 +133,45 @@ typedef struct {
   Shader* shader;
   Winding winding;
   int wireframe;
+  int keepData;
+  DrawList* drawList;
+  DrawState recordState;
+  float recordTransforms[MAX_TRANSFORMS + INTERNAL_TRANSFORMS][2][16];
+  int recordTransform;
+  int queueEnabled;
+  int flushing;
+  vec_queueddraw_t queue;
+  vec_char_t queueCommands;
+  vec_drawstate_t queueStates;
+  vec_float_t queueTransforms;
+  uint64_t queueObjects;
+  DrawKey* queueKeys;
+  DrawKey* queueScratch;
+  int queueCapacity;
   uint32_t streamVAO;
   uint32_t streamVBO;
   uint32_t streamIBO;
   vec_float_t streamData;
   vec_uint_t streamIndices;
+  vec_void_t streamingTextures;
+  size_t textureStreamBudget;
   CanvasState canvases[MAX_CANVASES];
   int canvas;
   Texture* texture;
+  uint32_t textureArray;
+  uint32_t poseBuffer;
+  size_t poseOffset;
+  uint32_t defaultPoseBuffer;
+  Material* material;
+  uint32_t materialBuffer;
+  size_t materialOffset;
+  uint32_t defaultMaterialBuffer;
+  uint32_t emissiveTexture;
   uint32_t program;
   uint32_t vertexArray;
   uint32_t vertexBuffer;
   uint32_t indexBuffer;
+  int vertexColorArray;
 } GraphicsState;
 
 // Base
@@ -136,6 +207,10 @@ float lovrGraphicsGetPointSize();
 void lovrGraphicsSetPointSize(float size);
 Shader* lovrGraphicsGetShader();
 void lovrGraphicsSetShader(Shader* shader);
+size_t lovrGraphicsGetTextureStreamBudget();
+void lovrGraphicsSetTextureStreamBudget(size_t budget);
+int lovrGraphicsGetKeepData();
+void lovrGraphicsSetKeepData(int keepData);
 Winding lovrGraphicsGetWinding();
 void lovrGraphicsSetWinding(Winding winding);
 int lovrGraphicsIsWireframe();
@@ -162,18 +237,37 @@ void lovrGraphicsSphere(Texture* texture, mat4 transform, int segments, Skybox*
 void lovrGraphicsSkybox(Skybox* skybox, float angle, float ax, float ay, float az);
 void lovrGraphicsPrint(const char* str, mat4 transform, float wrap, HorizontalAlign halign, VerticalAlign valign);
 
+// Recording
+DrawList* lovrGraphicsGetDrawList();
+void lovrGraphicsBeginDrawList(DrawList* drawList);
+void lovrGraphicsEndDrawList();
+int lovrGraphicsRecord(DrawCommand* command, mat4 transform);
+
+// Queue
+int lovrGraphicsIsQueueEnabled();
+void lovrGraphicsSetQueueEnabled(int enabled);
+void lovrGraphicsFlush();
+void lovrGraphicsFlushObject(Ref* object);
+
 // Internal State
 void lovrGraphicsPushCanvas();
 void lovrGraphicsPopCanvas();
 mat4 lovrGraphicsGetProjection();
+mat4 lovrGraphicsGetTransform(MatrixType type);
 void lovrGraphicsSetProjection(mat4 projection);
 void lovrGraphicsSetViewport(int x, int y, int w, int h);
 void lovrGraphicsBindFramebuffer(int framebuffer);
 Texture* lovrGraphicsGetTexture();
 void lovrGraphicsBindTexture(Texture* texture);
+void lovrGraphicsStreamTexture(Texture* texture);
+uint32_t lovrGraphicsGetTextureArray();
+void lovrGraphicsBindTextureArray(uint32_t textureArray);
+void lovrGraphicsBindPose(uint32_t buffer, size_t offset);
+void lovrGraphicsBindMaterial(Material* material, uint32_t buffer, size_t offset);
 void lovrGraphicsSetDefaultShader(DefaultShader defaultShader);
 Shader* lovrGraphicsGetActiveShader();
 void lovrGraphicsBindProgram(uint32_t program);
 void lovrGraphicsBindVertexArray(uint32_t vao);
 void lovrGraphicsBindVertexBuffer(uint32_t vbo);
 void lovrGraphicsBindIndexBuffer(uint32_t ibo);
+void lovrGraphicsSetVertexColorArray(int enabled);
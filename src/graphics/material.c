@@ -0,0 +1,89 @@
+#include "graphics/material.h"
+#include "graphics/graphics.h"
+#include <stdlib.h>
+
+Material* lovrMaterialCreate() {
+  Material* material = lovrAlloc(sizeof(Material), lovrMaterialDestroy);
+  if (!material) return NULL;
+
+  material->colors[COLOR_DIFFUSE] = (Color) { 0xff, 0xff, 0xff, 0xff };
+  material->colors[COLOR_EMISSIVE] = (Color) { 0x00, 0x00, 0x00, 0xff };
+  for (int i = 0; i < MAX_MATERIAL_TEXTURES; i++) {
+    material->textures[i] = NULL;
+  }
+  material->shader = NULL;
+  material->version = 0;
+
+  return material;
+}
+
+void lovrMaterialDestroy(const Ref* ref) {
+  Material* material = containerof(ref, Material);
+  for (int i = 0; i < MAX_MATERIAL_TEXTURES; i++) {
+    if (material->textures[i]) {
+      lovrRelease(&material->textures[i]->ref);
+    }
+  }
+  if (material->shader) {
+    lovrRelease(&material->shader->ref);
+  }
+  free(material);
+}
+
+void lovrMaterialGetBlock(Material* material, MaterialBlock* block) {
+  for (int i = 0; i < MAX_MATERIAL_COLORS; i++) {
+    Color color = material->colors[i];
+    block->colors[i][0] = color.r / 255.f;
+    block->colors[i][1] = color.g / 255.f;
+    block->colors[i][2] = color.b / 255.f;
+    block->colors[i][3] = color.a / 255.f;
+  }
+}
+
+Color lovrMaterialGetColor(Material* material, MaterialColor colorType) {
+  return material->colors[colorType];
+}
+
+void lovrMaterialSetColor(Material* material, MaterialColor colorType, Color color) {
+  lovrGraphicsFlushObject(&material->ref);
+  material->colors[colorType] = color;
+  material->version++;
+}
+
+Texture* lovrMaterialGetTexture(Material* material, MaterialTexture textureType) {
+  return material->textures[textureType];
+}
+
+void lovrMaterialSetTexture(Material* material, MaterialTexture textureType, Texture* texture) {
+  lovrGraphicsFlushObject(&material->ref);
+  if (material->textures[textureType] != texture) {
+    if (material->textures[textureType]) {
+      lovrRelease(&material->textures[textureType]->ref);
+    }
+
+    material->textures[textureType] = texture;
+
+    if (texture) {
+      lovrRetain(&texture->ref);
+    }
+  }
+}
+
+Shader* lovrMaterialGetShader(Material* material) {
+  return material->shader;
+}
+
+void lovrMaterialSetShader(Material* material, Shader* shader) {
+  lovrGraphicsFlushObject(&material->ref);
+  if (material->shader != shader) {
+    if (material->shader) {
+      lovrRelease(&material->shader->ref);
+    }
+
+    material->shader = shader;
+
+    if (shader) {
+      lovrRetain(&shader->ref);
+    }
+  }
+}
@@ -0,0 +1,44 @@
+#include "graphics/shader.h"
+#include "graphics/texture.h"
+#include "util.h"
+
+#pragma once
+
+#define EMISSIVE_TEXTURE_UNIT 3
+
+typedef enum {
+  COLOR_DIFFUSE,
+  COLOR_EMISSIVE,
+  MAX_MATERIAL_COLORS
+} MaterialColor;
+
+typedef enum {
+  TEXTURE_DIFFUSE,
+  TEXTURE_EMISSIVE,
+  MAX_MATERIAL_TEXTURES
+} MaterialTexture;
+
+// The contents of the lovrMaterialBlock uniform block, using the std140 layout
+typedef struct {
+  float colors[MAX_MATERIAL_COLORS][4];
+} MaterialBlock;
+
+// The version changes whenever the colors do, so copies of the uniform block know when they're stale.
+// Materials without a shader use the default one.
+typedef struct {
+  Ref ref;
+  Color colors[MAX_MATERIAL_COLORS];
+  Texture* textures[MAX_MATERIAL_TEXTURES];
+  Shader* shader;
+  int version;
+} Material;
+
+Material* lovrMaterialCreate();
+void lovrMaterialDestroy(const Ref* ref);
+void lovrMaterialGetBlock(Material* material, MaterialBlock* block);
+Color lovrMaterialGetColor(Material* material, MaterialColor colorType);
+void lovrMaterialSetColor(Material* material, MaterialColor colorType, Color color);
+Texture* lovrMaterialGetTexture(Material* material, MaterialTexture textureType);
+void lovrMaterialSetTexture(Material* material, MaterialTexture textureType, Texture* texture);
+Shader* lovrMaterialGetShader(Material* material);
+void lovrMaterialSetShader(Material* material, Shader* shader);
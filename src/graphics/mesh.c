@@ -1,17 +1,233 @@
 #include "graphics/mesh.h"
 #include "graphics/graphics.h"
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-static void lovrMeshBindAttributes(Mesh* mesh) {
-  Shader* shader = lovrGraphicsGetActiveShader();
-  if (shader == mesh->lastShader && !mesh->attributesDirty) {
+static vec_void_t pools;
+static vec_int_t drawCounts;
+static vec_int_t drawFirsts;
+static vec_void_t drawOffsets;
+static vec_uint_t drawCommands;
+static GLuint indirectBuffer;
+
+// Pools
+
+static int lovrMeshFormatEquals(MeshFormat* a, MeshFormat* b) {
+  if (a->length != b->length) {
+    return 0;
+  }
+
+  for (int i = 0; i < a->length; i++) {
+    MeshAttribute* x = &a->data[i];
+    MeshAttribute* y = &b->data[i];
+    if (x->type != y->type || x->count != y->count || x->normalized != y->normalized || x->offset != y->offset || x->stride != y->stride || strcmp(x->name, y->name)) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+// First fit.  Returns 0 if no free range is large enough.
+static int lovrMeshRangeAllocate(vec_meshrange_t* ranges, size_t count, size_t* offset) {
+  for (int i = 0; i < ranges->length; i++) {
+    MeshRange* range = &ranges->data[i];
+    if (range->count >= count) {
+      *offset = range->offset;
+      range->offset += count;
+      range->count -= count;
+      if (range->count == 0) {
+        vec_splice(ranges, i, 1);
+      }
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// Keeps the free list sorted by offset and merges adjacent ranges
+static void lovrMeshRangeFree(vec_meshrange_t* ranges, size_t offset, size_t count) {
+  if (count == 0) {
     return;
   }
 
-  lovrGraphicsBindVertexBuffer(mesh->vbo);
+  int i = 0;
+  while (i < ranges->length && ranges->data[i].offset < offset) {
+    i++;
+  }
+
+  MeshRange range = { offset, count };
+  vec_insert(ranges, i, range);
+
+  if (i + 1 < ranges->length && offset + count == ranges->data[i + 1].offset) {
+    ranges->data[i].count += ranges->data[i + 1].count;
+    vec_splice(ranges, i + 1, 1);
+  }
+
+  if (i > 0 && ranges->data[i - 1].offset + ranges->data[i - 1].count == offset) {
+    ranges->data[i - 1].count += ranges->data[i].count;
+    vec_splice(ranges, i, 1);
+  }
+}
+
+// Replaces a buffer with a larger one, keeping its contents
+static GLuint lovrMeshPoolResizeBuffer(GLuint buffer, size_t size, size_t newSize, MeshUsage usage) {
+  GLuint newBuffer;
+  glGenBuffers(1, &newBuffer);
+  lovrGraphicsBindVertexBuffer(newBuffer);
+  glBufferData(GL_ARRAY_BUFFER, newSize, NULL, usage);
+
+  if (size > 0) {
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ARRAY_BUFFER, 0, 0, size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+  }
+
+  return newBuffer;
+}
+
+static void lovrMeshPoolDestroy(const Ref* ref) {
+  MeshPool* pool = containerof(ref, MeshPool);
+  int i;
+  MeshAttribute attribute;
+  vec_foreach(&pool->format, attribute, i) {
+    free((char*) attribute.name);
+  }
+  vec_remove(&pools, pool);
+  glDeleteBuffers(1, &pool->vbo);
+  glDeleteBuffers(1, &pool->ibo);
+  glDeleteVertexArrays(1, &pool->vao);
+  vec_deinit(&pool->format);
+  vec_deinit(&pool->freeVertices);
+  vec_deinit(&pool->freeIndices);
+  free(pool);
+}
+
+static MeshPool* lovrMeshPoolGet(MeshFormat* format, int stride, MeshUsage usage) {
+  MeshPool* pool; int i;
+  vec_foreach(&pools, pool, i) {
+    if (pool->usage == usage && lovrMeshFormatEquals(&pool->format, format)) {
+      lovrRetain(&pool->ref);
+      return pool;
+    }
+  }
+
+  pool = lovrAlloc(sizeof(MeshPool), lovrMeshPoolDestroy);
+  if (!pool) return NULL;
+
+  // Attribute names usually point into Lua strings, so the pool keeps its own copies
+  vec_init(&pool->format);
+  MeshAttribute attribute;
+  vec_foreach(format, attribute, i) {
+    size_t length = strlen(attribute.name) + 1;
+    attribute.name = memcpy(malloc(length), attribute.name, length);
+    vec_push(&pool->format, attribute);
+  }
+
+  pool->usage = usage;
+  pool->stride = stride;
+  pool->vbo = 0;
+  pool->ibo = 0;
+  pool->vertexCapacity = 0;
+  pool->indexCapacity = 0;
+  pool->enabledAttributes = 0;
+  pool->lastShader = NULL;
+  pool->hasVertexColors = 0;
+  pool->mappedMesh = NULL;
+  vec_init(&pool->freeVertices);
+  vec_init(&pool->freeIndices);
+  glGenVertexArrays(1, &pool->vao);
+  vec_push(&pools, pool);
+  return pool;
+}
+
+static size_t lovrMeshPoolAllocateVertices(MeshPool* pool, size_t count) {
+  size_t offset;
+  while (!lovrMeshRangeAllocate(&pool->freeVertices, count, &offset)) {
+    if (pool->mappedMesh) {
+      lovrMeshUnmap(pool->mappedMesh);
+    }
+
+    size_t capacity = MAX(2 * pool->vertexCapacity, MESH_POOL_VERTEX_CAPACITY);
+    capacity = MAX(capacity, pool->vertexCapacity + count);
+    size_t size = pool->vertexCapacity * pool->stride;
+    pool->vbo = lovrMeshPoolResizeBuffer(pool->vbo, size, capacity * pool->stride, pool->usage);
+    lovrMeshRangeFree(&pool->freeVertices, pool->vertexCapacity, capacity - pool->vertexCapacity);
+    pool->vertexCapacity = capacity;
+    pool->lastShader = NULL;
+  }
+
+  return offset;
+}
+
+static size_t lovrMeshPoolAllocateIndices(MeshPool* pool, size_t count) {
+  size_t offset;
+  while (!lovrMeshRangeAllocate(&pool->freeIndices, count, &offset)) {
+    size_t capacity = MAX(2 * pool->indexCapacity, MESH_POOL_INDEX_CAPACITY);
+    capacity = MAX(capacity, pool->indexCapacity + count);
+    size_t size = pool->indexCapacity * sizeof(uint16_t);
+    pool->ibo = lovrMeshPoolResizeBuffer(pool->ibo, size, capacity * sizeof(uint16_t), pool->usage);
+    lovrMeshRangeFree(&pool->freeIndices, pool->indexCapacity, capacity - pool->indexCapacity);
+    pool->indexCapacity = capacity;
+    lovrGraphicsBindVertexArray(pool->vao);
+    lovrGraphicsBindIndexBuffer(pool->ibo);
+  }
+
+  return offset;
+}
+
+// Mesh
+
+static GLuint lovrMeshGetVertexBuffer(Mesh* mesh) {
+  return mesh->pool ? mesh->pool->vbo : mesh->vbo;
+}
+
+#ifndef EMSCRIPTEN
+// Moves a stream mesh to its next region after it's been drawn, waiting for the GPU to finish with
+// that region.  With a region per frame in flight the fence has almost always signaled already.
+static void lovrMeshAdvanceRegion(Mesh* mesh, size_t start, size_t count) {
+  size_t size = mesh->count * mesh->stride;
+  char* previous = (char*) mesh->persistentData + mesh->region * size;
+
+  mesh->fences[mesh->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  mesh->region = (mesh->region + 1) % MESH_STREAM_REGIONS;
+  mesh->vertexOffset = mesh->region * mesh->count;
+  mesh->regionDrawn = 0;
+
+  GLsync fence = mesh->fences[mesh->region];
+  if (fence) {
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(fence);
+    mesh->fences[mesh->region] = NULL;
+  }
+
+  // Regions hold the whole mesh, so partial writes need the rest of the previous contents
+  if (start > 0 || count < mesh->count) {
+    memcpy((char*) mesh->persistentData + mesh->region * size, previous, size);
+  }
+}
+#endif
+
+// Returns whether the bound attributes include a vertex color array
+static int lovrMeshBindAttributes(Mesh* mesh) {
+  Shader* shader = lovrGraphicsGetActiveShader();
+  MeshPool* pool = mesh->pool;
+  if (pool) {
+    if (shader == pool->lastShader && mesh->enabledAttributes == pool->enabledAttributes) {
+      return pool->hasVertexColors;
+    }
+  } else if (shader == mesh->lastShader && !mesh->attributesDirty) {
+    return mesh->hasVertexColors;
+  }
+
+  lovrGraphicsBindVertexBuffer(lovrMeshGetVertexBuffer(mesh));
 
   size_t offset = 0;
+  int hasVertexColors = 0;
   int i;
   MeshAttribute attribute;
 
@@ -21,25 +237,50 @@ static void lovrMeshBindAttributes(Mesh* mesh) {
     if (location >= 0) {
       if (mesh->enabledAttributes & (1 << i)) {
         glEnableVertexAttribArray(location);
+        hasVertexColors |= location == LOVR_SHADER_VERTEX_COLOR;
 
-        if (attribute.type == MESH_INT) {
-          glVertexAttribIPointer(location, attribute.count, attribute.type, mesh->stride, (void*) offset);
+        size_t start = mesh->hasLayout ? attribute.offset : offset;
+        int stride = mesh->hasLayout ? attribute.stride : mesh->stride;
+        if (attribute.type == MESH_INT && !attribute.normalized) {
+          glVertexAttribIPointer(location, attribute.count, attribute.type, stride, (void*) start);
         } else {
-          glVertexAttribPointer(location, attribute.count, attribute.type, GL_FALSE, mesh->stride, (void*) offset);
+          GLboolean normalized = attribute.normalized ? GL_TRUE : GL_FALSE;
+          glVertexAttribPointer(location, attribute.count, attribute.type, normalized, stride, (void*) start);
         }
       } else {
         glDisableVertexAttribArray(location);
       }
     }
 
-    offset += sizeof(attribute.type) * attribute.count;
+    offset += lovrMeshAttributeGetSize(attribute);
   }
 
-  mesh->lastShader = shader;
-  mesh->attributesDirty = 0;
+  if (pool) {
+    pool->lastShader = shader;
+    pool->enabledAttributes = mesh->enabledAttributes;
+    pool->hasVertexColors = hasVertexColors;
+  } else {
+    mesh->lastShader = shader;
+    mesh->attributesDirty = 0;
+    mesh->hasVertexColors = hasVertexColors;
+  }
+
+  return hasVertexColors;
+}
+
+// Releases the storage shared by all meshes.  Pools are owned by their meshes, ones that are still
+// alive are forgotten so a restarted graphics module starts with new ones.
+void lovrMeshDestroyShared() {
+  vec_deinit(&pools);
+  vec_deinit(&drawCounts);
+  vec_deinit(&drawFirsts);
+  vec_deinit(&drawOffsets);
+  vec_deinit(&drawCommands);
+  glDeleteBuffers(1, &indirectBuffer);
+  indirectBuffer = 0;
 }
 
-Mesh* lovrMeshCreate(size_t count, MeshFormat* format, MeshDrawMode drawMode, MeshUsage usage) {
+Mesh* lovrMeshCreate(size_t count, MeshFormat* format, MeshDrawMode drawMode, MeshUsage usage, int keepData) {
   Mesh* mesh = lovrAlloc(sizeof(Mesh), lovrMeshDestroy);
   if (!mesh) return NULL;
 
@@ -58,10 +299,14 @@ Mesh* lovrMeshCreate(size_t count, MeshFormat* format, MeshDrawMode drawMode, Me
   }
 
   int stride = 0;
+  int hasLayout = mesh->format.length > 0 && mesh->format.data[0].stride > 0;
   int i;
   MeshAttribute attribute;
   vec_foreach(&mesh->format, attribute, i) {
-    stride += attribute.count * sizeof(attribute.type);
+    lovrAssert(attribute.count >= 1 && attribute.count <= 4, "Mesh attributes must have between 1 and 4 components");
+    lovrAssert(attribute.type != MESH_PACKED || attribute.count == 4, "Packed mesh attributes must have 4 components");
+    lovrAssert((attribute.stride > 0) == hasLayout, "Either all mesh attributes or none of them must have a stride");
+    stride += hasLayout ? attribute.stride : lovrMeshAttributeGetSize(attribute);
   }
 
   if (stride == 0) {
@@ -71,30 +316,75 @@ Mesh* lovrMeshCreate(size_t count, MeshFormat* format, MeshDrawMode drawMode, Me
   mesh->data = NULL;
   mesh->count = count;
   mesh->stride = stride;
+  mesh->hasLayout = hasLayout;
   mesh->enabledAttributes = ~0;
   mesh->attributesDirty = 1;
   mesh->isMapped = 0;
+  mesh->dirtyStart = count;
+  mesh->dirtyEnd = 0;
+  mesh->persistentData = NULL;
+  mesh->region = 0;
+  mesh->regionDrawn = 0;
+  for (int i = 0; i < MESH_STREAM_REGIONS; i++) {
+    mesh->fences[i] = NULL;
+  }
   mesh->drawMode = drawMode;
   mesh->usage = usage;
   mesh->vao = 0;
   mesh->vbo = 0;
   mesh->ibo = 0;
+  mesh->pool = NULL;
+  mesh->vertexOffset = 0;
+  mesh->indexOffset = 0;
+  mesh->indexCapacity = 0;
+  mesh->indexSize = count <= MESH_MAX_SHORT_INDEXED_VERTICES ? sizeof(uint16_t) : sizeof(uint32_t);
+  mesh->indexType = count <= MESH_MAX_SHORT_INDEXED_VERTICES ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
   mesh->isRangeEnabled = 0;
   mesh->rangeStart = 0;
   mesh->rangeCount = mesh->count;
   mesh->texture = NULL;
+  mesh->textureArray = NULL;
   mesh->lastShader = NULL;
+  mesh->hasVertexColors = 0;
+
+#ifdef EMSCRIPTEN
+  keepData = 1;
+#endif
+
+  // With keepData, vertices are read and written through a copy in memory and the modified range
+  // is uploaded before the next draw, so vertex reads never wait on the GPU
+  if (keepData) {
+    mesh->data = calloc(mesh->count, mesh->stride);
+  }
+
+#ifndef EMSCRIPTEN
+  // Stream meshes are mapped once into storage with a region for each of the last few frames, so
+  // writes go to a region the GPU is done with instead of mapping and unmapping the buffer
+  if (usage == MESH_STREAM && !keepData && !hasLayout && GLAD_GL_ARB_buffer_storage && count > 0) {
+    GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    size_t size = MESH_STREAM_REGIONS * count * stride;
+    glGenBuffers(1, &mesh->vbo);
+    lovrGraphicsBindVertexBuffer(mesh->vbo);
+    glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+    mesh->persistentData = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+    glGenVertexArrays(1, &mesh->vao);
+    return mesh;
+  }
+
+  // Small static meshes share buffers and a vertex array object with other meshes of their format.
+  // Meshes with a layout can't, their attribute offsets are relative to the start of the buffer.
+  if (usage == MESH_STATIC && !hasLayout && count > 0 && count <= MESH_POOL_MAX_VERTICES) {
+    mesh->pool = lovrMeshPoolGet(&mesh->format, stride, usage);
+    mesh->vertexOffset = lovrMeshPoolAllocateVertices(mesh->pool, count);
+    return mesh;
+  }
+#endif
 
   glGenBuffers(1, &mesh->vbo);
-  glGenBuffers(1, &mesh->ibo);
   lovrGraphicsBindVertexBuffer(mesh->vbo);
   glBufferData(GL_ARRAY_BUFFER, mesh->count * mesh->stride, NULL, mesh->usage);
   glGenVertexArrays(1, &mesh->vao);
 
-#ifdef EMSCRIPTEN
-  mesh->data = malloc(mesh->count * mesh->stride);
-#endif
-
   return mesh;
 }
 
@@ -103,39 +393,188 @@ void lovrMeshDestroy(const Ref* ref) {
   if (mesh->texture) {
     lovrRelease(&mesh->texture->ref);
   }
-  glDeleteBuffers(1, &mesh->vbo);
-  glDeleteBuffers(1, &mesh->ibo);
-  glDeleteVertexArrays(1, &mesh->vao);
+  if (mesh->textureArray) {
+    lovrRelease(&mesh->textureArray->ref);
+  }
+  if (mesh->pool) {
+    lovrMeshUnmap(mesh);
+    lovrMeshRangeFree(&mesh->pool->freeVertices, mesh->vertexOffset, mesh->count);
+    lovrMeshRangeFree(&mesh->pool->freeIndices, mesh->indexOffset, mesh->indexCapacity);
+    lovrRelease(&mesh->pool->ref);
+  } else {
+    for (int i = 0; i < MESH_STREAM_REGIONS; i++) {
+      if (mesh->fences[i]) {
+        glDeleteSync(mesh->fences[i]);
+      }
+    }
+    glDeleteBuffers(1, &mesh->vbo);
+    glDeleteBuffers(1, &mesh->ibo);
+    glDeleteVertexArrays(1, &mesh->vao);
+  }
   vec_deinit(&mesh->map);
   vec_deinit(&mesh->format);
-#ifdef EMSCRIPTEN
   free(mesh->data);
-#endif
   free(mesh);
 }
 
-void lovrMeshDraw(Mesh* mesh, mat4 transform) {
+// Sets up all of the state needed to draw the mesh, for callers that issue their own draw calls
+void lovrMeshBind(Mesh* mesh) {
   if (mesh->isMapped) {
     lovrMeshUnmap(mesh);
   }
 
-  lovrGraphicsPush();
-  lovrGraphicsMatrixTransform(MATRIX_MODEL, transform);
+  mesh->regionDrawn = 1;
+
   lovrGraphicsBindTexture(mesh->texture);
-  lovrGraphicsSetDefaultShader(SHADER_DEFAULT);
+  if (mesh->textureArray) {
+    lovrTextureArrayPrepare(mesh->textureArray);
+    lovrGraphicsSetDefaultShader(SHADER_TEXTURE_ARRAY);
+  } else {
+    lovrGraphicsSetDefaultShader(SHADER_DEFAULT);
+  }
   lovrGraphicsPrepare();
-  lovrGraphicsBindVertexArray(mesh->vao);
-  lovrMeshBindAttributes(mesh);
+  lovrGraphicsBindVertexArray(mesh->pool ? mesh->pool->vao : mesh->vao);
+  lovrGraphicsSetVertexColorArray(lovrMeshBindAttributes(mesh));
+}
+
+void lovrMeshDraw(Mesh* mesh, mat4 transform) {
+  DrawCommand command = { .type = DRAW_COMMAND_MESH, .object = &mesh->ref };
+  if (lovrGraphicsRecord(&command, transform)) return;
+
+  lovrGraphicsPush();
+  lovrGraphicsMatrixTransform(MATRIX_MODEL, transform);
+  lovrMeshBind(mesh);
   size_t start = mesh->rangeStart;
   size_t count = mesh->rangeCount;
   if (mesh->map.length > 0) {
-    glDrawElements(mesh->drawMode, mesh->map.length, GL_UNSIGNED_INT, (GLvoid*) start);
+
+    // Draw ranges of indexed meshes are measured in indices
+    if (!mesh->isRangeEnabled) {
+      start = 0;
+      count = mesh->map.length;
+    } else if (start + count > mesh->map.length) {
+      count = start < mesh->map.length ? mesh->map.length - start : 0;
+    }
+
+    size_t offset = (mesh->indexOffset + start) * mesh->indexSize;
+#ifndef EMSCRIPTEN
+    if (mesh->vertexOffset > 0) {
+      glDrawElementsBaseVertex(mesh->drawMode, count, mesh->indexType, (GLvoid*) offset, mesh->vertexOffset);
+    } else
+#endif
+    glDrawElements(mesh->drawMode, count, mesh->indexType, (GLvoid*) offset);
   } else {
-    glDrawArrays(mesh->drawMode, start, count);
+    glDrawArrays(mesh->drawMode, mesh->vertexOffset + start, count);
   }
   lovrGraphicsPop();
 }
 
+#ifndef EMSCRIPTEN
+// Uploads the ranges as indirect draw commands, each one { count, instances, first, base vertex,
+// base instance } for indexed meshes or { count, instances, first, base instance } otherwise
+static void lovrMeshDrawIndirect(Mesh* mesh, int drawCount) {
+  int indexed = mesh->map.length > 0;
+  vec_clear(&drawCommands);
+  for (int i = 0; i < drawCount; i++) {
+    if (indexed) {
+      unsigned int command[5] = { drawCounts.data[i], 1, mesh->indexOffset + drawFirsts.data[i], mesh->vertexOffset, 0 };
+      vec_pusharr(&drawCommands, command, 5);
+    } else {
+      unsigned int command[4] = { drawCounts.data[i], 1, mesh->vertexOffset + drawFirsts.data[i], 0 };
+      vec_pusharr(&drawCommands, command, 4);
+    }
+  }
+
+  if (!indirectBuffer) {
+    glGenBuffers(1, &indirectBuffer);
+  }
+
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, drawCommands.length * sizeof(unsigned int), drawCommands.data, GL_STREAM_DRAW);
+
+  if (indexed) {
+    glMultiDrawElementsIndirect(mesh->drawMode, mesh->indexType, NULL, drawCount, 0);
+  } else {
+    glMultiDrawArraysIndirect(mesh->drawMode, NULL, drawCount, 0);
+  }
+}
+#endif
+
+// Draws several ranges of the mesh (indices if it has a vertex map, otherwise vertices) with a
+// single multi-draw call, indirect when GL_ARB_multi_draw_indirect is supported.  Adjacent ranges
+// are merged.
+void lovrMeshDrawRanges(Mesh* mesh, mat4 transform, MeshRange* ranges, int rangeCount) {
+  if (rangeCount == 0) {
+    return;
+  }
+
+  vec_clear(&drawCounts);
+  vec_clear(&drawFirsts);
+  for (int i = 0; i < rangeCount; i++) {
+    int first = ranges[i].offset;
+    int count = ranges[i].count;
+    int last = drawCounts.length - 1;
+    if (last >= 0 && drawFirsts.data[last] + drawCounts.data[last] == first) {
+      drawCounts.data[last] += count;
+    } else {
+      vec_push(&drawFirsts, first);
+      vec_push(&drawCounts, count);
+    }
+  }
+
+  lovrGraphicsPush();
+  lovrGraphicsMatrixTransform(MATRIX_MODEL, transform);
+  lovrMeshBind(mesh);
+
+  int drawCount = drawCounts.length;
+#ifndef EMSCRIPTEN
+  if (GLAD_GL_ARB_multi_draw_indirect) {
+    lovrMeshDrawIndirect(mesh, drawCount);
+  } else
+#endif
+  if (mesh->map.length > 0) {
+    vec_clear(&drawOffsets);
+    for (int i = 0; i < drawCount; i++) {
+      size_t offset = (mesh->indexOffset + drawFirsts.data[i]) * mesh->indexSize;
+      vec_push(&drawOffsets, (void*) offset);
+    }
+
+    const void* const* offsets = (const void* const*) drawOffsets.data;
+
+#ifdef EMSCRIPTEN
+    for (int i = 0; i < drawCount; i++) {
+      glDrawElements(mesh->drawMode, drawCounts.data[i], mesh->indexType, drawOffsets.data[i]);
+    }
+#else
+    if (mesh->vertexOffset > 0) {
+
+      // The offsets have been computed, so drawFirsts is reused to hold each range's base vertex
+      for (int i = 0; i < drawCount; i++) {
+        drawFirsts.data[i] = mesh->vertexOffset;
+      }
+
+      glMultiDrawElementsBaseVertex(mesh->drawMode, drawCounts.data, mesh->indexType, offsets, drawCount, drawFirsts.data);
+    } else {
+      glMultiDrawElements(mesh->drawMode, drawCounts.data, mesh->indexType, offsets, drawCount);
+    }
+#endif
+  } else {
+    for (int i = 0; i < drawCount; i++) {
+      drawFirsts.data[i] += mesh->vertexOffset;
+    }
+
+#ifdef EMSCRIPTEN
+    for (int i = 0; i < drawCount; i++) {
+      glDrawArrays(mesh->drawMode, drawFirsts.data[i], drawCounts.data[i]);
+    }
+#else
+    glMultiDrawArrays(mesh->drawMode, drawFirsts.data, drawCounts.data, drawCount);
+#endif
+  }
+
+  lovrGraphicsPop();
+}
+
 MeshFormat lovrMeshGetVertexFormat(Mesh* mesh) {
   return mesh->format;
 }
@@ -145,6 +584,7 @@ MeshDrawMode lovrMeshGetDrawMode(Mesh* mesh) {
 }
 
 int lovrMeshSetDrawMode(Mesh* mesh, MeshDrawMode drawMode) {
+  lovrGraphicsFlushObject(&mesh->ref);
   mesh->drawMode = drawMode;
   return 0;
 }
@@ -163,14 +603,48 @@ unsigned int* lovrMeshGetVertexMap(Mesh* mesh, size_t* count) {
 }
 
 void lovrMeshSetVertexMap(Mesh* mesh, unsigned int* map, size_t count) {
+  lovrGraphicsFlushObject(&mesh->ref);
   if (count == 0 || !map) {
     vec_clear(&mesh->map);
   } else {
     vec_clear(&mesh->map);
     vec_pusharr(&mesh->map, map, count);
-    lovrGraphicsBindVertexArray(mesh->vao);
-    lovrGraphicsBindIndexBuffer(mesh->ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), mesh->map.data, GL_STATIC_DRAW);
+
+    // Meshes with few enough vertices upload their indices as shorts
+    void* data = mesh->map.data;
+    if (mesh->indexType == GL_UNSIGNED_SHORT) {
+      uint16_t* shorts = malloc(count * sizeof(uint16_t));
+      for (size_t i = 0; i < count; i++) {
+        shorts[i] = (uint16_t) map[i];
+      }
+      data = shorts;
+    }
+
+    if (mesh->pool) {
+      MeshPool* pool = mesh->pool;
+      if (count > mesh->indexCapacity) {
+        lovrMeshRangeFree(&pool->freeIndices, mesh->indexOffset, mesh->indexCapacity);
+        mesh->indexOffset = lovrMeshPoolAllocateIndices(pool, count);
+        mesh->indexCapacity = count;
+      }
+
+      lovrGraphicsBindVertexArray(pool->vao);
+      lovrGraphicsBindIndexBuffer(pool->ibo);
+      size_t offset = mesh->indexOffset * mesh->indexSize;
+      glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, count * mesh->indexSize, data);
+    } else {
+      if (!mesh->ibo) {
+        glGenBuffers(1, &mesh->ibo);
+      }
+
+      lovrGraphicsBindVertexArray(mesh->vao);
+      lovrGraphicsBindIndexBuffer(mesh->ibo);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * mesh->indexSize, data, GL_STATIC_DRAW);
+    }
+
+    if (data != mesh->map.data) {
+      free(data);
+    }
   }
 }
 
@@ -188,6 +662,7 @@ int lovrMeshIsAttributeEnabled(Mesh* mesh, const char* name) {
 }
 
 void lovrMeshSetAttributeEnabled(Mesh* mesh, const char* name, int enable) {
+  lovrGraphicsFlushObject(&mesh->ref);
   int i;
   MeshAttribute attribute;
 
@@ -210,6 +685,7 @@ int lovrMeshIsRangeEnabled(Mesh* mesh) {
 }
 
 void lovrMeshSetRangeEnabled(Mesh* mesh, char isEnabled) {
+  lovrGraphicsFlushObject(&mesh->ref);
   mesh->isRangeEnabled = isEnabled;
 
   if (!isEnabled) {
@@ -224,7 +700,9 @@ void lovrMeshGetDrawRange(Mesh* mesh, int* start, int* count) {
 }
 
 int lovrMeshSetDrawRange(Mesh* mesh, int start, int count) {
-  if (start < 0 || count < 0 || (size_t) start + count > mesh->count) {
+  lovrGraphicsFlushObject(&mesh->ref);
+  size_t limit = mesh->map.length > 0 ? mesh->map.length : mesh->count;
+  if (start < 0 || count < 0 || (size_t) start + count > limit) {
     return 1;
   }
 
@@ -238,6 +716,7 @@ Texture* lovrMeshGetTexture(Mesh* mesh) {
 }
 
 void lovrMeshSetTexture(Mesh* mesh, Texture* texture) {
+  lovrGraphicsFlushObject(&mesh->ref);
   if (mesh->texture != texture) {
     if (mesh->texture) {
       lovrRelease(&mesh->texture->ref);
@@ -251,27 +730,73 @@ void lovrMeshSetTexture(Mesh* mesh, Texture* texture) {
   }
 }
 
+TextureArray* lovrMeshGetTextureArray(Mesh* mesh) {
+  return mesh->textureArray;
+}
+
+void lovrMeshSetTextureArray(Mesh* mesh, TextureArray* textureArray) {
+  lovrGraphicsFlushObject(&mesh->ref);
+  if (mesh->textureArray != textureArray) {
+    if (mesh->textureArray) {
+      lovrRelease(&mesh->textureArray->ref);
+    }
+
+    mesh->textureArray = textureArray;
+
+    if (mesh->textureArray) {
+      lovrRetain(&mesh->textureArray->ref);
+    }
+  }
+}
+
 void* lovrMeshMap(Mesh* mesh, int start, size_t count, int read, int write) {
-#ifdef EMSCRIPTEN
-  mesh->isMapped = 1;
-  mesh->mapStart = start;
-  mesh->mapCount = count;
-  return (char*) mesh->data + start * mesh->stride;
-#else
+  lovrAssert(!mesh->hasLayout || (start == 0 && count == mesh->count), "Meshes with an attribute layout can only be mapped whole");
+  if (write) {
+    lovrGraphicsFlushObject(&mesh->ref);
+  }
+
+  if (mesh->data) {
+    if (write) {
+      mesh->isMapped = 1;
+      mesh->dirtyStart = MIN(mesh->dirtyStart, (size_t) start);
+      mesh->dirtyEnd = MAX(mesh->dirtyEnd, start + count);
+    }
+
+    return (char*) mesh->data + start * mesh->stride;
+  }
+
+#ifndef EMSCRIPTEN
+  if (mesh->persistentData) {
+    if (write && mesh->regionDrawn) {
+      lovrMeshAdvanceRegion(mesh, start, count);
+    }
+
+    return (char*) mesh->persistentData + (mesh->vertexOffset + start) * mesh->stride;
+  }
+#endif
+
   if (mesh->isMapped) {
     lovrMeshUnmap(mesh);
   }
 
+  // Only one range of a buffer can be mapped at once
+  if (mesh->pool) {
+    if (mesh->pool->mappedMesh) {
+      lovrMeshUnmap(mesh->pool->mappedMesh);
+    }
+    mesh->pool->mappedMesh = mesh;
+  }
+
   mesh->isMapped = 1;
-  mesh->mapStart = start;
-  mesh->mapCount = count;
   GLbitfield access = 0;
   access |= read ? GL_MAP_READ_BIT : 0;
   access |= write ? GL_MAP_WRITE_BIT : 0;
-  access |= (write && start == 0 && count == mesh->count) ? GL_MAP_INVALIDATE_BUFFER_BIT : 0;
-  lovrGraphicsBindVertexBuffer(mesh->vbo);
-  return glMapBufferRange(GL_ARRAY_BUFFER, start * mesh->stride, count * mesh->stride, access);
-#endif
+  if (write && !read && start == 0 && count == mesh->count) {
+    access |= mesh->pool ? GL_MAP_INVALIDATE_RANGE_BIT : GL_MAP_INVALIDATE_BUFFER_BIT;
+  }
+  lovrGraphicsBindVertexBuffer(lovrMeshGetVertexBuffer(mesh));
+  size_t offset = (mesh->vertexOffset + start) * mesh->stride;
+  return glMapBufferRange(GL_ARRAY_BUFFER, offset, count * mesh->stride, access);
 }
 
 void lovrMeshUnmap(Mesh* mesh) {
@@ -280,13 +805,136 @@ void lovrMeshUnmap(Mesh* mesh) {
   }
 
   mesh->isMapped = 0;
-  lovrGraphicsBindVertexBuffer(mesh->vbo);
 
-#ifdef EMSCRIPTEN
-  int start = mesh->mapStart * mesh->stride;
-  size_t count = mesh->mapCount * mesh->stride;
-  glBufferSubData(GL_ARRAY_BUFFER, start, count, (char*) mesh->data + start);
-#else
+  // Writes to the copy in memory are coalesced into a single dirty range and uploaded at once
+  if (mesh->data) {
+    if (mesh->pool && mesh->pool->mappedMesh) {
+      lovrMeshUnmap(mesh->pool->mappedMesh);
+    }
+
+    lovrGraphicsBindVertexBuffer(lovrMeshGetVertexBuffer(mesh));
+    size_t start = mesh->dirtyStart * mesh->stride;
+    size_t size = (mesh->dirtyEnd - mesh->dirtyStart) * mesh->stride;
+    size_t offset = mesh->vertexOffset * mesh->stride + start;
+    glBufferSubData(GL_ARRAY_BUFFER, offset, size, (char*) mesh->data + start);
+    mesh->dirtyStart = mesh->count;
+    mesh->dirtyEnd = 0;
+    return;
+  }
+
+  if (mesh->pool && mesh->pool->mappedMesh == mesh) {
+    mesh->pool->mappedMesh = NULL;
+  }
+
+  lovrGraphicsBindVertexBuffer(lovrMeshGetVertexBuffer(mesh));
   glUnmapBuffer(GL_ARRAY_BUFFER);
-#endif
+}
+
+// The copy of the vertices in memory, valid for the lifetime of the Mesh.  GPU mappings can't be
+// handed out, they move when pools grow or another mesh in the pool is mapped, and stream regions
+// may still be in use by the GPU.  Changes are uploaded after they are marked dirty.
+void* lovrMeshGetPointer(Mesh* mesh) {
+  lovrAssert(mesh->data, "Only a Mesh created with keepData has a vertex pointer");
+  return mesh->data;
+}
+
+void lovrMeshMarkDirty(Mesh* mesh, size_t start, size_t count) {
+  lovrAssert(mesh->data, "Only a Mesh created with keepData has a vertex pointer");
+  lovrAssert(start + count <= mesh->count, "Invalid mesh vertex range");
+  if (mesh->hasLayout) {
+    lovrMeshMap(mesh, 0, mesh->count, 0, 1);
+  } else {
+    lovrMeshMap(mesh, start, count, 0, 1);
+  }
+}
+
+int lovrMeshAttributeGetSize(MeshAttribute attribute) {
+  switch (attribute.type) {
+    case MESH_FLOAT: return attribute.count * sizeof(float);
+    case MESH_HALF: return attribute.count * sizeof(uint16_t);
+    case MESH_BYTE: return attribute.count * sizeof(int8_t);
+    case MESH_UBYTE: return attribute.count * sizeof(uint8_t);
+    case MESH_SHORT: return attribute.count * sizeof(int16_t);
+    case MESH_USHORT: return attribute.count * sizeof(uint16_t);
+    case MESH_INT: return attribute.count * sizeof(int32_t);
+    case MESH_PACKED: return sizeof(uint32_t);
+  }
+
+  return 0;
+}
+
+// Rounds to nearest, flushing values too small for a half-float subnormal to zero
+uint16_t lovrMeshPackHalf(float value) {
+  union { float f; uint32_t u; } x = { value };
+  uint32_t sign = (x.u >> 16) & 0x8000;
+  uint32_t mantissa = x.u & 0x7fffff;
+  int exponent = (int) ((x.u >> 23) & 0xff) - 127 + 15;
+
+  if (((x.u >> 23) & 0xff) == 0xff) {
+    return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+  } else if (exponent >= 31) {
+    return sign | 0x7c00;
+  } else if (exponent <= 0) {
+    if (exponent < -10) {
+      return sign;
+    }
+
+    mantissa |= 0x800000;
+    int shift = 14 - exponent;
+    return sign | ((mantissa + (1 << (shift - 1))) >> shift);
+  }
+
+  // A carry out of the mantissa correctly rounds up into the exponent
+  return sign | (((exponent << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1));
+}
+
+float lovrMeshUnpackHalf(uint16_t value) {
+  uint32_t sign = (value & 0x8000) << 16;
+  uint32_t exponent = (value >> 10) & 0x1f;
+  uint32_t mantissa = value & 0x3ff;
+  union { uint32_t u; float f; } x;
+
+  if (exponent == 0) {
+    float f = mantissa / 16777216.f;
+    return sign ? -f : f;
+  } else if (exponent == 31) {
+    x.u = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    x.u = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+
+  return x.f;
+}
+
+uint32_t lovrMeshPackInt1010102(float* values, int normalized) {
+  int32_t v[4];
+  for (int i = 0; i < 4; i++) {
+    int max = i < 3 ? 511 : 1;
+    if (normalized) {
+      float f = MIN(MAX(values[i], -1.f), 1.f);
+      v[i] = (int32_t) roundf(f * max);
+    } else {
+      float f = roundf(values[i]);
+      v[i] = (int32_t) MIN(MAX(f, -max - 1), max);
+    }
+  }
+
+  return (v[0] & 0x3ff) | (v[1] & 0x3ff) << 10 | (v[2] & 0x3ff) << 20 | (uint32_t) (v[3] & 0x3) << 30;
+}
+
+void lovrMeshUnpackInt1010102(uint32_t value, float* values, int normalized) {
+  int32_t v[4];
+  v[0] = (int32_t) (value << 22) >> 22;
+  v[1] = (int32_t) (value << 12) >> 22;
+  v[2] = (int32_t) (value << 2) >> 22;
+  v[3] = (int32_t) value >> 30;
+
+  for (int i = 0; i < 4; i++) {
+    if (normalized) {
+      float max = i < 3 ? 511.f : 1.f;
+      values[i] = MAX(v[i] / max, -1.f);
+    } else {
+      values[i] = v[i];
+    }
+  }
 }
@@ -1,11 +1,19 @@
 #include "util.h"
 #include "graphics/shader.h"
 #include "graphics/texture.h"
+#include "graphics/textureArray.h"
 #include "math/math.h"
 #include "lib/glfw.h"
 
 #pragma once
 
+// Pooled meshes always use 16 bit indices, so they can't have more than 65536 vertices
+#define MESH_POOL_MAX_VERTICES 65536
+#define MESH_MAX_SHORT_INDEXED_VERTICES 65536
+#define MESH_STREAM_REGIONS 3
+#define MESH_POOL_VERTEX_CAPACITY 65536
+#define MESH_POOL_INDEX_CAPACITY 196608
+
 typedef enum {
   MESH_POINTS = GL_POINTS,
   MESH_TRIANGLE_STRIP = GL_TRIANGLE_STRIP,
@@ -21,45 +29,99 @@ typedef enum {
 
 typedef enum {
   MESH_FLOAT = GL_FLOAT,
+  MESH_HALF = GL_HALF_FLOAT,
   MESH_BYTE = GL_BYTE,
-  MESH_INT = GL_INT
+  MESH_UBYTE = GL_UNSIGNED_BYTE,
+  MESH_SHORT = GL_SHORT,
+  MESH_USHORT = GL_UNSIGNED_SHORT,
+  MESH_INT = GL_INT,
+  MESH_PACKED = GL_INT_2_10_10_10_REV
 } MeshAttributeType;
 
+// Normalized attributes map integers to [0, 1] (unsigned) or [-1, 1] (signed) in the shader.
+// Packed attributes always have 4 components stored as 10, 10, 10, and 2 bit signed integers.
+// Attributes are interleaved, unless they all have a stride.  Then each one starts at its offset in
+// the vertex buffer, like glTF accessors, and the vertex size is the sum of the strides.
 typedef struct {
   const char* name;
   MeshAttributeType type;
   int count;
+  int normalized;
+  size_t offset;
+  int stride;
 } MeshAttribute;
 
 typedef vec_t(MeshAttribute) MeshFormat;
 
 typedef struct {
+  size_t offset;
+  size_t count;
+} MeshRange;
+
+typedef vec_t(MeshRange) vec_meshrange_t;
+
+// Shared vertex and index storage for small static meshes with the same format
+typedef struct {
+  Ref ref;
+  MeshFormat format;
+  MeshUsage usage;
+  int stride;
+  GLuint vao;
+  GLuint vbo;
+  GLuint ibo;
+  size_t vertexCapacity;
+  size_t indexCapacity;
+  vec_meshrange_t freeVertices;
+  vec_meshrange_t freeIndices;
+  int enabledAttributes;
+  Shader* lastShader;
+  int hasVertexColors;
+  struct Mesh* mappedMesh;
+} MeshPool;
+
+typedef struct Mesh {
   Ref ref;
   void* data;
   size_t count;
   int stride;
+  int hasLayout;
   int enabledAttributes;
   int attributesDirty;
   int isMapped;
-  int mapStart;
-  size_t mapCount;
+  size_t dirtyStart;
+  size_t dirtyEnd;
+  void* persistentData;
+  int region;
+  int regionDrawn;
+  GLsync fences[MESH_STREAM_REGIONS];
   MeshFormat format;
   MeshDrawMode drawMode;
   MeshUsage usage;
   GLuint vao;
   GLuint vbo;
   GLuint ibo;
+  MeshPool* pool;
+  size_t vertexOffset;
+  size_t indexOffset;
+  size_t indexCapacity;
+  size_t indexSize;
+  GLenum indexType;
   vec_uint_t map;
   int isRangeEnabled;
   int rangeStart;
   int rangeCount;
   Texture* texture;
+  TextureArray* textureArray;
   Shader* lastShader;
+  int hasVertexColors;
 } Mesh;
 
-Mesh* lovrMeshCreate(size_t count, MeshFormat* format, MeshDrawMode drawMode, MeshUsage usage);
+Mesh* lovrMeshCreate(size_t count, MeshFormat* format, MeshDrawMode drawMode, MeshUsage usage, int keepData);
 void lovrMeshDestroy(const Ref* ref);
+void lovrMeshDestroyShared();
+void lovrMeshBind(Mesh* mesh);
 void lovrMeshDraw(Mesh* mesh, mat4 transform);
+void lovrMeshDrawRanges(Mesh* mesh, mat4 transform, MeshRange* ranges, int rangeCount);
 MeshFormat lovrMeshGetVertexFormat(Mesh* mesh);
 MeshDrawMode lovrMeshGetDrawMode(Mesh* mesh);
 int lovrMeshSetDrawMode(Mesh* mesh, MeshDrawMode drawMode);
@@ -75,5 +137,14 @@ void lovrMeshGetDrawRange(Mesh* mesh, int* start, int* count);
 int lovrMeshSetDrawRange(Mesh* mesh, int start, int count);
 Texture* lovrMeshGetTexture(Mesh* mesh);
 void lovrMeshSetTexture(Mesh* mesh, Texture* texture);
+TextureArray* lovrMeshGetTextureArray(Mesh* mesh);
+void lovrMeshSetTextureArray(Mesh* mesh, TextureArray* textureArray);
 void* lovrMeshMap(Mesh* mesh, int start, size_t count, int read, int write);
 void lovrMeshUnmap(Mesh* mesh);
+void* lovrMeshGetPointer(Mesh* mesh);
+void lovrMeshMarkDirty(Mesh* mesh, size_t start, size_t count);
+int lovrMeshAttributeGetSize(MeshAttribute attribute);
+uint16_t lovrMeshPackHalf(float value);
+float lovrMeshUnpackHalf(uint16_t value);
+uint32_t lovrMeshPackInt1010102(float* values, int normalized);
+void lovrMeshUnpackInt1010102(uint32_t value, float* values, int normalized);
@@ -3,66 +3,300 @@
 #include "math/mat4.h"
 #include "math/vec3.h"
 #include <stdlib.h>
+#include <string.h>
 #include <float.h>
+#include <math.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 
-static void visitNode(Model* model, ModelData* modelData, ModelNode* node, mat4 transform, vec_float_t* vertices, vec_uint_t* indices) {
-  float newTransform[16];
+// A model drops a level of detail each time its bounding sphere halves in size on screen, starting
+// once it's smaller than LOD_SCREEN_SIZE of the screen height.  Levels have a quarter of the faces of
+// the previous one, which keeps the triangle density on screen about the same.  The level is picked
+// for each draw on its own, so instances of a model drawn at different distances don't interfere.
+#define LOD_SCREEN_SIZE .5f
 
-  if (transform) {
-    mat4_set(newTransform, transform);
-  } else {
-    mat4_identity(newTransform);
+// Batches of rays are split between threads in groups of at least this many
+#define RAYCAST_GRAIN 256
+
+typedef struct {
+  Model* model;
+  float* rays;
+  ModelHit* hits;
+} ModelRaycastBatch;
+
+static void aabbReset(float* aabb) {
+  aabb[0] = aabb[2] = aabb[4] = FLT_MAX;
+  aabb[1] = aabb[3] = aabb[5] = -FLT_MAX;
+}
+
+static void aabbAdd(float* aabb, float* point) {
+  aabb[0] = MIN(aabb[0], point[0]);
+  aabb[1] = MAX(aabb[1], point[0]);
+  aabb[2] = MIN(aabb[2], point[1]);
+  aabb[3] = MAX(aabb[3], point[1]);
+  aabb[4] = MIN(aabb[4], point[2]);
+  aabb[5] = MAX(aabb[5], point[2]);
+}
+
+// Returns 0 if all corners of the box are outside the same clip plane
+static int aabbIsVisible(float* aabb, mat4 clip) {
+  int outside[6] = { 0 };
+
+  for (int i = 0; i < 8; i++) {
+    float x = aabb[0 + (i & 1)];
+    float y = aabb[2 + ((i >> 1) & 1)];
+    float z = aabb[4 + ((i >> 2) & 1)];
+    float cx = clip[0] * x + clip[4] * y + clip[8] * z + clip[12];
+    float cy = clip[1] * x + clip[5] * y + clip[9] * z + clip[13];
+    float cz = clip[2] * x + clip[6] * y + clip[10] * z + clip[14];
+    float cw = clip[3] * x + clip[7] * y + clip[11] * z + clip[15];
+    outside[0] += cx < -cw;
+    outside[1] += cx > cw;
+    outside[2] += cy < -cw;
+    outside[3] += cy > cw;
+    outside[4] += cz < -cw;
+    outside[5] += cz > cw;
   }
 
-  mat4_multiply(newTransform, node->transform);
+  for (int i = 0; i < 6; i++) {
+    if (outside[i] == 8) {
+      return 0;
+    }
+  }
 
-  int indexOffset = vertices->length / 3;
+  return 1;
+}
 
-  // Meshes
-  for (int m = 0; m < node->meshes.length; m++) {
-    ModelMesh* mesh = modelData->meshes.data[node->meshes.data[m]];
+static uint8_t colorComponent(float x) {
+  return (uint8_t) roundf((x < 0.f ? 0.f : (x > 1.f ? 1.f : x)) * 255.f);
+}
 
-    // Transformed vertices
-    for (int v = 0; v < mesh->vertices.length; v++) {
-      ModelVertex vertex = mesh->vertices.data[v];
+// Images are decoded the first time a material uses them, so materials can share textures
+static Texture* lovrModelLoadTexture(ModelData* modelData, Texture** textures, int image) {
+  if (image < 0 || !modelData->images.data[image].blob) {
+    return NULL;
+  }
 
-      float vec[3] = { vertex.x, vertex.y, vertex.z };
-      mat4_transform(newTransform, vec);
-      vec_pusharr(vertices, vec, 3);
+  if (!textures[image]) {
+    TextureData* textureData = lovrTextureDataFromBlob(modelData->images.data[image].blob, NULL);
+    textures[image] = lovrTextureCreate(textureData, 0);
+    lovrTextureReleaseData(textures[image]);
+  }
 
-      model->aabb[0] = MIN(model->aabb[0], vec[0]);
-      model->aabb[1] = MAX(model->aabb[1], vec[0]);
-      model->aabb[2] = MIN(model->aabb[2], vec[1]);
-      model->aabb[3] = MAX(model->aabb[3], vec[1]);
-      model->aabb[4] = MIN(model->aabb[4], vec[2]);
-      model->aabb[5] = MAX(model->aabb[5], vec[2]);
+  return textures[image];
+}
 
-      if (modelData->hasNormals) {
-        ModelVertex normal = mesh->normals.data[v];
-        vec_push(vertices, normal.x);
-        vec_push(vertices, normal.y);
-        vec_push(vertices, normal.z);
+static int comparePartKeys(const void* a, const void* b) {
+  const ModelPart* p = a;
+  const ModelPart* q = b;
+  if (p->key != q->key) {
+    return p->key < q->key ? -1 : 1;
+  }
+  return p->primitive - q->primitive;
+}
+
+// Material colors are packed into one uniform buffer, a range of which is bound for each material.
+// The colors are uploaded again when a material changes them, and the parts are sorted again when a
+// material changes its shader.
+static void lovrModelUpdateMaterials(Model* model) {
+  int sort = model->materialsDirty;
+  glBindBuffer(GL_UNIFORM_BUFFER, model->materialBuffer);
+  for (int i = 0; i < model->materialCount; i++) {
+    Material* material = model->materials[i];
+    if (model->materialsDirty || model->materialVersions[i] != material->version) {
+      MaterialBlock block;
+      lovrMaterialGetBlock(material, &block);
+      glBufferSubData(GL_UNIFORM_BUFFER, i * model->materialStride, sizeof(MaterialBlock), &block);
+      model->materialVersions[i] = material->version;
+    }
+
+    if (model->materialShaders[i] != material->shader) {
+      model->materialShaders[i] = material->shader;
+      sort = 1;
+    }
+  }
+
+  // Skinned parts are drawn in model space, so they're grouped by their palette instead of a node
+  if (sort) {
+    ModelPart* part; int i;
+    vec_foreach_ptr(&model->parts, part, i) {
+      ModelPrimitive* primitive = &model->primitives.data[part->primitive];
+      Shader* shader = model->materials[primitive->material]->shader;
+      uint64_t shaderId = shader ? shader->id : 0;
+      uint64_t node = primitive->isSkinned ? (uint64_t) primitive->palette : (1 << 23) | part->node;
+      part->key = (shaderId << 48) | ((uint64_t) primitive->material << 24) | node;
+    }
+
+    qsort(model->parts.data, model->parts.length, sizeof(ModelPart), comparePartKeys);
+  }
+
+  model->materialsDirty = 0;
+}
+
+static int lovrModelIsDirty(Model* model) {
+  return model->nodesDirty || (model->animator && model->animator->dirty);
+}
+
+// Bounds of the visible parts in their current pose, skinned parts use their rest pose
+static void lovrModelUpdateBounds(Model* model) {
+  memcpy(model->aabb, model->skinnedAABB, sizeof(model->aabb));
+  ModelPart* part; int i;
+  vec_foreach_ptr(&model->parts, part, i) {
+    ModelNodeState* node = &model->nodes[part->node];
+    if (!node->globalVisible || model->primitives.data[part->primitive].isSkinned) {
+      continue;
+    }
+
+    for (int j = 0; j < 8; j++) {
+      float corner[3] = { part->aabb[0 + (j & 1)], part->aabb[2 + ((j >> 1) & 1)], part->aabb[4 + ((j >> 2) & 1)] };
+      mat4_transform(node->globalTransform, corner);
+      aabbAdd(model->aabb, corner);
+    }
+  }
+}
+
+// Animates the local node transforms, makes them global, and uploads the bone transforms
+static void lovrModelUpdateNodes(Model* model) {
+  float* transforms = model->nodeTransforms;
+  for (int i = 0; i < model->nodeCount; i++) {
+    mat4_set(transforms + 16 * i, model->nodes[i].transform);
+  }
+
+  if (model->animator) {
+    lovrAnimatorEvaluate(model->animator, transforms);
+  }
+
+  // Parents come before their children, so local transforms become global in a single pass
+  for (int i = 0; i < model->nodeCount; i++) {
+    ModelNodeState* node = &model->nodes[i];
+    if (node->parent >= 0) {
+      ModelNodeState* parent = &model->nodes[node->parent];
+      mat4_set(node->globalTransform, parent->globalTransform);
+      mat4_multiply(node->globalTransform, transforms + 16 * i);
+      node->globalVisible = node->visible && parent->globalVisible;
+    } else {
+      mat4_set(node->globalTransform, transforms + 16 * i);
+      node->globalVisible = node->visible;
+    }
+  }
+
+  model->nodesDirty = 0;
+  model->inversesDirty = 1;
+  lovrModelUpdateBounds(model);
+
+  if (model->isSkinned) {
+    int boneCount = model->boneNodes.length;
+    for (int i = 0; i < boneCount; i++) {
+      float* bone = model->pose + 16 * i;
+      mat4_set(bone, model->nodes[model->boneNodes.data[i]].globalTransform);
+      mat4_multiply(bone, model->boneOffsets.data + 16 * i);
+    }
+
+    for (int i = 0; i < model->paletteCount; i++) {
+      PoseBlock* block = (PoseBlock*) (model->poseBlocks + i * model->poseStride);
+      int* palette = model->paletteBones.data + i * LOVR_MAX_BONES;
+      for (int j = 0; j < LOVR_MAX_BONES && palette[j] >= 0; j++) {
+        mat4_set(block->bones[j], model->pose + 16 * palette[j]);
       }
+    }
 
-      if (modelData->hasTexCoords) {
-        ModelVertex texCoord = mesh->texCoords.data[v];
-        vec_push(vertices, texCoord.x);
-        vec_push(vertices, texCoord.y);
+    if (model->paletteCount > 0) {
+      glBindBuffer(GL_UNIFORM_BUFFER, model->poseBuffer);
+      glBufferSubData(GL_UNIFORM_BUFFER, 0, model->paletteCount * model->poseStride, model->poseBlocks);
+    }
+  }
+}
+
+// Skinned primitives share palettes of up to LOVR_MAX_BONES bones, filled in primitive order.  slots
+// maps the bones in the last palette to their index in it.  A primitive using more bones than fit in
+// a palette can't be skinned on the GPU, so it's drawn in its rest pose like a rigid primitive.
+static void lovrModelAssignPalette(Model* model, ModelMesh* modelMesh, ModelPrimitive* primitive, int* slots) {
+  int boneCount = model->boneNodes.length;
+  char* used = calloc(boneCount, 1);
+  lovrAssert(used, "Out of memory");
+
+  int usedCount = 0;
+  int newCount = 0;
+  for (int v = 0; v < modelMesh->boneWeights.length; v++) {
+    ModelBoneWeights* boneWeights = &modelMesh->boneWeights.data[v];
+    for (int i = 0; i < MAX_BONES_PER_VERTEX; i++) {
+      unsigned int bone = boneWeights->bones[i];
+      if (boneWeights->weights[i] > 0.f && !used[bone]) {
+        lovrAssert(bone < (unsigned int) boneCount, "Invalid bone index %d", bone);
+        used[bone] = 1;
+        usedCount++;
+        newCount += slots[bone] < 0;
       }
     }
+  }
+
+  if (usedCount > LOVR_MAX_BONES) {
+    primitive->isSkinned = 0;
+    free(used);
+    return;
+  }
+
+  int size = 0;
+  int* palette = NULL;
+  if (model->paletteCount > 0) {
+    palette = model->paletteBones.data + (model->paletteCount - 1) * LOVR_MAX_BONES;
+    while (size < LOVR_MAX_BONES && palette[size] >= 0) {
+      size++;
+    }
+  }
+
+  if (!palette || size + newCount > LOVR_MAX_BONES) {
+    for (int i = 0; i < LOVR_MAX_BONES; i++) {
+      vec_push(&model->paletteBones, -1);
+    }
+
+    palette = model->paletteBones.data + model->paletteCount++ * LOVR_MAX_BONES;
+    memset(slots, 0xff, boneCount * sizeof(int));
+    size = 0;
+  }
 
-    // Face vertex indices
-    for (int f = 0; f < mesh->faces.length; f++) {
-      ModelFace face = mesh->faces.data[f];
-      vec_push(indices, face.indices[0] + indexOffset);
-      vec_push(indices, face.indices[1] + indexOffset);
-      vec_push(indices, face.indices[2] + indexOffset);
+  for (int i = 0; i < boneCount; i++) {
+    if (used[i] && slots[i] < 0) {
+      slots[i] = size;
+      palette[size++] = i;
     }
   }
 
-  for (int c = 0; c < node->children.length; c++) {
-    visitNode(model, modelData, node->children.data[c], newTransform, vertices, indices);
+  primitive->palette = model->paletteCount - 1;
+  free(used);
+}
+
+static void skinVertex(float* pose, float* position, ModelBoneWeights* boneWeights, float* result) {
+#ifdef __SSE__
+  __m128 x = _mm_set1_ps(position[0]);
+  __m128 y = _mm_set1_ps(position[1]);
+  __m128 z = _mm_set1_ps(position[2]);
+  __m128 sum = _mm_setzero_ps();
+  for (int j = 0; j < MAX_BONES_PER_VERTEX; j++) {
+    float weight = boneWeights->weights[j];
+    if (weight == 0) continue;
+    float* m = pose + 16 * boneWeights->bones[j];
+    __m128 column = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m), x), _mm_mul_ps(_mm_loadu_ps(m + 4), y));
+    column = _mm_add_ps(column, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m + 8), z), _mm_loadu_ps(m + 12)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(column, _mm_set1_ps(weight)));
   }
+  float skinned[4];
+  _mm_storeu_ps(skinned, sum);
+#else
+  float skinned[4] = { 0, 0, 0, 0 };
+  for (int j = 0; j < MAX_BONES_PER_VERTEX; j++) {
+    float weight = boneWeights->weights[j];
+    if (weight == 0) continue;
+    float* m = pose + 16 * boneWeights->bones[j];
+    for (int k = 0; k < 3; k++) {
+      skinned[k] += (m[k] * position[0] + m[4 + k] * position[1] + m[8 + k] * position[2] + m[12 + k]) * weight;
+    }
+  }
+#endif
+  result[0] = skinned[0];
+  result[1] = skinned[1];
+  result[2] = skinned[2];
 }
 
 Model* lovrModelCreate(ModelData* modelData) {
@@ -70,50 +304,310 @@ Model* lovrModelCreate(ModelData* modelData) {
   if (!model) return NULL;
 
   model->modelData = modelData;
-  model->aabb[0] = FLT_MAX;
-  model->aabb[1] = FLT_MIN;
-  model->aabb[2] = FLT_MAX;
-  model->aabb[3] = FLT_MIN;
-  model->aabb[4] = FLT_MAX;
-  model->aabb[5] = FLT_MIN;
+  model->isSkinned = modelData->hasBones;
+  model->animator = NULL;
+  model->pose = NULL;
+  model->paletteCount = 0;
+  model->poseBlocks = NULL;
+  model->poseBuffer = 0;
+  model->materialBuffer = 0;
+  model->texture = NULL;
+  model->lod = 0;
+  model->lodCount = 1;
+  model->autoLod = 1;
+  vec_init(&model->primitives);
+  vec_init(&model->parts);
+  vec_init(&model->visibleRanges);
+  vec_init(&model->boneNodes);
+  vec_init(&model->boneOffsets);
+  vec_init(&model->paletteBones);
+  vec_init(&model->positions);
+  vec_init(&model->skinWeights);
+  aabbReset(model->aabb);
+  aabbReset(model->skinnedAABB);
 
-  vec_float_t vertices;
-  vec_init(&vertices);
+  // Nodes
+  model->nodeCount = modelData->nodes.length;
+  model->nodes = malloc(model->nodeCount * sizeof(ModelNodeState));
+  model->nodeTransforms = malloc(16 * model->nodeCount * sizeof(float));
+  model->nodeInverses = malloc(16 * model->nodeCount * sizeof(float));
+  model->nodesDirty = 1;
+  model->inversesDirty = 1;
+  for (int i = 0; i < model->nodeCount; i++) {
+    ModelNode* node = modelData->nodes.data[i];
+    ModelNodeState* state = &model->nodes[i];
+    size_t length = strlen(node->name) + 1;
+    state->name = memcpy(malloc(length), node->name, length);
+    state->parent = node->parent ? node->parent->index : -1;
+    state->visible = 1;
+    state->globalVisible = 1;
+    mat4_set(state->transform, node->transform);
+    mat4_identity(state->globalTransform);
+  }
 
-  vec_uint_t indices;
-  vec_init(&indices);
+  if (model->isSkinned) {
+    ModelBone* bone; int i;
+    vec_foreach_ptr(&modelData->bones, bone, i) {
+      vec_push(&model->boneNodes, bone->node);
+      vec_pusharr(&model->boneOffsets, bone->offset, 16);
+    }
 
-  visitNode(model, modelData, modelData->root, NULL, &vertices, &indices);
+    model->pose = malloc(16 * model->boneNodes.length * sizeof(float));
+    lovrAssert(model->pose, "Out of memory");
+  }
+
+  // Primitives.  The full detail triangles of every primitive come first in the index buffer, so they
+  // are numbered without gaps, followed by the other levels of detail.
+  int vertexCount = 0;
+  int lodIndexCount = 0;
+  model->triangleCount = 0;
+  ModelMesh* modelMesh; int m;
+  vec_foreach(&modelData->meshes, modelMesh, m) {
+    ModelPrimitive primitive = {
+      .vertices = { .offset = vertexCount, .count = modelMesh->vertices.length },
+      .indices[0] = { .offset = 3 * model->triangleCount, .count = 3 * modelMesh->faces.length },
+      .lodCount = 1 + modelMesh->lodCount,
+      .node = -1,
+      .isSkinned = model->isSkinned && modelMesh->hasBones,
+      .palette = -1,
+      .material = modelMesh->material,
+      .bvh = NULL
+    };
+
+    for (int i = 0; i < modelMesh->lodCount; i++) {
+      ModelLod* lod = &modelMesh->lods[i];
+      primitive.indices[i + 1] = (MeshRange) { .offset = lodIndexCount + 3 * lod->start, .count = 3 * lod->count };
+    }
 
+    vec_push(&model->primitives, primitive);
+    model->lodCount = MAX(model->lodCount, primitive.lodCount);
+    model->triangleCount += modelMesh->faces.length;
+    vertexCount += modelMesh->vertices.length;
+    lodIndexCount += 3 * modelMesh->lodFaces.length;
+  }
+
+  int indexCount = 3 * model->triangleCount + lodIndexCount;
+  for (int i = 0; i < model->primitives.length; i++) {
+    ModelPrimitive* primitive = &model->primitives.data[i];
+    for (int j = 1; j < primitive->lodCount; j++) {
+      primitive->indices[j].offset += 3 * model->triangleCount;
+    }
+  }
+
+  // Parts, in node order.  They're sorted by material before the first draw.
+  for (int i = 0; i < model->nodeCount; i++) {
+    ModelNode* node = modelData->nodes.data[i];
+    for (int j = 0; j < node->meshes.length; j++) {
+      int index = node->meshes.data[j];
+      ModelMesh* mesh = modelData->meshes.data[index];
+      ModelPrimitive* primitive = &model->primitives.data[index];
+      primitive->node = primitive->node >= 0 ? primitive->node : i;
+      if (primitive->indices[0].count > 0) {
+        ModelPart part = { .node = i, .primitive = index };
+        memcpy(part.aabb, mesh->aabb, sizeof(part.aabb));
+        vec_push(&model->parts, part);
+      }
+    }
+  }
+
+  // Each attribute is an array in the vertex buffer.  Positions have the layout of the mesh arrays,
+  // which for glTF files are the buffer views, so they're copied as is.
   MeshFormat format;
   vec_init(&format);
+  size_t offset = 0;
 
-  int components = 3;
-  MeshAttribute position = { .name = "lovrPosition", .type = MESH_FLOAT, .count = 3 };
+  MeshAttribute position = { .name = "lovrPosition", .type = MESH_FLOAT, .count = 3, .offset = offset, .stride = sizeof(ModelVertex) };
   vec_push(&format, position);
+  offset += vertexCount * position.stride;
 
+  // Normals are packed into 10 bits per component
+  size_t normalOffset = offset;
   if (modelData->hasNormals) {
-    MeshAttribute normal = { .name = "lovrNormal", .type = MESH_FLOAT, .count = 3 };
+    MeshAttribute normal = { .name = "lovrNormal", .type = MESH_PACKED, .count = 4, .normalized = 1, .offset = offset, .stride = sizeof(uint32_t) };
     vec_push(&format, normal);
-    components += 3;
+    offset += vertexCount * normal.stride;
   }
 
+  size_t texCoordOffset = offset;
   if (modelData->hasTexCoords) {
-    MeshAttribute texCoord = { .name = "lovrTexCoord", .type = MESH_FLOAT, .count = 2 };
+    MeshAttribute texCoord = { .name = "lovrTexCoord", .type = MESH_FLOAT, .count = 2, .offset = offset, .stride = 2 * sizeof(float) };
     vec_push(&format, texCoord);
-    components += 2;
+    offset += vertexCount * texCoord.stride;
+  }
+
+  size_t boneOffset = offset;
+  if (model->isSkinned) {
+    MeshAttribute bones = { .name = "lovrBones", .type = MESH_UBYTE, .count = MAX_BONES_PER_VERTEX, .offset = offset, .stride = MAX_BONES_PER_VERTEX };
+    offset += vertexCount * bones.stride;
+    MeshAttribute weights = { .name = "lovrBoneWeights", .type = MESH_UBYTE, .count = MAX_BONES_PER_VERTEX, .normalized = 1, .offset = offset, .stride = MAX_BONES_PER_VERTEX };
+    offset += vertexCount * weights.stride;
+    vec_push(&format, bones);
+    vec_push(&format, weights);
+    vec_reserve(&model->skinWeights, vertexCount);
+  }
+
+  // Positions are kept for skinning on the CPU and for raycasting
+  vec_reserve(&model->positions, 4 * vertexCount);
+
+  // Vertices are in the space of their primitive, nodes are transformed when drawing
+  vec_uint_t indices;
+  vec_init(&indices);
+  vec_reserve(&indices, indexCount);
+
+  int* slots = NULL;
+  if (model->isSkinned) {
+    slots = malloc(model->boneNodes.length * sizeof(int));
+    lovrAssert(slots, "Out of memory");
+    memset(slots, 0xff, model->boneNodes.length * sizeof(int));
   }
 
-  model->mesh = lovrMeshCreate(vertices.length / components, &format, MESH_TRIANGLES, MESH_STATIC);
-  void* data = lovrMeshMap(model->mesh, 0, vertices.length / components, 0, 1);
-  memcpy(data, vertices.data, vertices.length * sizeof(float));
+  model->mesh = lovrMeshCreate(vertexCount, &format, MESH_TRIANGLES, MESH_STATIC, 0);
+  char* data = lovrMeshMap(model->mesh, 0, vertexCount, 0, 1);
+  vec_foreach(&modelData->meshes, modelMesh, m) {
+    ModelPrimitive* primitive = &model->primitives.data[m];
+    size_t first = primitive->vertices.offset;
+    size_t count = modelMesh->vertices.length;
+
+    if (primitive->isSkinned) {
+      lovrModelAssignPalette(model, modelMesh, primitive, slots);
+    }
+    memcpy(data + first * sizeof(ModelVertex), modelMesh->vertices.data, count * sizeof(ModelVertex));
+
+    for (size_t v = 0; v < count; v++) {
+      ModelVertex vertex = modelMesh->vertices.data[v];
+      float position[4] = { vertex.x, vertex.y, vertex.z, 1.f };
+      vec_pusharr(&model->positions, position, 4);
+
+      if (modelData->hasTexCoords) {
+        memcpy(data + texCoordOffset + (first + v) * 2 * sizeof(float), &modelMesh->texCoords.data[v], 2 * sizeof(float));
+      }
+
+      if (modelData->hasNormals) {
+        ModelVertex n = modelMesh->normals.data[v];
+        float normal[4] = { n.x, n.y, n.z, 0.f };
+        uint32_t packed = lovrMeshPackInt1010102(normal, 1);
+        memcpy(data + normalOffset + (first + v) * sizeof(uint32_t), &packed, sizeof(uint32_t));
+      }
+
+      // Vertices of rigid primitives have no weights.  Bones are indices into the palette of the primitive.
+      if (model->isSkinned) {
+        ModelBoneWeights boneWeights = { .bones = { 0 }, .weights = { 0.f } };
+        if (primitive->isSkinned) {
+          boneWeights = modelMesh->boneWeights.data[v];
+        }
+
+        float total = 0;
+        for (int i = 0; i < MAX_BONES_PER_VERTEX; i++) {
+          total += boneWeights.weights[i];
+        }
+
+        uint8_t* bones = (uint8_t*) data + boneOffset + (first + v) * MAX_BONES_PER_VERTEX;
+        uint8_t* weights = bones + vertexCount * MAX_BONES_PER_VERTEX;
+        for (int i = 0; i < MAX_BONES_PER_VERTEX; i++) {
+          boneWeights.weights[i] = total > 0 ? boneWeights.weights[i] / total : 0.f;
+          bones[i] = boneWeights.weights[i] > 0.f ? slots[boneWeights.bones[i]] : 0;
+          weights[i] = (uint8_t) roundf(boneWeights.weights[i] * 255.f);
+        }
+
+        vec_push(&model->skinWeights, boneWeights);
+      }
+    }
+
+    for (int f = 0; f < modelMesh->faces.length; f++) {
+      ModelFace face = modelMesh->faces.data[f];
+      vec_push(&indices, face.indices[0] + primitive->vertices.offset);
+      vec_push(&indices, face.indices[1] + primitive->vertices.offset);
+      vec_push(&indices, face.indices[2] + primitive->vertices.offset);
+    }
+  }
+
+  vec_foreach(&modelData->meshes, modelMesh, m) {
+    ModelPrimitive* primitive = &model->primitives.data[m];
+    for (int f = 0; f < modelMesh->lodFaces.length; f++) {
+      ModelFace face = modelMesh->lodFaces.data[f];
+      vec_push(&indices, face.indices[0] + primitive->vertices.offset);
+      vec_push(&indices, face.indices[1] + primitive->vertices.offset);
+      vec_push(&indices, face.indices[2] + primitive->vertices.offset);
+    }
+  }
   lovrMeshUnmap(model->mesh);
   lovrMeshSetVertexMap(model->mesh, indices.data, indices.length);
+  free(slots);
 
-  model->texture = NULL;
+  // Materials
+  model->materialCount = modelData->materials.length;
+  model->materials = malloc(model->materialCount * sizeof(Material*));
+  model->materialVersions = malloc(model->materialCount * sizeof(int));
+  model->materialShaders = malloc(model->materialCount * sizeof(Shader*));
+  model->materialsDirty = 1;
+  Texture** textures = calloc(MAX(modelData->images.length, 1), sizeof(Texture*));
+  lovrAssert(model->materials && model->materialVersions && model->materialShaders && textures, "Out of memory");
+  for (int i = 0; i < model->materialCount; i++) {
+    ModelMaterial* modelMaterial = &modelData->materials.data[i];
+    Material* material = lovrMaterialCreate();
+    float* diffuse = modelMaterial->diffuseColor;
+    float* emissive = modelMaterial->emissiveColor;
+    lovrMaterialSetColor(material, COLOR_DIFFUSE, (Color) { colorComponent(diffuse[0]), colorComponent(diffuse[1]), colorComponent(diffuse[2]), colorComponent(diffuse[3]) });
+    lovrMaterialSetColor(material, COLOR_EMISSIVE, (Color) { colorComponent(emissive[0]), colorComponent(emissive[1]), colorComponent(emissive[2]), 0xff });
+    lovrMaterialSetTexture(material, TEXTURE_DIFFUSE, lovrModelLoadTexture(modelData, textures, modelMaterial->diffuseTexture));
+    lovrMaterialSetTexture(material, TEXTURE_EMISSIVE, lovrModelLoadTexture(modelData, textures, modelMaterial->emissiveTexture));
+    model->materials[i] = material;
+    model->materialVersions[i] = -1;
+    model->materialShaders[i] = NULL;
+  }
+
+  for (int i = 0; i < modelData->images.length; i++) {
+    if (textures[i]) {
+      lovrRelease(&textures[i]->ref);
+    }
+  }
+  free(textures);
+
+  // Ranges of uniform buffers have to start at a multiple of the offset alignment
+  GLint alignment;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  alignment = MAX(alignment, 1);
+  model->materialStride = (sizeof(MaterialBlock) + alignment - 1) / alignment * alignment;
+  glGenBuffers(1, &model->materialBuffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, model->materialBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, MAX(model->materialCount, 1) * model->materialStride, NULL, GL_DYNAMIC_DRAW);
+
+  if (modelData->animations.length > 0) {
+    model->animator = lovrAnimatorCreate(modelData);
+  }
+
+  // Each palette is a PoseBlock in the pose buffer
+  if (model->isSkinned) {
+    model->poseStride = (sizeof(PoseBlock) + alignment - 1) / alignment * alignment;
+    model->poseBlocks = calloc(MAX(model->paletteCount, 1), model->poseStride);
+    lovrAssert(model->poseBlocks, "Out of memory");
+    for (int i = 0; i < model->paletteCount; i++) {
+      ((PoseBlock*) (model->poseBlocks + i * model->poseStride))->skinned = 1;
+    }
+
+    glGenBuffers(1, &model->poseBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, model->poseBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, MAX(model->paletteCount, 1) * model->poseStride, NULL, GL_DYNAMIC_DRAW);
+  }
+
+  lovrModelUpdateNodes(model);
+
+  // Skinned primitives move with their bones, their bounding box comes from the rest pose
+  if (model->isSkinned) {
+    ModelPrimitive* primitive; int i;
+    vec_foreach_ptr(&model->primitives, primitive, i) {
+      if (!primitive->isSkinned) continue;
+      for (size_t v = primitive->vertices.offset; v < primitive->vertices.offset + primitive->vertices.count; v++) {
+        float skinned[3];
+        skinVertex(model->pose, model->positions.data + 4 * v, &model->skinWeights.data[v], skinned);
+        aabbAdd(model->skinnedAABB, skinned);
+      }
+    }
+
+    lovrModelUpdateBounds(model);
+  }
 
   vec_deinit(&format);
-  vec_deinit(&vertices);
   vec_deinit(&indices);
   return model;
 }
@@ -123,26 +617,232 @@ void lovrModelDestroy(const Ref* ref) {
   if (model->texture) {
     lovrRelease(&model->texture->ref);
   }
-  lovrModelDataDestroy(model->modelData);
+  if (model->modelData) {
+    lovrModelDataDestroy(model->modelData);
+  }
+  if (model->animator) {
+    lovrAnimatorDestroy(model->animator);
+  }
+  for (int i = 0; i < model->nodeCount; i++) {
+    free(model->nodes[i].name);
+  }
+  ModelPrimitive* primitive; int i;
+  vec_foreach_ptr(&model->primitives, primitive, i) {
+    if (primitive->bvh) {
+      lovrBvhDestroy(primitive->bvh);
+    }
+  }
+  for (int i = 0; i < model->materialCount; i++) {
+    lovrRelease(&model->materials[i]->ref);
+  }
   lovrRelease(&model->mesh->ref);
+  glDeleteBuffers(1, &model->poseBuffer);
+  glDeleteBuffers(1, &model->materialBuffer);
+  vec_deinit(&model->primitives);
+  vec_deinit(&model->parts);
+  vec_deinit(&model->visibleRanges);
+  vec_deinit(&model->boneNodes);
+  vec_deinit(&model->boneOffsets);
+  vec_deinit(&model->paletteBones);
+  vec_deinit(&model->positions);
+  vec_deinit(&model->skinWeights);
+  free(model->nodes);
+  free(model->nodeTransforms);
+  free(model->nodeInverses);
+  free(model->pose);
+  free(model->poseBlocks);
+  free(model->materials);
+  free(model->materialVersions);
+  free(model->materialShaders);
   free(model);
 }
 
+// The fraction of the screen height covered by the bounding sphere of the model, which is 1 when the
+// camera is inside of it
+static float lovrModelGetScreenSize(Model* model, mat4 transform) {
+  float* aabb = model->aabb;
+  if (aabb[0] > aabb[1]) {
+    return 0.f;
+  }
+
+  float modelView[16];
+  mat4_set(modelView, lovrGraphicsGetTransform(MATRIX_VIEW));
+  mat4_multiply(modelView, lovrGraphicsGetTransform(MATRIX_MODEL));
+  mat4_multiply(modelView, transform);
+
+  float center[3] = { (aabb[0] + aabb[1]) * .5f, (aabb[2] + aabb[3]) * .5f, (aabb[4] + aabb[5]) * .5f };
+  float extent[3] = { aabb[1] - center[0], aabb[3] - center[1], aabb[5] - center[2] };
+  mat4_transform(modelView, center);
+
+  float scale = 0.f;
+  for (int i = 0; i < 3; i++) {
+    float* column = modelView + 4 * i;
+    scale = MAX(scale, column[0] * column[0] + column[1] * column[1] + column[2] * column[2]);
+  }
+
+  float radius = vec3_length(extent) * sqrtf(scale);
+  mat4 projection = lovrGraphicsGetProjection();
+
+  // Perspective projections divide by distance, orthographic ones don't
+  if (projection[15] == 0.f) {
+    float distance = -center[2];
+    return distance > radius ? radius * projection[5] / distance : 1.f;
+  } else {
+    return radius * projection[5];
+  }
+}
+
+static int lovrModelPickLod(Model* model, float size) {
+  int lod = 0;
+  float threshold = LOD_SCREEN_SIZE;
+  while (lod < model->lodCount - 1 && size < threshold) {
+    threshold *= .5f;
+    lod++;
+  }
+  return lod;
+}
+
+// Draws the visible ranges collected for a node and material, or for the skinned primitives if node is -1
+static void lovrModelDrawBatch(Model* model, mat4 transform, int node) {
+  if (model->visibleRanges.length == 0) {
+    return;
+  }
+
+  float batchTransform[16];
+  mat4_set(batchTransform, transform);
+  if (node >= 0) {
+    mat4_multiply(batchTransform, model->nodes[node].globalTransform);
+  }
+
+  lovrMeshDrawRanges(model->mesh, batchTransform, model->visibleRanges.data, model->visibleRanges.length);
+  vec_clear(&model->visibleRanges);
+}
+
 void lovrModelDraw(Model* model, mat4 transform) {
-  lovrMeshDraw(model->mesh, transform);
+  DrawCommand command = { .type = DRAW_COMMAND_MODEL, .object = &model->ref };
+  if (lovrGraphicsRecord(&command, transform)) return;
+
+  if (lovrModelIsDirty(model)) {
+    lovrModelUpdateNodes(model);
+  }
+
+  // The picked level is only remembered so it can be queried, it doesn't affect the next draw
+  int lod = model->lod;
+  if (model->autoLod && model->lodCount > 1) {
+    lod = lovrModelPickLod(model, lovrModelGetScreenSize(model, transform));
+    model->lod = lod;
+  }
+
+  lovrModelUpdateMaterials(model);
+
+  float clip[16];
+  mat4_set(clip, lovrGraphicsGetProjection());
+  mat4_multiply(clip, lovrGraphicsGetTransform(MATRIX_VIEW));
+  mat4_multiply(clip, lovrGraphicsGetTransform(MATRIX_MODEL));
+  mat4_multiply(clip, transform);
+
+  // Visible parts of each node that share a material are culled and drawn with one multi-draw.
+  // Skinned parts move with their bones, so they aren't culled, and they're batched by palette.  Other
+  // parts use the default pose, which doesn't skin.  A texture set on the model replaces the diffuse
+  // textures of its materials.
+  float nodeClip[16];
+  int batchNode = -2;
+  int batchPalette = -2;
+  int batchMaterial = -1;
+  vec_clear(&model->visibleRanges);
+  ModelPart* part; int i;
+  vec_foreach_ptr(&model->parts, part, i) {
+    ModelNodeState* node = &model->nodes[part->node];
+    ModelPrimitive* primitive = &model->primitives.data[part->primitive];
+    if (!node->globalVisible) {
+      continue;
+    }
+
+    int partNode = primitive->isSkinned ? -1 : part->node;
+    int partPalette = primitive->isSkinned ? primitive->palette : -1;
+    if (partNode != batchNode || partPalette != batchPalette || primitive->material != batchMaterial) {
+      lovrModelDrawBatch(model, transform, batchNode);
+
+      if (primitive->material != batchMaterial) {
+        Material* material = model->materials[primitive->material];
+        batchMaterial = primitive->material;
+        lovrMeshSetTexture(model->mesh, model->texture ? model->texture : material->textures[TEXTURE_DIFFUSE]);
+        lovrGraphicsBindMaterial(material, model->materialBuffer, batchMaterial * model->materialStride);
+      }
+
+      if (partPalette != batchPalette) {
+        batchPalette = partPalette;
+        if (partPalette >= 0) {
+          lovrGraphicsBindPose(model->poseBuffer, partPalette * model->poseStride);
+        } else {
+          lovrGraphicsBindPose(0, 0);
+        }
+      }
+
+      if (partNode != batchNode) {
+        batchNode = partNode;
+        if (partNode >= 0) {
+          mat4_set(nodeClip, clip);
+          mat4_multiply(nodeClip, node->globalTransform);
+        }
+      }
+    }
+
+    if (partNode >= 0 && !aabbIsVisible(part->aabb, nodeClip)) {
+      continue;
+    }
+
+    vec_push(&model->visibleRanges, primitive->indices[MIN(lod, primitive->lodCount - 1)]);
+  }
+
+  lovrModelDrawBatch(model, transform, batchNode);
+  lovrGraphicsBindMaterial(NULL, 0, 0);
+
+  if (model->isSkinned) {
+    lovrGraphicsBindPose(0, 0);
+  }
+}
+
+// The Model copies everything it needs to draw, so the imported data is only kept around on request.
+// Animated models need their animations, so they always keep it.
+void lovrModelReleaseData(Model* model) {
+  if (model->modelData && !model->animator) {
+    lovrModelDataDestroy(model->modelData);
+    model->modelData = NULL;
+  }
+}
+
+int lovrModelGetMaterialCount(Model* model) {
+  return model->materialCount;
+}
+
+Material* lovrModelGetMaterial(Model* model, int index) {
+  return model->materials[index];
+}
+
+// Materials can be shared between models
+void lovrModelSetMaterial(Model* model, int index, Material* material) {
+  lovrGraphicsFlushObject(&model->ref);
+  if (model->materials[index] != material) {
+    lovrRetain(&material->ref);
+    lovrRelease(&model->materials[index]->ref);
+    model->materials[index] = material;
+    model->materialsDirty = 1;
+  }
 }
 
 Texture* lovrModelGetTexture(Model* model) {
   return model->texture;
 }
 
+// The texture replaces the diffuse textures of all materials, or NULL goes back to using them
 void lovrModelSetTexture(Model* model, Texture* texture) {
+  lovrGraphicsFlushObject(&model->ref);
   if (model->texture) {
     lovrRelease(&model->texture->ref);
   }
 
   model->texture = texture;
-  lovrMeshSetTexture(model->mesh, model->texture);
 
   if (model->texture) {
     lovrRetain(&model->texture->ref);
@@ -150,5 +850,199 @@ void lovrModelSetTexture(Model* model, Texture* texture) {
 }
 
 float* lovrModelGetAABB(Model* model) {
+  if (lovrModelIsDirty(model)) {
+    lovrModelUpdateNodes(model);
+  }
+
   return model->aabb;
 }
+
+Animator* lovrModelGetAnimator(Model* model) {
+  return model->animator;
+}
+
+int lovrModelGetNodeCount(Model* model) {
+  return model->nodeCount;
+}
+
+int lovrModelFindNode(Model* model, const char* name) {
+  for (int i = 0; i < model->nodeCount; i++) {
+    if (!strcmp(model->nodes[i].name, name)) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+const char* lovrModelGetNodeName(Model* model, int node) {
+  return model->nodes[node].name;
+}
+
+void lovrModelGetNodeTransform(Model* model, int node, mat4 transform) {
+  mat4_set(transform, model->nodes[node].transform);
+}
+
+// Node transforms are relative to the parent node.  Animations are applied on top of them.
+void lovrModelSetNodeTransform(Model* model, int node, mat4 transform) {
+  lovrGraphicsFlushObject(&model->ref);
+  mat4_set(model->nodes[node].transform, transform);
+  model->nodesDirty = 1;
+}
+
+int lovrModelIsNodeVisible(Model* model, int node) {
+  return model->nodes[node].visible;
+}
+
+// Hiding a node hides its children too
+void lovrModelSetNodeVisible(Model* model, int node, int visible) {
+  lovrGraphicsFlushObject(&model->ref);
+  model->nodes[node].visible = visible;
+  model->nodesDirty = 1;
+}
+
+int lovrModelGetLodCount(Model* model) {
+  return model->lodCount;
+}
+
+// The forced level of detail, or the one picked by the last draw
+int lovrModelGetLod(Model* model) {
+  return model->lod;
+}
+
+// Forces a level of detail, or goes back to picking one based on screen size if lod is -1
+void lovrModelSetLod(Model* model, int lod) {
+  lovrGraphicsFlushObject(&model->ref);
+  model->autoLod = lod < 0;
+  model->lod = lod < 0 ? model->lod : lod;
+}
+
+int lovrModelGetVertexCount(Model* model) {
+  return lovrMeshGetVertexCount(model->mesh);
+}
+
+// Poses the vertices of a skinned model on the CPU, writing 3 floats per vertex.  Used for physics
+// and picking, where the GPU skinned vertices aren't available.  Rigid primitives are transformed
+// by the first node that draws them.
+void lovrModelGetSkinnedPositions(Model* model, float* positions) {
+  lovrAssert(model->isSkinned, "Model is not skinned");
+  if (lovrModelIsDirty(model)) {
+    lovrModelUpdateNodes(model);
+  }
+
+  ModelPrimitive* primitive; int i;
+  vec_foreach_ptr(&model->primitives, primitive, i) {
+    size_t start = primitive->vertices.offset;
+    size_t end = start + primitive->vertices.count;
+    for (size_t v = start; v < end; v++) {
+      float* position = model->positions.data + 4 * v;
+      float* result = positions + 3 * v;
+      if (primitive->isSkinned) {
+        skinVertex(model->pose, position, &model->skinWeights.data[v], result);
+      } else {
+        vec3_init(result, position);
+        if (primitive->node >= 0) {
+          mat4_transform(model->nodes[primitive->node].globalTransform, result);
+        }
+      }
+    }
+  }
+}
+
+int lovrModelGetTriangleCount(Model* model) {
+  return model->triangleCount;
+}
+
+void lovrModelGetTriangle(Model* model, int triangle, unsigned int* vertices) {
+  size_t count;
+  unsigned int* indices = lovrMeshGetVertexMap(model->mesh, &count);
+  memcpy(vertices, indices + 3 * triangle, 3 * sizeof(unsigned int));
+}
+
+// Brings the node inverses up to date with the pose, and builds the BVHs the first time
+static void lovrModelPrepareRaycast(Model* model) {
+  if (lovrModelIsDirty(model)) {
+    lovrModelUpdateNodes(model);
+  }
+
+  // Nodes that are scaled flat can't be inverted, and their inverse is left as zeros
+  if (model->inversesDirty) {
+    for (int i = 0; i < model->nodeCount; i++) {
+      float* inverse = model->nodeInverses + 16 * i;
+      mat4_set(inverse, model->nodes[i].globalTransform);
+      if (!mat4_invert(inverse)) {
+        memset(inverse, 0, 16 * sizeof(float));
+      }
+    }
+
+    model->inversesDirty = 0;
+  }
+
+  size_t count;
+  unsigned int* indices = lovrMeshGetVertexMap(model->mesh, &count);
+  ModelPrimitive* primitive; int i;
+  vec_foreach_ptr(&model->primitives, primitive, i) {
+    if (!primitive->bvh) {
+      MeshRange* range = &primitive->indices[0];
+      primitive->bvh = lovrBvhCreate(model->positions.data, 4, indices + range->offset, range->count / 3);
+      lovrAssert(primitive->bvh, "Out of memory");
+    }
+  }
+}
+
+// Rays are moved into the space of each part, which keeps distances the same.  Skinned parts are
+// tested in their rest pose.
+static int lovrModelRaycastParts(Model* model, float* origin, float* direction, ModelHit* hit) {
+  int found = 0;
+  ModelPart* part; int i;
+  vec_foreach_ptr(&model->parts, part, i) {
+    ModelNodeState* node = &model->nodes[part->node];
+    ModelPrimitive* primitive = &model->primitives.data[part->primitive];
+    float* inverse = model->nodeInverses + 16 * part->node;
+    if (!node->globalVisible || (!primitive->isSkinned && inverse[15] == 0.f)) {
+      continue;
+    }
+
+    float partOrigin[3], partDirection[3];
+    vec3_init(partOrigin, origin);
+    vec3_init(partDirection, direction);
+    if (!primitive->isSkinned) {
+      mat4_transform(inverse, partOrigin);
+      mat4_transformDirection(inverse, partDirection);
+    }
+
+    BvhHit bvhHit = { .distance = hit->distance };
+    if (lovrBvhRaycast(primitive->bvh, partOrigin, partDirection, &bvhHit)) {
+      hit->distance = bvhHit.distance;
+      hit->triangle = primitive->indices[0].offset / 3 + bvhHit.triangle;
+      hit->node = part->node;
+      hit->u = bvhHit.u;
+      hit->v = bvhHit.v;
+      found = 1;
+    }
+  }
+
+  return found;
+}
+
+static void raycastBatch(void* userdata, int start, int end) {
+  ModelRaycastBatch* batch = userdata;
+  for (int i = start; i < end; i++) {
+    float* ray = batch->rays + 6 * i;
+    lovrModelRaycastParts(batch->model, ray, ray + 3, &batch->hits[i]);
+  }
+}
+
+// Finds the closest triangle hit by a ray in the space of the model, if it's closer than hit->distance.
+// Distances are in multiples of the length of the direction.
+int lovrModelRaycast(Model* model, float* origin, float* direction, ModelHit* hit) {
+  lovrModelPrepareRaycast(model);
+  return lovrModelRaycastParts(model, origin, direction, hit);
+}
+
+// Each ray is an origin and a direction, and updates its hit like lovrModelRaycast
+void lovrModelRaycastBatch(Model* model, float* rays, int count, ModelHit* hits) {
+  lovrModelPrepareRaycast(model);
+  ModelRaycastBatch batch = { model, rays, hits };
+  lovrParallelFor(count, RAYCAST_GRAIN, raycastBatch, &batch);
+}
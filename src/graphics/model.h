@@ -1,23 +1,128 @@
 #include "loaders/model.h"
+#include "graphics/animator.h"
+#include "graphics/material.h"
 #include "graphics/mesh.h"
 #include "graphics/texture.h"
+#include "math/bvh.h"
 #include "math/math.h"
 #include "lib/glfw.h"
 #include "util.h"
 
 #pragma once
 
+// The vertices and indices of each ModelMesh are stored once in the shared Mesh.  There's a range
+// of indices for each level of detail, starting with full detail.  The BVH is built the first time
+// the primitive is raycast.  The material is an index into the materials of the Model.  Skinned
+// primitives are drawn with one of the bone palettes of the Model.
+typedef struct {
+  MeshRange vertices;
+  MeshRange indices[MAX_LODS];
+  int lodCount;
+  int node;
+  int isSkinned;
+  int palette;
+  int material;
+  Bvh* bvh;
+} ModelPrimitive;
+
+typedef vec_t(ModelPrimitive) vec_model_primitive_t;
+
+// A primitive drawn by a node.  The bounding box is in the space of the primitive.  Parts are sorted by
+// their key, which groups them by shader, then material, then node.
+typedef struct {
+  int node;
+  int primitive;
+  uint64_t key;
+  float aabb[6];
+} ModelPart;
+
+typedef vec_t(ModelPart) vec_model_part_t;
+
+// Triangles are numbered by their position in the index buffer.  The barycentric coordinates u and v
+// weight the second and third vertex of the triangle.
+typedef struct {
+  float distance;
+  int triangle;
+  int node;
+  float u;
+  float v;
+} ModelHit;
+
+// Nodes are ordered so parents come before their children
+typedef struct {
+  char* name;
+  int parent;
+  int visible;
+  int globalVisible;
+  float transform[16];
+  float globalTransform[16];
+} ModelNodeState;
+
 typedef struct {
   Ref ref;
   ModelData* modelData;
   Mesh* mesh;
+  vec_model_primitive_t primitives;
+  vec_model_part_t parts;
+  vec_t(MeshRange) visibleRanges;
+  ModelNodeState* nodes;
+  int nodeCount;
+  int nodesDirty;
+  int triangleCount;
+  Material** materials;
+  int materialCount;
+  int materialsDirty;
+  int* materialVersions;
+  Shader** materialShaders;
+  GLuint materialBuffer;
+  size_t materialStride;
   Texture* texture;
   float aabb[6];
+  float skinnedAABB[6];
+  int isSkinned;
+  int lod;
+  int lodCount;
+  int autoLod;
+  Animator* animator;
+  vec_int_t boneNodes;
+  vec_float_t boneOffsets;
+  vec_float_t positions;
+  vec_model_bone_weights_t skinWeights;
+  float* nodeTransforms;
+  float* nodeInverses;
+  int inversesDirty;
+  float* pose;
+  vec_int_t paletteBones;
+  int paletteCount;
+  char* poseBlocks;
+  size_t poseStride;
+  GLuint poseBuffer;
 } Model;
 
 Model* lovrModelCreate(ModelData* modelData);
 void lovrModelDestroy(const Ref* ref);
 void lovrModelDraw(Model* model, mat4 transform);
+void lovrModelReleaseData(Model* model);
+int lovrModelGetMaterialCount(Model* model);
+Material* lovrModelGetMaterial(Model* model, int index);
+void lovrModelSetMaterial(Model* model, int index, Material* material);
 Texture* lovrModelGetTexture(Model* model);
 void lovrModelSetTexture(Model* model, Texture* texture);
 float* lovrModelGetAABB(Model* model);
+Animator* lovrModelGetAnimator(Model* model);
+int lovrModelGetNodeCount(Model* model);
+int lovrModelFindNode(Model* model, const char* name);
+const char* lovrModelGetNodeName(Model* model, int node);
+void lovrModelGetNodeTransform(Model* model, int node, mat4 transform);
+void lovrModelSetNodeTransform(Model* model, int node, mat4 transform);
+int lovrModelIsNodeVisible(Model* model, int node);
+void lovrModelSetNodeVisible(Model* model, int node, int visible);
+int lovrModelGetLodCount(Model* model);
+int lovrModelGetLod(Model* model);
+void lovrModelSetLod(Model* model, int lod);
+int lovrModelGetVertexCount(Model* model);
+void lovrModelGetSkinnedPositions(Model* model, float* positions);
+int lovrModelGetTriangleCount(Model* model);
+void lovrModelGetTriangle(Model* model, int triangle, unsigned int* vertices);
+int lovrModelRaycast(Model* model, float* origin, float* direction, ModelHit* hit);
+void lovrModelRaycastBatch(Model* model, float* rays, int count, ModelHit* hits);
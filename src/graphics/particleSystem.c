@@ -0,0 +1,355 @@
+#include "graphics/particleSystem.h"
+#include "graphics/graphics.h"
+#include "math/vec3.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+typedef struct {
+  ParticleSystem* particleSystem;
+  float dt;
+} ParticleUpdate;
+
+static float lerp(float a, float b, float t) {
+  return a + (b - a) * t;
+}
+
+static float randomRange(ParticleSystem* particleSystem, float* range) {
+  return lerp(range[0], range[1], lovrRandomGeneratorRandom(particleSystem->generator));
+}
+
+// Integrates particles in [start, end) and writes their instance data.  Particles are stored as
+// separate arrays for each component so 4 of them can be processed at a time.
+static void updateParticles(void* userdata, int start, int end) {
+  ParticleUpdate* update = userdata;
+  ParticleSystem* ps = update->particleSystem;
+  float dt = update->dt;
+  float damping = MAX(1.f - ps->drag * dt, 0.f);
+  float gx = ps->gravity[0] * dt;
+  float gy = ps->gravity[1] * dt;
+  float gz = ps->gravity[2] * dt;
+  float sizes[2] = { ps->sizes[0], ps->sizes[1] };
+  float colors[2][4] = {
+    { ps->colors[0].r / 255.f, ps->colors[0].g / 255.f, ps->colors[0].b / 255.f, ps->colors[0].a / 255.f },
+    { ps->colors[1].r / 255.f, ps->colors[1].g / 255.f, ps->colors[1].b / 255.f, ps->colors[1].a / 255.f }
+  };
+
+  int i = start;
+
+#ifdef __SSE__
+  __m128 vdt = _mm_set1_ps(dt);
+  __m128 vdamping = _mm_set1_ps(damping);
+  __m128 vgx = _mm_set1_ps(gx), vgy = _mm_set1_ps(gy), vgz = _mm_set1_ps(gz);
+  __m128 one = _mm_set1_ps(1.f);
+  __m128 size0 = _mm_set1_ps(sizes[0]), sizeDelta = _mm_set1_ps(sizes[1] - sizes[0]);
+  __m128 color0[4], colorDelta[4];
+  for (int c = 0; c < 4; c++) {
+    color0[c] = _mm_set1_ps(colors[0][c]);
+    colorDelta[c] = _mm_set1_ps(colors[1][c] - colors[0][c]);
+  }
+
+  for (; i + 4 <= end; i += 4) {
+    __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(ps->vx + i), vgx), vdamping);
+    __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(ps->vy + i), vgy), vdamping);
+    __m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(ps->vz + i), vgz), vdamping);
+    __m128 x = _mm_add_ps(_mm_loadu_ps(ps->x + i), _mm_mul_ps(vx, vdt));
+    __m128 y = _mm_add_ps(_mm_loadu_ps(ps->y + i), _mm_mul_ps(vy, vdt));
+    __m128 z = _mm_add_ps(_mm_loadu_ps(ps->z + i), _mm_mul_ps(vz, vdt));
+    __m128 age = _mm_add_ps(_mm_loadu_ps(ps->age + i), vdt);
+    __m128 t = _mm_min_ps(_mm_div_ps(age, _mm_loadu_ps(ps->lifetime + i)), one);
+    _mm_storeu_ps(ps->vx + i, vx);
+    _mm_storeu_ps(ps->vy + i, vy);
+    _mm_storeu_ps(ps->vz + i, vz);
+    _mm_storeu_ps(ps->x + i, x);
+    _mm_storeu_ps(ps->y + i, y);
+    _mm_storeu_ps(ps->z + i, z);
+    _mm_storeu_ps(ps->age + i, age);
+
+    // Transpose into the interleaved layout used by the instance buffer
+    __m128 size = _mm_add_ps(size0, _mm_mul_ps(sizeDelta, t));
+    __m128 r = _mm_add_ps(color0[0], _mm_mul_ps(colorDelta[0], t));
+    __m128 g = _mm_add_ps(color0[1], _mm_mul_ps(colorDelta[1], t));
+    __m128 b = _mm_add_ps(color0[2], _mm_mul_ps(colorDelta[2], t));
+    __m128 a = _mm_add_ps(color0[3], _mm_mul_ps(colorDelta[3], t));
+    _MM_TRANSPOSE4_PS(x, y, z, size);
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+    float* instance = ps->instances + i * PARTICLE_INSTANCE_SIZE;
+    _mm_storeu_ps(instance + 0, x);
+    _mm_storeu_ps(instance + 4, r);
+    _mm_storeu_ps(instance + 8, y);
+    _mm_storeu_ps(instance + 12, g);
+    _mm_storeu_ps(instance + 16, z);
+    _mm_storeu_ps(instance + 20, b);
+    _mm_storeu_ps(instance + 24, size);
+    _mm_storeu_ps(instance + 28, a);
+  }
+#endif
+
+  for (; i < end; i++) {
+    ps->vx[i] = (ps->vx[i] + gx) * damping;
+    ps->vy[i] = (ps->vy[i] + gy) * damping;
+    ps->vz[i] = (ps->vz[i] + gz) * damping;
+    ps->x[i] += ps->vx[i] * dt;
+    ps->y[i] += ps->vy[i] * dt;
+    ps->z[i] += ps->vz[i] * dt;
+    ps->age[i] += dt;
+    float t = MIN(ps->age[i] / ps->lifetime[i], 1.f);
+    float* instance = ps->instances + i * PARTICLE_INSTANCE_SIZE;
+    instance[0] = ps->x[i];
+    instance[1] = ps->y[i];
+    instance[2] = ps->z[i];
+    instance[3] = lerp(sizes[0], sizes[1], t);
+    for (int c = 0; c < 4; c++) {
+      instance[4 + c] = lerp(colors[0][c], colors[1][c], t);
+    }
+  }
+}
+
+// Dead particles are replaced by the last live particle so the arrays stay packed
+static void killParticles(ParticleSystem* ps) {
+  float* arrays[] = { ps->x, ps->y, ps->z, ps->vx, ps->vy, ps->vz, ps->age, ps->lifetime };
+  int i = 0;
+  while (i < ps->count) {
+    if (ps->age[i] < ps->lifetime[i]) {
+      i++;
+      continue;
+    }
+
+    int last = --ps->count;
+    for (int j = 0; j < 8; j++) {
+      arrays[j][i] = arrays[j][last];
+    }
+    memcpy(ps->instances + i * PARTICLE_INSTANCE_SIZE, ps->instances + last * PARTICLE_INSTANCE_SIZE, PARTICLE_INSTANCE_SIZE * sizeof(float));
+  }
+}
+
+ParticleSystem* lovrParticleSystemCreate(int capacity) {
+  lovrAssert(capacity > 0, "ParticleSystem capacity must be positive");
+
+  ParticleSystem* ps = lovrAlloc(sizeof(ParticleSystem), lovrParticleSystemDestroy);
+  if (!ps) return NULL;
+
+  ps->count = 0;
+  ps->capacity = capacity;
+  ps->data = malloc(capacity * (8 + PARTICLE_INSTANCE_SIZE) * sizeof(float));
+  float** arrays[] = { &ps->x, &ps->y, &ps->z, &ps->vx, &ps->vy, &ps->vz, &ps->age, &ps->lifetime };
+  for (int i = 0; i < 8; i++) {
+    *arrays[i] = ps->data + i * capacity;
+  }
+  ps->instances = ps->data + 8 * capacity;
+
+  vec3_set(ps->position, 0, 0, 0);
+  vec3_set(ps->direction, 0, 1, 0);
+  ps->spread = M_PI;
+  ps->speed[0] = ps->speed[1] = 1;
+  ps->lifetimes[0] = ps->lifetimes[1] = 1;
+  vec3_set(ps->gravity, 0, 0, 0);
+  ps->drag = 0;
+  ps->sizes[0] = ps->sizes[1] = .1;
+  ps->colors[0] = ps->colors[1] = (Color) { 255, 255, 255, 255 };
+  ps->emissionRate = 0;
+  ps->emissionTimer = 0;
+  ps->generator = lovrRandomGeneratorCreate();
+  ps->texture = NULL;
+
+  float quad[] = {
+    -.5, .5, 0,  0, 0,
+    -.5, -.5, 0, 0, 1,
+    .5, .5, 0,   1, 0,
+    .5, -.5, 0,  1, 1
+  };
+
+  size_t stride = PARTICLE_INSTANCE_SIZE * sizeof(float);
+  glGenVertexArrays(1, &ps->vao);
+  glGenBuffers(1, &ps->quadBuffer);
+  glGenBuffers(1, &ps->instanceBuffer);
+  lovrGraphicsBindVertexArray(ps->vao);
+  lovrGraphicsBindVertexBuffer(ps->quadBuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(LOVR_SHADER_POSITION);
+  glVertexAttribPointer(LOVR_SHADER_POSITION, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
+  glEnableVertexAttribArray(LOVR_SHADER_TEX_COORD);
+  glVertexAttribPointer(LOVR_SHADER_TEX_COORD, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*) (3 * sizeof(float)));
+  lovrGraphicsBindVertexBuffer(ps->instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, capacity * stride, NULL, GL_STREAM_DRAW);
+  glEnableVertexAttribArray(LOVR_SHADER_PARTICLE);
+  glVertexAttribPointer(LOVR_SHADER_PARTICLE, 4, GL_FLOAT, GL_FALSE, stride, 0);
+  glVertexAttribDivisor(LOVR_SHADER_PARTICLE, 1);
+  glEnableVertexAttribArray(LOVR_SHADER_VERTEX_COLOR);
+  glVertexAttribPointer(LOVR_SHADER_VERTEX_COLOR, 4, GL_FLOAT, GL_FALSE, stride, (void*) (4 * sizeof(float)));
+  glVertexAttribDivisor(LOVR_SHADER_VERTEX_COLOR, 1);
+
+  return ps;
+}
+
+void lovrParticleSystemDestroy(const Ref* ref) {
+  ParticleSystem* particleSystem = containerof(ref, ParticleSystem);
+  if (particleSystem->texture) {
+    lovrRelease(&particleSystem->texture->ref);
+  }
+  lovrRelease(&particleSystem->generator->ref);
+  glDeleteBuffers(1, &particleSystem->quadBuffer);
+  glDeleteBuffers(1, &particleSystem->instanceBuffer);
+  glDeleteVertexArrays(1, &particleSystem->vao);
+  free(particleSystem->data);
+  free(particleSystem);
+}
+
+// New particles are sent out in a cone around the emission direction, spread is its angle in radians
+void lovrParticleSystemEmit(ParticleSystem* particleSystem, int count) {
+  lovrGraphicsFlushObject(&particleSystem->ref);
+  ParticleSystem* ps = particleSystem;
+  count = MIN(count, ps->capacity - ps->count);
+
+  float d[3], u[3], w[3];
+  vec3_normalize(vec3_init(d, ps->direction));
+  vec3_set(u, fabsf(d[0]) < .9f ? 1 : 0, fabsf(d[0]) < .9f ? 0 : 1, 0);
+  vec3_normalize(vec3_cross(u, d));
+  vec3_cross(vec3_init(w, d), u);
+  float cosSpread = cosf(MIN(ps->spread, (float) M_PI));
+
+  for (int n = 0; n < count; n++) {
+    int i = ps->count++;
+    float cosTheta = lerp(1.f, cosSpread, lovrRandomGeneratorRandom(ps->generator));
+    float sinTheta = sqrtf(MAX(1.f - cosTheta * cosTheta, 0.f));
+    float phi = 2 * M_PI * lovrRandomGeneratorRandom(ps->generator);
+    float speed = randomRange(ps, ps->speed);
+    float a = sinTheta * cosf(phi);
+    float b = sinTheta * sinf(phi);
+
+    ps->x[i] = ps->position[0];
+    ps->y[i] = ps->position[1];
+    ps->z[i] = ps->position[2];
+    ps->vx[i] = (d[0] * cosTheta + u[0] * a + w[0] * b) * speed;
+    ps->vy[i] = (d[1] * cosTheta + u[1] * a + w[1] * b) * speed;
+    ps->vz[i] = (d[2] * cosTheta + u[2] * a + w[2] * b) * speed;
+    ps->age[i] = 0;
+    ps->lifetime[i] = MAX(randomRange(ps, ps->lifetimes), .0001f);
+
+    float* instance = ps->instances + i * PARTICLE_INSTANCE_SIZE;
+    vec3_init(instance, ps->position);
+    instance[3] = ps->sizes[0];
+    instance[4] = ps->colors[0].r / 255.f;
+    instance[5] = ps->colors[0].g / 255.f;
+    instance[6] = ps->colors[0].b / 255.f;
+    instance[7] = ps->colors[0].a / 255.f;
+  }
+}
+
+void lovrParticleSystemUpdate(ParticleSystem* particleSystem, float dt) {
+  lovrGraphicsFlushObject(&particleSystem->ref);
+  ParticleSystem* ps = particleSystem;
+
+  if (ps->emissionRate > 0) {
+    ps->emissionTimer += dt * ps->emissionRate;
+    int count = (int) ps->emissionTimer;
+    ps->emissionTimer -= count;
+    lovrParticleSystemEmit(ps, count);
+  }
+
+  ParticleUpdate update = { ps, dt };
+  lovrParallelFor(ps->count, PARTICLE_PARALLEL_GRAIN, updateParticles, &update);
+  killParticles(ps);
+}
+
+// Every particle is a camera facing quad, drawn with one instanced call
+void lovrParticleSystemDraw(ParticleSystem* particleSystem, mat4 transform) {
+  DrawCommand command = { .type = DRAW_COMMAND_PARTICLE_SYSTEM, .object = &particleSystem->ref };
+  if (lovrGraphicsRecord(&command, transform)) return;
+
+  if (particleSystem->count == 0) {
+    return;
+  }
+
+  size_t stride = PARTICLE_INSTANCE_SIZE * sizeof(float);
+  lovrGraphicsBindVertexBuffer(particleSystem->instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, particleSystem->capacity * stride, NULL, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, particleSystem->count * stride, particleSystem->instances);
+
+  lovrGraphicsPush();
+  lovrGraphicsMatrixTransform(MATRIX_MODEL, transform);
+  lovrGraphicsBindTexture(particleSystem->texture);
+  lovrGraphicsSetDefaultShader(SHADER_PARTICLE);
+  lovrGraphicsPrepare();
+  lovrGraphicsSetVertexColorArray(1);
+  lovrGraphicsBindVertexArray(particleSystem->vao);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, particleSystem->count);
+  lovrGraphicsPop();
+}
+
+void lovrParticleSystemReset(ParticleSystem* particleSystem) {
+  lovrGraphicsFlushObject(&particleSystem->ref);
+  particleSystem->count = 0;
+  particleSystem->emissionTimer = 0;
+}
+
+int lovrParticleSystemGetCount(ParticleSystem* particleSystem) {
+  return particleSystem->count;
+}
+
+int lovrParticleSystemGetCapacity(ParticleSystem* particleSystem) {
+  return particleSystem->capacity;
+}
+
+void lovrParticleSystemSetPosition(ParticleSystem* particleSystem, float x, float y, float z) {
+  vec3_set(particleSystem->position, x, y, z);
+}
+
+void lovrParticleSystemSetDirection(ParticleSystem* particleSystem, float x, float y, float z, float spread) {
+  vec3_set(particleSystem->direction, x, y, z);
+  particleSystem->spread = spread;
+}
+
+void lovrParticleSystemSetSpeed(ParticleSystem* particleSystem, float min, float max) {
+  particleSystem->speed[0] = min;
+  particleSystem->speed[1] = max;
+}
+
+void lovrParticleSystemSetLifetime(ParticleSystem* particleSystem, float min, float max) {
+  particleSystem->lifetimes[0] = min;
+  particleSystem->lifetimes[1] = max;
+}
+
+void lovrParticleSystemSetGravity(ParticleSystem* particleSystem, float x, float y, float z) {
+  vec3_set(particleSystem->gravity, x, y, z);
+}
+
+void lovrParticleSystemSetDrag(ParticleSystem* particleSystem, float drag) {
+  particleSystem->drag = drag;
+}
+
+void lovrParticleSystemSetSizes(ParticleSystem* particleSystem, float start, float end) {
+  particleSystem->sizes[0] = start;
+  particleSystem->sizes[1] = end;
+}
+
+void lovrParticleSystemSetColors(ParticleSystem* particleSystem, Color start, Color end) {
+  particleSystem->colors[0] = start;
+  particleSystem->colors[1] = end;
+}
+
+void lovrParticleSystemSetEmissionRate(ParticleSystem* particleSystem, float rate) {
+  particleSystem->emissionRate = rate;
+}
+
+Texture* lovrParticleSystemGetTexture(ParticleSystem* particleSystem) {
+  return particleSystem->texture;
+}
+
+void lovrParticleSystemSetTexture(ParticleSystem* particleSystem, Texture* texture) {
+  lovrGraphicsFlushObject(&particleSystem->ref);
+  if (particleSystem->texture != texture) {
+    if (particleSystem->texture) {
+      lovrRelease(&particleSystem->texture->ref);
+    }
+
+    particleSystem->texture = texture;
+
+    if (particleSystem->texture) {
+      lovrRetain(&particleSystem->texture->ref);
+    }
+  }
+}
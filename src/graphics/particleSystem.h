@@ -0,0 +1,62 @@
+#include "graphics/texture.h"
+#include "math/math.h"
+#include "math/randomGenerator.h"
+#include "lib/glfw.h"
+#include "util.h"
+
+#pragma once
+
+#define PARTICLE_INSTANCE_SIZE 8
+#define PARTICLE_PARALLEL_GRAIN 8192
+
+typedef struct {
+  Ref ref;
+  int count;
+  int capacity;
+  float* data;
+  float* x;
+  float* y;
+  float* z;
+  float* vx;
+  float* vy;
+  float* vz;
+  float* age;
+  float* lifetime;
+  float* instances;
+  float position[3];
+  float direction[3];
+  float spread;
+  float speed[2];
+  float lifetimes[2];
+  float gravity[3];
+  float drag;
+  float sizes[2];
+  Color colors[2];
+  float emissionRate;
+  float emissionTimer;
+  RandomGenerator* generator;
+  Texture* texture;
+  GLuint vao;
+  GLuint quadBuffer;
+  GLuint instanceBuffer;
+} ParticleSystem;
+
+ParticleSystem* lovrParticleSystemCreate(int capacity);
+void lovrParticleSystemDestroy(const Ref* ref);
+void lovrParticleSystemEmit(ParticleSystem* particleSystem, int count);
+void lovrParticleSystemUpdate(ParticleSystem* particleSystem, float dt);
+void lovrParticleSystemDraw(ParticleSystem* particleSystem, mat4 transform);
+void lovrParticleSystemReset(ParticleSystem* particleSystem);
+int lovrParticleSystemGetCount(ParticleSystem* particleSystem);
+int lovrParticleSystemGetCapacity(ParticleSystem* particleSystem);
+void lovrParticleSystemSetPosition(ParticleSystem* particleSystem, float x, float y, float z);
+void lovrParticleSystemSetDirection(ParticleSystem* particleSystem, float x, float y, float z, float spread);
+void lovrParticleSystemSetSpeed(ParticleSystem* particleSystem, float min, float max);
+void lovrParticleSystemSetLifetime(ParticleSystem* particleSystem, float min, float max);
+void lovrParticleSystemSetGravity(ParticleSystem* particleSystem, float x, float y, float z);
+void lovrParticleSystemSetDrag(ParticleSystem* particleSystem, float drag);
+void lovrParticleSystemSetSizes(ParticleSystem* particleSystem, float start, float end);
+void lovrParticleSystemSetColors(ParticleSystem* particleSystem, Color start, Color end);
+void lovrParticleSystemSetEmissionRate(ParticleSystem* particleSystem, float rate);
+Texture* lovrParticleSystemGetTexture(ParticleSystem* particleSystem);
+void lovrParticleSystemSetTexture(ParticleSystem* particleSystem, Texture* texture);
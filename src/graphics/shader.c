@@ -1,9 +1,14 @@
 #include "graphics/shader.h"
 #include "graphics/graphics.h"
+#include "graphics/material.h"
+#include "graphics/textureArray.h"
 #include "math/mat4.h"
 #include <stdio.h>
 #include <stdlib.h>
 
+#define STRINGIFY(x) #x
+#define TOSTRING(x) STRINGIFY(x)
+
 static const char* lovrShaderVertexPrefix = ""
 #ifdef EMSCRIPTEN
 "#version 300 es \n"
@@ -14,35 +19,67 @@ static const char* lovrShaderVertexPrefix = ""
 "in vec3 lovrPosition; \n"
 "in vec3 lovrNormal; \n"
 "in vec2 lovrTexCoord; \n"
+"in float lovrTexLayer; \n"
+"in vec4 lovrVertexColor; \n"
+"in vec4 lovrBones; \n"
+"in vec4 lovrBoneWeights; \n"
 "out vec2 texCoord; \n"
+"out float texLayer; \n"
+"out vec4 vertexColor; \n"
 "uniform mat4 lovrModel; \n"
 "uniform mat4 lovrView; \n"
 "uniform mat4 lovrProjection; \n"
 "uniform mat4 lovrTransform; \n"
-"uniform mat3 lovrNormalMatrix; \n";
+"uniform mat3 lovrNormalMatrix; \n"
+"layout(std140) uniform lovrPoseBlock { \n"
+"  mat4 lovrPose[" TOSTRING(LOVR_MAX_BONES) "]; \n"
+"  int lovrSkinned; \n"
+"}; \n";
 
 static const char* lovrShaderFragmentPrefix = ""
 #ifdef EMSCRIPTEN
 "#version 300 es \n"
 "precision mediump float; \n"
+"precision mediump sampler2DArray; \n"
 #else
 "#version 150 \n"
 "in vec4 gl_FragCoord; \n"
 #endif
 "in vec2 texCoord; \n"
+"in float texLayer; \n"
+"in vec4 vertexColor; \n"
 "out vec4 lovrFragColor; \n"
 "uniform vec4 lovrColor; \n"
-"uniform sampler2D lovrTexture; \n";
+"uniform sampler2D lovrTexture; \n"
+"uniform sampler2DArray lovrTextureArray; \n"
+"uniform sampler2D lovrEmissiveTexture; \n"
+"layout(std140) uniform lovrMaterialBlock { \n"
+"  vec4 lovrDiffuseColor; \n"
+"  vec4 lovrEmissiveColor; \n"
+"}; \n";
 
 static const char* lovrShaderVertexSuffix = ""
 "void main() { \n"
 "  texCoord = lovrTexCoord; \n"
-"  gl_Position = position(lovrProjection, lovrTransform, vec4(lovrPosition, 1.0)); \n"
+"  texLayer = lovrTexLayer; \n"
+"  vertexColor = lovrVertexColor; \n"
+"  vec4 vertex = vec4(lovrPosition, 1.0); \n"
+"  float boneWeight = dot(lovrBoneWeights, vec4(1.0)); \n"
+"  if (lovrSkinned != 0 && boneWeight > 0.0) { \n"
+"    mat4 pose = \n"
+"      lovrPose[int(lovrBones.x)] * lovrBoneWeights.x + \n"
+"      lovrPose[int(lovrBones.y)] * lovrBoneWeights.y + \n"
+"      lovrPose[int(lovrBones.z)] * lovrBoneWeights.z + \n"
+"      lovrPose[int(lovrBones.w)] * lovrBoneWeights.w; \n"
+"    vertex = (pose * vertex) / boneWeight; \n"
+"  } \n"
+"  gl_Position = position(lovrProjection, lovrTransform, vertex); \n"
 "}";
 
 static const char* lovrShaderFragmentSuffix = ""
 "void main() { \n"
-"  lovrFragColor = color(lovrColor, lovrTexture, texCoord); \n"
+"  lovrFragColor = vertexColor * color(lovrColor * lovrDiffuseColor, lovrTexture, texCoord); \n"
+"  lovrFragColor.rgb += lovrEmissiveColor.rgb * texture(lovrEmissiveTexture, texCoord).rgb; \n"
 "}";
 
 static const char* lovrDefaultVertexShader = ""
@@ -81,6 +118,18 @@ static const char* lovrFontFragmentShader = ""
 "  return vec4(graphicsColor.rgb, graphicsColor.a * alpha); \n"
 "}";
 
+static const char* lovrTextureArrayFragmentShader = ""
+"vec4 color(vec4 graphicsColor, sampler2D image, vec2 uv) { \n"
+"  return graphicsColor * texture(lovrTextureArray, vec3(uv, texLayer)); \n"
+"}";
+
+static const char* lovrParticleVertexShader = ""
+"in vec4 lovrParticle; \n"
+"vec4 position(mat4 projection, mat4 transform, vec4 vertex) { \n"
+"  vec4 center = transform * vec4(lovrParticle.xyz, 1.0); \n"
+"  return projection * (center + vec4(vertex.xy * lovrParticle.w, 0.0, 0.0)); \n"
+"}";
+
 static const char* lovrNoopVertexShader = ""
 "vec4 position(mat4 projection, mat4 transform, vec4 vertex) { \n"
 "  return vertex; \n"
@@ -120,6 +169,11 @@ static GLuint linkShaders(GLuint vertexShader, GLuint fragmentShader) {
   glBindAttribLocation(shader, LOVR_SHADER_POSITION, "lovrPosition");
   glBindAttribLocation(shader, LOVR_SHADER_NORMAL, "lovrNormal");
   glBindAttribLocation(shader, LOVR_SHADER_TEX_COORD, "lovrTexCoord");
+  glBindAttribLocation(shader, LOVR_SHADER_TEX_LAYER, "lovrTexLayer");
+  glBindAttribLocation(shader, LOVR_SHADER_VERTEX_COLOR, "lovrVertexColor");
+  glBindAttribLocation(shader, LOVR_SHADER_PARTICLE, "lovrParticle");
+  glBindAttribLocation(shader, LOVR_SHADER_BONES, "lovrBones");
+  glBindAttribLocation(shader, LOVR_SHADER_BONE_WEIGHTS, "lovrBoneWeights");
 
   glLinkProgram(shader);
 
@@ -148,19 +202,31 @@ Shader* lovrShaderCreate(const char* vertexSource, const char* fragmentSource) {
 
   // Vertex
   vertexSource = vertexSource == NULL ? lovrDefaultVertexShader : vertexSource;
-  char fullVertexSource[4096];
+  char fullVertexSource[8192];
   snprintf(fullVertexSource, sizeof(fullVertexSource), "%s\n%s\n%s", lovrShaderVertexPrefix, vertexSource, lovrShaderVertexSuffix);
   GLuint vertexShader = compileShader(GL_VERTEX_SHADER, fullVertexSource);
 
   // Fragment
   fragmentSource = fragmentSource == NULL ? lovrDefaultFragmentShader : fragmentSource;
-  char fullFragmentSource[4096];
+  char fullFragmentSource[8192];
   snprintf(fullFragmentSource, sizeof(fullFragmentSource), "%s\n%s\n%s", lovrShaderFragmentPrefix, fragmentSource, lovrShaderFragmentSuffix);
   GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fullFragmentSource);
 
   // Link
   GLuint id = linkShaders(vertexShader, fragmentShader);
 
+  // Skinned models bind a palette of bone transforms to the pose block, see lovrGraphicsBindPose
+  GLuint poseBlock = glGetUniformBlockIndex(id, "lovrPoseBlock");
+  if (poseBlock != GL_INVALID_INDEX) {
+    glUniformBlockBinding(id, poseBlock, LOVR_SHADER_POSE_BLOCK);
+  }
+
+  // Material colors come from a range of a uniform buffer, see lovrGraphicsBindMaterial
+  GLuint materialBlock = glGetUniformBlockIndex(id, "lovrMaterialBlock");
+  if (materialBlock != GL_INVALID_INDEX) {
+    glUniformBlockBinding(id, materialBlock, LOVR_SHADER_MATERIAL_BLOCK);
+  }
+
   // Compute information about uniforms
   GLint uniformCount;
   GLsizei bufferSize = LOVR_MAX_UNIFORM_LENGTH / sizeof(GLchar);
@@ -188,6 +254,8 @@ Shader* lovrShaderCreate(const char* vertexSource, const char* fragmentSource) {
   // Send initial uniform values to shader
   lovrGraphicsBindProgram(id);
   lovrShaderBind(shader, shader->model, shader->view, shader->projection, shader->color, 1);
+  lovrShaderSendInt(shader, lovrShaderGetUniformId(shader, "lovrTextureArray"), TEXTURE_ARRAY_UNIT);
+  lovrShaderSendInt(shader, lovrShaderGetUniformId(shader, "lovrEmissiveTexture"), EMISSIVE_TEXTURE_UNIT);
 
   return shader;
 }
@@ -202,6 +270,8 @@ Shader* lovrShaderCreateDefault(DefaultShader type) {
     }
     case SHADER_FONT: return lovrShaderCreate(NULL, lovrFontFragmentShader);
     case SHADER_FULLSCREEN: return lovrShaderCreate(lovrNoopVertexShader, NULL);
+    case SHADER_TEXTURE_ARRAY: return lovrShaderCreate(NULL, lovrTextureArrayFragmentShader);
+    case SHADER_PARTICLE: return lovrShaderCreate(lovrParticleVertexShader, NULL);
     default: lovrThrow("Unknown default shader type");
   }
 }
@@ -8,15 +8,33 @@
 #define LOVR_SHADER_POSITION 0
 #define LOVR_SHADER_NORMAL 1
 #define LOVR_SHADER_TEX_COORD 2
+#define LOVR_SHADER_TEX_LAYER 3
+#define LOVR_SHADER_VERTEX_COLOR 4
+#define LOVR_SHADER_PARTICLE 5
+#define LOVR_SHADER_BONES 6
+#define LOVR_SHADER_BONE_WEIGHTS 7
+#define LOVR_SHADER_POSE_BLOCK 0
+#define LOVR_SHADER_MATERIAL_BLOCK 1
+#define LOVR_MAX_BONES 64
 #define LOVR_MAX_UNIFORM_LENGTH 256
 
 typedef enum {
   SHADER_DEFAULT,
   SHADER_SKYBOX,
   SHADER_FONT,
-  SHADER_FULLSCREEN
+  SHADER_FULLSCREEN,
+  SHADER_TEXTURE_ARRAY,
+  SHADER_PARTICLE
 } DefaultShader;
 
+// The contents of the pose block.  Vertices are only skinned when skinned is set, so draws without
+// bones don't depend on the values of the bone attributes.
+typedef struct {
+  float bones[LOVR_MAX_BONES][16];
+  int skinned;
+  int padding[3];
+} PoseBlock;
+
 typedef struct {
   GLchar name[LOVR_MAX_UNIFORM_LENGTH];
   int index;
@@ -0,0 +1,140 @@
+#include "graphics/spriteBatch.h"
+#include "graphics/graphics.h"
+#include "math/mat4.h"
+#include <stdlib.h>
+#include <string.h>
+
+SpriteBatch* lovrSpriteBatchCreate(int capacity) {
+  lovrAssert(capacity > 0, "SpriteBatch capacity must be positive");
+
+  SpriteBatch* spriteBatch = lovrAlloc(sizeof(SpriteBatch), lovrSpriteBatchDestroy);
+  if (!spriteBatch) return NULL;
+
+  MeshFormat format;
+  vec_init(&format);
+  MeshAttribute position = { .name = "lovrPosition", .type = MESH_FLOAT, .count = 3 };
+  MeshAttribute texCoord = { .name = "lovrTexCoord", .type = MESH_FLOAT, .count = 2 };
+  MeshAttribute color = { .name = "lovrVertexColor", .type = MESH_FLOAT, .count = 4 };
+  vec_push(&format, position);
+  vec_push(&format, texCoord);
+  vec_push(&format, color);
+  spriteBatch->mesh = lovrMeshCreate(capacity * 4, &format, MESH_TRIANGLES, MESH_DYNAMIC, 0);
+  vec_deinit(&format);
+
+  // Every quad uses the same index pattern, so the index buffer is built once up front
+  unsigned int* indices = malloc(capacity * 6 * sizeof(unsigned int));
+  for (int i = 0; i < capacity; i++) {
+    unsigned int* quad = indices + i * 6;
+    unsigned int base = i * 4;
+    quad[0] = base + 0; quad[1] = base + 1; quad[2] = base + 2;
+    quad[3] = base + 2; quad[4] = base + 1; quad[5] = base + 3;
+  }
+  lovrMeshSetVertexMap(spriteBatch->mesh, indices, capacity * 6);
+  free(indices);
+
+  spriteBatch->vertices = malloc(capacity * 4 * SPRITE_BATCH_VERTEX_SIZE * sizeof(float));
+  spriteBatch->count = 0;
+  spriteBatch->capacity = capacity;
+  spriteBatch->dirtyStart = capacity;
+  spriteBatch->dirtyEnd = 0;
+  spriteBatch->color = (Color) { 255, 255, 255, 255 };
+
+  return spriteBatch;
+}
+
+void lovrSpriteBatchDestroy(const Ref* ref) {
+  SpriteBatch* spriteBatch = containerof(ref, SpriteBatch);
+  lovrRelease(&spriteBatch->mesh->ref);
+  free(spriteBatch->vertices);
+  free(spriteBatch);
+}
+
+// Only the quads that changed since the last draw are copied into the vertex buffer
+void lovrSpriteBatchDraw(SpriteBatch* spriteBatch, mat4 transform) {
+  DrawCommand command = { .type = DRAW_COMMAND_SPRITE_BATCH, .object = &spriteBatch->ref };
+  if (lovrGraphicsRecord(&command, transform)) return;
+
+  if (spriteBatch->dirtyEnd > spriteBatch->dirtyStart) {
+    int start = spriteBatch->dirtyStart * 4;
+    int count = (spriteBatch->dirtyEnd - spriteBatch->dirtyStart) * 4;
+    size_t stride = SPRITE_BATCH_VERTEX_SIZE * sizeof(float);
+    void* data = lovrMeshMap(spriteBatch->mesh, start, count, 0, 1);
+    memcpy(data, spriteBatch->vertices + start * SPRITE_BATCH_VERTEX_SIZE, count * stride);
+    lovrMeshUnmap(spriteBatch->mesh);
+    spriteBatch->dirtyStart = spriteBatch->capacity;
+    spriteBatch->dirtyEnd = 0;
+  }
+
+  if (spriteBatch->count == 0) {
+    return;
+  }
+
+  // The mesh picks the index type and offset of its vertex map, so the draw goes through it
+  MeshRange range = { .offset = 0, .count = spriteBatch->count * 6 };
+  lovrMeshDrawRanges(spriteBatch->mesh, transform, &range, 1);
+}
+
+int lovrSpriteBatchAdd(SpriteBatch* spriteBatch, mat4 transform, float* uv) {
+  lovrAssert(spriteBatch->count < spriteBatch->capacity, "SpriteBatch is full (capacity is %d)", spriteBatch->capacity);
+  int index = spriteBatch->count++;
+  lovrSpriteBatchSet(spriteBatch, index, transform, uv);
+  return index;
+}
+
+// Quads are unit planes facing +z, the same as lovr.graphics.plane, and uv is { x, y, width, height }
+void lovrSpriteBatchSet(SpriteBatch* spriteBatch, int index, mat4 transform, float* uv) {
+  lovrGraphicsFlushObject(&spriteBatch->ref);
+  lovrAssert(index >= 0 && index < spriteBatch->count, "Invalid sprite index %d", index + 1);
+
+  float corners[4][5] = {
+    { -.5, .5, 0, uv[0], uv[1] },
+    { -.5, -.5, 0, uv[0], uv[1] + uv[3] },
+    { .5, .5, 0, uv[0] + uv[2], uv[1] },
+    { .5, -.5, 0, uv[0] + uv[2], uv[1] + uv[3] }
+  };
+
+  Color color = spriteBatch->color;
+  float* vertex = spriteBatch->vertices + index * 4 * SPRITE_BATCH_VERTEX_SIZE;
+  for (int i = 0; i < 4; i++, vertex += SPRITE_BATCH_VERTEX_SIZE) {
+    mat4_transform(transform, corners[i]);
+    memcpy(vertex, corners[i], 5 * sizeof(float));
+    vertex[5] = color.r / 255.f;
+    vertex[6] = color.g / 255.f;
+    vertex[7] = color.b / 255.f;
+    vertex[8] = color.a / 255.f;
+  }
+
+  spriteBatch->dirtyStart = MIN(spriteBatch->dirtyStart, index);
+  spriteBatch->dirtyEnd = MAX(spriteBatch->dirtyEnd, index + 1);
+}
+
+void lovrSpriteBatchClear(SpriteBatch* spriteBatch) {
+  lovrGraphicsFlushObject(&spriteBatch->ref);
+  spriteBatch->count = 0;
+  spriteBatch->dirtyStart = spriteBatch->capacity;
+  spriteBatch->dirtyEnd = 0;
+}
+
+int lovrSpriteBatchGetCount(SpriteBatch* spriteBatch) {
+  return spriteBatch->count;
+}
+
+int lovrSpriteBatchGetCapacity(SpriteBatch* spriteBatch) {
+  return spriteBatch->capacity;
+}
+
+Color lovrSpriteBatchGetColor(SpriteBatch* spriteBatch) {
+  return spriteBatch->color;
+}
+
+void lovrSpriteBatchSetColor(SpriteBatch* spriteBatch, Color color) {
+  spriteBatch->color = color;
+}
+
+Texture* lovrSpriteBatchGetTexture(SpriteBatch* spriteBatch) {
+  return lovrMeshGetTexture(spriteBatch->mesh);
+}
+
+void lovrSpriteBatchSetTexture(SpriteBatch* spriteBatch, Texture* texture) {
+  lovrMeshSetTexture(spriteBatch->mesh, texture);
+}
@@ -0,0 +1,32 @@
+#include "graphics/mesh.h"
+#include "graphics/texture.h"
+#include "math/math.h"
+#include "util.h"
+
+#pragma once
+
+#define SPRITE_BATCH_VERTEX_SIZE 9
+
+typedef struct {
+  Ref ref;
+  Mesh* mesh;
+  float* vertices;
+  int count;
+  int capacity;
+  int dirtyStart;
+  int dirtyEnd;
+  Color color;
+} SpriteBatch;
+
+SpriteBatch* lovrSpriteBatchCreate(int capacity);
+void lovrSpriteBatchDestroy(const Ref* ref);
+void lovrSpriteBatchDraw(SpriteBatch* spriteBatch, mat4 transform);
+int lovrSpriteBatchAdd(SpriteBatch* spriteBatch, mat4 transform, float* uv);
+void lovrSpriteBatchSet(SpriteBatch* spriteBatch, int index, mat4 transform, float* uv);
+void lovrSpriteBatchClear(SpriteBatch* spriteBatch);
+int lovrSpriteBatchGetCount(SpriteBatch* spriteBatch);
+int lovrSpriteBatchGetCapacity(SpriteBatch* spriteBatch);
+Color lovrSpriteBatchGetColor(SpriteBatch* spriteBatch);
+void lovrSpriteBatchSetColor(SpriteBatch* spriteBatch, Color color);
+Texture* lovrSpriteBatchGetTexture(SpriteBatch* spriteBatch);
+void lovrSpriteBatchSetTexture(SpriteBatch* spriteBatch, Texture* texture);
@@ -5,10 +5,35 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-static void lovrTextureCreateStorage(Texture* texture) {
+// A streaming texture starts out with the smallest levels of its mipmap chain that fit in this many
+// bytes, at least one of them.  Finer levels are uploaded by the per frame stream.
+#define TEXTURE_STREAM_INITIAL_BUDGET 16384
+
+static void lovrTextureCreateStorage(Texture* texture, int stream) {
   TextureData* textureData = texture->textureData;
 
-  if (textureData->format.compressed || !textureData->mipmaps.generated) {
+  if (textureData->format.compressed) {
+    int mipmapCount = textureData->mipmaps.list.length;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipmapCount - 1);
+
+    if (!stream || mipmapCount <= 1) {
+      return;
+    }
+
+    // Streaming textures start with no levels uploaded and fill in the mipmap chain from the bottom
+    texture->mipmapBase = mipmapCount;
+#ifndef EMSCRIPTEN
+    if (GLAD_GL_ARB_texture_storage) {
+#endif
+      glTexStorage2D(GL_TEXTURE_2D, mipmapCount, textureData->format.glInternalFormat, textureData->width, textureData->height);
+      texture->isStorageImmutable = 1;
+#ifndef EMSCRIPTEN
+    }
+#endif
+    return;
+  }
+
+  if (!textureData->mipmaps.generated) {
     return;
   }
 
@@ -17,6 +42,7 @@ static void lovrTextureCreateStorage(Texture* texture) {
   int mipmapCount = log2(MAX(w, h)) + 1;
   GLenum internalFormat = textureData->format.glInternalFormat;
   GLenum format = textureData->format.glFormat;
+  GLenum type = textureData->format.glType;
 #ifndef EMSCRIPTEN
   if (GLAD_GL_ARB_texture_storage) {
 #endif
@@ -24,7 +50,7 @@ static void lovrTextureCreateStorage(Texture* texture) {
 #ifndef EMSCRIPTEN
   } else {
     for (int i = 0; i < mipmapCount; i++) {
-      glTexImage2D(GL_TEXTURE_2D, i, internalFormat, w, h, 0, format, GL_UNSIGNED_BYTE, NULL);
+      glTexImage2D(GL_TEXTURE_2D, i, internalFormat, w, h, 0, format, type, NULL);
       w = MAX(w >> 1, 1);
       h = MAX(h >> 1, 1);
     }
@@ -32,30 +58,53 @@ static void lovrTextureCreateStorage(Texture* texture) {
 #endif
 }
 
-Texture* lovrTextureCreate(TextureData* textureData) {
+static void lovrTextureUploadMipmap(Texture* texture, int level) {
+  TextureData* textureData = texture->textureData;
+  GLenum glInternalFormat = textureData->format.glInternalFormat;
+  Mipmap m = textureData->mipmaps.list.data[level];
+
+  if (texture->isStorageImmutable) {
+    glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, m.width, m.height, glInternalFormat, m.size, m.data);
+  } else {
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, glInternalFormat, m.width, m.height, 0, m.size, m.data);
+  }
+}
+
+Texture* lovrTextureCreate(TextureData* textureData, int stream) {
   Texture* texture = lovrAlloc(sizeof(Texture), lovrTextureDestroy);
   if (!texture) return NULL;
 
   texture->framebuffer = 0;
   texture->depthBuffer = 0;
   texture->textureData = textureData;
+  texture->width = textureData->width;
+  texture->height = textureData->height;
+  texture->hasMipmaps = textureData->format.compressed || textureData->mipmaps.generated;
+  texture->keepData = 1;
+  texture->mipmapBase = 0;
+  texture->isStorageImmutable = 0;
   glGenTextures(1, &texture->id);
   lovrGraphicsBindTexture(texture);
-  lovrTextureCreateStorage(texture);
+  lovrTextureCreateStorage(texture, stream);
   lovrTextureRefresh(texture);
   lovrTextureSetFilter(texture, lovrGraphicsGetDefaultFilter());
 
   lovrTextureSetWrap(texture, WRAP_REPEAT, WRAP_REPEAT);
 
+  if (lovrTextureIsStreaming(texture)) {
+    lovrGraphicsStreamTexture(texture);
+  }
+
   return texture;
 }
 
 Texture* lovrTextureCreateWithFramebuffer(TextureData* textureData, TextureProjection projection, int msaa) {
-  Texture* texture = lovrTextureCreate(textureData);
+  GLenum internalFormat = textureData->format.glInternalFormat;
+  Texture* texture = lovrTextureCreate(textureData, 0);
   if (!texture) return NULL;
 
-  int width = texture->textureData->width;
-  int height = texture->textureData->height;
+  int width = texture->width;
+  int height = texture->height;
   texture->projection = projection;
   texture->msaa = msaa;
 
@@ -67,7 +116,7 @@ Texture* lovrTextureCreateWithFramebuffer(TextureData* textureData, TextureProje
   if (msaa) {
     glGenRenderbuffers(1, &texture->msaaId);
     glBindRenderbuffer(GL_RENDERBUFFER, texture->msaaId);
-    glRenderbufferStorageMultisample(GL_RENDERBUFFER, msaa, GL_RGBA8, width, height);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, msaa, internalFormat, width, height);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, texture->msaaId);
   } else {
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->id, 0);
@@ -95,14 +144,16 @@ Texture* lovrTextureCreateWithFramebuffer(TextureData* textureData, TextureProje
   }
 
   lovrAssert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Error creating texture");
-  lovrGraphicsClear(1, 1);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
   return texture;
 }
 
 void lovrTextureDestroy(const Ref* ref) {
   Texture* texture = containerof(ref, Texture);
-  lovrTextureDataDestroy(texture->textureData);
+  if (texture->textureData) {
+    lovrTextureDataDestroy(texture->textureData);
+  }
   if (texture->framebuffer) {
     glDeleteFramebuffers(1, &texture->framebuffer);
   }
@@ -113,8 +164,8 @@ void lovrTextureDestroy(const Ref* ref) {
 void lovrTextureBindFramebuffer(Texture* texture) {
   lovrAssert(texture->framebuffer, "Texture cannot be used as a canvas");
 
-  int w = texture->textureData->width;
-  int h = texture->textureData->height;
+  int w = texture->width;
+  int h = texture->height;
 
   lovrGraphicsBindFramebuffer(texture->framebuffer);
   lovrGraphicsSetViewport(0, 0, w, h);
@@ -140,13 +191,15 @@ void lovrTextureBindFramebuffer(Texture* texture) {
 }
 
 void lovrTextureResolveMSAA(Texture* texture) {
+  lovrGraphicsFlush();
+
   if (!texture->msaa) {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     return;
   }
 
-  int w = texture->textureData->width;
-  int h = texture->textureData->height;
+  int w = texture->width;
+  int h = texture->height;
 
   glBindFramebuffer(GL_READ_FRAMEBUFFER, texture->framebuffer);
   glBindFramebuffer(GL_DRAW_FRAMEBUFFER, texture->resolveFramebuffer);
@@ -157,31 +210,100 @@ void lovrTextureResolveMSAA(Texture* texture) {
 
 void lovrTextureRefresh(Texture* texture) {
   TextureData* textureData = texture->textureData;
+  lovrAssert(textureData, "Texture data was released and can not be uploaded again");
   GLenum glInternalFormat = textureData->format.glInternalFormat;
   GLenum glFormat = textureData->format.glFormat;
+  GLenum glType = textureData->format.glType;
   lovrGraphicsBindTexture(texture);
 
   if (textureData->format.compressed) {
-    Mipmap m; int i;
-    vec_foreach(&textureData->mipmaps.list, m, i) {
-      glCompressedTexImage2D(GL_TEXTURE_2D, i, glInternalFormat, m.width, m.height, 0, m.size, m.data);
+    if (lovrTextureIsStreaming(texture)) {
+      lovrTextureStream(texture, TEXTURE_STREAM_INITIAL_BUDGET);
+    } else {
+      for (int i = 0; i < textureData->mipmaps.list.length; i++) {
+        lovrTextureUploadMipmap(texture, i);
+      }
     }
   } else {
     int w = textureData->width;
     int h = textureData->height;
-    glTexImage2D(GL_TEXTURE_2D, 0, glInternalFormat, w, h, 0, glFormat, GL_UNSIGNED_BYTE, textureData->data);
+    glTexImage2D(GL_TEXTURE_2D, 0, glInternalFormat, w, h, 0, glFormat, glType, textureData->data);
     if (textureData->mipmaps.generated) {
       glGenerateMipmap(GL_TEXTURE_2D);
     }
   }
+
+  if (!texture->keepData) {
+    lovrTextureReleaseData(texture);
+  }
+}
+
+void lovrTextureReplaceData(Texture* texture, TextureData* textureData) {
+  lovrGraphicsFlush();
+  lovrAssert(!lovrTextureIsStreaming(texture), "Can not replace the data of a texture that is still streaming");
+
+  if (texture->textureData) {
+    lovrTextureDataDestroy(texture->textureData);
+  }
+
+  texture->textureData = textureData;
+  texture->width = textureData->width;
+  texture->height = textureData->height;
+  lovrTextureRefresh(texture);
+}
+
+// Frees the CPU copy of the pixels.  Streaming textures hold on to it until every level is uploaded.
+void lovrTextureReleaseData(Texture* texture) {
+  texture->keepData = 0;
+
+  if (texture->textureData && !lovrTextureIsStreaming(texture)) {
+    lovrTextureDataDestroy(texture->textureData);
+    texture->textureData = NULL;
+  }
+}
+
+// Uploads the next finer mipmap levels of a streaming texture, stopping once the byte budget is used
+// up.  At least one level is always uploaded so large levels don't stall the stream forever.
+size_t lovrTextureStream(Texture* texture, size_t budget) {
+  if (!lovrTextureIsStreaming(texture)) {
+    return 0;
+  }
+
+  size_t bytes = 0;
+  lovrGraphicsBindTexture(texture);
+
+  while (texture->mipmapBase > 0) {
+    int level = texture->mipmapBase - 1;
+    size_t size = texture->textureData->mipmaps.list.data[level].size;
+
+    if (bytes > 0 && bytes + size > budget) {
+      break;
+    }
+
+    lovrTextureUploadMipmap(texture, level);
+    texture->mipmapBase = level;
+    bytes += size;
+  }
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture->mipmapBase);
+
+  if (!texture->keepData) {
+    lovrTextureReleaseData(texture);
+  }
+
+  return bytes;
+}
+
+int lovrTextureIsStreaming(Texture* texture) {
+  return texture->mipmapBase > 0;
 }
 
 int lovrTextureGetHeight(Texture* texture) {
-  return texture->textureData->height;
+  return texture->height;
 }
 
 int lovrTextureGetWidth(Texture* texture) {
-  return texture->textureData->width;
+  return texture->width;
 }
 
 TextureFilter lovrTextureGetFilter(Texture* texture) {
@@ -189,7 +311,8 @@ TextureFilter lovrTextureGetFilter(Texture* texture) {
 }
 
 void lovrTextureSetFilter(Texture* texture, TextureFilter filter) {
-  int hasMipmaps = texture->textureData->format.compressed || texture->textureData->mipmaps.generated;
+  lovrGraphicsFlush();
+  int hasMipmaps = texture->hasMipmaps;
   float anisotropy = filter.mode == FILTER_ANISOTROPIC ? MAX(filter.anisotropy, 1.) : 1.;
   lovrGraphicsBindTexture(texture);
   texture->filter = filter;
@@ -231,6 +354,7 @@ void lovrTextureGetWrap(Texture* texture, WrapMode* horizontal, WrapMode* vertic
 }
 
 void lovrTextureSetWrap(Texture* texture, WrapMode horizontal, WrapMode vertical) {
+  lovrGraphicsFlush();
   texture->wrapHorizontal = horizontal;
   texture->wrapVertical = vertical;
   lovrGraphicsBindTexture(texture);
@@ -30,6 +30,10 @@ typedef enum {
 typedef struct {
   Ref ref;
   TextureData* textureData;
+  int width;
+  int height;
+  int hasMipmaps;
+  int keepData;
   GLuint id;
   GLuint msaaId;
   GLuint framebuffer;
@@ -40,16 +44,22 @@ typedef struct {
   WrapMode wrapHorizontal;
   WrapMode wrapVertical;
   int msaa;
+  int mipmapBase;
+  int isStorageImmutable;
 } Texture;
 
 GLenum lovrTextureGetGLFormat(TextureFormat format);
 
-Texture* lovrTextureCreate(TextureData* textureData);
+Texture* lovrTextureCreate(TextureData* textureData, int stream);
 Texture* lovrTextureCreateWithFramebuffer(TextureData* textureData, TextureProjection projection, int msaa);
 void lovrTextureDestroy(const Ref* ref);
 void lovrTextureBindFramebuffer(Texture* texture);
 void lovrTextureResolveMSAA(Texture* texture);
 void lovrTextureRefresh(Texture* texture);
+void lovrTextureReplaceData(Texture* texture, TextureData* textureData);
+void lovrTextureReleaseData(Texture* texture);
+size_t lovrTextureStream(Texture* texture, size_t budget);
+int lovrTextureIsStreaming(Texture* texture);
 int lovrTextureGetHeight(Texture* texture);
 int lovrTextureGetWidth(Texture* texture);
 TextureFilter lovrTextureGetFilter(Texture* texture);
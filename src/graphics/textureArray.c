@@ -0,0 +1,185 @@
+#include "graphics/textureArray.h"
+#include "graphics/graphics.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Array textures live on their own texture unit so they can be sampled alongside lovrTexture
+static void lovrTextureArrayBind(TextureArray* textureArray) {
+  lovrGraphicsBindTextureArray(textureArray->id);
+  glActiveTexture(GL_TEXTURE0 + TEXTURE_ARRAY_UNIT);
+}
+
+static void lovrTextureArrayUnbind() {
+  glActiveTexture(GL_TEXTURE0);
+}
+
+static GLuint lovrTextureArrayCreateStorage(TextureArray* textureArray, int capacity) {
+  int w = textureArray->width;
+  int h = textureArray->height;
+  int mipmapCount = textureArray->hasMipmaps ? log2(MAX(w, h)) + 1 : 1;
+  TextureFormat format = textureArray->format;
+
+  GLuint id;
+  glGenTextures(1, &id);
+  lovrGraphicsBindTextureArray(id);
+  glActiveTexture(GL_TEXTURE0 + TEXTURE_ARRAY_UNIT);
+
+#ifndef EMSCRIPTEN
+  if (GLAD_GL_ARB_texture_storage) {
+#endif
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, mipmapCount, format.glInternalFormat, w, h, capacity);
+#ifndef EMSCRIPTEN
+  } else {
+    for (int i = 0; i < mipmapCount; i++) {
+      glTexImage3D(GL_TEXTURE_2D_ARRAY, i, format.glInternalFormat, w, h, capacity, 0, format.glFormat, format.glType, NULL);
+      w = MAX(w >> 1, 1);
+      h = MAX(h >> 1, 1);
+    }
+  }
+#endif
+
+  GLenum minFilter = textureArray->hasMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, minFilter);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  lovrTextureArrayUnbind();
+
+  return id;
+}
+
+// Doubles the number of layers.  The existing layers are copied over through a pixel buffer, which
+// works for every format, unlike copying from a framebuffer, which needs a color renderable one.
+// WebGL can't read textures back, so there they still go through a framebuffer.
+static void lovrTextureArrayGrow(TextureArray* textureArray) {
+  GLuint oldId = textureArray->id;
+  int capacity = textureArray->capacity * 2;
+  int width = textureArray->width;
+  int height = textureArray->height;
+  int layerCount = textureArray->layerCount;
+  TextureFormat format = textureArray->format;
+
+#ifdef EMSCRIPTEN
+  textureArray->id = lovrTextureArrayCreateStorage(textureArray, capacity);
+  textureArray->capacity = capacity;
+
+  GLint readFramebuffer;
+  GLuint framebuffer;
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+  lovrTextureArrayBind(textureArray);
+
+  for (int i = 0; i < layerCount; i++) {
+    glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, oldId, 0, i);
+    glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, 0, 0, width, height);
+  }
+
+  lovrTextureArrayUnbind();
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+  glDeleteFramebuffers(1, &framebuffer);
+#else
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+  glBufferData(GL_PIXEL_PACK_BUFFER, (size_t) width * height * format.blockBytes * layerCount, NULL, GL_STREAM_COPY);
+  lovrTextureArrayBind(textureArray);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, format.glFormat, format.glType, NULL);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  lovrTextureArrayUnbind();
+
+  textureArray->id = lovrTextureArrayCreateStorage(textureArray, capacity);
+  textureArray->capacity = capacity;
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+  lovrTextureArrayBind(textureArray);
+  glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, width, height, layerCount, format.glFormat, format.glType, NULL);
+  lovrTextureArrayUnbind();
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  glDeleteBuffers(1, &buffer);
+#endif
+
+  glDeleteTextures(1, &oldId);
+  textureArray->mipmapsDirty = textureArray->hasMipmaps;
+}
+
+TextureArray* lovrTextureArrayCreate(int width, int height, int capacity, TextureFormat format, int mipmaps) {
+  lovrAssert(!format.compressed, "Texture arrays can not use compressed formats");
+  lovrAssert(capacity > 0, "Texture array capacity must be positive");
+
+  TextureArray* textureArray = lovrAlloc(sizeof(TextureArray), lovrTextureArrayDestroy);
+  if (!textureArray) return NULL;
+
+  textureArray->width = width;
+  textureArray->height = height;
+  textureArray->layerCount = 0;
+  textureArray->capacity = capacity;
+  textureArray->format = format;
+  textureArray->hasMipmaps = mipmaps;
+  textureArray->mipmapsDirty = 0;
+  textureArray->id = lovrTextureArrayCreateStorage(textureArray, capacity);
+
+  return textureArray;
+}
+
+void lovrTextureArrayDestroy(const Ref* ref) {
+  TextureArray* textureArray = containerof(ref, TextureArray);
+
+  // The name can be reused by a new texture, which would otherwise look like it's already bound
+  if (lovrGraphicsGetTextureArray() == textureArray->id) {
+    lovrGraphicsBindTextureArray(0);
+  }
+
+  glDeleteTextures(1, &textureArray->id);
+  free(textureArray);
+}
+
+// Mipmaps are regenerated once before drawing instead of after every layer that changes
+void lovrTextureArrayPrepare(TextureArray* textureArray) {
+  lovrTextureArrayBind(textureArray);
+
+  if (textureArray->mipmapsDirty) {
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    textureArray->mipmapsDirty = 0;
+  }
+
+  lovrTextureArrayUnbind();
+}
+
+int lovrTextureArrayAdd(TextureArray* textureArray, TextureData* textureData) {
+  if (textureArray->layerCount == textureArray->capacity) {
+    lovrTextureArrayGrow(textureArray);
+  }
+
+  int layer = textureArray->layerCount++;
+  lovrTextureArraySet(textureArray, layer, textureData);
+  return layer;
+}
+
+void lovrTextureArraySet(TextureArray* textureArray, int layer, TextureData* textureData) {
+  lovrGraphicsFlush();
+  TextureFormat format = textureArray->format;
+  lovrAssert(layer >= 0 && layer < textureArray->layerCount, "Invalid texture array layer %d", layer);
+  lovrAssert(textureData->width == textureArray->width && textureData->height == textureArray->height,
+    "Texture array layers must be %dx%d, got %dx%d", textureArray->width, textureArray->height, textureData->width, textureData->height);
+  lovrAssert(textureData->format.glInternalFormat == format.glInternalFormat, "Texture array layers must all use the same format");
+
+  lovrTextureArrayBind(textureArray);
+  glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, textureData->width, textureData->height, 1, format.glFormat, format.glType, textureData->data);
+  lovrTextureArrayUnbind();
+  textureArray->mipmapsDirty = textureArray->hasMipmaps;
+}
+
+int lovrTextureArrayGetLayerCount(TextureArray* textureArray) {
+  return textureArray->layerCount;
+}
+
+int lovrTextureArrayGetWidth(TextureArray* textureArray) {
+  return textureArray->width;
+}
+
+int lovrTextureArrayGetHeight(TextureArray* textureArray) {
+  return textureArray->height;
+}
@@ -0,0 +1,30 @@
+#include "graphics/texture.h"
+#include "loaders/texture.h"
+#include "lib/glfw.h"
+#include "util.h"
+
+#pragma once
+
+#define TEXTURE_ARRAY_UNIT 2
+#define DEFAULT_TEXTURE_ARRAY_CAPACITY 16
+
+typedef struct {
+  Ref ref;
+  GLuint id;
+  int width;
+  int height;
+  int layerCount;
+  int capacity;
+  TextureFormat format;
+  int hasMipmaps;
+  int mipmapsDirty;
+} TextureArray;
+
+TextureArray* lovrTextureArrayCreate(int width, int height, int capacity, TextureFormat format, int mipmaps);
+void lovrTextureArrayDestroy(const Ref* ref);
+void lovrTextureArrayPrepare(TextureArray* textureArray);
+int lovrTextureArrayAdd(TextureArray* textureArray, TextureData* textureData);
+void lovrTextureArraySet(TextureArray* textureArray, int layer, TextureData* textureData);
+int lovrTextureArrayGetLayerCount(TextureArray* textureArray);
+int lovrTextureArrayGetWidth(TextureArray* textureArray);
+int lovrTextureArrayGetHeight(TextureArray* textureArray);
@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <float.h>
 
 static HeadsetState state;
 
@@ -600,23 +601,31 @@ ModelData* lovrHeadsetControllerNewModelData(Controller* controller) {
   ModelData* modelData = malloc(sizeof(ModelData));
   if (!modelData) return NULL;
 
-  ModelMesh* mesh = malloc(sizeof(ModelMesh));
-  vec_init(&modelData->meshes);
-  vec_push(&modelData->meshes, mesh);
+  size_t vertexCount = vrModel->unVertexCount;
+  size_t faceCount = vrModel->unTriangleCount;
+  lovrModelDataInit(modelData);
+  lovrModelDataReserve(modelData, sizeof(ModelMesh) + sizeof(ModelNode) + faceCount * sizeof(ModelFace) + 3 * vertexCount * sizeof(ModelVertex) + 256);
+  modelData->hasNormals = 1;
+  modelData->hasTexCoords = 1;
 
-  vec_init(&mesh->faces);
-  for (uint32_t i = 0; i < vrModel->unTriangleCount; i++) {
-    ModelFace face;
-    face.indices[0] = vrModel->rIndexData[3 * i + 0];
-    face.indices[1] = vrModel->rIndexData[3 * i + 1];
-    face.indices[2] = vrModel->rIndexData[3 * i + 2];
-    vec_push(&mesh->faces, face);
-  }
+  ModelMesh* mesh = lovrModelDataAllocate(modelData, sizeof(ModelMesh));
+  vec_push(&modelData->meshes, mesh);
 
-  vec_init(&mesh->vertices);
-  vec_init(&mesh->normals);
-  vec_init(&mesh->texCoords);
-  for (size_t i = 0; i < vrModel->unVertexCount; i++) {
+  lovrModelDataAllocateArray(modelData, &mesh->faces, faceCount);
+  for (size_t i = 0; i < 3 * faceCount; i++) {
+    mesh->faces.data[i / 3].indices[i % 3] = vrModel->rIndexData[i];
+  }
+
+  lovrModelDataAllocateArray(modelData, &mesh->vertices, vertexCount);
+  lovrModelDataAllocateArray(modelData, &mesh->normals, vertexCount);
+  lovrModelDataAllocateArray(modelData, &mesh->texCoords, vertexCount);
+  vec_init(&mesh->boneWeights);
+  vec_init(&mesh->lodFaces);
+  mesh->lodCount = 0;
+  mesh->hasBones = 0;
+  mesh->aabb[0] = mesh->aabb[2] = mesh->aabb[4] = FLT_MAX;
+  mesh->aabb[1] = mesh->aabb[3] = mesh->aabb[5] = -FLT_MAX;
+  for (size_t i = 0; i < vertexCount; i++) {
     float* position = vrModel->rVertexData[i].vPosition.v;
     float* normal = vrModel->rVertexData[i].vNormal.v;
     float* texCoords = vrModel->rVertexData[i].rfTextureCoord;
@@ -625,28 +634,36 @@ ModelData* lovrHeadsetControllerNewModelData(Controller* controller) {
     v.x = position[0];
     v.y = position[1];
     v.z = position[2];
-    vec_push(&mesh->vertices, v);
+    mesh->vertices.data[i] = v;
+    mesh->aabb[0] = MIN(mesh->aabb[0], v.x);
+    mesh->aabb[1] = MAX(mesh->aabb[1], v.x);
+    mesh->aabb[2] = MIN(mesh->aabb[2], v.y);
+    mesh->aabb[3] = MAX(mesh->aabb[3], v.y);
+    mesh->aabb[4] = MIN(mesh->aabb[4], v.z);
+    mesh->aabb[5] = MAX(mesh->aabb[5], v.z);
 
     v.x = normal[0];
     v.y = normal[1];
     v.z = normal[2];
-    vec_push(&mesh->normals, v);
+    mesh->normals.data[i] = v;
 
     v.x = texCoords[0];
     v.y = texCoords[1];
     v.z = 0.f;
-    vec_push(&mesh->texCoords, v);
+    mesh->texCoords.data[i] = v;
   }
 
-  ModelNode* root = malloc(sizeof(ModelNode));
-  vec_init(&root->meshes);
-  vec_push(&root->meshes, 0);
+  ModelNode* root = lovrModelDataAllocate(modelData, sizeof(ModelNode));
+  root->name = lovrModelDataCopyString(modelData, "", 0);
+  root->index = 0;
+  root->parent = NULL;
+  lovrModelDataAllocateArray(modelData, &root->meshes, 1);
+  root->meshes.data[0] = 0;
   vec_init(&root->children);
   mat4_identity(root->transform);
 
   modelData->root = root;
-  modelData->hasNormals = 1;
-  modelData->hasTexCoords = 1;
+  vec_push(&modelData->nodes, root);
 
   return modelData;
 }
@@ -724,6 +741,7 @@ void lovrHeadsetRenderTo(headsetRenderCallback callback, void* userdata) {
     lovrGraphicsSetProjection(projection);
     lovrGraphicsClear(1, 1);
     callback(eye, userdata);
+    lovrGraphicsFlush();
     lovrGraphicsPop();
     lovrTextureResolveMSAA(state.texture);
 
@@ -44,6 +44,7 @@ static void onRequestAnimationFrame(void* userdata) {
     }
 
     state.renderCallback(eye, userdata);
+    lovrGraphicsFlush();
     lovrGraphicsPop();
   }
 }
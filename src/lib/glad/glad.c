@@ -7,6 +7,9 @@
     APIs: gl=3.3, gles2=3.0
     Profile: core
     Extensions:
+        GL_ARB_buffer_storage,
+        GL_ARB_draw_indirect,
+        GL_ARB_multi_draw_indirect,
         GL_ARB_texture_storage,
         GL_EXT_texture_compression_s3tc,
         GL_EXT_texture_filter_anisotropic
@@ -15,9 +18,9 @@
     Omit khrplatform: False
 
     Commandline:
-        --profile="core" --api="gl=3.3,gles2=3.0" --generator="c" --spec="gl" --no-loader --extensions="GL_ARB_texture_storage,GL_EXT_texture_compression_s3tc,GL_EXT_texture_filter_anisotropic"
+        --profile="core" --api="gl=3.3,gles2=3.0" --generator="c" --spec="gl" --no-loader --extensions="GL_ARB_buffer_storage,GL_ARB_draw_indirect,GL_ARB_multi_draw_indirect,GL_ARB_texture_storage,GL_EXT_texture_compression_s3tc,GL_EXT_texture_filter_anisotropic"
     Online:
-        http://glad.dav1d.de/#profile=core&language=c&specification=gl&api=gl%3D3.3&api=gles2%3D3.0&extensions=GL_ARB_texture_storage&extensions=GL_EXT_texture_compression_s3tc&extensions=GL_EXT_texture_filter_anisotropic
+        http://glad.dav1d.de/#profile=core&language=c&specification=gl&api=gl%3D3.3&api=gles2%3D3.0&extensions=GL_ARB_buffer_storage&extensions=GL_ARB_draw_indirect&extensions=GL_ARB_multi_draw_indirect&extensions=GL_ARB_texture_storage&extensions=GL_EXT_texture_compression_s3tc&extensions=GL_EXT_texture_filter_anisotropic
 */
 
 #include <stdio.h>
@@ -520,9 +523,17 @@ PFNGLGETUNIFORMBLOCKINDEXPROC glad_glGetUniformBlockIndex;
 PFNGLTEXIMAGE2DMULTISAMPLEPROC glad_glTexImage2DMultisample;
 PFNGLGETACTIVEUNIFORMPROC glad_glGetActiveUniform;
 PFNGLFRONTFACEPROC glad_glFrontFace;
+int GLAD_GL_ARB_buffer_storage;
+int GLAD_GL_ARB_draw_indirect;
+int GLAD_GL_ARB_multi_draw_indirect;
 int GLAD_GL_ARB_texture_storage;
 int GLAD_GL_EXT_texture_compression_s3tc;
 int GLAD_GL_EXT_texture_filter_anisotropic;
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage;
+PFNGLDRAWARRAYSINDIRECTPROC glad_glDrawArraysIndirect;
+PFNGLDRAWELEMENTSINDIRECTPROC glad_glDrawElementsIndirect;
+PFNGLMULTIDRAWARRAYSINDIRECTPROC glad_glMultiDrawArraysIndirect;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect;
 PFNGLTEXSTORAGE1DPROC glad_glTexStorage1D;
 static void load_GL_VERSION_1_0(GLADloadproc load) {
 	if(!GLAD_GL_VERSION_1_0) return;
@@ -937,6 +948,20 @@ static void load_GL_VERSION_3_3(GLADloadproc load) {
 	glad_glSecondaryColorP3ui = (PFNGLSECONDARYCOLORP3UIPROC)load("glSecondaryColorP3ui");
 	glad_glSecondaryColorP3uiv = (PFNGLSECONDARYCOLORP3UIVPROC)load("glSecondaryColorP3uiv");
 }
+static void load_GL_ARB_buffer_storage(GLADloadproc load) {
+	if(!GLAD_GL_ARB_buffer_storage) return;
+	glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+}
+static void load_GL_ARB_draw_indirect(GLADloadproc load) {
+	if(!GLAD_GL_ARB_draw_indirect) return;
+	glad_glDrawArraysIndirect = (PFNGLDRAWARRAYSINDIRECTPROC)load("glDrawArraysIndirect");
+	glad_glDrawElementsIndirect = (PFNGLDRAWELEMENTSINDIRECTPROC)load("glDrawElementsIndirect");
+}
+static void load_GL_ARB_multi_draw_indirect(GLADloadproc load) {
+	if(!GLAD_GL_ARB_multi_draw_indirect) return;
+	glad_glMultiDrawArraysIndirect = (PFNGLMULTIDRAWARRAYSINDIRECTPROC)load("glMultiDrawArraysIndirect");
+	glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+}
 static void load_GL_ARB_texture_storage(GLADloadproc load) {
 	if(!GLAD_GL_ARB_texture_storage) return;
 	glad_glTexStorage1D = (PFNGLTEXSTORAGE1DPROC)load("glTexStorage1D");
@@ -945,6 +970,9 @@ static void load_GL_ARB_texture_storage(GLADloadproc load) {
 }
 static int find_extensionsGL(void) {
 	if (!get_exts()) return 0;
+	GLAD_GL_ARB_buffer_storage = has_ext("GL_ARB_buffer_storage");
+	GLAD_GL_ARB_draw_indirect = has_ext("GL_ARB_draw_indirect");
+	GLAD_GL_ARB_multi_draw_indirect = has_ext("GL_ARB_multi_draw_indirect");
 	GLAD_GL_ARB_texture_storage = has_ext("GL_ARB_texture_storage");
 	GLAD_GL_EXT_texture_compression_s3tc = has_ext("GL_EXT_texture_compression_s3tc");
 	GLAD_GL_EXT_texture_filter_anisotropic = has_ext("GL_EXT_texture_filter_anisotropic");
@@ -1026,6 +1054,9 @@ int gladLoadGLLoader(GLADloadproc load) {
 	load_GL_VERSION_3_3(load);
 
 	if (!find_extensionsGL()) return 0;
+	load_GL_ARB_buffer_storage(load);
+	load_GL_ARB_draw_indirect(load);
+	load_GL_ARB_multi_draw_indirect(load);
 	load_GL_ARB_texture_storage(load);
 	return GLVersion.major != 0 || GLVersion.minor != 0;
 }
@@ -0,0 +1,1251 @@
+#include "loaders/model.h"
+#include "filesystem/filesystem.h"
+#include "math/mat4.h"
+#include "math/vec3.h"
+#include "lib/jsmn/jsmn.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <float.h>
+
+#define GLB_MAGIC 0x46546c67 // glTF
+#define GLB_CHUNK_JSON 0x4e4f534a // JSON
+#define GLB_CHUNK_BIN 0x004e4942 // BIN
+
+#define GLTF_BYTE 5120
+#define GLTF_UNSIGNED_BYTE 5121
+#define GLTF_SHORT 5122
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT 5125
+#define GLTF_FLOAT 5126
+
+#define GLTF_TRIANGLES 4
+
+typedef struct {
+  char* data;
+  size_t size;
+} GltfBuffer;
+
+typedef struct {
+  int buffer;
+  size_t offset;
+  size_t length;
+  size_t stride;
+} GltfBufferView;
+
+typedef struct {
+  int view;
+  size_t offset;
+  int count;
+  int componentType;
+  int components;
+  int normalized;
+  int hasBounds;
+  float min[4];
+  float max[4];
+} GltfAccessor;
+
+typedef struct {
+  int input;
+  int output;
+  int cubic;
+} GltfSampler;
+
+typedef struct {
+  int firstPrimitive;
+  int primitiveCount;
+  int skin;
+} GltfMesh;
+
+typedef struct {
+  ModelNode* node;
+  int mesh;
+  int skin;
+  int hasParent;
+} GltfNode;
+
+typedef struct {
+  Blob* blob;
+  ModelData* modelData;
+  const char* json;
+  jsmntok_t* tokens;
+  GltfBuffer* buffers;
+  GltfBufferView* views;
+  GltfAccessor* accessors;
+  GltfMesh* meshes;
+  GltfNode* nodes;
+  int* images;
+  int* textures;
+  char* binaryData;
+  size_t binarySize;
+  int bufferCount;
+  int viewCount;
+  int accessorCount;
+  int meshCount;
+  int nodeCount;
+  int imageCount;
+  int textureCount;
+} GltfLoader;
+
+// JSON
+
+static int jsonSkip(jsmntok_t* tokens, int token) {
+  int remaining = 1;
+  while (remaining > 0) {
+    remaining += tokens[token++].size - 1;
+  }
+  return token;
+}
+
+static int jsonEquals(GltfLoader* loader, int token, const char* string) {
+  jsmntok_t* t = &loader->tokens[token];
+  size_t length = t->end - t->start;
+  return t->type == JSMN_STRING && strlen(string) == length && !strncmp(loader->json + t->start, string, length);
+}
+
+static float jsonNumber(GltfLoader* loader, int token) {
+  return strtof(loader->json + loader->tokens[token].start, NULL);
+}
+
+static int jsonInt(GltfLoader* loader, int token) {
+  return (int) strtol(loader->json + loader->tokens[token].start, NULL, 10);
+}
+
+static char* jsonString(GltfLoader* loader, int token) {
+  jsmntok_t* t = &loader->tokens[token];
+  return lovrModelDataCopyString(loader->modelData, loader->json + t->start, t->end - t->start);
+}
+
+// Reads up to count numbers from an array, returning how many were read
+static int jsonNumbers(GltfLoader* loader, int token, float* numbers, int count) {
+  jsmntok_t* t = &loader->tokens[token];
+  int n = MIN(t->size, count);
+  for (int i = 0; i < n; i++) {
+    numbers[i] = jsonNumber(loader, token + 1 + i);
+  }
+  return n;
+}
+
+// Buffers
+
+static int decodeBase64Char(char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A';
+  if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+  if (c >= '0' && c <= '9') return c - '0' + 52;
+  if (c == '+' || c == '-') return 62;
+  if (c == '/' || c == '_') return 63;
+  return -1;
+}
+
+static char* decodeBase64(const char* string, size_t length, size_t* size) {
+  char* data = malloc(length / 4 * 3 + 3);
+  uint32_t bits = 0;
+  int bitCount = 0;
+  *size = 0;
+
+  for (size_t i = 0; i < length; i++) {
+    int value = decodeBase64Char(string[i]);
+    if (value < 0) {
+      continue;
+    }
+
+    bits = (bits << 6) | value;
+    bitCount += 6;
+    if (bitCount >= 8) {
+      bitCount -= 8;
+      data[(*size)++] = (bits >> bitCount) & 0xff;
+    }
+  }
+
+  return data;
+}
+
+// Returns the decoded contents of a data uri, or NULL if the uri is a path
+static char* decodeDataUri(GltfLoader* loader, int uri, size_t* size) {
+  jsmntok_t* t = &loader->tokens[uri];
+  const char* string = loader->json + t->start;
+  size_t length = t->end - t->start;
+  if (length <= 5 || strncmp(string, "data:", 5)) {
+    return NULL;
+  }
+
+  const char* comma = memchr(string, ',', length);
+  lovrAssert(comma && comma - string >= 7 && !strncmp(comma - 7, ";base64", 7), "glTF data uris must use base64");
+  return decodeBase64(comma + 1, length - (comma + 1 - string), size);
+}
+
+static int decodeHexChar(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Copies a uri that's a relative path, decoding the percent encoded characters
+static void decodeUriPath(GltfLoader* loader, int uri, char* path, size_t size) {
+  jsmntok_t* t = &loader->tokens[uri];
+  const char* string = loader->json + t->start;
+  size_t length = t->end - t->start;
+  size_t n = 0;
+
+  for (size_t i = 0; i < length && n + 1 < size; i++) {
+    int high, low;
+    if (string[i] == '%' && i + 2 < length && (high = decodeHexChar(string[i + 1])) >= 0 && (low = decodeHexChar(string[i + 2])) >= 0) {
+      path[n++] = (char) ((high << 4) | low);
+      i += 2;
+    } else {
+      path[n++] = string[i];
+    }
+  }
+
+  path[n] = '\0';
+}
+
+// Buffers with a uri are either embedded as base64 or are files next to the model
+static void loadBuffer(GltfLoader* loader, GltfBuffer* buffer, int uri, size_t byteLength) {
+  Blob* blob = NULL;
+
+  // The GLB binary chunk is used in place, the source Blob is already referenced by the ModelData
+  if (uri < 0) {
+    lovrAssert(loader->binaryData, "glTF buffer has no uri and there is no GLB binary chunk");
+    buffer->data = loader->binaryData;
+    buffer->size = loader->binarySize;
+  } else {
+    size_t size;
+    char* data = decodeDataUri(loader, uri, &size);
+
+    if (data) {
+      blob = lovrBlobCreate(data, size, "glTF buffer");
+    } else {
+      char file[LOVR_PATH_MAX];
+      char path[LOVR_PATH_MAX];
+      decodeUriPath(loader, uri, file, LOVR_PATH_MAX);
+      const char* slash = strrchr(loader->blob->name, '/');
+      int directoryLength = slash ? (int) (slash - loader->blob->name + 1) : 0;
+      snprintf(path, LOVR_PATH_MAX, "%.*s%s", directoryLength, loader->blob->name, file);
+
+      data = lovrFilesystemRead(path, &size);
+      lovrAssert(data, "Could not read glTF buffer '%s'", path);
+      blob = lovrBlobCreate(data, size, "glTF buffer");
+    }
+
+    vec_push(&loader->modelData->blobs, blob);
+    buffer->data = blob->data;
+    buffer->size = blob->size;
+  }
+
+  lovrAssert(byteLength <= buffer->size, "glTF buffer is smaller than its byteLength");
+}
+
+// Accessors
+
+static int getComponentSize(int componentType) {
+  switch (componentType) {
+    case GLTF_BYTE: case GLTF_UNSIGNED_BYTE: return 1;
+    case GLTF_SHORT: case GLTF_UNSIGNED_SHORT: return 2;
+    case GLTF_UNSIGNED_INT: case GLTF_FLOAT: return 4;
+    default: lovrThrow("Unknown glTF component type %d", componentType); return 0;
+  }
+}
+
+static size_t getStride(GltfLoader* loader, GltfAccessor* accessor) {
+  size_t stride = accessor->view >= 0 ? loader->views[accessor->view].stride : 0;
+  return stride ? stride : (size_t) getComponentSize(accessor->componentType) * accessor->components;
+}
+
+// Returns NULL for accessors without a buffer view, which are all zeroes
+static char* getAccessorData(GltfLoader* loader, GltfAccessor* accessor) {
+  if (accessor->view < 0) {
+    return NULL;
+  }
+
+  return loader->buffers[loader->views[accessor->view].buffer].data + loader->views[accessor->view].offset + accessor->offset;
+}
+
+static GltfAccessor* getAccessor(GltfLoader* loader, int index, int components) {
+  lovrAssert(index >= 0 && index < loader->accessorCount, "Invalid glTF accessor %d", index);
+  GltfAccessor* accessor = &loader->accessors[index];
+  lovrAssert(accessor->components == components, "glTF accessor %d has %d components, expected %d", index, accessor->components, components);
+  return accessor;
+}
+
+// Accessor data can be used directly if it is tightly packed and aligned
+static int canBorrow(GltfLoader* loader, GltfAccessor* accessor, int componentType, int components) {
+  char* data = getAccessorData(loader, accessor);
+  return data && accessor->componentType == componentType && !accessor->normalized &&
+    accessor->components == components && getStride(loader, accessor) == 4 * (size_t) components &&
+    ((uintptr_t) data & 3) == 0;
+}
+
+// Reads an element of an accessor as floats, applying normalization
+static void readFloats(GltfLoader* loader, GltfAccessor* accessor, int index, float* values) {
+  char* data = getAccessorData(loader, accessor);
+  if (!data) {
+    memset(values, 0, accessor->components * sizeof(float));
+    return;
+  }
+
+  char* element = data + index * getStride(loader, accessor);
+  int normalized = accessor->normalized;
+  for (int i = 0; i < accessor->components; i++) {
+    switch (accessor->componentType) {
+      case GLTF_BYTE: {
+        int8_t x; memcpy(&x, element + i, 1);
+        values[i] = normalized ? MAX(x / 127.f, -1.f) : x;
+        break;
+      }
+      case GLTF_UNSIGNED_BYTE: {
+        uint8_t x; memcpy(&x, element + i, 1);
+        values[i] = normalized ? x / 255.f : x;
+        break;
+      }
+      case GLTF_SHORT: {
+        int16_t x; memcpy(&x, element + 2 * i, 2);
+        values[i] = normalized ? MAX(x / 32767.f, -1.f) : x;
+        break;
+      }
+      case GLTF_UNSIGNED_SHORT: {
+        uint16_t x; memcpy(&x, element + 2 * i, 2);
+        values[i] = normalized ? x / 65535.f : x;
+        break;
+      }
+      case GLTF_UNSIGNED_INT: {
+        uint32_t x; memcpy(&x, element + 4 * i, 4);
+        values[i] = x;
+        break;
+      }
+      case GLTF_FLOAT:
+        memcpy(&values[i], element + 4 * i, 4);
+        break;
+    }
+  }
+}
+
+static uint32_t readIndex(GltfLoader* loader, GltfAccessor* accessor, int index) {
+  char* data = getAccessorData(loader, accessor);
+  if (!data) {
+    return 0;
+  }
+
+  char* element = data + index * getStride(loader, accessor);
+  switch (accessor->componentType) {
+    case GLTF_UNSIGNED_BYTE: return *(uint8_t*) element;
+    case GLTF_UNSIGNED_SHORT: { uint16_t x; memcpy(&x, element, 2); return x; }
+    case GLTF_UNSIGNED_INT: { uint32_t x; memcpy(&x, element, 4); return x; }
+    default: lovrThrow("Invalid glTF index type %d", accessor->componentType); return 0;
+  }
+}
+
+// Reads a vec3 accessor into a ModelVertex array, pointing at the buffer when the layout matches
+static void readVertices(GltfLoader* loader, GltfAccessor* accessor, vec_model_vertex_t* vertices) {
+  if (canBorrow(loader, accessor, GLTF_FLOAT, 3)) {
+    vertices->data = (ModelVertex*) getAccessorData(loader, accessor);
+  } else {
+    vertices->data = lovrModelDataAllocate(loader->modelData, accessor->count * sizeof(ModelVertex));
+    for (int i = 0; i < accessor->count; i++) {
+      readFloats(loader, accessor, i, &vertices->data[i].x);
+    }
+  }
+
+  vertices->length = vertices->capacity = accessor->count;
+}
+
+static void parseBuffers(GltfLoader* loader, int token) {
+  jsmntok_t* tokens = loader->tokens;
+  loader->bufferCount = tokens[token].size;
+  loader->buffers = calloc(loader->bufferCount, sizeof(GltfBuffer));
+
+  int t = token + 1;
+  for (int i = 0; i < loader->bufferCount; i++) {
+    int uri = -1;
+    size_t byteLength = 0;
+    int keys = tokens[t].size;
+    t++;
+    for (int k = 0; k < keys; k++) {
+      if (jsonEquals(loader, t, "uri")) uri = t + 1;
+      else if (jsonEquals(loader, t, "byteLength")) byteLength = jsonNumber(loader, t + 1);
+      t = jsonSkip(tokens, t + 1);
+    }
+
+    loadBuffer(loader, &loader->buffers[i], uri, byteLength);
+  }
+}
+
+static void parseBufferViews(GltfLoader* loader, int token) {
+  jsmntok_t* tokens = loader->tokens;
+  loader->viewCount = tokens[token].size;
+  loader->views = calloc(loader->viewCount, sizeof(GltfBufferView));
+
+  int t = token + 1;
+  for (int i = 0; i < loader->viewCount; i++) {
+    GltfBufferView* view = &loader->views[i];
+    view->buffer = -1;
+    int keys = tokens[t].size;
+    t++;
+    for (int k = 0; k < keys; k++) {
+      if (jsonEquals(loader, t, "buffer")) view->buffer = jsonInt(loader, t + 1);
+      else if (jsonEquals(loader, t, "byteOffset")) view->offset = jsonNumber(loader, t + 1);
+      else if (jsonEquals(loader, t, "byteLength")) view->length = jsonNumber(loader, t + 1);
+      else if (jsonEquals(loader, t, "byteStride")) view->stride = jsonNumber(loader, t + 1);
+      t = jsonSkip(tokens, t + 1);
+    }
+
+    lovrAssert(view->buffer >= 0 && view->buffer < loader->bufferCount, "Invalid glTF buffer %d", view->buffer);
+    GltfBuffer* buffer = &loader->buffers[view->buffer];
+    lovrAssert(view->offset <= buffer->size && view->length <= buffer->size - view->offset, "glTF buffer view %d is out of bounds", i);
+  }
+}
+
+static void parseAccessors(GltfLoader* loader, int token) {
+  jsmntok_t* tokens = loader->tokens;
+  loader->accessorCount = tokens[token].size;
+  loader->accessors = calloc(loader->accessorCount, sizeof(GltfAccessor));
+
+  int t = token + 1;
+  for (int i = 0; i < loader->accessorCount; i++) {
+    GltfAccessor* accessor = &loader->accessors[i];
+    accessor->view = -1;
+    int hasMin = 0;
+    int hasMax = 0;
+    int keys = tokens[t].size;
+    t++;
+    for (int k = 0; k < keys; k++) {
+      if (jsonEquals(loader, t, "bufferView")) accessor->view = jsonInt(loader, t + 1);
+      else if (jsonEquals(loader, t, "byteOffset")) accessor->offset = jsonNumber(loader, t + 1);
+      else if (jsonEquals(loader, t, "componentType")) accessor->componentType = jsonInt(loader, t + 1);
+      else if (jsonEquals(loader, t, "normalized")) accessor->normalized = loader->json[tokens[t + 1].start] == 't';
+      else if (jsonEquals(loader, t, "count")) accessor->count = jsonInt(loader, t + 1);
+      else if (jsonEquals(loader, t, "min")) hasMin = jsonNumbers(loader, t + 1, accessor->min, 4) > 0;
+      else if (jsonEquals(loader, t, "max")) hasMax = jsonNumbers(loader, t + 1, accessor->max, 4) > 0;
+      else if (jsonEquals(loader, t, "sparse")) lovrThrow("Sparse glTF accessors are not supported");
+      else if (jsonEquals(loader, t, "type")) {
+        if (jsonEquals(loader, t + 1, "SCALAR")) accessor->components = 1;
+        else if (jsonEquals(loader, t + 1, "VEC2")) accessor->components = 2;
+        else if (jsonEquals(loader, t + 1, "VEC3")) accessor->components = 3;
+        else if (jsonEquals(loader, t + 1, "VEC4")) accessor->components = 4;
+        else if (jsonEquals(loader, t + 1, "MAT4")) accessor->components = 16;
+        else accessor->components = 0;
+      }
+      t = jsonSkip(tokens, t + 1);
+    }
+
+    accessor->hasBounds = hasMin && hasMax;
+    lovrAssert(accessor->count >= 0, "Invalid glTF accessor count");
+    lovrAssert(accessor->view < loader->viewCount, "Invalid glTF buffer view %d", accessor->view);
+
+    // Make sure the last element fits in the buffer view
+    if (accessor->view >= 0 && accessor->count > 0) {
+      GltfBufferView* view = &loader->views[accessor->view];
+      size_t elementSize = (size_t) getComponentSize(accessor->componentType) * accessor->components;
+      size_t end = accessor->offset + (accessor->count - 1) * getStride(loader, accessor) + elementSize;
+      lovrAssert(end <= view->length, "glTF accessor %d is out of bounds", i);
+    }
+  }
+}
+
+// Materials
+
+// Images are files next to the model, data uris, or buffer views
+static void parseImages(GltfLoader* loader, int token) {
+  jsmntok_t* tokens = loader->tokens;
+  ModelData* modelData = loader->modelData;
+  loader->imageCount = tokens[token].size;
+  loader->images = calloc(loader->imageCount, sizeof(int));
+
+  int t = token + 1;
+  for (int i = 0; i < loader->imageCount; i++) {
+    int uri = -1;
+    int view = -1;
+    int keys = tokens[t].size;
+    t++;
+    for (int k = 0; k < keys; k++) {
+      if (jsonEquals(loader, t, "uri")) uri = t + 1;
+      else if (jsonEquals(loader, t, "bufferView")) view = jsonInt(loader, t + 1);
+      t = jsonSkip(tokens, t + 1);
+    }
+
+    loader->images[i] = -1;
+    if (uri >= 0) {
+      size_t size;
+      char* data = decodeDataUri(loader, uri, &size);
+      if (data) {
+        loader->images[i] = lovrModelDataAddImage(modelData, NULL, NULL, data, size);
+        free(data);
+      } else {
+        char path[LOVR_PATH_MAX];
+        decodeUriPath(loader, uri, path, LOVR_PATH_MAX);
+        loader->images[i] = lovrModelDataAddImage(modelData, loader->blob->name, path, NULL, 0);
+      }
+    } else if (view >= 0) {
+      lovrAssert(view < loader->viewCount, "Invalid glTF buffer view %d", view);
+      GltfBufferView* bufferView = &loader->views[view];
+      char* data = loader->buffers[bufferView->buffer].data + bufferView->offset;
+      loader->images[i] = lovrModelDataAddImage(modelData, NULL, NULL, data, bufferView->length);
+    }
+  }
+}
+
+// Samplers are ignored, model textures repeat and use the default filter
+static void parseTextures(GltfLoader* loader, int token) {
+  jsmntok_t* tokens = loader->tokens;
+  loader->textureCount = tokens[token].size;
+  loader->textures = calloc(loader->textureCount, sizeof(int));
+
+  int t = token + 1;
+  for (int i = 0; i < loader->textureCount; i++) {
+    int source = -1;
+    int keys = tokens[t].size;
+    t++;
+    for (int k = 0; k < keys; k++) {
+      if (jsonEquals(loader, t, "source")) source = jsonInt(loader, t + 1);
+      t = jsonSkip(tokens, t + 1);
+    }
+
+    lovrAssert(source < loader->imageCount, "Invalid glTF image %d", source);
+    loader->textures[i] = source >= 0 ? loader->images[source] : -1;
+  }
+}
+
+// Returns the image used by a texture info object
+static int parseTextureInfo(GltfLoader* loader, int token) {
+  jsmntok_t* tokens = loader->tokens;
+  int texture = -1;
+  int t = token + 1;
+  for (int k = 0; k < tokens[token].size; k++) {
+    if (jsonEquals(loader, t, "index")) texture = jsonInt(loader, t + 1);
+    t = jsonSkip(tokens, t + 1);
+  }
+
+  lovrAssert(texture < loader->textureCount, "Invalid glTF texture %d", texture);
+  return texture >= 0 ? loader->textures[texture] : -1;
+}
+
+// Metallic roughness parameters other than the base color aren't used
+static void parseMaterials(GltfLoader* loader, int token) {
+  jsmntok_t* tokens = loader->tokens;
+  ModelData* modelData = loader->modelData;
+
+  int t = token + 1;
+  for (int i = 0; i < tokens[token].size; i++) {
+    ModelMaterial* material = &modelData->materials.data[lovrModelDataAddMaterial(modelData, NULL)];
+    int keys = tokens[t].size;
+    t++;
+    for (int k = 0; k < keys; k++) {
+      if (jsonEquals(loader, t, "name")) material->name = jsonString(loader, t + 1);
+      else if (jsonEquals(loader, t, "emissiveFactor")) jsonNumbers(loader, t + 1, material->emissiveColor, 3);
+      else if (jsonEquals(loader, t, "emissiveTexture")) material->emissiveTexture = parseTextureInfo(loader, t + 1);
+      else if (jsonEquals(loader, t, "pbrMetallicRoughness")) {
+        int p = t + 2;
+        for (int j = 0; j < tokens[t + 1].size; j++) {
+          if (jsonEquals(loader, p, "baseColorFactor")) jsonNumbers(loader, p + 1, material->diffuseColor, 4);
+          else if (jsonEquals(loader, p, "baseColorTexture")) material->diffuseTexture = parseTextureInfo(loader, p + 1);
+          p = jsonSkip(tokens, p + 1);
+        }
+      }
+      t = jsonSkip(tokens, t + 1);
+    }
+  }
+}
+
+// Meshes
+
+static void computeNormals(GltfLoader* loader, ModelMesh* mesh) {
+  int vertexCount = mesh->vertices.length;
+  ModelVertex* normals = lovrModelDataAllocate(loader->modelData, vertexCount * sizeof(ModelVertex));
+  memset(normals, 0, vertexCount * sizeof(ModelVertex));
+
+  for (int f = 0; f < mesh->faces.length; f++) {
+    unsigned int* indices = mesh->faces.data[f].indices;
+    ModelVertex* a = &mesh->vertices.data[indices[0]];
+    ModelVertex* b = &mesh->vertices.data[indices[1]];
+    ModelVertex* c = &mesh->vertices.data[indices[2]];
+    float u[3] = { b->x - a->x, b->y - a->y, b->z - a->z };
+    float v[3] = { c->x - a->x, c->y - a->y, c->z - a->z };
+    vec3_cross(u, v);
+    for (int i = 0; i < 3; i++) {
+      normals[indices[i]].x += u[0];
+      normals[indices[i]].y += u[1];
+      normals[indices[i]].z += u[2];
+    }
+  }
+
+  for (int i = 0; i < vertexCount; i++) {
+    vec3_normalize(&normals[i].x);
+  }
+
+  mesh->normals.data = normals;
+  mesh->normals.length = mesh->normals.capacity = vertexCount;
+}
+
+static void parsePrimitive(GltfLoader* loader, int token) {
+  jsmntok_t* tokens = loader->tokens;
+  ModelData* modelData = loader->modelData;
+  int position = -1, normal = -1, texCoord = -1, joints = -1, weights = -1, indices = -1;
+  int mode = GLTF_TRIANGLES;
+  int material = -1;
+
+  int t = token + 1;
+  for (int k = 0; k < tokens[token].size; k++) {
+    if (jsonEquals(loader, t, "indices")) indices = jsonInt(loader, t + 1);
+    else if (jsonEquals(loader, t, "mode")) mode = jsonInt(loader, t + 1);
+    else if (jsonEquals(loader, t, "material")) material = jsonInt(loader, t + 1);
+    else if (jsonEquals(loader, t, "attributes")) {
+      int a = t + 2;
+      for (int j = 0; j < tokens[t + 1].size; j++) {
+        if (jsonEquals(loader, a, "POSITION")) position = jsonInt(loader, a + 1);
+        else if (jsonEquals(loader, a, "NORMAL")) normal = jsonInt(loader, a + 1);
+        else if (jsonEquals(loader, a, "TEXCOORD_0")) texCoord = jsonInt(loader, a + 1);
+        else if (jsonEquals(loader, a, "JOINTS_0")) joints = jsonInt(loader, a + 1);
+        else if (jsonEquals(loader, a, "WEIGHTS_0")) weights = jsonInt(loader, a + 1);
+        a = jsonSkip(tokens, a + 1);
+      }
+    }
+    t = jsonSkip(tokens, t + 1);
+  }
+
+  // Lines and points are skipped, like they are for other formats
+  if (mode != GLTF_TRIANGLES || position < 0) {
+    return;
+  }
+
+  ModelMesh* mesh = lovrModelDataAllocate(modelData, sizeof(ModelMesh));
+  vec_init(&mesh->faces);
+  vec_init(&mesh->vertices);
+  vec_init(&mesh->normals);
+  vec_init(&mesh->texCoords);
+  vec_init(&mesh->boneWeights);
+  vec_init(&mesh->lodFaces);
+  mesh->lodCount = 0;
+  mesh->hasBones = 0;
+  mesh->material = material;
+  vec_push(&modelData->meshes, mesh);
+
+  // Vertices
+  GltfAccessor* positions = getAccessor(loader, position, 3);
+  int vertexCount = positions->count;
+  readVertices(loader, positions, &mesh->vertices);
+
+  if (positions->hasBounds) {
+    for (int i = 0; i < 3; i++) {
+      mesh->aabb[2 * i + 0] = positions->min[i];
+      mesh->aabb[2 * i + 1] = positions->max[i];
+    }
+  } else {
+    mesh->aabb[0] = mesh->aabb[2] = mesh->aabb[4] = vertexCount > 0 ? FLT_MAX : 0;
+    mesh->aabb[1] = mesh->aabb[3] = mesh->aabb[5] = vertexCount > 0 ? -FLT_MAX : 0;
+    for (int i = 0; i < vertexCount; i++) {
+      ModelVertex* v = &mesh->vertices.data[i];
+      mesh->aabb[0] = MIN(mesh->aabb[0], v->x);
+      mesh->aabb[1] = MAX(mesh->aabb[1], v->x);
+      mesh->aabb[2] = MIN(mesh->aabb[2], v->y);
+      mesh->aabb[3] = MAX(mesh->aabb[3], v->y);
+      mesh->aabb[4] = MIN(mesh->aabb[4], v->z);
+      mesh->aabb[5] = MAX(mesh->aabb[5], v->z);
+    }
+  }
+
+  // Faces, 32 bit indices are used directly
+  if (indices >= 0) {
+    GltfAccessor* accessor = getAccessor(loader, indices, 1);
+    int faceCount = accessor->count / 3;
+    if (canBorrow(loader, accessor, GLTF_UNSIGNED_INT, 1)) {
+      mesh->faces.data = (ModelFace*) getAccessorData(loader, accessor);
+    } else {
+      mesh->faces.data = lovrModelDataAllocate(loader->modelData, faceCount * sizeof(ModelFace));
+      for (int i = 0; i < faceCount; i++) {
+        for (int j = 0; j < 3; j++) {
+          mesh->faces.data[i].indices[j] = readIndex(loader, accessor, 3 * i + j);
+        }
+      }
+    }
+    mesh->faces.length = mesh->faces.capacity = faceCount;
+  } else {
+    int faceCount = vertexCount / 3;
+    mesh->faces.data = lovrModelDataAllocate(loader->modelData, faceCount * sizeof(ModelFace));
+    for (int i = 0; i < faceCount; i++) {
+      for (int j = 0; j < 3; j++) {
+        mesh->faces.data[i].indices[j] = 3 * i + j;
+      }
+    }
+    mesh->faces.length = mesh->faces.capacity = faceCount;
+  }
+
+  for (int i = 0; i < mesh->faces.length; i++) {
+    unsigned int* face = mesh->faces.data[i].indices;
+    lovrAssert(face[0] < (unsigned) vertexCount && face[1] < (unsigned) vertexCount && face[2] < (unsigned) vertexCount, "glTF index is out of range");
+  }
+
+  // Normals
+  modelData->hasNormals = 1;
+  if (normal >= 0) {
+    GltfAccessor* accessor = getAccessor(loader, normal, 3);
+    lovrAssert(accessor->count == vertexCount, "glTF attributes have different counts");
+    readVertices(loader, accessor, &mesh->normals);
+  } else {
+    computeNormals(loader, mesh);
+  }
+
+  // Texture coordinates have 2 components, so they're always expanded
+  if (texCoord >= 0) {
+    GltfAccessor* accessor = getAccessor(loader, texCoord, 2);
+    lovrAssert(accessor->count == vertexCount, "glTF attributes have different counts");
+    mesh->texCoords.data = lovrModelDataAllocate(loader->modelData, vertexCount * sizeof(ModelVertex));
+    mesh->texCoords.length = mesh->texCoords.capacity = vertexCount;
+    for (int i = 0; i < vertexCount; i++) {
+      ModelVertex* uv = &mesh->texCoords.data[i];
+      readFloats(loader, accessor, i, &uv->x);
+      uv->z = 0.f;
+    }
+    modelData->hasTexCoords = 1;
+  }
+
+  // Joints index into the skin of the node using the mesh, they're offset when skins are read
+  if (joints >= 0 && weights >= 0) {
+    GltfAccessor* jointAccessor = getAccessor(loader, joints, 4);
+    GltfAccessor* weightAccessor = getAccessor(loader, weights, 4);
+    lovrAssert(jointAccessor->count == vertexCount && weightAccessor->count == vertexCount, "glTF attributes have different counts");
+    mesh->boneWeights.data = lovrModelDataAllocate(loader->modelData, vertexCount * sizeof(ModelBoneWeights));
+    mesh->boneWeights.length = mesh->boneWeights.capacity = vertexCount;
+    for (int i = 0; i < vertexCount; i++) {
+      float jointValues[4];
+      ModelBoneWeights* boneWeights = &mesh->boneWeights.data[i];
+      readFloats(loader, jointAccessor, i, jointValues);
+      readFloats(loader, weightAccessor, i, boneWeights->weights);
+      for (int j = 0; j < MAX_BONES_PER_VERTEX; j++) {
+        boneWeights->bones[j] = jointValues[j];
+      }
+    }
+    mesh->hasBones = 1;
+  }
+}
+
+static void parseMeshes(GltfLoader* loader, int token) {
+  jsmntok_t* tokens = loader->tokens;
+  loader->meshCount = tokens[token].size;
+  loader->meshes = calloc(loader->meshCount, sizeof(GltfMesh));
+
+  int t = token + 1;
+  for (int i = 0; i < loader->meshCount; i++) {
+    GltfMesh* mesh = &loader->meshes[i];
+    mesh->firstPrimitive = loader->modelData->meshes.length;
+    mesh->skin = -1;
+    int keys = tokens[t].size;
+    t++;
+    for (int k = 0; k < keys; k++) {
+      if (jsonEquals(loader, t, "primitives")) {
+        int p = t + 2;
+        for (int j = 0; j < tokens[t + 1].size; j++) {
+          parsePrimitive(loader, p);
+          p = jsonSkip(tokens, p);
+        }
+      }
+      t = jsonSkip(tokens, t + 1);
+    }
+    mesh->primitiveCount = loader->modelData->meshes.length - mesh->firstPrimitive;
+  }
+}
+
+static void parseNodes(GltfLoader* loader, int token) {
+  jsmntok_t* tokens = loader->tokens;
+  loader->nodeCount = tokens[token].size;
+  loader->nodes = calloc(loader->nodeCount, sizeof(GltfNode));
+  ModelNode* nodes = lovrModelDataAllocate(loader->modelData, loader->nodeCount * sizeof(ModelNode));
+
+  for (int i = 0; i < loader->nodeCount; i++) {
+    ModelNode* node = &nodes[i];
+    node->name = NULL;
+    node->index = -1;
+    node->parent = NULL;
+    vec_init(&node->meshes);
+    vec_init(&node->children);
+    loader->nodes[i].node = node;
+    loader->nodes[i].mesh = -1;
+    loader->nodes[i].skin = -1;
+  }
+
+  int t = token + 1;
+  for (int i = 0; i < loader->nodeCount; i++) {
+    GltfNode* gltfNode = &loader->nodes[i];
+    ModelNode* node = gltfNode->node;
+    float translation[3] = { 0, 0, 0 };
+    float rotation[4] = { 0, 0, 0, 1 };
+    float scale[3] = { 1, 1, 1 };
+    int hasMatrix = 0;
+    int keys = tokens[t].size;
+    t++;
+    for (int k = 0; k < keys; k++) {
+      if (jsonEquals(loader, t, "name")) node->name = jsonString(loader, t + 1);
+      else if (jsonEquals(loader, t, "mesh")) gltfNode->mesh = jsonInt(loader, t + 1);
+      else if (jsonEquals(loader, t, "skin")) gltfNode->skin = jsonInt(loader, t + 1);
+      else if (jsonEquals(loader, t, "matrix")) hasMatrix = jsonNumbers(loader, t + 1, node->transform, 16) == 16;
+      else if (jsonEquals(loader, t, "translation")) jsonNumbers(loader, t + 1, translation, 3);
+      else if (jsonEquals(loader, t, "rotation")) jsonNumbers(loader, t + 1, rotation, 4);
+      else if (jsonEquals(loader, t, "scale")) jsonNumbers(loader, t + 1, scale, 3);
+      else if (jsonEquals(loader, t, "children")) {
+        lovrModelDataAllocateArray(loader->modelData, &node->children, tokens[t + 1].size);
+        for (int j = 0; j < tokens[t + 1].size; j++) {
+          int child = jsonInt(loader, t + 2 + j);
+          lovrAssert(child >= 0 && child < loader->nodeCount && child != i, "Invalid glTF node %d", child);
+          lovrAssert(!loader->nodes[child].hasParent, "glTF node %d has multiple parents", child);
+          loader->nodes[child].hasParent = 1;
+          loader->nodes[child].node->parent = node;
+          node->children.data[j] = loader->nodes[child].node;
+        }
+      }
+      t = jsonSkip(tokens, t + 1);
+    }
+
+    if (!node->name) {
+      node->name = lovrModelDataCopyString(loader->modelData, "", 0);
+    }
+
+    if (!hasMatrix) {
+      mat4_identity(node->transform);
+      mat4_translate(node->transform, translation[0], translation[1], translation[2]);
+      mat4_rotateQuat(node->transform, rotation);
+      mat4_scale(node->transform, scale[0], scale[1], scale[2]);
+    }
+
+    if (gltfNode->mesh >= 0) {
+      lovrAssert(gltfNode->mesh < loader->meshCount, "Invalid glTF mesh %d", gltfNode->mesh);
+      GltfMesh* mesh = &loader->meshes[gltfNode->mesh];
+      lovrModelDataAllocateArray(loader->modelData, &node->meshes, mesh->primitiveCount);
+      for (int j = 0; j < mesh->primitiveCount; j++) {
+        node->meshes.data[j] = mesh->firstPrimitive + j;
+      }
+    }
+  }
+}
+
+// Nodes are numbered in depth first order, parents before children
+static void indexNodes(ModelData* modelData, ModelNode* node) {
+  node->index = modelData->nodes.length;
+  vec_push(&modelData->nodes, node);
+  for (int i = 0; i < node->children.length; i++) {
+    indexNodes(modelData, node->children.data[i]);
+  }
+}
+
+// The scene's root nodes become children of a new root node.  Nodes outside of the scene are dropped.
+static void buildScene(GltfLoader* loader, int scenesToken, int sceneIndex) {
+  ModelData* modelData = loader->modelData;
+  ModelNode* root = lovrModelDataAllocate(modelData, sizeof(ModelNode));
+  root->name = lovrModelDataCopyString(modelData, "", 0);
+  root->parent = NULL;
+  mat4_identity(root->transform);
+  vec_init(&root->meshes);
+  vec_init(&root->children);
+  modelData->root = root;
+
+  jsmntok_t* tokens = loader->tokens;
+  int sceneNodes = -1;
+  if (scenesToken >= 0 && sceneIndex < tokens[scenesToken].size) {
+    int t = scenesToken + 1;
+    for (int i = 0; i < sceneIndex; i++) {
+      t = jsonSkip(tokens, t);
+    }
+
+    int keys = tokens[t].size;
+    t++;
+    for (int k = 0; k < keys; k++) {
+      if (jsonEquals(loader, t, "nodes")) {
+        sceneNodes = t + 1;
+      }
+      t = jsonSkip(tokens, t + 1);
+    }
+  }
+
+  if (sceneNodes >= 0) {
+    lovrModelDataAllocateArray(modelData, &root->children, tokens[sceneNodes].size);
+    for (int i = 0; i < tokens[sceneNodes].size; i++) {
+      int n = jsonInt(loader, sceneNodes + 1 + i);
+      lovrAssert(n >= 0 && n < loader->nodeCount && !loader->nodes[n].hasParent, "Invalid glTF scene node %d", n);
+      loader->nodes[n].hasParent = 1;
+      loader->nodes[n].node->parent = root;
+      root->children.data[i] = loader->nodes[n].node;
+    }
+  } else {
+    int count = 0;
+    for (int i = 0; i < loader->nodeCount; i++) {
+      count += !loader->nodes[i].hasParent;
+    }
+
+    lovrModelDataAllocateArray(modelData, &root->children, count);
+    root->children.length = 0;
+    for (int i = 0; i < loader->nodeCount; i++) {
+      if (!loader->nodes[i].hasParent) {
+        loader->nodes[i].node->parent = root;
+        root->children.data[root->children.length++] = loader->nodes[i].node;
+      }
+    }
+  }
+
+  indexNodes(modelData, root);
+
+  for (int i = 0; i < loader->nodeCount; i++) {
+    if (loader->nodes[i].node->index < 0) {
+      loader->nodes[i].node = NULL;
+    }
+  }
+}
+
+static int getNodeIndex(GltfLoader* loader, int node) {
+  lovrAssert(node >= 0 && node < loader->nodeCount, "Invalid glTF node %d", node);
+  return loader->nodes[node].node ? loader->nodes[node].node->index : -1;
+}
+
+static void parseSkins(GltfLoader* loader, int token) {
+  jsmntok_t* tokens = loader->tokens;
+  ModelData* modelData = loader->modelData;
+  int skinCount = tokens[token].size;
+  int* firstBone = malloc(skinCount * sizeof(int));
+  int* boneCount = malloc(skinCount * sizeof(int));
+
+  int t = token + 1;
+  for (int i = 0; i < skinCount; i++) {
+    int joints = -1;
+    int inverseBindMatrices = -1;
+    int keys = tokens[t].size;
+    t++;
+    for (int k = 0; k < keys; k++) {
+      if (jsonEquals(loader, t, "joints")) joints = t + 1;
+      else if (jsonEquals(loader, t, "inverseBindMatrices")) inverseBindMatrices = jsonInt(loader, t + 1);
+      t = jsonSkip(tokens, t + 1);
+    }
+
+    lovrAssert(joints >= 0, "glTF skin %d has no joints", i);
+    GltfAccessor* matrices = inverseBindMatrices >= 0 ? getAccessor(loader, inverseBindMatrices, 16) : NULL;
+    lovrAssert(!matrices || matrices->count >= tokens[joints].size, "glTF skin %d has too few inverse bind matrices", i);
+    firstBone[i] = modelData->bones.length;
+    boneCount[i] = tokens[joints].size;
+
+    for (int j = 0; j < tokens[joints].size; j++) {
+      int node = jsonInt(loader, joints + 1 + j);
+      ModelBone bone;
+      bone.node = getNodeIndex(loader, node);
+      lovrAssert(bone.node >= 0, "glTF joint %d is not part of the scene", node);
+      ModelNode* boneNode = modelData->nodes.data[bone.node];
+      bone.name = lovrModelDataCopyString(modelData, boneNode->name, strlen(boneNode->name));
+      if (matrices) {
+        readFloats(loader, matrices, j, bone.offset);
+      } else {
+        mat4_identity(bone.offset);
+      }
+      vec_push(&modelData->bones, bone);
+    }
+  }
+
+  // Offset joint indices of skinned meshes by the first bone of their skin
+  for (int i = 0; i < loader->nodeCount; i++) {
+    GltfNode* node = &loader->nodes[i];
+    if (node->mesh < 0 || node->skin < 0 || !node->node) {
+      continue;
+    }
+
+    lovrAssert(node->skin < skinCount, "Invalid glTF skin %d", node->skin);
+    GltfMesh* mesh = &loader->meshes[node->mesh];
+    if (mesh->skin >= 0) {
+      continue;
+    }
+
+    mesh->skin = node->skin;
+    for (int p = 0; p < mesh->primitiveCount; p++) {
+      ModelMesh* primitive = modelData->meshes.data[mesh->firstPrimitive + p];
+      for (int v = 0; v < primitive->boneWeights.length; v++) {
+        ModelBoneWeights* boneWeights = &primitive->boneWeights.data[v];
+        for (int j = 0; j < MAX_BONES_PER_VERTEX; j++) {
+          lovrAssert(boneWeights->bones[j] < (unsigned) boneCount[node->skin], "glTF joint index is out of range");
+          boneWeights->bones[j] += firstBone[node->skin];
+        }
+      }
+      modelData->hasBones = modelData->hasBones || primitive->hasBones;
+    }
+  }
+
+  // Meshes that aren't used by a skinned node are rigid
+  for (int i = 0; i < loader->meshCount; i++) {
+    GltfMesh* mesh = &loader->meshes[i];
+    if (mesh->skin < 0) {
+      for (int p = 0; p < mesh->primitiveCount; p++) {
+        ((ModelMesh*) modelData->meshes.data[mesh->firstPrimitive + p])->hasBones = 0;
+      }
+    }
+  }
+
+  free(firstBone);
+  free(boneCount);
+}
+
+static void readKeyframes(GltfLoader* loader, GltfSampler* sampler, int components, vec_model_keyframe_t* keyframes, float* duration) {
+  GltfAccessor* input = getAccessor(loader, sampler->input, 1);
+  GltfAccessor* output = getAccessor(loader, sampler->output, components);
+  int stride = sampler->cubic ? 3 : 1;
+  lovrAssert(output->count >= input->count * stride, "glTF animation sampler has too few outputs");
+
+  vec_clear(keyframes);
+  vec_reserve(keyframes, input->count);
+  for (int i = 0; i < input->count; i++) {
+    ModelKeyframe keyframe = { .data = { 0, 0, 0, 0 } };
+    readFloats(loader, input, i, &keyframe.time);
+
+    // Cubic spline samplers store an in tangent, value, and out tangent, only the value is used
+    readFloats(loader, output, i * stride + (sampler->cubic ? 1 : 0), keyframe.data);
+    *duration = MAX(*duration, keyframe.time);
+    vec_push(keyframes, keyframe);
+  }
+}
+
+static void parseAnimations(GltfLoader* loader, int token) {
+  jsmntok_t* tokens = loader->tokens;
+  ModelData* modelData = loader->modelData;
+
+  int t = token + 1;
+  for (int i = 0; i < tokens[token].size; i++) {
+    ModelAnimation animation;
+    animation.name = NULL;
+    animation.duration = 0;
+    vec_init(&animation.channels);
+
+    int channels = -1;
+    int samplers = -1;
+    int keys = tokens[t].size;
+    t++;
+    for (int k = 0; k < keys; k++) {
+      if (jsonEquals(loader, t, "name")) animation.name = jsonString(loader, t + 1);
+      else if (jsonEquals(loader, t, "channels")) channels = t + 1;
+      else if (jsonEquals(loader, t, "samplers")) samplers = t + 1;
+      t = jsonSkip(tokens, t + 1);
+    }
+
+    if (!animation.name) {
+      char name[32];
+      snprintf(name, sizeof(name), "animation%d", i + 1);
+      animation.name = lovrModelDataCopyString(modelData, name, strlen(name));
+    }
+
+    int samplerCount = samplers >= 0 ? tokens[samplers].size : 0;
+    GltfSampler* gltfSamplers = malloc(MAX(samplerCount, 1) * sizeof(GltfSampler));
+    int s = samplers + 1;
+    for (int j = 0; j < samplerCount; j++) {
+      GltfSampler* sampler = &gltfSamplers[j];
+      sampler->input = sampler->output = -1;
+      sampler->cubic = 0;
+      int samplerKeys = tokens[s].size;
+      s++;
+      for (int k = 0; k < samplerKeys; k++) {
+        if (jsonEquals(loader, s, "input")) sampler->input = jsonInt(loader, s + 1);
+        else if (jsonEquals(loader, s, "output")) sampler->output = jsonInt(loader, s + 1);
+        else if (jsonEquals(loader, s, "interpolation")) sampler->cubic = jsonEquals(loader, s + 1, "CUBICSPLINE");
+        s = jsonSkip(tokens, s + 1);
+      }
+    }
+
+    // glTF channels animate one property of a node, they're merged into one channel per node
+    int c = channels + 1;
+    for (int j = 0; channels >= 0 && j < tokens[channels].size; j++) {
+      int samplerIndex = -1;
+      int node = -1;
+      int path = -1;
+      int channelKeys = tokens[c].size;
+      c++;
+      for (int k = 0; k < channelKeys; k++) {
+        if (jsonEquals(loader, c, "sampler")) samplerIndex = jsonInt(loader, c + 1);
+        else if (jsonEquals(loader, c, "target")) {
+          int target = c + 2;
+          for (int l = 0; l < tokens[c + 1].size; l++) {
+            if (jsonEquals(loader, target, "node")) node = jsonInt(loader, target + 1);
+            else if (jsonEquals(loader, target, "path")) path = target + 1;
+            target = jsonSkip(tokens, target + 1);
+          }
+        }
+        c = jsonSkip(tokens, c + 1);
+      }
+
+      int nodeIndex = node >= 0 ? getNodeIndex(loader, node) : -1;
+      if (nodeIndex < 0 || path < 0) {
+        continue;
+      }
+
+      lovrAssert(samplerIndex >= 0 && samplerIndex < samplerCount, "Invalid glTF animation sampler %d", samplerIndex);
+      GltfSampler* sampler = &gltfSamplers[samplerIndex];
+
+      ModelAnimationChannel* channel = NULL;
+      for (int k = 0; k < animation.channels.length; k++) {
+        if (animation.channels.data[k].node == nodeIndex) {
+          channel = &animation.channels.data[k];
+          break;
+        }
+      }
+
+      if (!channel) {
+        ModelAnimationChannel newChannel;
+        newChannel.node = nodeIndex;
+        vec_init(&newChannel.positions);
+        vec_init(&newChannel.rotations);
+        vec_init(&newChannel.scales);
+        vec_push(&animation.channels, newChannel);
+        channel = &vec_last(&animation.channels);
+      }
+
+      if (jsonEquals(loader, path, "translation")) {
+        readKeyframes(loader, sampler, 3, &channel->positions, &animation.duration);
+      } else if (jsonEquals(loader, path, "rotation")) {
+        readKeyframes(loader, sampler, 4, &channel->rotations, &animation.duration);
+      } else if (jsonEquals(loader, path, "scale")) {
+        readKeyframes(loader, sampler, 3, &channel->scales, &animation.duration);
+      }
+    }
+
+    free(gltfSamplers);
+    vec_push(&modelData->animations, animation);
+  }
+}
+
+int lovrModelDataIsGltf(Blob* blob) {
+  const unsigned char* data = blob->data;
+  size_t i = 0;
+
+  if (blob->size >= 4 && *(uint32_t*) data == GLB_MAGIC) {
+    return 1;
+  }
+
+  // Skip a byte order mark and whitespace to look for the start of a JSON object
+  if (blob->size >= 3 && data[0] == 0xef && data[1] == 0xbb && data[2] == 0xbf) {
+    i = 3;
+  }
+
+  while (i < blob->size && (data[i] == ' ' || data[i] == '\t' || data[i] == '\r' || data[i] == '\n')) {
+    i++;
+  }
+
+  return i < blob->size && data[i] == '{';
+}
+
+ModelData* lovrModelDataCreateGltf(Blob* blob) {
+  ModelData* modelData = malloc(sizeof(ModelData));
+  if (!modelData) return NULL;
+
+  lovrModelDataInit(modelData);
+
+  GltfLoader loader;
+  memset(&loader, 0, sizeof(loader));
+  loader.blob = blob;
+  loader.modelData = modelData;
+
+  // GLB files are a JSON chunk and an optional binary chunk
+  const char* json = blob->data;
+  size_t jsonLength = blob->size;
+  if (blob->size >= 4 && *(uint32_t*) blob->data == GLB_MAGIC) {
+    uint32_t* header = blob->data;
+    lovrAssert(blob->size >= 20 && header[1] == 2, "Only version 2 GLB files are supported");
+    lovrAssert(header[4] == GLB_CHUNK_JSON && header[3] <= blob->size - 20, "Invalid GLB file");
+    json = (char*) blob->data + 20;
+    jsonLength = header[3];
+
+    size_t binaryOffset = 20 + ((jsonLength + 3) & ~((size_t) 3));
+    if (binaryOffset + 8 <= blob->size) {
+      uint32_t* chunk = (uint32_t*) ((char*) blob->data + binaryOffset);
+      lovrAssert(chunk[1] == GLB_CHUNK_BIN && chunk[0] <= blob->size - binaryOffset - 8, "Invalid GLB file");
+      loader.binaryData = (char*) blob->data + binaryOffset + 8;
+      loader.binarySize = chunk[0];
+      lovrRetain(&blob->ref);
+      vec_push(&modelData->blobs, blob);
+    }
+  }
+
+  // Parse JSON
+  jsmn_parser parser;
+  jsmn_init(&parser);
+  int tokenCount = jsmn_parse(&parser, json, jsonLength, NULL, 0);
+  lovrAssert(tokenCount > 0, "Could not parse glTF JSON");
+  jsmntok_t* tokens = malloc(tokenCount * sizeof(jsmntok_t));
+  jsmn_init(&parser);
+  lovrAssert(jsmn_parse(&parser, json, jsonLength, tokens, tokenCount) > 0 && tokens[0].type == JSMN_OBJECT, "Could not parse glTF JSON");
+  loader.json = json;
+  loader.tokens = tokens;
+
+  int buffers = -1, bufferViews = -1, accessors = -1, images = -1, textures = -1, materials = -1;
+  int meshes = -1, nodes = -1, scenes = -1, skins = -1, animations = -1;
+  int scene = 0;
+  int t = 1;
+  for (int k = 0; k < tokens[0].size; k++) {
+    if (jsonEquals(&loader, t, "buffers")) buffers = t + 1;
+    else if (jsonEquals(&loader, t, "bufferViews")) bufferViews = t + 1;
+    else if (jsonEquals(&loader, t, "accessors")) accessors = t + 1;
+    else if (jsonEquals(&loader, t, "images")) images = t + 1;
+    else if (jsonEquals(&loader, t, "textures")) textures = t + 1;
+    else if (jsonEquals(&loader, t, "materials")) materials = t + 1;
+    else if (jsonEquals(&loader, t, "meshes")) meshes = t + 1;
+    else if (jsonEquals(&loader, t, "nodes")) nodes = t + 1;
+    else if (jsonEquals(&loader, t, "scenes")) scenes = t + 1;
+    else if (jsonEquals(&loader, t, "scene")) scene = jsonInt(&loader, t + 1);
+    else if (jsonEquals(&loader, t, "skins")) skins = t + 1;
+    else if (jsonEquals(&loader, t, "animations")) animations = t + 1;
+    else if (jsonEquals(&loader, t, "asset")) {
+      int a = t + 2;
+      for (int j = 0; j < tokens[t + 1].size; j++) {
+        if (jsonEquals(&loader, a, "version")) {
+          lovrAssert(loader.json[tokens[a + 1].start] == '2', "Only glTF 2.0 models are supported");
+        }
+        a = jsonSkip(tokens, a + 1);
+      }
+    }
+    t = jsonSkip(tokens, t + 1);
+  }
+
+  if (buffers >= 0) parseBuffers(&loader, buffers);
+  if (bufferViews >= 0) parseBufferViews(&loader, bufferViews);
+  if (accessors >= 0) parseAccessors(&loader, accessors);
+  if (images >= 0) parseImages(&loader, images);
+  if (textures >= 0) parseTextures(&loader, textures);
+  if (materials >= 0) parseMaterials(&loader, materials);
+  if (meshes >= 0) parseMeshes(&loader, meshes);
+  if (nodes >= 0) parseNodes(&loader, nodes);
+  buildScene(&loader, scenes, scene);
+  if (skins >= 0) parseSkins(&loader, skins);
+  if (animations >= 0) parseAnimations(&loader, animations);
+
+  // Skinning data is only kept for meshes attached to a skin
+  if (skins < 0) {
+    ModelMesh* mesh; int i;
+    vec_foreach(&modelData->meshes, mesh, i) {
+      mesh->hasBones = 0;
+    }
+  }
+
+  // Primitives without a material use a white one
+  int defaultMaterial = -1;
+  for (int i = 0; i < modelData->meshes.length; i++) {
+    ModelMesh* mesh = modelData->meshes.data[i];
+    lovrAssert(mesh->material < modelData->materials.length, "Invalid glTF material %d", mesh->material);
+    if (mesh->material < 0) {
+      defaultMaterial = defaultMaterial >= 0 ? defaultMaterial : lovrModelDataAddMaterial(modelData, NULL);
+      mesh->material = defaultMaterial;
+    }
+  }
+
+  // Every mesh needs texture coordinates if any of them have them
+  if (modelData->hasTexCoords) {
+    ModelMesh* mesh; int i;
+    vec_foreach(&modelData->meshes, mesh, i) {
+      if (mesh->texCoords.length == 0 && mesh->vertices.length > 0) {
+        mesh->texCoords.data = lovrModelDataAllocate(modelData, mesh->vertices.length * sizeof(ModelVertex));
+        mesh->texCoords.length = mesh->texCoords.capacity = mesh->vertices.length;
+        memset(mesh->texCoords.data, 0, mesh->vertices.length * sizeof(ModelVertex));
+      }
+    }
+  }
+
+  lovrModelDataGenerateLods(modelData);
+
+  free(loader.buffers);
+  free(loader.views);
+  free(loader.accessors);
+  free(loader.meshes);
+  free(loader.nodes);
+  free(loader.images);
+  free(loader.textures);
+  free(tokens);
+  return modelData;
+}
@@ -1,14 +1,754 @@
 #include "loaders/model.h"
+#include "filesystem/filesystem.h"
 #include "math/mat4.h"
 #include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <float.h>
+#include <math.h>
 #include <assimp/cimport.h>
 #include <assimp/scene.h>
 #include <assimp/mesh.h>
 #include <assimp/matrix4x4.h>
 #include <assimp/vector3.h>
 #include <assimp/postprocess.h>
+#include <assimp/anim.h>
+#include <assimp/material.h>
+#include <assimp/texture.h>
 
-static void assimpNodeTraversal(ModelNode* node, struct aiNode* assimpNode) {
+static char* copyString(ModelData* modelData, const char* string) {
+  return lovrModelDataCopyString(modelData, string, strlen(string));
+}
+
+static void readKeyframe(ModelKeyframe* keyframe, double time, double ticksPerSecond, float x, float y, float z, float w) {
+  keyframe->time = time / ticksPerSecond;
+  keyframe->data[0] = x;
+  keyframe->data[1] = y;
+  keyframe->data[2] = z;
+  keyframe->data[3] = w;
+}
+
+// Mesh optimization
+//
+// Imported meshes are reordered for the GPU before they're cached: triangles are sorted for the
+// post-transform vertex cache (Forsyth's linear-speed algorithm), then grouped into clusters at the
+// points where the cache starts over and the clusters are sorted so outward facing ones draw first
+// to cut overdraw, and finally vertices are renumbered in the order they're first used so vertex
+// fetches walk memory linearly.
+
+#define VERTEX_CACHE_SIZE 32
+#define OVERDRAW_CACHE_SIZE 16
+#define OVERDRAW_MIN_CLUSTER 64
+
+static float vertexScore(int cachePosition, int remaining) {
+  if (remaining == 0) {
+    return -1.f;
+  }
+
+  float score = 0.f;
+  if (cachePosition >= 3) {
+    score = powf(1.f - (cachePosition - 3) / (float) (VERTEX_CACHE_SIZE - 3), 1.5f);
+  } else if (cachePosition >= 0) {
+    score = .75f;
+  }
+
+  return score + 2.f / sqrtf(remaining);
+}
+
+static void optimizeVertexCache(unsigned int* indices, int faceCount, int vertexCount) {
+  int indexCount = 3 * faceCount;
+  int* offsets = calloc(vertexCount + 1, sizeof(int));
+  int* remaining = calloc(vertexCount, sizeof(int));
+  int* adjacency = malloc(indexCount * sizeof(int));
+  int* cachePosition = malloc(vertexCount * sizeof(int));
+  float* vertexScores = malloc(vertexCount * sizeof(float));
+  char* emitted = calloc(faceCount, sizeof(char));
+  unsigned int* result = malloc(indexCount * sizeof(unsigned int));
+
+  if (!offsets || !remaining || !adjacency || !cachePosition || !vertexScores || !emitted || !result) {
+    goto done;
+  }
+
+  // Each vertex gets a list of the faces that use it
+  for (int i = 0; i < indexCount; i++) {
+    offsets[indices[i] + 1]++;
+  }
+
+  for (int i = 0; i < vertexCount; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+
+  for (int i = 0; i < indexCount; i++) {
+    unsigned int v = indices[i];
+    adjacency[offsets[v] + remaining[v]++] = i / 3;
+  }
+
+  for (int i = 0; i < vertexCount; i++) {
+    cachePosition[i] = -1;
+    vertexScores[i] = vertexScore(-1, remaining[i]);
+  }
+
+  int best = -1;
+  float bestScore = -1.f;
+  for (int i = 0; i < faceCount; i++) {
+    unsigned int* face = &indices[3 * i];
+    float score = vertexScores[face[0]] + vertexScores[face[1]] + vertexScores[face[2]];
+    if (score > bestScore) {
+      best = i;
+      bestScore = score;
+    }
+  }
+
+  int cache[VERTEX_CACHE_SIZE + 3];
+  int cacheCount = 0;
+  int cursor = 0;
+
+  for (int f = 0; f < faceCount; f++) {
+
+    // When nothing in the cache has faces left, restart at the next face that hasn't been emitted
+    if (best < 0) {
+      while (emitted[cursor]) cursor++;
+      best = cursor;
+    }
+
+    unsigned int* face = &indices[3 * best];
+    memcpy(&result[3 * f], face, 3 * sizeof(unsigned int));
+    emitted[best] = 1;
+
+    for (int i = 0; i < 3; i++) {
+      unsigned int v = face[i];
+      int* faces = &adjacency[offsets[v]];
+      for (int j = 0; j < remaining[v]; j++) {
+        if (faces[j] == best) {
+          faces[j] = faces[--remaining[v]];
+          break;
+        }
+      }
+    }
+
+    // The face's vertices move to the front of the cache, the ones pushed past the end fall out
+    int newCache[VERTEX_CACHE_SIZE + 3];
+    int newCount = 0;
+    for (int i = 0; i < 3; i++) {
+      if (i == 0 || (face[i] != face[0] && (i == 1 || face[i] != face[1]))) {
+        newCache[newCount++] = face[i];
+      }
+    }
+
+    for (int i = 0; i < cacheCount; i++) {
+      int v = cache[i];
+      if (v != (int) face[0] && v != (int) face[1] && v != (int) face[2]) {
+        newCache[newCount++] = v;
+      }
+    }
+
+    for (int i = 0; i < newCount; i++) {
+      int v = newCache[i];
+      cachePosition[v] = i < VERTEX_CACHE_SIZE ? i : -1;
+      vertexScores[v] = vertexScore(cachePosition[v], remaining[v]);
+    }
+
+    // The next face is the best one using a vertex that's still in the cache
+    best = -1;
+    bestScore = -1.f;
+    for (int i = 0; i < newCount; i++) {
+      int v = newCache[i];
+      int* faces = &adjacency[offsets[v]];
+      for (int j = 0; j < remaining[v]; j++) {
+        unsigned int* other = &indices[3 * faces[j]];
+        float score = vertexScores[other[0]] + vertexScores[other[1]] + vertexScores[other[2]];
+        if (i < VERTEX_CACHE_SIZE && score > bestScore) {
+          best = faces[j];
+          bestScore = score;
+        }
+      }
+    }
+
+    cacheCount = MIN(newCount, VERTEX_CACHE_SIZE);
+    memcpy(cache, newCache, cacheCount * sizeof(int));
+  }
+
+  memcpy(indices, result, indexCount * sizeof(unsigned int));
+
+done:
+  free(offsets);
+  free(remaining);
+  free(adjacency);
+  free(cachePosition);
+  free(vertexScores);
+  free(emitted);
+  free(result);
+}
+
+typedef struct {
+  int start;
+  int count;
+  float sortKey;
+} FaceCluster;
+
+static int compareClusters(const void* a, const void* b) {
+  const FaceCluster* x = a;
+  const FaceCluster* y = b;
+  if (x->sortKey != y->sortKey) {
+    return x->sortKey > y->sortKey ? -1 : 1;
+  }
+  return x->start - y->start;
+}
+
+static void optimizeOverdraw(unsigned int* indices, int faceCount, int vertexCount, ModelVertex* vertices) {
+  int* timestamps = malloc(vertexCount * sizeof(int));
+  FaceCluster* clusters = malloc(faceCount * sizeof(FaceCluster));
+  float* clusterData = calloc(faceCount, 6 * sizeof(float));
+  unsigned int* result = malloc(3 * faceCount * sizeof(unsigned int));
+  int clusterCount = 0;
+
+  if (!timestamps || !clusters || !clusterData || !result) {
+    goto done;
+  }
+
+  // Simulate a FIFO cache, starting a new cluster where a face misses on all of its vertices
+  int time = OVERDRAW_CACHE_SIZE + 1;
+  for (int i = 0; i < vertexCount; i++) {
+    timestamps[i] = 0;
+  }
+
+  for (int f = 0; f < faceCount; f++) {
+    int misses = 0;
+    for (int i = 0; i < 3; i++) {
+      unsigned int v = indices[3 * f + i];
+      if (time - timestamps[v] > OVERDRAW_CACHE_SIZE) {
+        timestamps[v] = time++;
+        misses++;
+      }
+    }
+
+    if (clusterCount == 0 || (misses == 3 && clusters[clusterCount - 1].count >= OVERDRAW_MIN_CLUSTER)) {
+      clusters[clusterCount++] = (FaceCluster) { .start = f, .count = 0 };
+    }
+
+    clusters[clusterCount - 1].count++;
+  }
+
+  if (clusterCount <= 1) {
+    goto done;
+  }
+
+  // Clusters are sorted by how far they face away from the center of the mesh, using area weighted
+  // centroids and normals
+  float center[3] = { 0.f, 0.f, 0.f };
+  float totalArea = 0.f;
+  for (int c = 0; c < clusterCount; c++) {
+    float* data = &clusterData[6 * c];
+    float area = 0.f;
+    for (int f = clusters[c].start; f < clusters[c].start + clusters[c].count; f++) {
+      ModelVertex* a = &vertices[indices[3 * f + 0]];
+      ModelVertex* b = &vertices[indices[3 * f + 1]];
+      ModelVertex* d = &vertices[indices[3 * f + 2]];
+      float u[3] = { b->x - a->x, b->y - a->y, b->z - a->z };
+      float v[3] = { d->x - a->x, d->y - a->y, d->z - a->z };
+      float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+      float w = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      data[0] += (a->x + b->x + d->x) * w / 3.f;
+      data[1] += (a->y + b->y + d->y) * w / 3.f;
+      data[2] += (a->z + b->z + d->z) * w / 3.f;
+      data[3] += n[0];
+      data[4] += n[1];
+      data[5] += n[2];
+      area += w;
+    }
+
+    center[0] += data[0];
+    center[1] += data[1];
+    center[2] += data[2];
+    totalArea += area;
+
+    if (area > 0.f) {
+      data[0] /= area;
+      data[1] /= area;
+      data[2] /= area;
+    }
+  }
+
+  if (totalArea > 0.f) {
+    center[0] /= totalArea;
+    center[1] /= totalArea;
+    center[2] /= totalArea;
+  }
+
+  for (int c = 0; c < clusterCount; c++) {
+    float* data = &clusterData[6 * c];
+    float length = sqrtf(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+    float dot = (data[0] - center[0]) * data[3] + (data[1] - center[1]) * data[4] + (data[2] - center[2]) * data[5];
+    clusters[c].sortKey = length > 0.f ? dot / length : 0.f;
+  }
+
+  qsort(clusters, clusterCount, sizeof(FaceCluster), compareClusters);
+
+  unsigned int* cursor = result;
+  for (int c = 0; c < clusterCount; c++) {
+    size_t size = 3 * clusters[c].count * sizeof(unsigned int);
+    memcpy(cursor, &indices[3 * clusters[c].start], size);
+    cursor += 3 * clusters[c].count;
+  }
+
+  memcpy(indices, result, 3 * faceCount * sizeof(unsigned int));
+
+done:
+  free(timestamps);
+  free(clusters);
+  free(clusterData);
+  free(result);
+}
+
+// Moves element i of an array to remap[i]
+static void permute(void* data, size_t stride, int count, int* remap, char* scratch) {
+  for (int i = 0; i < count; i++) {
+    memcpy(scratch + remap[i] * stride, (char*) data + i * stride, stride);
+  }
+
+  memcpy(data, scratch, count * stride);
+}
+
+static void optimizeVertexFetch(ModelMesh* mesh) {
+  int vertexCount = mesh->vertices.length;
+  int indexCount = 3 * mesh->faces.length;
+  unsigned int* indices = (unsigned int*) mesh->faces.data;
+  int* remap = malloc(vertexCount * sizeof(int));
+  char* scratch = malloc(vertexCount * sizeof(ModelBoneWeights));
+
+  if (!remap || !scratch) {
+    free(remap);
+    free(scratch);
+    return;
+  }
+
+  // Unreferenced vertices are kept, at the end
+  int next = 0;
+  memset(remap, 0xff, vertexCount * sizeof(int));
+  for (int i = 0; i < indexCount; i++) {
+    if (remap[indices[i]] < 0) {
+      remap[indices[i]] = next++;
+    }
+  }
+
+  for (int i = 0; i < vertexCount; i++) {
+    if (remap[i] < 0) {
+      remap[i] = next++;
+    }
+  }
+
+  for (int i = 0; i < indexCount; i++) {
+    indices[i] = remap[indices[i]];
+  }
+
+  permute(mesh->vertices.data, sizeof(ModelVertex), vertexCount, remap, scratch);
+
+  if (mesh->normals.length == vertexCount) {
+    permute(mesh->normals.data, sizeof(ModelVertex), vertexCount, remap, scratch);
+  }
+
+  if (mesh->texCoords.length == vertexCount) {
+    permute(mesh->texCoords.data, sizeof(ModelVertex), vertexCount, remap, scratch);
+  }
+
+  if (mesh->boneWeights.length == vertexCount) {
+    permute(mesh->boneWeights.data, sizeof(ModelBoneWeights), vertexCount, remap, scratch);
+  }
+
+  free(remap);
+  free(scratch);
+}
+
+// Mesh simplification
+//
+// Coarser levels of detail are built with quadric error edge collapses (Garland and Heckbert).  A
+// vertex always collapses onto one of its neighbors instead of a new position, so every level
+// indexes the same vertices.  Vertices on borders and attribute seams (vertices sharing a position)
+// are locked, which keeps silhouettes and texture layouts from tearing.  Each level targets a
+// quarter of the faces of the previous one and is built from it, stopping early once collapses no
+// longer make a meaningful dent.
+
+#define LOD_REDUCTION 4
+#define LOD_MIN_FACES 256
+
+typedef struct {
+  float cost;
+  unsigned int from;
+  unsigned int to;
+} EdgeCollapse;
+
+static int compareCollapses(const void* a, const void* b) {
+  const EdgeCollapse* x = a;
+  const EdgeCollapse* y = b;
+  return (x->cost > y->cost) - (x->cost < y->cost);
+}
+
+// Quadrics are symmetric 4x4 matrices, stored as a2, b2, c2, d2, ab, ac, ad, bc, bd, cd
+static float quadricError(float* q, ModelVertex* p) {
+  float x = p->x, y = p->y, z = p->z;
+  float error =
+    q[0] * x * x + q[1] * y * y + q[2] * z * z + q[3] +
+    2.f * (q[4] * x * y + q[5] * x * z + q[6] * x + q[7] * y * z + q[8] * y + q[9] * z);
+  return fabsf(error);
+}
+
+static uint32_t hashPosition(ModelVertex* v) {
+  uint32_t bits[3];
+  memcpy(bits, v, sizeof(bits));
+  return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+}
+
+static uint32_t nextPowerOfTwo(uint32_t x) {
+  uint32_t result = 1;
+  while (result < x) result <<= 1;
+  return result;
+}
+
+// Locks vertices on seams and borders, and sums the area weighted plane quadrics of each vertex
+static int prepareSimplification(ModelMesh* mesh, char* locked, float* quadrics) {
+  int vertexCount = mesh->vertices.length;
+  int faceCount = mesh->faces.length;
+  unsigned int* indices = (unsigned int*) mesh->faces.data;
+  ModelVertex* vertices = mesh->vertices.data;
+  uint32_t vertexTableSize = nextPowerOfTwo(2 * vertexCount);
+  uint32_t edgeTableSize = nextPowerOfTwo(6 * faceCount);
+  unsigned int* positions = malloc(vertexCount * sizeof(unsigned int));
+  int* vertexTable = malloc(vertexTableSize * sizeof(int));
+  uint64_t* edgeKeys = malloc(edgeTableSize * sizeof(uint64_t));
+  int* edgeCounts = calloc(edgeTableSize, sizeof(int));
+  int success = positions && vertexTable && edgeKeys && edgeCounts;
+
+  if (!success) {
+    goto done;
+  }
+
+  // Vertices with the same position are welded to the first of them, and locked
+  memset(locked, 0, vertexCount);
+  memset(vertexTable, 0xff, vertexTableSize * sizeof(int));
+  for (int i = 0; i < vertexCount; i++) {
+    uint32_t slot = hashPosition(&vertices[i]) & (vertexTableSize - 1);
+    while (vertexTable[slot] >= 0 && memcmp(&vertices[vertexTable[slot]], &vertices[i], sizeof(ModelVertex))) {
+      slot = (slot + 1) & (vertexTableSize - 1);
+    }
+
+    if (vertexTable[slot] < 0) {
+      vertexTable[slot] = i;
+      positions[i] = i;
+    } else {
+      positions[i] = vertexTable[slot];
+      locked[positions[i]] = 1;
+    }
+  }
+
+  // Edges used by anything other than two faces are borders (or non-manifold)
+  memset(edgeKeys, 0xff, edgeTableSize * sizeof(uint64_t));
+  for (int i = 0; i < 3 * faceCount; i++) {
+    unsigned int a = positions[indices[i]];
+    unsigned int b = positions[indices[i % 3 == 2 ? i - 2 : i + 1]];
+    uint64_t key = a < b ? ((uint64_t) a << 32 | b) : ((uint64_t) b << 32 | a);
+    uint32_t slot = (uint32_t) ((key * 0x9e3779b97f4a7c15ull) >> 32) & (edgeTableSize - 1);
+    while (edgeKeys[slot] != UINT64_MAX && edgeKeys[slot] != key) {
+      slot = (slot + 1) & (edgeTableSize - 1);
+    }
+    edgeKeys[slot] = key;
+    edgeCounts[slot]++;
+  }
+
+  for (uint32_t i = 0; i < edgeTableSize; i++) {
+    if (edgeKeys[i] != UINT64_MAX && edgeCounts[i] != 2) {
+      locked[edgeKeys[i] >> 32] = 1;
+      locked[edgeKeys[i] & 0xffffffff] = 1;
+    }
+  }
+
+  for (int i = 0; i < vertexCount; i++) {
+    locked[i] = locked[positions[i]];
+  }
+
+  memset(quadrics, 0, 10 * vertexCount * sizeof(float));
+  for (int f = 0; f < faceCount; f++) {
+    ModelVertex* a = &vertices[indices[3 * f + 0]];
+    ModelVertex* b = &vertices[indices[3 * f + 1]];
+    ModelVertex* c = &vertices[indices[3 * f + 2]];
+    float u[3] = { b->x - a->x, b->y - a->y, b->z - a->z };
+    float v[3] = { c->x - a->x, c->y - a->y, c->z - a->z };
+    float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+    float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length == 0.f) {
+      continue;
+    }
+
+    n[0] /= length;
+    n[1] /= length;
+    n[2] /= length;
+    float d = -(n[0] * a->x + n[1] * a->y + n[2] * a->z);
+    float w = length * .5f;
+    float plane[10] = {
+      n[0] * n[0] * w, n[1] * n[1] * w, n[2] * n[2] * w, d * d * w,
+      n[0] * n[1] * w, n[0] * n[2] * w, n[0] * d * w, n[1] * n[2] * w, n[1] * d * w, n[2] * d * w
+    };
+
+    for (int i = 0; i < 3; i++) {
+      float* q = quadrics + 10 * indices[3 * f + i];
+      for (int j = 0; j < 10; j++) {
+        q[j] += plane[j];
+      }
+    }
+  }
+
+done:
+  free(positions);
+  free(vertexTable);
+  free(edgeKeys);
+  free(edgeCounts);
+  return success;
+}
+
+// Returns whether collapsing a vertex would flip any of the faces around it, or turn one by more
+// than about 75 degrees
+static int collapseFlips(unsigned int* indices, int* faces, int faceCount, unsigned int from, unsigned int to, ModelVertex* vertices) {
+  ModelVertex* p = &vertices[from];
+  ModelVertex* q = &vertices[to];
+  for (int i = 0; i < faceCount; i++) {
+    unsigned int* face = &indices[3 * faces[i]];
+    int k = face[0] == from ? 0 : (face[1] == from ? 1 : 2);
+    unsigned int b = face[(k + 1) % 3];
+    unsigned int c = face[(k + 2) % 3];
+    if (b == to || c == to) {
+      continue;
+    }
+
+    ModelVertex* vb = &vertices[b];
+    ModelVertex* vc = &vertices[c];
+    float u0[3] = { vb->x - p->x, vb->y - p->y, vb->z - p->z };
+    float v0[3] = { vc->x - p->x, vc->y - p->y, vc->z - p->z };
+    float u1[3] = { vb->x - q->x, vb->y - q->y, vb->z - q->z };
+    float v1[3] = { vc->x - q->x, vc->y - q->y, vc->z - q->z };
+    float n0[3] = { u0[1] * v0[2] - u0[2] * v0[1], u0[2] * v0[0] - u0[0] * v0[2], u0[0] * v0[1] - u0[1] * v0[0] };
+    float n1[3] = { u1[1] * v1[2] - u1[2] * v1[1], u1[2] * v1[0] - u1[0] * v1[2], u1[0] * v1[1] - u1[1] * v1[0] };
+    float dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+    float lengths = (n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]) * (n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]);
+    if (dot <= 0.f || dot * dot < .0625f * lengths) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// Collapses edges in passes, cheapest first, until the faces are down to the target count or nothing
+// else can collapse.  A vertex is only involved in one collapse per pass, which keeps the flip test
+// of every collapse valid.  Returns the new face count.
+static int simplifyFaces(unsigned int* indices, int faceCount, int targetCount, ModelMesh* mesh, char* locked, float* quadrics) {
+  int vertexCount = mesh->vertices.length;
+  ModelVertex* vertices = mesh->vertices.data;
+  int* offsets = malloc((vertexCount + 1) * sizeof(int));
+  int* adjacency = malloc(3 * faceCount * sizeof(int));
+  unsigned int* remap = malloc(vertexCount * sizeof(unsigned int));
+  char* touched = malloc(vertexCount);
+  EdgeCollapse* collapses = malloc(vertexCount * sizeof(EdgeCollapse));
+
+  if (!offsets || !adjacency || !remap || !touched || !collapses) {
+    goto done;
+  }
+
+  while (faceCount > targetCount) {
+    memset(offsets, 0, (vertexCount + 1) * sizeof(int));
+    for (int i = 0; i < 3 * faceCount; i++) {
+      offsets[indices[i] + 1]++;
+    }
+
+    for (int i = 0; i < vertexCount; i++) {
+      offsets[i + 1] += offsets[i];
+    }
+
+    for (int i = 0; i < 3 * faceCount; i++) {
+      adjacency[offsets[indices[i]]++] = i / 3;
+    }
+
+    for (int i = vertexCount; i > 0; i--) {
+      offsets[i] = offsets[i - 1];
+    }
+    offsets[0] = 0;
+
+    // Every unlocked vertex is a candidate for its cheapest collapse
+    for (int i = 0; i < vertexCount; i++) {
+      collapses[i] = (EdgeCollapse) { FLT_MAX, i, i };
+    }
+
+    for (int i = 0; i < 3 * faceCount; i++) {
+      unsigned int a = indices[i];
+      unsigned int b = indices[i % 3 == 2 ? i - 2 : i + 1];
+      float cost;
+      if (!locked[a] && (cost = quadricError(quadrics + 10 * a, &vertices[b])) < collapses[a].cost) {
+        collapses[a].cost = cost;
+        collapses[a].to = b;
+      }
+      if (!locked[b] && (cost = quadricError(quadrics + 10 * b, &vertices[a])) < collapses[b].cost) {
+        collapses[b].cost = cost;
+        collapses[b].to = a;
+      }
+    }
+
+    int collapseCount = 0;
+    for (int i = 0; i < vertexCount; i++) {
+      if (collapses[i].from != collapses[i].to) {
+        collapses[collapseCount++] = collapses[i];
+      }
+    }
+
+    qsort(collapses, collapseCount, sizeof(EdgeCollapse), compareCollapses);
+
+    // Each collapse removes about two faces
+    int budget = MAX((faceCount - targetCount) / 2, 1);
+    int collapsed = 0;
+    memset(touched, 0, vertexCount);
+    for (int i = 0; i < vertexCount; i++) {
+      remap[i] = i;
+    }
+
+    for (int i = 0; i < collapseCount && collapsed < budget; i++) {
+      unsigned int from = collapses[i].from;
+      unsigned int to = collapses[i].to;
+      int* faces = &adjacency[offsets[from]];
+      int count = offsets[from + 1] - offsets[from];
+      if (touched[from] || touched[to] || collapseFlips(indices, faces, count, from, to, vertices)) {
+        continue;
+      }
+
+      for (int j = 0; j < count; j++) {
+        unsigned int* face = &indices[3 * faces[j]];
+        touched[face[0]] = touched[face[1]] = touched[face[2]] = 1;
+      }
+
+      for (int j = 0; j < 10; j++) {
+        quadrics[10 * to + j] += quadrics[10 * from + j];
+      }
+
+      remap[from] = to;
+      collapsed++;
+    }
+
+    if (collapsed == 0) {
+      break;
+    }
+
+    int newCount = 0;
+    for (int f = 0; f < faceCount; f++) {
+      unsigned int a = remap[indices[3 * f + 0]];
+      unsigned int b = remap[indices[3 * f + 1]];
+      unsigned int c = remap[indices[3 * f + 2]];
+      if (a != b && b != c && c != a) {
+        indices[3 * newCount + 0] = a;
+        indices[3 * newCount + 1] = b;
+        indices[3 * newCount + 2] = c;
+        newCount++;
+      }
+    }
+
+    faceCount = newCount;
+  }
+
+done:
+  free(offsets);
+  free(adjacency);
+  free(remap);
+  free(touched);
+  free(collapses);
+  return faceCount;
+}
+
+static void generateLods(ModelMesh* mesh) {
+  int vertexCount = mesh->vertices.length;
+  int faceCount = mesh->faces.length;
+  if (faceCount < LOD_MIN_FACES) {
+    return;
+  }
+
+  char* locked = malloc(vertexCount);
+  float* quadrics = malloc(10 * vertexCount * sizeof(float));
+  unsigned int* indices = malloc(3 * faceCount * sizeof(unsigned int));
+
+  if (locked && quadrics && indices && prepareSimplification(mesh, locked, quadrics)) {
+    memcpy(indices, mesh->faces.data, 3 * faceCount * sizeof(unsigned int));
+    while (mesh->lodCount < MAX_LODS - 1 && faceCount >= LOD_MIN_FACES / LOD_REDUCTION) {
+      int count = simplifyFaces(indices, faceCount, faceCount / LOD_REDUCTION, mesh, locked, quadrics);
+      if (count == 0 || count > faceCount * 3 / 4) {
+        break;
+      }
+
+      optimizeVertexCache(indices, count, vertexCount);
+      ModelLod* lod = &mesh->lods[mesh->lodCount++];
+      lod->start = mesh->lodFaces.length;
+      lod->count = count;
+      vec_pusharr(&mesh->lodFaces, (ModelFace*) indices, count);
+      faceCount = count;
+    }
+  }
+
+  free(locked);
+  free(quadrics);
+  free(indices);
+}
+
+static void optimizeMesh(ModelMesh* mesh) {
+  if (mesh->faces.length == 0 || mesh->vertices.length == 0) {
+    return;
+  }
+
+  unsigned int* indices = (unsigned int*) mesh->faces.data;
+  optimizeVertexCache(indices, mesh->faces.length, mesh->vertices.length);
+  optimizeOverdraw(indices, mesh->faces.length, mesh->vertices.length, mesh->vertices.data);
+  optimizeVertexFetch(mesh);
+  generateLods(mesh);
+}
+
+static void generateMeshLods(void* userdata, int start, int end) {
+  ModelData* modelData = userdata;
+  for (int i = start; i < end; i++) {
+    generateLods(modelData->meshes.data[i]);
+  }
+}
+
+// For meshes that use the arrays of their source file in place, like glTF buffers, only the levels
+// of detail are built.  The arrays aren't reordered, they can be shared by several meshes or belong
+// to the Blob the model was loaded from.
+void lovrModelDataGenerateLods(ModelData* modelData) {
+  lovrParallelFor(modelData->meshes.length, 1, generateMeshLods, modelData);
+}
+
+// Assimp import
+//
+// The scene is measured first, so the arena can be reserved in a single block.  Positions, normals,
+// texture coordinates, faces, and bone weights of all meshes are each contiguous.  Bones are shared
+// between meshes, so they're collected up front, and then meshes are converted and optimized in
+// parallel, each one writing to its own slice of the arrays.
+
+#define ARENA_SIZE(size) (((size) + 15) & ~((size_t) 15))
+
+typedef struct {
+  const struct aiScene* scene;
+  ModelData* modelData;
+  int* boneIndices;
+  int* boneOffsets;
+} AssimpConversion;
+
+static void assimpMeasureNodes(struct aiNode* assimpNode, int* nodeCount, size_t* size) {
+  (*nodeCount)++;
+  *size += ARENA_SIZE(strlen(assimpNode->mName.data) + 1);
+  *size += ARENA_SIZE(assimpNode->mNumMeshes * sizeof(unsigned int));
+  *size += ARENA_SIZE(assimpNode->mNumChildren * sizeof(ModelNode*));
+  for (unsigned int n = 0; n < assimpNode->mNumChildren; n++) {
+    assimpMeasureNodes(assimpNode->mChildren[n], nodeCount, size);
+  }
+}
+
+static void assimpNodeTraversal(ModelData* modelData, ModelNode* nodes, ModelNode* parent, struct aiNode* assimpNode) {
+  ModelNode* node = &nodes[modelData->nodes.length];
+  node->name = copyString(modelData, assimpNode->mName.data);
+  node->index = modelData->nodes.length;
+  node->parent = parent;
+  vec_push(&modelData->nodes, node);
 
   // Transform
   struct aiMatrix4x4 m = assimpNode->mTransformation;
@@ -16,120 +756,1056 @@ static void assimpNodeTraversal(ModelNode* node, struct aiNode* assimpNode) {
   mat4_set(node->transform, (float*) &m);
 
   // Meshes
-  vec_init(&node->meshes);
-  vec_pusharr(&node->meshes, assimpNode->mMeshes, assimpNode->mNumMeshes);
+  lovrModelDataAllocateArray(modelData, &node->meshes, assimpNode->mNumMeshes);
+  for (unsigned int m = 0; m < assimpNode->mNumMeshes; m++) {
+    node->meshes.data[m] = assimpNode->mMeshes[m];
+  }
 
   // Children
-  vec_init(&node->children);
+  lovrModelDataAllocateArray(modelData, &node->children, assimpNode->mNumChildren);
   for (unsigned int n = 0; n < assimpNode->mNumChildren; n++) {
-    ModelNode* child = malloc(sizeof(ModelNode));
-    assimpNodeTraversal(child, assimpNode->mChildren[n]);
-    vec_push(&node->children, child);
+    node->children.data[n] = &nodes[modelData->nodes.length];
+    assimpNodeTraversal(modelData, nodes, node, assimpNode->mChildren[n]);
   }
 }
 
-ModelData* lovrModelDataCreate(Blob* blob) {
+static void assimpConvertMeshes(void* userdata, int start, int end) {
+  AssimpConversion* conversion = userdata;
+  for (int m = start; m < end; m++) {
+    struct aiMesh* assimpMesh = conversion->scene->mMeshes[m];
+    ModelMesh* mesh = conversion->modelData->meshes.data[m];
+    unsigned int vertexCount = assimpMesh->mNumVertices;
+
+    // Faces, skipping lines and points.  Polygons are triangulated.
+    for (unsigned int f = 0; f < assimpMesh->mNumFaces; f++) {
+      struct aiFace assimpFace = assimpMesh->mFaces[f];
+      if (assimpFace.mNumIndices == 3) {
+        memcpy(mesh->faces.data[mesh->faces.length++].indices, assimpFace.mIndices, 3 * sizeof(unsigned int));
+      }
+    }
+
+    // Vertices
+    mesh->aabb[0] = mesh->aabb[2] = mesh->aabb[4] = vertexCount > 0 ? FLT_MAX : 0;
+    mesh->aabb[1] = mesh->aabb[3] = mesh->aabb[5] = vertexCount > 0 ? -FLT_MAX : 0;
+    for (unsigned int v = 0; v < vertexCount; v++) {
+      ModelVertex* vertex = &mesh->vertices.data[v];
+      vertex->x = assimpMesh->mVertices[v].x;
+      vertex->y = assimpMesh->mVertices[v].y;
+      vertex->z = assimpMesh->mVertices[v].z;
+      mesh->aabb[0] = MIN(mesh->aabb[0], vertex->x);
+      mesh->aabb[1] = MAX(mesh->aabb[1], vertex->x);
+      mesh->aabb[2] = MIN(mesh->aabb[2], vertex->y);
+      mesh->aabb[3] = MAX(mesh->aabb[3], vertex->y);
+      mesh->aabb[4] = MIN(mesh->aabb[4], vertex->z);
+      mesh->aabb[5] = MAX(mesh->aabb[5], vertex->z);
+    }
+
+    // Normals
+    for (unsigned int n = 0; n < vertexCount; n++) {
+      ModelVertex* normal = &mesh->normals.data[n];
+      normal->x = assimpMesh->mNormals[n].x;
+      normal->y = assimpMesh->mNormals[n].y;
+      normal->z = assimpMesh->mNormals[n].z;
+    }
+
+    // Meshes without texture coordinates get zeroed ones if any other mesh has them
+    if (mesh->texCoords.length > 0 && assimpMesh->mTextureCoords[0]) {
+      for (unsigned int i = 0; i < vertexCount; i++) {
+        ModelVertex* texCoord = &mesh->texCoords.data[i];
+        texCoord->x = assimpMesh->mTextureCoords[0][i].x;
+        texCoord->y = assimpMesh->mTextureCoords[0][i].y;
+        texCoord->z = 0.f;
+      }
+    } else if (mesh->texCoords.length > 0) {
+      memset(mesh->texCoords.data, 0, vertexCount * sizeof(ModelVertex));
+    }
+
+    // Vertices keep their most influential weights
+    if (mesh->hasBones) {
+      memset(mesh->boneWeights.data, 0, vertexCount * sizeof(ModelBoneWeights));
+    }
+
+    for (unsigned int b = 0; b < assimpMesh->mNumBones; b++) {
+      struct aiBone* assimpBone = assimpMesh->mBones[b];
+      int boneIndex = conversion->boneIndices[conversion->boneOffsets[m] + b];
+      for (unsigned int w = 0; w < assimpBone->mNumWeights; w++) {
+        struct aiVertexWeight weight = assimpBone->mWeights[w];
+        ModelBoneWeights* boneWeights = &mesh->boneWeights.data[weight.mVertexId];
+        int slot = 0;
+        for (int i = 1; i < MAX_BONES_PER_VERTEX; i++) {
+          if (boneWeights->weights[i] < boneWeights->weights[slot]) {
+            slot = i;
+          }
+        }
+
+        if (weight.mWeight > boneWeights->weights[slot]) {
+          boneWeights->bones[slot] = boneIndex;
+          boneWeights->weights[slot] = weight.mWeight;
+        }
+      }
+    }
+
+    optimizeMesh(mesh);
+  }
+}
+
+// Embedded textures are named by their index, like *0.  Only the ones stored as encoded image files
+// are supported, raw texels are skipped.
+static int assimpImportTexture(ModelData* modelData, const struct aiScene* scene, struct aiMaterial* assimpMaterial, enum aiTextureType type, const char* source) {
+  struct aiString path;
+  if (aiGetMaterialTexture(assimpMaterial, type, 0, &path, NULL, NULL, NULL, NULL, NULL, NULL) != aiReturn_SUCCESS) {
+    return -1;
+  }
+
+  if (path.data[0] == '*') {
+    unsigned long index = strtoul(path.data + 1, NULL, 10);
+    if (index >= scene->mNumTextures || scene->mTextures[index]->mHeight != 0) {
+      return -1;
+    }
+
+    struct aiTexture* texture = scene->mTextures[index];
+    return lovrModelDataAddImage(modelData, NULL, NULL, texture->pcData, texture->mWidth);
+  }
+
+  return lovrModelDataAddImage(modelData, source, path.data, NULL, 0);
+}
+
+static ModelData* assimpImport(Blob* blob, unsigned int flags) {
   ModelData* modelData = malloc(sizeof(ModelData));
   if (!modelData) return NULL;
 
-  modelData->hasNormals = 0;
-  modelData->hasTexCoords = 0;
+  lovrModelDataInit(modelData);
 
-  unsigned int flags = aiProcessPreset_TargetRealtime_MaxQuality | aiProcess_OptimizeGraph | aiProcess_FlipUVs;
   const struct aiScene* scene = aiImportFileFromMemory(blob->data, blob->size, flags, NULL);
+  lovrAssert(scene, "Unable to load model: %s", aiGetErrorString());
 
-  // Meshes
-  vec_init(&modelData->meshes);
+  // Measure
+  size_t vertexCount = 0;
+  size_t faceCount = 0;
+  size_t skinnedVertexCount = 0;
+  int boneReferenceCount = 0;
+  for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+    struct aiMesh* assimpMesh = scene->mMeshes[m];
+    lovrAssert(assimpMesh->mNormals, "Model must have normals");
+    vertexCount += assimpMesh->mNumVertices;
+    faceCount += assimpMesh->mNumFaces;
+    skinnedVertexCount += assimpMesh->mNumBones > 0 ? assimpMesh->mNumVertices : 0;
+    boneReferenceCount += assimpMesh->mNumBones;
+    modelData->hasTexCoords = modelData->hasTexCoords || assimpMesh->mTextureCoords[0] != NULL;
+    modelData->hasBones = modelData->hasBones || assimpMesh->mNumBones > 0;
+  }
+
+  int nodeCount = 0;
+  size_t size = 0;
+  assimpMeasureNodes(scene->mRootNode, &nodeCount, &size);
+  size += ARENA_SIZE(scene->mNumMeshes * sizeof(ModelMesh));
+  size += ARENA_SIZE(nodeCount * sizeof(ModelNode));
+  size += ARENA_SIZE(faceCount * sizeof(ModelFace));
+  size += ARENA_SIZE(vertexCount * sizeof(ModelVertex)) * (modelData->hasTexCoords ? 3 : 2);
+  size += ARENA_SIZE(skinnedVertexCount * sizeof(ModelBoneWeights));
+  lovrModelDataReserve(modelData, size);
+
+  ModelMesh* meshes = lovrModelDataAllocate(modelData, scene->mNumMeshes * sizeof(ModelMesh));
+  ModelFace* faces = lovrModelDataAllocate(modelData, faceCount * sizeof(ModelFace));
+  ModelVertex* vertices = lovrModelDataAllocate(modelData, vertexCount * sizeof(ModelVertex));
+  ModelVertex* normals = lovrModelDataAllocate(modelData, vertexCount * sizeof(ModelVertex));
+  ModelVertex* texCoords = modelData->hasTexCoords ? lovrModelDataAllocate(modelData, vertexCount * sizeof(ModelVertex)) : NULL;
+  ModelBoneWeights* boneWeights = lovrModelDataAllocate(modelData, skinnedVertexCount * sizeof(ModelBoneWeights));
+
+  // Meshes are given their slices of the arrays
+  vec_reserve(&modelData->meshes, scene->mNumMeshes);
   for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
     struct aiMesh* assimpMesh = scene->mMeshes[m];
-    ModelMesh* mesh = malloc(sizeof(ModelMesh));
+    unsigned int count = assimpMesh->mNumVertices;
+    ModelMesh* mesh = &meshes[m];
+    mesh->faces = (vec_model_face_t) { .data = faces, .length = 0, .capacity = assimpMesh->mNumFaces };
+    mesh->vertices = (vec_model_vertex_t) { .data = vertices, .length = count, .capacity = count };
+    mesh->normals = (vec_model_vertex_t) { .data = normals, .length = count, .capacity = count };
+    mesh->texCoords = (vec_model_vertex_t) { .data = texCoords, .length = texCoords ? count : 0, .capacity = texCoords ? count : 0 };
+    mesh->hasBones = assimpMesh->mNumBones > 0;
+    mesh->boneWeights = (vec_model_bone_weights_t) { .data = boneWeights, .length = mesh->hasBones ? count : 0, .capacity = mesh->hasBones ? count : 0 };
+    vec_init(&mesh->lodFaces);
+    mesh->lodCount = 0;
     vec_push(&modelData->meshes, mesh);
 
-    // Faces
-    vec_init(&mesh->faces);
-    for (unsigned int f = 0; f < assimpMesh->mNumFaces; f++) {
-      struct aiFace assimpFace = assimpMesh->mFaces[f];
+    faces += assimpMesh->mNumFaces;
+    vertices += count;
+    normals += count;
+    texCoords += texCoords ? count : 0;
+    boneWeights += mesh->hasBones ? count : 0;
+  }
+
+  modelData->hasNormals = 1;
+
+  // Bones, shared by name between meshes
+  int* boneIndices = malloc(MAX(boneReferenceCount, 1) * sizeof(int));
+  int* boneOffsets = malloc(MAX(scene->mNumMeshes, 1) * sizeof(int));
+  lovrAssert(boneIndices && boneOffsets, "Out of memory");
+  for (unsigned int m = 0, reference = 0; m < scene->mNumMeshes; m++) {
+    struct aiMesh* assimpMesh = scene->mMeshes[m];
+    boneOffsets[m] = reference;
+    for (unsigned int b = 0; b < assimpMesh->mNumBones; b++) {
+      struct aiBone* assimpBone = assimpMesh->mBones[b];
+
+      int boneIndex = -1;
+      for (int i = 0; i < modelData->bones.length; i++) {
+        if (!strcmp(modelData->bones.data[i].name, assimpBone->mName.data)) {
+          boneIndex = i;
+          break;
+        }
+      }
+
+      if (boneIndex == -1) {
+        ModelBone bone;
+        bone.name = copyString(modelData, assimpBone->mName.data);
+        bone.node = -1;
+        struct aiMatrix4x4 m = assimpBone->mOffsetMatrix;
+        aiTransposeMatrix4(&m);
+        mat4_set(bone.offset, (float*) &m);
+        boneIndex = modelData->bones.length;
+        vec_push(&modelData->bones, bone);
+      }
+
+      boneIndices[reference++] = boneIndex;
+    }
+  }
+
+  // Materials.  Assimp usually adds a default one, but every mesh needs one, so it's added if needed.
+  for (unsigned int i = 0; i < scene->mNumMaterials; i++) {
+    struct aiMaterial* assimpMaterial = scene->mMaterials[i];
+    struct aiString name;
+    int hasName = aiGetMaterialString(assimpMaterial, AI_MATKEY_NAME, &name) == aiReturn_SUCCESS;
+    int index = lovrModelDataAddMaterial(modelData, hasName ? name.data : NULL);
+    ModelMaterial* material = &modelData->materials.data[index];
+
+    struct aiColor4D color;
+    if (aiGetMaterialColor(assimpMaterial, AI_MATKEY_COLOR_DIFFUSE, &color) == aiReturn_SUCCESS) {
+      float diffuse[4] = { color.r, color.g, color.b, color.a };
+      memcpy(material->diffuseColor, diffuse, sizeof(diffuse));
+    }
 
-      // Skip lines and points, polygons are triangulated
-      if (assimpFace.mNumIndices != 3) {
+    if (aiGetMaterialColor(assimpMaterial, AI_MATKEY_COLOR_EMISSIVE, &color) == aiReturn_SUCCESS) {
+      float emissive[4] = { color.r, color.g, color.b, 1.f };
+      memcpy(material->emissiveColor, emissive, sizeof(emissive));
+    }
+
+    material->diffuseTexture = assimpImportTexture(modelData, scene, assimpMaterial, aiTextureType_DIFFUSE, blob->name);
+    material->emissiveTexture = assimpImportTexture(modelData, scene, assimpMaterial, aiTextureType_EMISSIVE, blob->name);
+  }
+
+  if (modelData->materials.length == 0) {
+    lovrModelDataAddMaterial(modelData, NULL);
+  }
+
+  for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+    unsigned int material = scene->mMeshes[m]->mMaterialIndex;
+    modelData->meshes.data[m]->material = material < (unsigned int) modelData->materials.length ? (int) material : 0;
+  }
+
+  AssimpConversion conversion = { scene, modelData, boneIndices, boneOffsets };
+  lovrParallelFor(scene->mNumMeshes, 1, assimpConvertMeshes, &conversion);
+  free(boneIndices);
+  free(boneOffsets);
+
+  // Nodes
+  ModelNode* nodes = lovrModelDataAllocate(modelData, nodeCount * sizeof(ModelNode));
+  vec_reserve(&modelData->nodes, nodeCount);
+  assimpNodeTraversal(modelData, nodes, NULL, scene->mRootNode);
+  modelData->root = nodes;
+
+  for (int i = 0; i < modelData->bones.length; i++) {
+    ModelBone* bone = &modelData->bones.data[i];
+    bone->node = lovrModelDataFindNode(modelData, bone->name);
+    lovrAssert(bone->node >= 0, "Model bone '%s' has no node", bone->name);
+  }
+
+  // Animations
+  for (unsigned int a = 0; a < scene->mNumAnimations; a++) {
+    struct aiAnimation* assimpAnimation = scene->mAnimations[a];
+    double ticksPerSecond = assimpAnimation->mTicksPerSecond > 0 ? assimpAnimation->mTicksPerSecond : 25.;
+
+    ModelAnimation animation;
+    animation.name = copyString(modelData, assimpAnimation->mName.data);
+    animation.duration = assimpAnimation->mDuration / ticksPerSecond;
+    vec_init(&animation.channels);
+
+    for (unsigned int c = 0; c < assimpAnimation->mNumChannels; c++) {
+      struct aiNodeAnim* assimpChannel = assimpAnimation->mChannels[c];
+      ModelAnimationChannel channel;
+      channel.node = lovrModelDataFindNode(modelData, assimpChannel->mNodeName.data);
+      if (channel.node < 0) {
         continue;
       }
 
-      ModelFace face;
-      for (unsigned int i = 0; i < assimpFace.mNumIndices; i++) {
-        face.indices[i] = assimpFace.mIndices[i];
+      vec_init(&channel.positions);
+      vec_init(&channel.rotations);
+      vec_init(&channel.scales);
+      vec_reserve(&channel.positions, assimpChannel->mNumPositionKeys);
+      vec_reserve(&channel.rotations, assimpChannel->mNumRotationKeys);
+      vec_reserve(&channel.scales, assimpChannel->mNumScalingKeys);
+
+      for (unsigned int k = 0; k < assimpChannel->mNumPositionKeys; k++) {
+        struct aiVectorKey key = assimpChannel->mPositionKeys[k];
+        ModelKeyframe keyframe;
+        readKeyframe(&keyframe, key.mTime, ticksPerSecond, key.mValue.x, key.mValue.y, key.mValue.z, 0.f);
+        vec_push(&channel.positions, keyframe);
+      }
+
+      for (unsigned int k = 0; k < assimpChannel->mNumRotationKeys; k++) {
+        struct aiQuatKey key = assimpChannel->mRotationKeys[k];
+        ModelKeyframe keyframe;
+        readKeyframe(&keyframe, key.mTime, ticksPerSecond, key.mValue.x, key.mValue.y, key.mValue.z, key.mValue.w);
+        vec_push(&channel.rotations, keyframe);
+      }
+
+      for (unsigned int k = 0; k < assimpChannel->mNumScalingKeys; k++) {
+        struct aiVectorKey key = assimpChannel->mScalingKeys[k];
+        ModelKeyframe keyframe;
+        readKeyframe(&keyframe, key.mTime, ticksPerSecond, key.mValue.x, key.mValue.y, key.mValue.z, 0.f);
+        vec_push(&channel.scales, keyframe);
       }
-      vec_push(&mesh->faces, face);
+
+      vec_push(&animation.channels, channel);
     }
 
-    // Vertices
-    vec_init(&mesh->vertices);
-    for (unsigned int v = 0; v < assimpMesh->mNumVertices; v++) {
-      ModelVertex vertex;
-      vertex.x = assimpMesh->mVertices[v].x;
-      vertex.y = assimpMesh->mVertices[v].y;
-      vertex.z = assimpMesh->mVertices[v].z;
-      vec_push(&mesh->vertices, vertex);
+    vec_push(&modelData->animations, animation);
+  }
+
+  aiReleaseImport(scene);
+  return modelData;
+}
+
+// Model cache
+//
+// Imported models are written to the save directory in a flat binary format that is mapped back in
+// on later loads.  Everything is 4 byte aligned, so mesh arrays are used directly from the mapping.
+// Files are named after the cache version, a hash of the source and the import flags, and are only
+// used if the header matches exactly.  Images stored as files are read again when the cache is
+// loaded, embedded ones are stored in the cache.  Files from other versions are removed, and the
+// oldest files are removed when the cache grows past its size limit.
+
+#define MODEL_CACHE_MAGIC 0x4c444d4c // LMDL
+#define MODEL_CACHE_VERSION 7
+#define MODEL_CACHE_MAX_SIZE (256 * 1024 * 1024)
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t flags;
+  uint32_t hasNormals;
+  uint64_t hash;
+  uint64_t size;
+  uint32_t meshCount;
+  uint32_t nodeCount;
+  uint32_t boneCount;
+  uint32_t animationCount;
+  uint32_t hasTexCoords;
+  uint32_t hasBones;
+  uint32_t materialCount;
+  uint32_t imageCount;
+} ModelCacheHeader;
+
+typedef struct {
+  char* data;
+  size_t size;
+  size_t capacity;
+} ModelCacheWriter;
+
+typedef struct {
+  char* data;
+  size_t size;
+  size_t offset;
+  int error;
+} ModelCacheReader;
+
+typedef struct {
+  char path[LOVR_PATH_MAX];
+  long modified;
+  int size;
+  int stale;
+} ModelCacheFile;
+
+typedef vec_t(ModelCacheFile) vec_modelcachefile_t;
+
+// FNV-1a over 8 byte words, folding the high bits down since the multiply only carries upward
+static uint64_t hashWords(uint64_t hash, const uint8_t* bytes, size_t size) {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, bytes + i, sizeof(word));
+    hash = (hash ^ word) * 0x100000001b3;
+    hash ^= hash >> 29;
+  }
+
+  for (; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3;
+  }
+
+  return hash;
+}
+
+// The source is identified by its size, its modification time if it's a file, and a digest of all
+// of its contents, which is cheap next to an import
+static uint64_t hashSource(Blob* blob) {
+  long modified = blob->name ? lovrFilesystemGetLastModified(blob->name) : -1;
+  uint64_t key[2] = { blob->size, (uint64_t) modified };
+  uint64_t hash = hashWords(0xcbf29ce484222325, (uint8_t*) key, sizeof(key));
+  return hashWords(hash, blob->data, blob->size);
+}
+
+static void listCacheFile(void* userdata, const char* dir, const char* file) {
+  vec_modelcachefile_t* files = userdata;
+  ModelCacheFile entry;
+  char prefix[16];
+  snprintf(prefix, sizeof(prefix), "v%d-", MODEL_CACHE_VERSION);
+  snprintf(entry.path, LOVR_PATH_MAX, "%s/%s", dir, file);
+  entry.modified = lovrFilesystemGetLastModified(entry.path);
+  entry.size = lovrFilesystemGetSize(entry.path);
+  entry.stale = strncmp(file, prefix, strlen(prefix)) != 0;
+  vec_push(files, entry);
+}
+
+static int compareCacheFiles(const void* a, const void* b) {
+  long x = ((const ModelCacheFile*) a)->modified;
+  long y = ((const ModelCacheFile*) b)->modified;
+  return (x > y) - (x < y);
+}
+
+// Makes room for a new file of the given size
+static void trimCache(size_t reserve) {
+  vec_modelcachefile_t files;
+  vec_init(&files);
+  lovrFilesystemGetDirectoryItems("cache/models", listCacheFile, &files);
+
+  size_t total = reserve;
+  for (int i = 0; i < files.length; i++) {
+    ModelCacheFile* file = &files.data[i];
+    if (file->stale || file->size < 0) {
+      lovrFilesystemRemove(file->path);
+      vec_splice(&files, i--, 1);
+    } else {
+      total += file->size;
     }
+  }
 
-    // Normals
-    lovrAssert(assimpMesh->mNormals, "Model must have normals");
+  vec_sort(&files, compareCacheFiles);
+  for (int i = 0; i < files.length && total > MODEL_CACHE_MAX_SIZE; i++) {
+    if (!lovrFilesystemRemove(files.data[i].path)) {
+      total -= files.data[i].size;
+    }
+  }
+
+  vec_deinit(&files);
+}
+
+static void cacheWrite(ModelCacheWriter* writer, const void* data, size_t size) {
+  size_t padded = (size + 3) & ~((size_t) 3);
+  if (writer->size + padded > writer->capacity) {
+    while (writer->size + padded > writer->capacity) {
+      writer->capacity = writer->capacity ? writer->capacity * 2 : 4096;
+    }
+    writer->data = realloc(writer->data, writer->capacity);
+  }
+
+  if (size > 0) {
+    memcpy(writer->data + writer->size, data, size);
+  }
+  memset(writer->data + writer->size + size, 0, padded - size);
+  writer->size += padded;
+}
+
+static void cacheWriteInt(ModelCacheWriter* writer, uint32_t value) {
+  cacheWrite(writer, &value, sizeof(uint32_t));
+}
+
+static void cacheWriteString(ModelCacheWriter* writer, const char* string) {
+  uint32_t length = strlen(string) + 1;
+  cacheWriteInt(writer, length);
+  cacheWrite(writer, string, length);
+}
+
+// Returns a pointer to an array in the cache, or NULL and sets the error flag if it doesn't fit
+static void* cacheRead(ModelCacheReader* reader, size_t count, size_t stride) {
+  if (reader->error || (stride > 0 && count > (reader->size - reader->offset) / stride)) {
+    reader->error = 1;
+    return NULL;
+  }
+
+  size_t size = count * stride;
+  size_t padded = (size + 3) & ~((size_t) 3);
+  void* data = reader->data + reader->offset;
+  reader->offset = MIN(reader->offset + padded, reader->size);
+  return data;
+}
+
+static uint32_t cacheReadInt(ModelCacheReader* reader) {
+  uint32_t* value = cacheRead(reader, 1, sizeof(uint32_t));
+  return value ? *value : 0;
+}
+
+// Strings are used straight from the mapping
+static char* cacheReadString(ModelCacheReader* reader) {
+  uint32_t length = cacheReadInt(reader);
+  char* string = cacheRead(reader, length, 1);
+  if (!string || length == 0 || string[length - 1] != '\0') {
+    reader->error = 1;
+    return NULL;
+  }
+  return string;
+}
+
+#define cacheReadArray(reader, v, count) \
+  ((v)->data = cacheRead(reader, count, sizeof(*(v)->data)), \
+   (v)->length = (v)->capacity = (v)->data ? (count) : 0)
+
+#define cacheCopyArray(reader, v, count) \
+  do { \
+    int n = (count); \
+    void* data = cacheRead(reader, n, sizeof(*(v)->data)); \
+    if (data && n > 0) { \
+      vec_reserve(v, n); \
+      memcpy((v)->data, data, n * sizeof(*(v)->data)); \
+      (v)->length = n; \
+    } \
+  } while (0)
+
+static void lovrModelDataWriteCache(ModelData* modelData, const char* path, uint64_t hash, uint32_t flags) {
+  ModelCacheWriter writer = { NULL, 0, 0 };
+  ModelCacheHeader header = {
+    .magic = MODEL_CACHE_MAGIC,
+    .version = MODEL_CACHE_VERSION,
+    .flags = flags,
+    .hasNormals = modelData->hasNormals,
+    .hash = hash,
+    .size = 0,
+    .meshCount = modelData->meshes.length,
+    .nodeCount = modelData->nodes.length,
+    .boneCount = modelData->bones.length,
+    .animationCount = modelData->animations.length,
+    .hasTexCoords = modelData->hasTexCoords,
+    .hasBones = modelData->hasBones,
+    .materialCount = modelData->materials.length,
+    .imageCount = modelData->images.length
+  };
+
+  cacheWrite(&writer, &header, sizeof(header));
+
+  ModelMesh* mesh; int i;
+  vec_foreach(&modelData->meshes, mesh, i) {
+    cacheWriteInt(&writer, mesh->vertices.length);
+    cacheWriteInt(&writer, mesh->faces.length);
+    cacheWriteInt(&writer, mesh->lodFaces.length);
+    cacheWriteInt(&writer, mesh->lodCount);
+    cacheWriteInt(&writer, mesh->hasBones);
+    cacheWriteInt(&writer, mesh->material);
+    cacheWrite(&writer, mesh->aabb, sizeof(mesh->aabb));
+    cacheWrite(&writer, mesh->lods, mesh->lodCount * sizeof(ModelLod));
+    cacheWrite(&writer, mesh->faces.data, mesh->faces.length * sizeof(ModelFace));
+    cacheWrite(&writer, mesh->lodFaces.data, mesh->lodFaces.length * sizeof(ModelFace));
+    cacheWrite(&writer, mesh->vertices.data, mesh->vertices.length * sizeof(ModelVertex));
+    if (modelData->hasNormals) {
+      cacheWrite(&writer, mesh->normals.data, mesh->vertices.length * sizeof(ModelVertex));
+    }
+    if (modelData->hasTexCoords) {
+      cacheWrite(&writer, mesh->texCoords.data, mesh->vertices.length * sizeof(ModelVertex));
+    }
+    if (mesh->hasBones) {
+      cacheWrite(&writer, mesh->boneWeights.data, mesh->vertices.length * sizeof(ModelBoneWeights));
+    }
+  }
+
+  // Nodes are stored in order, so parents come before their children
+  ModelNode* node;
+  vec_foreach(&modelData->nodes, node, i) {
+    cacheWriteInt(&writer, node->parent ? (uint32_t) node->parent->index : UINT32_MAX);
+    cacheWrite(&writer, node->transform, sizeof(node->transform));
+    cacheWriteInt(&writer, node->meshes.length);
+    cacheWrite(&writer, node->meshes.data, node->meshes.length * sizeof(unsigned int));
+    cacheWriteInt(&writer, node->children.length);
+    cacheWriteString(&writer, node->name);
+  }
+
+  ModelBone* bone;
+  vec_foreach_ptr(&modelData->bones, bone, i) {
+    cacheWriteInt(&writer, bone->node);
+    cacheWrite(&writer, bone->offset, sizeof(bone->offset));
+    cacheWriteString(&writer, bone->name);
+  }
+
+  ModelAnimation* animation;
+  vec_foreach_ptr(&modelData->animations, animation, i) {
+    cacheWrite(&writer, &animation->duration, sizeof(float));
+    cacheWriteInt(&writer, animation->channels.length);
+    cacheWriteString(&writer, animation->name);
+
+    ModelAnimationChannel* channel; int j;
+    vec_foreach_ptr(&animation->channels, channel, j) {
+      cacheWriteInt(&writer, channel->node);
+      cacheWriteInt(&writer, channel->positions.length);
+      cacheWriteInt(&writer, channel->rotations.length);
+      cacheWriteInt(&writer, channel->scales.length);
+      cacheWrite(&writer, channel->positions.data, channel->positions.length * sizeof(ModelKeyframe));
+      cacheWrite(&writer, channel->rotations.data, channel->rotations.length * sizeof(ModelKeyframe));
+      cacheWrite(&writer, channel->scales.data, channel->scales.length * sizeof(ModelKeyframe));
+    }
+  }
+
+  ModelMaterial* material;
+  vec_foreach_ptr(&modelData->materials, material, i) {
+    cacheWrite(&writer, material->diffuseColor, sizeof(material->diffuseColor));
+    cacheWrite(&writer, material->emissiveColor, sizeof(material->emissiveColor));
+    cacheWriteInt(&writer, material->diffuseTexture);
+    cacheWriteInt(&writer, material->emissiveTexture);
+    cacheWriteString(&writer, material->name);
+  }
+
+  ModelImage* image;
+  vec_foreach_ptr(&modelData->images, image, i) {
+    cacheWriteInt(&writer, image->path != NULL);
+    if (image->path) {
+      cacheWriteString(&writer, image->path);
+    } else {
+      cacheWriteInt(&writer, image->blob->size);
+      cacheWrite(&writer, image->blob->data, image->blob->size);
+    }
+  }
+
+  ((ModelCacheHeader*) writer.data)->size = writer.size;
+
+  // Failing to write the cache isn't an error, the model will just be imported again next time
+  lovrFilesystemCreateDirectory("cache/models");
+  trimCache(writer.size);
+  lovrFilesystemWrite(path, writer.data, writer.size, 0);
+  free(writer.data);
+}
+
+static ModelData* lovrModelDataReadCache(const char* path, const char* source, uint64_t hash, uint32_t flags) {
+  size_t size;
+  void* mapping = lovrFilesystemMap(path, &size);
+  if (!mapping) {
+    return NULL;
+  }
+
+  ModelCacheHeader* header = mapping;
+  if (size < sizeof(ModelCacheHeader) ||
+      header->magic != MODEL_CACHE_MAGIC ||
+      header->version != MODEL_CACHE_VERSION ||
+      header->flags != flags ||
+      header->hash != hash ||
+      header->size != size ||
+      header->nodeCount == 0) {
+    lovrFilesystemUnmap(mapping, size);
+    return NULL;
+  }
+
+  ModelData* modelData = malloc(sizeof(ModelData));
+  if (!modelData) {
+    lovrFilesystemUnmap(mapping, size);
+    return NULL;
+  }
 
-    modelData->hasNormals = 1;
+  lovrModelDataInit(modelData);
+  modelData->hasNormals = header->hasNormals;
+  modelData->hasTexCoords = header->hasTexCoords;
+  modelData->hasBones = header->hasBones;
+  modelData->mapping = mapping;
+  modelData->mappingSize = size;
+
+  ModelCacheReader reader = { mapping, size, sizeof(ModelCacheHeader), 0 };
+
+  // Each mesh and node takes up more than 4 bytes of the file, which bounds the counts before the
+  // arena is reserved for them
+  if (header->meshCount > size / 4 || header->nodeCount > size / 4) {
+    reader.error = 1;
+  } else {
+    size_t meshSize = (header->meshCount * sizeof(ModelMesh) + 15) & ~((size_t) 15);
+    size_t nodeSize = header->nodeCount * (sizeof(ModelNode) + 16 + sizeof(ModelNode*));
+    lovrModelDataReserve(modelData, meshSize + nodeSize);
+  }
+
+  // Meshes point into the mapping
+  ModelMesh* meshes = reader.error ? NULL : lovrModelDataAllocate(modelData, header->meshCount * sizeof(ModelMesh));
+  vec_reserve(&modelData->meshes, reader.error ? 0 : header->meshCount);
+  for (uint32_t m = 0; m < header->meshCount && !reader.error; m++) {
+    ModelMesh* mesh = &meshes[m];
+    vec_init(&mesh->faces);
+    vec_init(&mesh->vertices);
     vec_init(&mesh->normals);
-    for (unsigned int n = 0; n < assimpMesh->mNumVertices; n++) {
-      ModelVertex normal;
-      normal.x = assimpMesh->mNormals[n].x;
-      normal.y = assimpMesh->mNormals[n].y;
-      normal.z = assimpMesh->mNormals[n].z;
-      vec_push(&mesh->normals, normal);
+    vec_init(&mesh->texCoords);
+    vec_init(&mesh->boneWeights);
+    vec_init(&mesh->lodFaces);
+    mesh->lodCount = 0;
+    vec_push(&modelData->meshes, mesh);
+
+    uint32_t vertexCount = cacheReadInt(&reader);
+    uint32_t faceCount = cacheReadInt(&reader);
+    uint32_t lodFaceCount = cacheReadInt(&reader);
+    uint32_t lodCount = cacheReadInt(&reader);
+    mesh->hasBones = cacheReadInt(&reader);
+    mesh->material = cacheReadInt(&reader);
+    if (mesh->material < 0 || (uint32_t) mesh->material >= header->materialCount) {
+      reader.error = 1;
     }
 
-    modelData->hasTexCoords = modelData->hasTexCoords || assimpMesh->mTextureCoords[0] != NULL;
-    if (assimpMesh->mTextureCoords[0]) {
-      vec_init(&mesh->texCoords);
-      for (unsigned int i = 0; i < assimpMesh->mNumVertices; i++) {
-        ModelVertex texCoord;
-        texCoord.x = assimpMesh->mTextureCoords[0][i].x;
-        texCoord.y = assimpMesh->mTextureCoords[0][i].y;
-        vec_push(&mesh->texCoords, texCoord);
+    float* aabb = cacheRead(&reader, 6, sizeof(float));
+    if (aabb) {
+      memcpy(mesh->aabb, aabb, sizeof(mesh->aabb));
+    }
+
+    ModelLod* lods = cacheRead(&reader, lodCount, sizeof(ModelLod));
+    if (lodCount >= MAX_LODS) {
+      reader.error = 1;
+    } else if (lods) {
+      for (uint32_t i = 0; i < lodCount; i++) {
+        if (lods[i].start < 0 || lods[i].count < 0 || (uint32_t) (lods[i].start + lods[i].count) > lodFaceCount) {
+          reader.error = 1;
+        }
       }
+      memcpy(mesh->lods, lods, lodCount * sizeof(ModelLod));
+      mesh->lodCount = lodCount;
+    }
+
+    cacheReadArray(&reader, &mesh->faces, faceCount);
+    cacheReadArray(&reader, &mesh->lodFaces, lodFaceCount);
+    cacheReadArray(&reader, &mesh->vertices, vertexCount);
+    if (modelData->hasNormals) {
+      cacheReadArray(&reader, &mesh->normals, vertexCount);
+    }
+    if (modelData->hasTexCoords) {
+      cacheReadArray(&reader, &mesh->texCoords, vertexCount);
+    }
+    if (mesh->hasBones) {
+      cacheReadArray(&reader, &mesh->boneWeights, vertexCount);
     }
   }
 
-  // Nodes
-  modelData->root = malloc(sizeof(ModelNode));
-  assimpNodeTraversal(modelData->root, scene->mRootNode);
+  // Nodes are stored in order, so parents have already been read and have room for their children
+  ModelNode* nodes = reader.error ? NULL : lovrModelDataAllocate(modelData, header->nodeCount * sizeof(ModelNode));
+  vec_reserve(&modelData->nodes, reader.error ? 0 : header->nodeCount);
+  for (uint32_t n = 0; n < header->nodeCount && !reader.error; n++) {
+    uint32_t parent = cacheReadInt(&reader);
+    if ((n == 0) != (parent == UINT32_MAX) || (n > 0 && parent >= n)) {
+      reader.error = 1;
+      break;
+    }
+
+    ModelNode* node = &nodes[n];
+    node->name = NULL;
+    node->index = n;
+    node->parent = n > 0 ? modelData->nodes.data[parent] : NULL;
+    vec_init(&node->meshes);
+    vec_init(&node->children);
+    vec_push(&modelData->nodes, node);
+    if (!node->parent) {
+      modelData->root = node;
+    } else if (node->parent->children.length < node->parent->children.capacity) {
+      node->parent->children.data[node->parent->children.length++] = node;
+    } else {
+      reader.error = 1;
+      break;
+    }
+
+    float* transform = cacheRead(&reader, 16, sizeof(float));
+    if (transform) {
+      mat4_set(node->transform, transform);
+    }
+
+    uint32_t meshCount = cacheReadInt(&reader);
+    cacheReadArray(&reader, &node->meshes, meshCount);
+    uint32_t childCount = cacheReadInt(&reader);
+    if (childCount >= header->nodeCount) {
+      reader.error = 1;
+      break;
+    }
+    lovrModelDataAllocateArray(modelData, &node->children, childCount);
+    node->children.length = 0;
+    node->name = cacheReadString(&reader);
+
+    for (int i = 0; i < node->meshes.length; i++) {
+      if (node->meshes.data[i] >= header->meshCount) {
+        reader.error = 1;
+      }
+    }
+  }
+
+  for (uint32_t b = 0; b < header->boneCount && !reader.error; b++) {
+    ModelBone bone;
+    bone.node = cacheReadInt(&reader);
+    float* offset = cacheRead(&reader, 16, sizeof(float));
+    if (offset) {
+      mat4_set(bone.offset, offset);
+    }
+    bone.name = cacheReadString(&reader);
+    if (reader.error || bone.node < 0 || bone.node >= modelData->nodes.length) {
+      reader.error = 1;
+      break;
+    }
+    vec_push(&modelData->bones, bone);
+  }
+
+  for (uint32_t a = 0; a < header->animationCount && !reader.error; a++) {
+    ModelAnimation animation;
+    float* duration = cacheRead(&reader, 1, sizeof(float));
+    animation.duration = duration ? *duration : 0;
+    uint32_t channelCount = cacheReadInt(&reader);
+    animation.name = cacheReadString(&reader);
+    vec_init(&animation.channels);
+    vec_push(&modelData->animations, animation);
+    ModelAnimation* target = &vec_last(&modelData->animations);
+
+    for (uint32_t c = 0; c < channelCount && !reader.error; c++) {
+      ModelAnimationChannel channel;
+      channel.node = cacheReadInt(&reader);
+      uint32_t positionCount = cacheReadInt(&reader);
+      uint32_t rotationCount = cacheReadInt(&reader);
+      uint32_t scaleCount = cacheReadInt(&reader);
+      vec_init(&channel.positions);
+      vec_init(&channel.rotations);
+      vec_init(&channel.scales);
+      cacheCopyArray(&reader, &channel.positions, positionCount);
+      cacheCopyArray(&reader, &channel.rotations, rotationCount);
+      cacheCopyArray(&reader, &channel.scales, scaleCount);
+      vec_push(&target->channels, channel);
+      if (channel.node < 0 || channel.node >= modelData->nodes.length) {
+        reader.error = 1;
+      }
+    }
+  }
+
+  for (uint32_t i = 0; i < header->materialCount && !reader.error; i++) {
+    float* colors = cacheRead(&reader, 8, sizeof(float));
+    int diffuseTexture = cacheReadInt(&reader);
+    int emissiveTexture = cacheReadInt(&reader);
+    char* name = cacheReadString(&reader);
+    if (reader.error || diffuseTexture < -1 || diffuseTexture >= (int) header->imageCount || emissiveTexture < -1 || emissiveTexture >= (int) header->imageCount) {
+      reader.error = 1;
+      break;
+    }
+
+    ModelMaterial* material = &modelData->materials.data[lovrModelDataAddMaterial(modelData, name)];
+    memcpy(material->diffuseColor, colors, 4 * sizeof(float));
+    memcpy(material->emissiveColor, colors + 4, 4 * sizeof(float));
+    material->diffuseTexture = diffuseTexture;
+    material->emissiveTexture = emissiveTexture;
+  }
+
+  // Images are added in order, and paths were unique when the cache was written, so indices match
+  for (uint32_t i = 0; i < header->imageCount && !reader.error; i++) {
+    if (cacheReadInt(&reader)) {
+      char* imagePath = cacheReadString(&reader);
+      if (imagePath) {
+        lovrModelDataAddImage(modelData, source, imagePath, NULL, 0);
+      }
+    } else {
+      uint32_t imageSize = cacheReadInt(&reader);
+      void* data = cacheRead(&reader, imageSize, 1);
+      if (data) {
+        lovrModelDataAddImage(modelData, NULL, NULL, data, imageSize);
+      }
+    }
+  }
+
+  if (reader.error) {
+    lovrModelDataDestroy(modelData);
+    return NULL;
+  }
+
+  return modelData;
+}
+
+void lovrModelDataInit(ModelData* modelData) {
+  modelData->root = NULL;
+  modelData->hasNormals = 0;
+  modelData->hasTexCoords = 0;
+  modelData->hasBones = 0;
+  modelData->mapping = NULL;
+  modelData->mappingSize = 0;
+  vec_init(&modelData->nodes);
+  vec_init(&modelData->meshes);
+  vec_init(&modelData->bones);
+  vec_init(&modelData->animations);
+  vec_init(&modelData->materials);
+  vec_init(&modelData->images);
+  vec_init(&modelData->blobs);
+  vec_init(&modelData->arena.blocks);
+  modelData->arena.cursor = NULL;
+  modelData->arena.remaining = 0;
+}
+
+// Makes sure the next size bytes can be allocated without starting another block.  Loaders that know
+// how much they need up front reserve it all, so the ModelData ends up with a single block.
+void lovrModelDataReserve(ModelData* modelData, size_t size) {
+  ModelArena* arena = &modelData->arena;
+  if (arena->remaining >= size) {
+    return;
+  }
+
+  char* block = malloc(size);
+  lovrAssert(block, "Out of memory");
+  vec_push(&arena->blocks, block);
+  arena->cursor = block;
+  arena->remaining = size;
+}
+
+// Allocations are 16 byte aligned.  Once a block runs out, the rest of it goes unused.
+void* lovrModelDataAllocate(ModelData* modelData, size_t size) {
+  ModelArena* arena = &modelData->arena;
+  size = (size + 15) & ~((size_t) 15);
+  if (size > arena->remaining) {
+    lovrModelDataReserve(modelData, MAX(size, MODEL_ARENA_BLOCK_SIZE));
+  }
+
+  void* data = arena->cursor;
+  arena->cursor += size;
+  arena->remaining -= size;
+  return data;
+}
+
+char* lovrModelDataCopyString(ModelData* modelData, const char* string, size_t length) {
+  char* copy = lovrModelDataAllocate(modelData, length + 1);
+  memcpy(copy, string, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+// Adds a white material without textures, returning its index
+int lovrModelDataAddMaterial(ModelData* modelData, const char* name) {
+  ModelMaterial material = {
+    .name = copyString(modelData, name ? name : ""),
+    .diffuseColor = { 1.f, 1.f, 1.f, 1.f },
+    .emissiveColor = { 0.f, 0.f, 0.f, 1.f },
+    .diffuseTexture = -1,
+    .emissiveTexture = -1
+  };
+
+  vec_push(&modelData->materials, material);
+  return modelData->materials.length - 1;
+}
+
+// Adds an image, returning its index.  Embedded images are copied from data.  Otherwise, the image is
+// read from path, relative to the directory of the source file, and images that several materials use
+// are only read once.  Backslashes in paths are treated as slashes.
+int lovrModelDataAddImage(ModelData* modelData, const char* source, const char* path, void* data, size_t size) {
+  ModelImage image = { .path = NULL, .blob = NULL };
+
+  if (path) {
+    image.path = copyString(modelData, path);
+    for (char* c = image.path; *c; c++) {
+      *c = *c == '\\' ? '/' : *c;
+    }
+
+    ModelImage* other; int i;
+    vec_foreach_ptr(&modelData->images, other, i) {
+      if (other->path && !strcmp(other->path, image.path)) {
+        return i;
+      }
+    }
+
+    char fullPath[LOVR_PATH_MAX];
+    const char* slash = source ? strrchr(source, '/') : NULL;
+    int directoryLength = slash ? (int) (slash - source + 1) : 0;
+    snprintf(fullPath, LOVR_PATH_MAX, "%.*s%s", directoryLength, source ? source : "", image.path);
+
+    size_t bytesRead;
+    void* contents = lovrFilesystemRead(fullPath, &bytesRead);
+    if (contents) {
+      image.blob = lovrBlobCreate(contents, bytesRead, "Model image");
+    }
+  } else {
+    void* copy = malloc(size);
+    lovrAssert(copy, "Out of memory");
+    memcpy(copy, data, size);
+    image.blob = lovrBlobCreate(copy, size, "Model image");
+  }
+
+  vec_push(&modelData->images, image);
+  return modelData->images.length - 1;
+}
+
+ModelData* lovrModelDataCreate(Blob* blob) {
+
+  // glTF is loaded directly, it's fast enough that it doesn't need to be cached
+  if (lovrModelDataIsGltf(blob)) {
+    return lovrModelDataCreateGltf(blob);
+  }
+
+  // Cache locality is handled by the optimization pass after import
+  unsigned int flags = aiProcessPreset_TargetRealtime_MaxQuality | aiProcess_OptimizeGraph | aiProcess_FlipUVs;
+  flags &= ~aiProcess_ImproveCacheLocality;
+  uint64_t hash = hashSource(blob);
+
+  char path[LOVR_PATH_MAX];
+  snprintf(path, LOVR_PATH_MAX, "cache/models/v%d-%016llx%08x.bin", MODEL_CACHE_VERSION, (unsigned long long) hash, flags);
+  int useCache = lovrFilesystemGetSaveDirectory() != NULL;
+
+  ModelData* modelData = useCache ? lovrModelDataReadCache(path, blob->name, hash, flags) : NULL;
+  if (modelData) {
+    return modelData;
+  }
+
+  modelData = assimpImport(blob, flags);
+  if (modelData && useCache) {
+    lovrModelDataWriteCache(modelData, path, hash, flags);
+  }
 
-  aiReleaseImport(scene);
   return modelData;
 }
 
 void lovrModelDataDestroy(ModelData* modelData) {
-  for (int i = 0; i < modelData->meshes.length; i++) {
-    ModelMesh* mesh = modelData->meshes.data[i];
-    vec_deinit(&mesh->faces);
-    vec_deinit(&mesh->vertices);
-    vec_deinit(&mesh->normals);
-    if (modelData->hasTexCoords) {
-      vec_deinit(&mesh->texCoords);
+  if (!modelData->mapping) {
+    for (int i = 0; i < modelData->meshes.length; i++) {
+      vec_deinit(&modelData->meshes.data[i]->lodFaces);
     }
-    free(mesh);
   }
 
-  vec_void_t nodes;
-  vec_init(&nodes);
-  vec_push(&nodes, modelData->root);
-  while (nodes.length > 0) {
-    ModelNode* node = vec_first(&nodes);
-    vec_extend(&nodes, &node->children);
-    vec_deinit(&node->meshes);
-    vec_deinit(&node->children);
-    vec_splice(&nodes, 0, 1);
-    free(node);
+  for (int i = 0; i < modelData->animations.length; i++) {
+    ModelAnimation* animation = &modelData->animations.data[i];
+    for (int j = 0; j < animation->channels.length; j++) {
+      ModelAnimationChannel* channel = &animation->channels.data[j];
+      vec_deinit(&channel->positions);
+      vec_deinit(&channel->rotations);
+      vec_deinit(&channel->scales);
+    }
+    vec_deinit(&animation->channels);
   }
 
   vec_deinit(&modelData->meshes);
-  vec_deinit(&nodes);
+  vec_deinit(&modelData->nodes);
+  vec_deinit(&modelData->bones);
+  vec_deinit(&modelData->animations);
+  for (int i = 0; i < modelData->images.length; i++) {
+    if (modelData->images.data[i].blob) {
+      lovrRelease(&modelData->images.data[i].blob->ref);
+    }
+  }
+
+  vec_deinit(&modelData->materials);
+  vec_deinit(&modelData->images);
+  if (modelData->mapping) {
+    lovrFilesystemUnmap(modelData->mapping, modelData->mappingSize);
+  }
+
+  for (int i = 0; i < modelData->blobs.length; i++) {
+    Blob* blob = modelData->blobs.data[i];
+    lovrRelease(&blob->ref);
+  }
+
+  for (int i = 0; i < modelData->arena.blocks.length; i++) {
+    free(modelData->arena.blocks.data[i]);
+  }
+
+  vec_deinit(&modelData->blobs);
+  vec_deinit(&modelData->arena.blocks);
   free(modelData);
 }
+
+int lovrModelDataFindNode(ModelData* modelData, const char* name) {
+  for (int i = 0; i < modelData->nodes.length; i++) {
+    ModelNode* node = modelData->nodes.data[i];
+    if (!strcmp(node->name, name)) {
+      return i;
+    }
+  }
+
+  return -1;
+}
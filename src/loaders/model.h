@@ -18,27 +18,150 @@ typedef struct {
 
 typedef vec_t(ModelFace) vec_model_face_t;
 
+#define MAX_BONES_PER_VERTEX 4
+
+// Unused slots have a weight of zero
+typedef struct {
+  unsigned int bones[MAX_BONES_PER_VERTEX];
+  float weights[MAX_BONES_PER_VERTEX];
+} ModelBoneWeights;
+
+typedef vec_t(ModelBoneWeights) vec_model_bone_weights_t;
+
+#define MAX_LODS 4
+
+// Colors are RGBA from 0 to 1.  Textures are indices into the images of the ModelData, or -1.
+typedef struct {
+  char* name;
+  float diffuseColor[4];
+  float emissiveColor[4];
+  int diffuseTexture;
+  int emissiveTexture;
+} ModelMaterial;
+
+typedef vec_t(ModelMaterial) vec_model_material_t;
+
+// An encoded image file used by materials.  The path is relative to the model and is NULL for images
+// embedded in it.  The Blob is NULL if the image couldn't be read.
+typedef struct {
+  char* path;
+  Blob* blob;
+} ModelImage;
+
+typedef vec_t(ModelImage) vec_model_image_t;
+
+// A simplified level of detail, as a range of the lodFaces of a mesh
+typedef struct {
+  int start;
+  int count;
+} ModelLod;
+
+// The bounding box is in the space of the mesh, as minx, maxx, miny, maxy, minz, maxz.  The faces are
+// the full detail version of the mesh, lods holds lodCount coarser levels that use the same vertices.
+// Every mesh has a material.
 typedef struct {
   vec_model_face_t faces;
   vec_model_vertex_t vertices;
   vec_model_vertex_t normals;
   vec_model_vertex_t texCoords;
+  vec_model_bone_weights_t boneWeights;
+  vec_model_face_t lodFaces;
+  ModelLod lods[MAX_LODS - 1];
+  int lodCount;
+  int hasBones;
+  int material;
+  float aabb[6];
 } ModelMesh;
 
 typedef vec_t(ModelMesh*) vec_model_mesh_t;
 
-typedef struct {
+typedef struct ModelNode {
+  char* name;
+  int index;
+  struct ModelNode* parent;
   float transform[16];
   vec_uint_t meshes;
   vec_void_t children;
 } ModelNode;
 
+// The offset transforms vertices from mesh space into the space of the bone's node
+typedef struct {
+  char* name;
+  int node;
+  float offset[16];
+} ModelBone;
+
+typedef vec_t(ModelBone) vec_model_bone_t;
+
+// Rotations are quaternions, positions and scales use the first 3 components
+typedef struct {
+  float time;
+  float data[4];
+} ModelKeyframe;
+
+typedef vec_t(ModelKeyframe) vec_model_keyframe_t;
+
+typedef struct {
+  int node;
+  vec_model_keyframe_t positions;
+  vec_model_keyframe_t rotations;
+  vec_model_keyframe_t scales;
+} ModelAnimationChannel;
+
+typedef vec_t(ModelAnimationChannel) vec_model_animation_channel_t;
+
+// Times are in seconds
+typedef struct {
+  char* name;
+  float duration;
+  vec_model_animation_channel_t channels;
+} ModelAnimation;
+
+typedef vec_t(ModelAnimation) vec_model_animation_t;
+
+#define MODEL_ARENA_BLOCK_SIZE 65536
+
+// Blocks of memory that are handed out in pieces and freed all at once
+typedef struct {
+  vec_void_t blocks;
+  char* cursor;
+  size_t remaining;
+} ModelArena;
+
+// Meshes, nodes, names, and mesh arrays are allocated from the arena, except for lodFaces, which are
+// generated on worker threads.  Mesh arrays can also point into the file mapping of the model cache
+// or into Blobs the ModelData holds a reference to.  Either way, they can't be resized.
 typedef struct {
   ModelNode* root;
+  vec_void_t nodes;
   vec_model_mesh_t meshes;
+  vec_model_bone_t bones;
+  vec_model_animation_t animations;
+  vec_model_material_t materials;
+  vec_model_image_t images;
   int hasNormals;
   int hasTexCoords;
+  int hasBones;
+  void* mapping;
+  size_t mappingSize;
+  vec_void_t blobs;
+  ModelArena arena;
 } ModelData;
 
+// Points a vec at count elements allocated from the arena of a ModelData
+#define lovrModelDataAllocateArray(modelData, v, count) \
+  ((v)->data = lovrModelDataAllocate(modelData, (count) * sizeof(*(v)->data)), \
+   (v)->length = (v)->capacity = (count))
+
 ModelData* lovrModelDataCreate(Blob* blob);
+void lovrModelDataInit(ModelData* modelData);
+void lovrModelDataReserve(ModelData* modelData, size_t size);
+void* lovrModelDataAllocate(ModelData* modelData, size_t size);
+char* lovrModelDataCopyString(ModelData* modelData, const char* string, size_t length);
+int lovrModelDataAddMaterial(ModelData* modelData, const char* name);
+int lovrModelDataAddImage(ModelData* modelData, const char* directory, const char* path, void* data, size_t size);
+void lovrModelDataGenerateLods(ModelData* modelData);
+int lovrModelDataIsGltf(Blob* blob);
+ModelData* lovrModelDataCreateGltf(Blob* blob);
 void lovrModelDataDestroy(ModelData* modelData);
+int lovrModelDataFindNode(ModelData* modelData, const char* name);
@@ -6,22 +6,73 @@
 #include <string.h>
 
 const TextureFormat FORMAT_RGB = {
-  .glInternalFormat = GL_RGB,
+  .glInternalFormat = GL_RGB8,
   .glFormat = GL_RGB,
+  .glType = GL_UNSIGNED_BYTE,
   .compressed = 0,
   .blockBytes = 3
 };
 
 const TextureFormat FORMAT_RGBA = {
-  .glInternalFormat = GL_RGBA,
+  .glInternalFormat = GL_RGBA8,
   .glFormat = GL_RGBA,
+  .glType = GL_UNSIGNED_BYTE,
   .compressed = 0,
   .blockBytes = 4
 };
 
+const TextureFormat FORMAT_R8 = {
+  .glInternalFormat = GL_R8,
+  .glFormat = GL_RED,
+  .glType = GL_UNSIGNED_BYTE,
+  .compressed = 0,
+  .blockBytes = 1
+};
+
+const TextureFormat FORMAT_RG8 = {
+  .glInternalFormat = GL_RG8,
+  .glFormat = GL_RG,
+  .glType = GL_UNSIGNED_BYTE,
+  .compressed = 0,
+  .blockBytes = 2
+};
+
+const TextureFormat FORMAT_R16F = {
+  .glInternalFormat = GL_R16F,
+  .glFormat = GL_RED,
+  .glType = GL_HALF_FLOAT,
+  .compressed = 0,
+  .blockBytes = 2
+};
+
+const TextureFormat FORMAT_RG16F = {
+  .glInternalFormat = GL_RG16F,
+  .glFormat = GL_RG,
+  .glType = GL_HALF_FLOAT,
+  .compressed = 0,
+  .blockBytes = 4
+};
+
+const TextureFormat FORMAT_RGBA16F = {
+  .glInternalFormat = GL_RGBA16F,
+  .glFormat = GL_RGBA,
+  .glType = GL_HALF_FLOAT,
+  .compressed = 0,
+  .blockBytes = 8
+};
+
+const TextureFormat FORMAT_RGBA32F = {
+  .glInternalFormat = GL_RGBA32F,
+  .glFormat = GL_RGBA,
+  .glType = GL_FLOAT,
+  .compressed = 0,
+  .blockBytes = 16
+};
+
 const TextureFormat FORMAT_DXT1 = {
   .glInternalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
   .glFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+  .glType = GL_UNSIGNED_BYTE,
   .compressed = 1,
   .blockBytes = 8
 };
@@ -29,6 +80,7 @@ const TextureFormat FORMAT_DXT1 = {
 const TextureFormat FORMAT_DXT3 = {
   .glInternalFormat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,
   .glFormat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,
+  .glType = GL_UNSIGNED_BYTE,
   .compressed = 1,
   .blockBytes = 16
 };
@@ -36,10 +88,77 @@ const TextureFormat FORMAT_DXT3 = {
 const TextureFormat FORMAT_DXT5 = {
   .glInternalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
   .glFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+  .glType = GL_UNSIGNED_BYTE,
   .compressed = 1,
   .blockBytes = 16
 };
 
+static int getChannelCount(GLenum glFormat) {
+  switch (glFormat) {
+    case GL_RED: return 1;
+    case GL_RG: return 2;
+    case GL_RGB: return 3;
+    default: return 4;
+  }
+}
+
+// Converts 8 bit pixels to floats in place, growing the buffer.
+static float* normalizePixels(uint8_t* pixels, size_t count) {
+  float* floats = realloc(pixels, count * sizeof(float));
+  if (!floats) {
+    free(pixels);
+    return NULL;
+  }
+
+  uint8_t* bytes = (uint8_t*) floats;
+  for (size_t i = count; i > 0; i--) {
+    floats[i - 1] = bytes[i - 1] / 255.f;
+  }
+
+  return floats;
+}
+
+// Rounds to nearest, flushes denormals to zero and clamps to infinity
+static uint16_t floatToHalf(float f) {
+  union { float f; uint32_t u; } bits = { .f = f };
+  uint32_t sign = (bits.u >> 16) & 0x8000;
+  int32_t exponent = ((bits.u >> 23) & 0xff) - 127 + 15;
+  uint32_t mantissa = bits.u & 0x7fffff;
+
+  if (((bits.u >> 23) & 0xff) == 0xff) {
+    return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+  } else if (exponent <= 0) {
+    return sign;
+  } else if (exponent >= 31) {
+    return sign | 0x7c00;
+  }
+
+  uint32_t half = sign | (exponent << 10) | (mantissa >> 13);
+  if (mantissa & 0x1000) {
+    half++;
+  }
+
+  return half;
+}
+
+// Sets every component to value, which float formats read as a fraction of 255
+static void fillPixels(void* data, size_t size, uint8_t value, TextureFormat format) {
+  if (format.glType == GL_HALF_FLOAT) {
+    uint16_t half = floatToHalf(value / 255.f);
+    uint16_t* halves = data;
+    for (size_t i = 0; i < size / sizeof(uint16_t); i++) {
+      halves[i] = half;
+    }
+  } else if (format.glType == GL_FLOAT) {
+    float* floats = data;
+    for (size_t i = 0; i < size / sizeof(float); i++) {
+      floats[i] = value / 255.f;
+    }
+  } else {
+    memset(data, value, size);
+  }
+}
+
 #define FOUR_CC(a, b, c, d) ((uint32_t) (((d)<<24) | ((c)<<16) | ((b)<<8) | (a)))
 
 // Modified from ddsparse (https://bitbucket.org/slime73/ddsparse)
@@ -76,8 +195,15 @@ static int parseDDS(uint8_t* data, size_t size, TextureData* textureData) {
       return 1;
     }
 
-    // Ensure DXT 1/3/5
     switch (header10->dxgiFormat) {
+      case DXGI_FORMAT_R8_UNORM: textureData->format = FORMAT_R8; break;
+      case DXGI_FORMAT_R8G8_UNORM: textureData->format = FORMAT_RG8; break;
+      case DXGI_FORMAT_R8G8B8A8_UNORM: textureData->format = FORMAT_RGBA; break;
+      case DXGI_FORMAT_R16_FLOAT: textureData->format = FORMAT_R16F; break;
+      case DXGI_FORMAT_R16G16_FLOAT: textureData->format = FORMAT_RG16F; break;
+      case DXGI_FORMAT_R16G16B16A16_FLOAT: textureData->format = FORMAT_RGBA16F; break;
+      case DXGI_FORMAT_R32G32B32A32_FLOAT: textureData->format = FORMAT_RGBA32F; break;
+
       case DXGI_FORMAT_BC1_TYPELESS:
       case DXGI_FORMAT_BC1_UNORM:
       case DXGI_FORMAT_BC1_UNORM_SRGB:
@@ -114,6 +240,18 @@ static int parseDDS(uint8_t* data, size_t size, TextureData* textureData) {
   int height = textureData->height = header->height;
   int mipmapCount = header->mipMapCount;
 
+  // Uncompressed images only use the top level, the rest of the chain is regenerated on the GPU
+  if (!textureData->format.compressed) {
+    size_t imageSize = (size_t) width * height * textureData->format.blockBytes;
+    if (imageSize == 0 || (offset + imageSize) > size) {
+      return 1;
+    }
+
+    textureData->data = memcpy(malloc(imageSize), &data[offset], imageSize);
+    textureData->mipmaps.generated = mipmapCount > 1 && textureData->format.glType != GL_FLOAT;
+    return 0;
+  }
+
   // Load mipmaps
   vec_init(&textureData->mipmaps.list);
   for (int i = 0; i < mipmapCount; i++) {
@@ -147,7 +285,9 @@ TextureData* lovrTextureDataGetBlank(int width, int height, uint8_t value, Textu
   textureData->width = width;
   textureData->height = height;
   textureData->format = format;
-  textureData->data = memset(malloc(size), value, size);
+  textureData->data = malloc(size);
+  lovrAssert(textureData->data, "Out of memory");
+  fillPixels(textureData->data, size, value, format);
   textureData->mipmaps.generated = 0;
   textureData->blob = NULL;
   return textureData;
@@ -166,28 +306,62 @@ TextureData* lovrTextureDataGetEmpty(int width, int height, TextureFormat format
   return textureData;
 }
 
-TextureData* lovrTextureDataFromBlob(Blob* blob) {
+// DDS files always use the format they were authored in, other images are converted to the
+// requested format (or RGBA if none was requested) as they are decoded.
+TextureData* lovrTextureDataFromBlob(Blob* blob, const TextureFormat* format) {
   TextureData* textureData = malloc(sizeof(TextureData));
   if (!textureData) return NULL;
 
   if (!parseDDS(blob->data, blob->size, textureData)) {
-    textureData->blob = blob;
-    lovrRetain(&blob->ref);
+    if (textureData->format.compressed) {
+      textureData->blob = blob;
+      lovrRetain(&blob->ref);
+    } else {
+      textureData->blob = NULL;
+    }
     return textureData;
   }
 
+  format = format ? format : &FORMAT_RGBA;
+  lovrAssert(!format->compressed, "Images can only be converted to uncompressed formats");
+  int channels = getChannelCount(format->glFormat);
+  int isHDR = stbi_is_hdr_from_memory(blob->data, blob->size);
+  int width, height;
+
   stbi_set_flip_vertically_on_load(0);
-  textureData->format = FORMAT_RGBA;
-  textureData->data = stbi_load_from_memory(blob->data, blob->size, &textureData->width, &textureData->height, NULL, 4);
-  textureData->mipmaps.generated = 1;
-  textureData->blob = NULL;
+  if (format->glType == GL_UNSIGNED_BYTE) {
+    textureData->data = stbi_load_from_memory(blob->data, blob->size, &width, &height, NULL, channels);
+  } else if (isHDR) {
+    textureData->data = stbi_loadf_from_memory(blob->data, blob->size, &width, &height, NULL, channels);
+  } else {
+    uint8_t* pixels = stbi_load_from_memory(blob->data, blob->size, &width, &height, NULL, channels);
+    textureData->data = pixels ? normalizePixels(pixels, (size_t) width * height * channels) : NULL;
+  }
 
   if (!textureData->data) {
-    lovrThrow("Could not load texture data from '%s'", blob->name);
     free(textureData);
+    lovrThrow("Could not load texture data from '%s'", blob->name);
     return NULL;
   }
 
+  if (format->glType == GL_HALF_FLOAT) {
+    float* floats = textureData->data;
+    uint16_t* halves = textureData->data;
+    size_t count = (size_t) width * height * channels;
+    for (size_t i = 0; i < count; i++) {
+      halves[i] = floatToHalf(floats[i]);
+    }
+
+    // The halves only use the first half of the buffer
+    void* data = realloc(textureData->data, count * sizeof(uint16_t));
+    textureData->data = data ? data : textureData->data;
+  }
+
+  textureData->width = width;
+  textureData->height = height;
+  textureData->format = *format;
+  textureData->mipmaps.generated = format->glType != GL_FLOAT;
+  textureData->blob = NULL;
   return textureData;
 }
 
@@ -200,7 +374,8 @@ void lovrTextureDataResize(TextureData* textureData, int width, int height, uint
   textureData->width = width;
   textureData->height = height;
   textureData->data = realloc(textureData->data, size);
-  memset(textureData->data, value, size);
+  lovrAssert(textureData->data, "Out of memory");
+  fillPixels(textureData->data, size, value, textureData->format);
 }
 
 void lovrTextureDataDestroy(TextureData* textureData) {
@@ -7,11 +7,13 @@
 typedef struct {
   GLenum glInternalFormat;
   GLenum glFormat;
+  GLenum glType;
   int blockBytes;
   int compressed;
 } TextureFormat;
 
-extern const TextureFormat FORMAT_RGB, FORMAT_RGBA, FORMAT_DXT1, FORMAT_DXT3, FORMAT_DXT5;
+extern const TextureFormat FORMAT_RGB, FORMAT_RGBA, FORMAT_R8, FORMAT_RG8, FORMAT_R16F, FORMAT_RG16F, FORMAT_RGBA16F,
+  FORMAT_RGBA32F, FORMAT_DXT1, FORMAT_DXT3, FORMAT_DXT5;
 
 typedef struct {
   int width;
@@ -36,6 +38,6 @@ typedef struct {
 
 TextureData* lovrTextureDataGetBlank(int width, int height, uint8_t value, TextureFormat format);
 TextureData* lovrTextureDataGetEmpty(int width, int height, TextureFormat format);
-TextureData* lovrTextureDataFromBlob(Blob* blob);
+TextureData* lovrTextureDataFromBlob(Blob* blob, const TextureFormat* format);
 void lovrTextureDataResize(TextureData* textureData, int width, int height, uint8_t value);
 void lovrTextureDataDestroy(TextureData* textureData);
@@ -70,6 +70,8 @@ void lovrInit(lua_State* L, int argc, char** argv) {
     lovrThrow("Error initializing glfw");
   }
 
+  lovrParallelInit();
+
   // arg global
   lua_newtable(L);
   if (argc > 0) {
@@ -117,6 +119,7 @@ void lovrInit(lua_State* L, int argc, char** argv) {
 }
 
 void lovrDestroy(int exitCode) {
+  lovrParallelDestroy();
   glfwTerminate();
   exit(exitCode);
 }
@@ -0,0 +1,526 @@
+#include "math/bvh.h"
+#include "math/math.h"
+#include "util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+// Nodes are split where the surface area heuristic expects raycasts to be cheapest, trying the splits
+// between BVH_BINS bins of triangle centroids on each axis.  Bins track the bounds of their triangles
+// and centroids, so children get their bounds from the bins and only the root is measured.  Past
+// BVH_SAH_DEPTH, nodes are split in half instead, which keeps the tree shallower than BVH_MAX_DEPTH.
+//
+// The top of the tree is built on the calling thread, binning large nodes across threads, until the
+// subtrees are small enough to be built as separate jobs.  A node with n triangles reserves room for
+// the 2n - 1 nodes its subtree could have, so jobs write to their own part of the node array, and the
+// gaps left by leaves with more than one triangle are compacted at the end.
+#define BVH_BINS 16
+#define BVH_MAX_LEAF_SIZE 4
+#define BVH_TRAVERSAL_COST 1.f
+#define BVH_SAH_DEPTH 32
+#define BVH_JOB_COUNT 64
+#define BVH_MIN_JOB_SIZE 1024
+#define BVH_CHUNKS 16
+#define BVH_CHUNK_SIZE 65536
+#define BVH_GRAIN 4096
+
+typedef struct {
+  float min[3];
+  float max[3];
+} BvhBox;
+
+// Triangles are sorted by partitioning their items in place
+typedef struct {
+  BvhBox box;
+  float centroid[3];
+  uint32_t index;
+} BvhItem;
+
+typedef struct {
+  BvhBox box;
+  BvhBox centroids;
+  uint32_t count;
+} BvhBin;
+
+typedef struct {
+  uint32_t slot;
+  uint32_t start;
+  uint32_t count;
+  int depth;
+  BvhBox bounds;
+  BvhBox centroids;
+} BvhJob;
+
+typedef vec_t(BvhJob) vec_bvh_job_t;
+
+typedef struct {
+  float* positions;
+  int stride;
+  unsigned int* indices;
+  BvhItem* items;
+  BvhNode* nodes;
+  BvhTriangle* triangles;
+  vec_bvh_job_t jobs;
+  uint32_t jobSize;
+} BvhBuilder;
+
+// A large range of triangles is measured or binned in chunks, each chunk on its own
+typedef struct {
+  BvhBuilder* builder;
+  uint32_t start;
+  uint32_t count;
+  BvhBox* centroidBounds;
+  BvhBox bounds[BVH_CHUNKS];
+  BvhBox centroids[BVH_CHUNKS];
+  BvhBin bins[BVH_CHUNKS][3][BVH_BINS];
+} BvhScan;
+
+static void boxReset(BvhBox* box) {
+  box->min[0] = box->min[1] = box->min[2] = FLT_MAX;
+  box->max[0] = box->max[1] = box->max[2] = -FLT_MAX;
+}
+
+static void boxAdd(BvhBox* box, float* min, float* max) {
+  for (int i = 0; i < 3; i++) {
+    box->min[i] = MIN(box->min[i], min[i]);
+    box->max[i] = MAX(box->max[i], max[i]);
+  }
+}
+
+// Half of the surface area, which is all the heuristic needs
+static float boxArea(BvhBox* box) {
+  float dx = box->max[0] - box->min[0];
+  float dy = box->max[1] - box->min[1];
+  float dz = box->max[2] - box->min[2];
+  return dx < 0.f ? 0.f : dx * dy + dy * dz + dz * dx;
+}
+
+static void binReset(BvhBin* bin) {
+  boxReset(&bin->box);
+  boxReset(&bin->centroids);
+  bin->count = 0;
+}
+
+static void binAdd(BvhBin* bin, BvhBin* other) {
+  boxAdd(&bin->box, other->box.min, other->box.max);
+  boxAdd(&bin->centroids, other->centroids.min, other->centroids.max);
+  bin->count += other->count;
+}
+
+static float binScale(BvhBox* centroids, int axis, int binCount) {
+  float extent = centroids->max[axis] - centroids->min[axis];
+  return extent > 0.f ? binCount / extent : 0.f;
+}
+
+static int binIndex(float value, float min, float scale, int binCount) {
+  int bin = (int) ((value - min) * scale);
+  return bin < 0 ? 0 : (bin >= binCount ? binCount - 1 : bin);
+}
+
+static void prepareItems(void* userdata, int start, int end) {
+  BvhBuilder* builder = userdata;
+  for (int i = start; i < end; i++) {
+    BvhItem* item = &builder->items[i];
+    boxReset(&item->box);
+    for (int j = 0; j < 3; j++) {
+      float* vertex = builder->positions + builder->indices[3 * i + j] * builder->stride;
+      boxAdd(&item->box, vertex, vertex);
+    }
+
+    for (int j = 0; j < 3; j++) {
+      item->centroid[j] = (item->box.min[j] + item->box.max[j]) * .5f;
+    }
+
+    item->index = i;
+  }
+}
+
+static void measureRange(BvhBuilder* builder, uint32_t start, uint32_t end, BvhBox* bounds, BvhBox* centroids) {
+  boxReset(bounds);
+  boxReset(centroids);
+  for (uint32_t i = start; i < end; i++) {
+    BvhItem* item = &builder->items[i];
+    boxAdd(bounds, item->box.min, item->box.max);
+    boxAdd(centroids, item->centroid, item->centroid);
+  }
+}
+
+static void binRange(BvhBuilder* builder, uint32_t start, uint32_t end, BvhBox* centroids, BvhBin bins[3][BVH_BINS], int binCount) {
+  float scale[3];
+  for (int axis = 0; axis < 3; axis++) {
+    scale[axis] = binScale(centroids, axis, binCount);
+    for (int i = 0; i < binCount; i++) {
+      binReset(&bins[axis][i]);
+    }
+  }
+
+  for (uint32_t i = start; i < end; i++) {
+    BvhItem* item = &builder->items[i];
+    for (int axis = 0; axis < 3; axis++) {
+      BvhBin* bin = &bins[axis][binIndex(item->centroid[axis], centroids->min[axis], scale[axis], binCount)];
+      boxAdd(&bin->box, item->box.min, item->box.max);
+      boxAdd(&bin->centroids, item->centroid, item->centroid);
+      bin->count++;
+    }
+  }
+}
+
+static void scanChunks(void* userdata, int start, int end) {
+  BvhScan* scan = userdata;
+  for (int c = start; c < end; c++) {
+    uint32_t first = scan->start + (uint32_t) ((uint64_t) scan->count * c / BVH_CHUNKS);
+    uint32_t last = scan->start + (uint32_t) ((uint64_t) scan->count * (c + 1) / BVH_CHUNKS);
+    if (scan->centroidBounds) {
+      binRange(scan->builder, first, last, scan->centroidBounds, scan->bins[c], BVH_BINS);
+    } else {
+      measureRange(scan->builder, first, last, &scan->bounds[c], &scan->centroids[c]);
+    }
+  }
+}
+
+// Measures the bounds of a range of triangles and of their centroids, if bins is NULL, or bins them.
+// Small ranges use fewer bins, which matters since most nodes are small.
+static void scanRange(BvhBuilder* builder, uint32_t start, uint32_t count, int parallel, BvhBox* bounds, BvhBox* centroids, BvhBin bins[3][BVH_BINS]) {
+  if (!parallel || count < BVH_CHUNK_SIZE) {
+    if (bins) {
+      binRange(builder, start, start + count, centroids, bins, MIN(count, BVH_BINS));
+    } else {
+      measureRange(builder, start, start + count, bounds, centroids);
+    }
+    return;
+  }
+
+  BvhScan* scan = malloc(sizeof(BvhScan));
+  lovrAssert(scan, "Out of memory");
+  scan->builder = builder;
+  scan->start = start;
+  scan->count = count;
+  scan->centroidBounds = bins ? centroids : NULL;
+  lovrParallelFor(BVH_CHUNKS, 1, scanChunks, scan);
+
+  if (bins) {
+    for (int axis = 0; axis < 3; axis++) {
+      for (int i = 0; i < BVH_BINS; i++) {
+        binReset(&bins[axis][i]);
+        for (int c = 0; c < BVH_CHUNKS; c++) {
+          binAdd(&bins[axis][i], &scan->bins[c][axis][i]);
+        }
+      }
+    }
+  } else {
+    boxReset(bounds);
+    boxReset(centroids);
+    for (int c = 0; c < BVH_CHUNKS; c++) {
+      boxAdd(bounds, scan->bounds[c].min, scan->bounds[c].max);
+      boxAdd(centroids, scan->centroids[c].min, scan->centroids[c].max);
+    }
+  }
+
+  free(scan);
+}
+
+// Builds the subtree of a range of triangles with known bounds into a slot.  When parallel is set,
+// subtrees small enough to be jobs are queued instead.
+static void buildNode(BvhBuilder* builder, uint32_t slot, uint32_t start, uint32_t count, int depth, int parallel, BvhBox* bounds, BvhBox* centroids) {
+  if (parallel && count <= builder->jobSize) {
+    BvhJob job = { slot, start, count, depth, *bounds, *centroids };
+    vec_push(&builder->jobs, job);
+    return;
+  }
+
+  BvhNode* node = &builder->nodes[slot];
+  memcpy(node->min, bounds->min, 3 * sizeof(float));
+  memcpy(node->max, bounds->max, 3 * sizeof(float));
+
+  BvhBin bins[3][BVH_BINS];
+  int binned = count > 1 && depth < BVH_SAH_DEPTH;
+  int binCount = MIN(count, BVH_BINS);
+  if (binned) {
+    scanRange(builder, start, count, parallel, NULL, centroids, bins);
+  }
+
+  // The cost of a split is the area of each side times its triangle count, relative to the node
+  int axis = -1;
+  int split = 0;
+  float cost = FLT_MAX;
+  for (int a = 0; binned && a < 3; a++) {
+    if (centroids->max[a] <= centroids->min[a]) {
+      continue;
+    }
+
+    float rightAreas[BVH_BINS];
+    uint32_t rightCounts[BVH_BINS];
+    BvhBox box;
+    uint32_t total = 0;
+    boxReset(&box);
+    for (int i = binCount - 1; i > 0; i--) {
+      boxAdd(&box, bins[a][i].box.min, bins[a][i].box.max);
+      total += bins[a][i].count;
+      rightAreas[i - 1] = boxArea(&box);
+      rightCounts[i - 1] = total;
+    }
+
+    total = 0;
+    boxReset(&box);
+    for (int i = 0; i < binCount - 1; i++) {
+      boxAdd(&box, bins[a][i].box.min, bins[a][i].box.max);
+      total += bins[a][i].count;
+      float splitCost = boxArea(&box) * total + rightAreas[i] * rightCounts[i];
+      if (total > 0 && rightCounts[i] > 0 && splitCost < cost) {
+        cost = splitCost;
+        axis = a;
+        split = i;
+      }
+    }
+  }
+
+  float area = boxArea(bounds);
+  float splitCost = axis >= 0 && area > 0.f ? BVH_TRAVERSAL_COST + cost / area : FLT_MAX;
+  if (count == 1 || (count <= BVH_MAX_LEAF_SIZE && count <= splitCost)) {
+    node->offset = start;
+    node->count = count;
+    return;
+  }
+
+  BvhBin left, right;
+  uint32_t leftCount;
+  if (axis >= 0) {
+    binReset(&left);
+    binReset(&right);
+    for (int i = 0; i < binCount; i++) {
+      binAdd(i <= split ? &left : &right, &bins[axis][i]);
+    }
+
+    BvhItem* items = builder->items + start;
+    float scale = binScale(centroids, axis, binCount);
+    uint32_t i = 0;
+    uint32_t j = count;
+    while (i < j) {
+      if (binIndex(items[i].centroid[axis], centroids->min[axis], scale, binCount) <= split) {
+        i++;
+      } else {
+        BvhItem item = items[i];
+        items[i] = items[--j];
+        items[j] = item;
+      }
+    }
+
+    leftCount = i;
+  } else {
+    leftCount = count / 2;
+    scanRange(builder, start, leftCount, parallel, &left.box, &left.centroids, NULL);
+    scanRange(builder, start + leftCount, count - leftCount, parallel, &right.box, &right.centroids, NULL);
+  }
+
+  node->offset = slot + 2 * leftCount;
+  node->count = 0;
+  buildNode(builder, slot + 1, start, leftCount, depth + 1, parallel, &left.box, &left.centroids);
+  buildNode(builder, slot + 2 * leftCount, start + leftCount, count - leftCount, depth + 1, parallel, &right.box, &right.centroids);
+}
+
+static void buildJobs(void* userdata, int start, int end) {
+  BvhBuilder* builder = userdata;
+  for (int i = start; i < end; i++) {
+    BvhJob* job = &builder->jobs.data[i];
+    buildNode(builder, job->slot, job->start, job->count, job->depth, 0, &job->bounds, &job->centroids);
+  }
+}
+
+static void writeTriangles(void* userdata, int start, int end) {
+  BvhBuilder* builder = userdata;
+  for (int i = start; i < end; i++) {
+    uint32_t index = builder->items[i].index;
+    unsigned int* indices = builder->indices + 3 * index;
+    float* a = builder->positions + indices[0] * builder->stride;
+    float* b = builder->positions + indices[1] * builder->stride;
+    float* c = builder->positions + indices[2] * builder->stride;
+    BvhTriangle* triangle = &builder->triangles[i];
+    for (int j = 0; j < 3; j++) {
+      triangle->v0[j] = a[j];
+      triangle->e1[j] = b[j] - a[j];
+      triangle->e2[j] = c[j] - a[j];
+    }
+    triangle->index = index;
+  }
+}
+
+// Nodes are in depth first order with gaps, so they're compacted in place by renumbering them in order
+static uint32_t compactNode(BvhNode* nodes, uint32_t slot, uint32_t* nodeCount) {
+  BvhNode node = nodes[slot];
+  uint32_t index = (*nodeCount)++;
+  nodes[index] = node;
+  if (node.count == 0) {
+    compactNode(nodes, slot + 1, nodeCount);
+    nodes[index].offset = compactNode(nodes, node.offset, nodeCount);
+  }
+  return index;
+}
+
+// Positions are read stride floats apart, and every 3 indices are a triangle
+Bvh* lovrBvhCreate(float* positions, int stride, unsigned int* indices, int triangleCount) {
+  Bvh* bvh = malloc(sizeof(Bvh));
+  if (!bvh) return NULL;
+
+  bvh->nodes = NULL;
+  bvh->triangles = NULL;
+  bvh->nodeCount = 0;
+  bvh->triangleCount = triangleCount;
+  if (triangleCount == 0) {
+    return bvh;
+  }
+
+  BvhBuilder builder = {
+    .positions = positions,
+    .stride = stride,
+    .indices = indices,
+    .items = malloc(triangleCount * sizeof(BvhItem)),
+    .nodes = malloc((2 * triangleCount - 1) * sizeof(BvhNode)),
+    .triangles = malloc(triangleCount * sizeof(BvhTriangle)),
+    .jobSize = MAX(triangleCount / BVH_JOB_COUNT, BVH_MIN_JOB_SIZE)
+  };
+
+  lovrAssert(builder.items && builder.nodes && builder.triangles, "Out of memory");
+  vec_init(&builder.jobs);
+
+  BvhBox bounds, centroids;
+  lovrParallelFor(triangleCount, BVH_GRAIN, prepareItems, &builder);
+  scanRange(&builder, 0, triangleCount, 1, &bounds, &centroids, NULL);
+  buildNode(&builder, 0, 0, triangleCount, 0, 1, &bounds, &centroids);
+  lovrParallelFor(builder.jobs.length, 1, buildJobs, &builder);
+  lovrParallelFor(triangleCount, BVH_GRAIN, writeTriangles, &builder);
+
+  uint32_t nodeCount = 0;
+  compactNode(builder.nodes, 0, &nodeCount);
+  BvhNode* nodes = realloc(builder.nodes, nodeCount * sizeof(BvhNode));
+  bvh->nodes = nodes ? nodes : builder.nodes;
+  bvh->nodeCount = nodeCount;
+  bvh->triangles = builder.triangles;
+
+  free(builder.items);
+  vec_deinit(&builder.jobs);
+  return bvh;
+}
+
+void lovrBvhDestroy(Bvh* bvh) {
+  free(bvh->nodes);
+  free(bvh->triangles);
+  free(bvh);
+}
+
+// Returns the distance where the ray enters the box, or FLT_MAX if it misses it before maxDistance.
+// Zero direction components divide to infinity, and the min/max functions skip the NaNs that can make.
+static float intersectBox(BvhNode* node, float* origin, float* inverse, float maxDistance) {
+  float tmin = 0.f;
+  float tmax = maxDistance;
+  for (int i = 0; i < 3; i++) {
+    float t1 = (node->min[i] - origin[i]) * inverse[i];
+    float t2 = (node->max[i] - origin[i]) * inverse[i];
+    tmin = fmaxf(tmin, fminf(t1, t2));
+    tmax = fminf(tmax, fmaxf(t1, t2));
+  }
+  return tmin <= tmax ? tmin : FLT_MAX;
+}
+
+// Möller-Trumbore, hitting both sides of the triangle
+static int intersectTriangle(BvhTriangle* triangle, float* origin, float* direction, BvhHit* hit) {
+  float* e1 = triangle->e1;
+  float* e2 = triangle->e2;
+  float p[3] = {
+    direction[1] * e2[2] - direction[2] * e2[1],
+    direction[2] * e2[0] - direction[0] * e2[2],
+    direction[0] * e2[1] - direction[1] * e2[0]
+  };
+
+  float determinant = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+  if (determinant == 0.f) {
+    return 0;
+  }
+
+  float inverse = 1.f / determinant;
+  float s[3] = { origin[0] - triangle->v0[0], origin[1] - triangle->v0[1], origin[2] - triangle->v0[2] };
+  float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverse;
+  if (u < 0.f || u > 1.f) {
+    return 0;
+  }
+
+  float q[3] = {
+    s[1] * e1[2] - s[2] * e1[1],
+    s[2] * e1[0] - s[0] * e1[2],
+    s[0] * e1[1] - s[1] * e1[0]
+  };
+
+  float v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inverse;
+  if (v < 0.f || u + v > 1.f) {
+    return 0;
+  }
+
+  float distance = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inverse;
+  if (distance < 0.f || distance >= hit->distance) {
+    return 0;
+  }
+
+  hit->distance = distance;
+  hit->triangle = triangle->index;
+  hit->u = u;
+  hit->v = v;
+  return 1;
+}
+
+// Finds the closest hit nearer than hit->distance, which is in multiples of the direction's length.
+// Children are visited nearest first, and the farther one is skipped if a closer hit turns up.
+int lovrBvhRaycast(Bvh* bvh, float* origin, float* direction, BvhHit* hit) {
+  float inverse[3] = { 1.f / direction[0], 1.f / direction[1], 1.f / direction[2] };
+  if (bvh->nodeCount == 0 || intersectBox(&bvh->nodes[0], origin, inverse, hit->distance) == FLT_MAX) {
+    return 0;
+  }
+
+  uint32_t stack[BVH_MAX_DEPTH];
+  float distances[BVH_MAX_DEPTH];
+  int top = 0;
+  int found = 0;
+  uint32_t index = 0;
+
+  for (;;) {
+    BvhNode* node = &bvh->nodes[index];
+    if (node->count > 0) {
+      for (uint32_t i = node->offset; i < node->offset + node->count; i++) {
+        found |= intersectTriangle(&bvh->triangles[i], origin, direction, hit);
+      }
+    } else {
+      uint32_t first = index + 1;
+      uint32_t second = node->offset;
+      float firstDistance = intersectBox(&bvh->nodes[first], origin, inverse, hit->distance);
+      float secondDistance = intersectBox(&bvh->nodes[second], origin, inverse, hit->distance);
+      if (secondDistance < firstDistance) {
+        uint32_t child = first;
+        float distance = firstDistance;
+        first = second;
+        firstDistance = secondDistance;
+        second = child;
+        secondDistance = distance;
+      }
+
+      if (firstDistance != FLT_MAX) {
+        if (secondDistance != FLT_MAX) {
+          stack[top] = second;
+          distances[top++] = secondDistance;
+        }
+        index = first;
+        continue;
+      }
+    }
+
+    while (top > 0 && distances[top - 1] > hit->distance) {
+      top--;
+    }
+
+    if (top == 0) {
+      break;
+    }
+
+    index = stack[--top];
+  }
+
+  return found;
+}
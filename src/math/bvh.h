@@ -0,0 +1,42 @@
+#include <stdint.h>
+
+#pragma once
+
+#define BVH_MAX_DEPTH 64
+
+// Interior nodes have a count of 0.  Their left child is the next node, and offset is the index of
+// the right child.  Leaves have offset and count of their range of triangles.
+typedef struct {
+  float min[3];
+  uint32_t offset;
+  float max[3];
+  uint32_t count;
+} BvhNode;
+
+// Triangles are stored in leaf order as a vertex and two edges, index is their original position
+typedef struct {
+  float v0[3];
+  float e1[3];
+  float e2[3];
+  uint32_t index;
+} BvhTriangle;
+
+// The barycentric coordinates u and v weight the second and third vertex of the triangle
+typedef struct {
+  float distance;
+  int triangle;
+  float u;
+  float v;
+} BvhHit;
+
+// Bounding volume hierarchy over triangles, built with binned SAH
+typedef struct {
+  BvhNode* nodes;
+  BvhTriangle* triangles;
+  int nodeCount;
+  int triangleCount;
+} Bvh;
+
+Bvh* lovrBvhCreate(float* positions, int stride, unsigned int* indices, int triangleCount);
+void lovrBvhDestroy(Bvh* bvh);
+int lovrBvhRaycast(Bvh* bvh, float* origin, float* direction, BvhHit* hit);
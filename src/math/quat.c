@@ -54,6 +54,33 @@ quat quat_normalize(quat q) {
   return q;
 }
 
+// Takes the shortest path, falling back to linear interpolation for nearly identical rotations
+quat quat_slerp(quat q, quat r, float t) {
+  float dot = q[0] * r[0] + q[1] * r[1] + q[2] * r[2] + q[3] * r[3];
+  float sign = dot < 0 ? -1 : 1;
+  dot = fabs(dot);
+
+  if (dot >= 1) {
+    return q;
+  }
+
+  float a = 1 - t;
+  float b = t;
+  float halfTheta = acos(dot);
+  float sinHalfTheta = sqrt(1 - dot * dot);
+  if (sinHalfTheta > .001) {
+    a = sin(a * halfTheta) / sinHalfTheta;
+    b = sin(b * halfTheta) / sinHalfTheta;
+  }
+
+  b *= sign;
+  q[0] = q[0] * a + r[0] * b;
+  q[1] = q[1] * a + r[1] * b;
+  q[2] = q[2] * a + r[2] * b;
+  q[3] = q[3] * a + r[3] * b;
+  return q;
+}
+
 float quat_length(quat q) {
   return sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
 }
@@ -7,6 +7,7 @@ quat quat_set(quat q, float x, float y, float z, float w);
 quat quat_fromAngleAxis(quat q, float angle, vec3 axis);
 quat quat_fromMat4(quat q, mat4 m);
 quat quat_normalize(quat q);
+quat quat_slerp(quat q, quat r, float t);
 float quat_length(quat q);
 void quat_rotate(quat q, vec3 v);
 void quat_getAngleAxis(quat q, float* angle, float* x, float* y, float* z);
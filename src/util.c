@@ -2,13 +2,47 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #ifdef _WIN32
 #include <Windows.h>
 #else
 #include <unistd.h>
+#ifndef EMSCRIPTEN
+#include <pthread.h>
+#endif
 #endif
 
 #define MAX_ERROR_LENGTH 1024
+#define MAX_PARALLEL_JOBS 16
+
+// Parallel loops are split into chunks that a pool of worker threads and the calling thread claim in
+// order.  The pool is started once, and its threads sleep on a condition variable between loops.
+typedef struct {
+  ParallelFunction function;
+  void* userdata;
+  int count;
+  int chunk;
+  int chunkCount;
+  int next;
+  int remaining;
+  int busy;
+  int quit;
+  int initialized;
+  int workerCount;
+#ifdef _WIN32
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE work;
+  CONDITION_VARIABLE done;
+  HANDLE threads[MAX_PARALLEL_JOBS];
+#elif !defined(EMSCRIPTEN)
+  pthread_mutex_t lock;
+  pthread_cond_t work;
+  pthread_cond_t done;
+  pthread_t threads[MAX_PARALLEL_JOBS];
+#endif
+} WorkerPool;
+
+static WorkerPool pool;
 
 char lovrErrorMessage[MAX_ERROR_LENGTH];
 jmp_buf* lovrCatch = NULL;
@@ -49,6 +83,186 @@ void lovrRelease(const Ref* ref) {
   if (--((Ref*) ref)->count == 0 && ref->free) ref->free(ref);
 }
 
+int lovrGetCoreCount() {
+  static int count = 0;
+
+  if (count == 0) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    count = info.dwNumberOfProcessors;
+#elif defined(EMSCRIPTEN)
+    count = 1;
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    count = cores > 0 ? cores : 1;
+#endif
+  }
+
+  return count;
+}
+
+#ifdef _WIN32
+#define poolLock() EnterCriticalSection(&pool.lock)
+#define poolUnlock() LeaveCriticalSection(&pool.lock)
+#define poolWait(c) SleepConditionVariableCS(&pool.c, &pool.lock, INFINITE)
+#define poolSignal(c) WakeConditionVariable(&pool.c)
+#define poolBroadcast(c) WakeAllConditionVariable(&pool.c)
+#elif !defined(EMSCRIPTEN)
+#define poolLock() pthread_mutex_lock(&pool.lock)
+#define poolUnlock() pthread_mutex_unlock(&pool.lock)
+#define poolWait(c) pthread_cond_wait(&pool.c, &pool.lock)
+#define poolSignal(c) pthread_cond_signal(&pool.c)
+#define poolBroadcast(c) pthread_cond_broadcast(&pool.c)
+#endif
+
+#ifndef EMSCRIPTEN
+// Runs the next unclaimed chunk of the current loop, called and returning with the lock held
+static void runParallelChunk() {
+  int start = pool.next++ * pool.chunk;
+  int end = start + pool.chunk < pool.count ? start + pool.chunk : pool.count;
+  poolUnlock();
+  pool.function(pool.userdata, start, end);
+  poolLock();
+  if (--pool.remaining == 0) {
+    poolSignal(done);
+  }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI runWorker(LPVOID arg) {
+#else
+static void* runWorker(void* arg) {
+#endif
+  poolLock();
+  for (;;) {
+    while (!pool.quit && pool.next >= pool.chunkCount) {
+      poolWait(work);
+    }
+
+    if (pool.quit) {
+      break;
+    }
+
+    runParallelChunk();
+  }
+  poolUnlock();
+  return 0;
+}
+#endif
+
+// Starts a worker thread for every core but the one the main thread runs on
+void lovrParallelInit() {
+  if (pool.initialized) {
+    return;
+  }
+
+  pool.initialized = 1;
+  pool.workerCount = 0;
+
+#ifndef EMSCRIPTEN
+  int workerCount = lovrGetCoreCount() - 1;
+  workerCount = workerCount < MAX_PARALLEL_JOBS - 1 ? workerCount : MAX_PARALLEL_JOBS - 1;
+
+#ifdef _WIN32
+  InitializeCriticalSection(&pool.lock);
+  InitializeConditionVariable(&pool.work);
+  InitializeConditionVariable(&pool.done);
+#else
+  pthread_mutex_init(&pool.lock, NULL);
+  pthread_cond_init(&pool.work, NULL);
+  pthread_cond_init(&pool.done, NULL);
+#endif
+
+  for (int i = 0; i < workerCount; i++) {
+#ifdef _WIN32
+    pool.threads[i] = CreateThread(NULL, 0, runWorker, NULL, 0, NULL);
+    if (!pool.threads[i]) break;
+#else
+    if (pthread_create(&pool.threads[i], NULL, runWorker, NULL)) break;
+#endif
+    pool.workerCount++;
+  }
+#endif
+}
+
+void lovrParallelDestroy() {
+  if (!pool.initialized) {
+    return;
+  }
+
+#ifndef EMSCRIPTEN
+  poolLock();
+  pool.quit = 1;
+  poolBroadcast(work);
+  poolUnlock();
+
+  for (int i = 0; i < pool.workerCount; i++) {
+#ifdef _WIN32
+    WaitForSingleObject(pool.threads[i], INFINITE);
+    CloseHandle(pool.threads[i]);
+#else
+    pthread_join(pool.threads[i], NULL);
+#endif
+  }
+
+#ifdef _WIN32
+  DeleteCriticalSection(&pool.lock);
+#else
+  pthread_mutex_destroy(&pool.lock);
+  pthread_cond_destroy(&pool.work);
+  pthread_cond_destroy(&pool.done);
+#endif
+#endif
+
+  memset(&pool, 0, sizeof(pool));
+}
+
+// Splits [0, count) into one chunk per thread, with at least grain items per chunk, and returns once
+// every chunk is done.  Loops started while another one is running (from one of its functions) run
+// on the calling thread.  Functions must not call lovrThrow.
+void lovrParallelFor(int count, int grain, ParallelFunction function, void* userdata) {
+  lovrParallelInit();
+
+  int chunkCount = pool.workerCount + 1;
+  chunkCount = chunkCount < (count + grain - 1) / grain ? chunkCount : (count + grain - 1) / grain;
+
+  if (chunkCount <= 1) {
+    function(userdata, 0, count);
+    return;
+  }
+
+#ifndef EMSCRIPTEN
+  poolLock();
+  if (pool.busy) {
+    poolUnlock();
+    function(userdata, 0, count);
+    return;
+  }
+
+  pool.function = function;
+  pool.userdata = userdata;
+  pool.count = count;
+  pool.chunk = (count + chunkCount - 1) / chunkCount;
+  pool.chunkCount = (count + pool.chunk - 1) / pool.chunk;
+  pool.next = 0;
+  pool.remaining = pool.chunkCount;
+  pool.busy = 1;
+  poolBroadcast(work);
+
+  while (pool.next < pool.chunkCount) {
+    runParallelChunk();
+  }
+
+  while (pool.remaining > 0) {
+    poolWait(done);
+  }
+
+  pool.busy = 0;
+  poolUnlock();
+#endif
+}
+
 // https://github.com/starwing/luautf8
 size_t utf8_decode(const char *s, const char *e, unsigned *pch) {
   unsigned ch;
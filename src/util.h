@@ -19,6 +19,8 @@ typedef struct {
   uint8_t r, g, b, a;
 } Color;
 
+typedef void (*ParallelFunction)(void* userdata, int start, int end);
+
 extern char lovrErrorMessage[];
 extern jmp_buf* lovrCatch;
 
@@ -27,4 +29,8 @@ void lovrSleep(double seconds);
 void* lovrAlloc(size_t size, void (*destructor)(const Ref* ref));
 void lovrRetain(const Ref* ref);
 void lovrRelease(const Ref* ref);
+int lovrGetCoreCount();
+void lovrParallelInit();
+void lovrParallelDestroy();
+void lovrParallelFor(int count, int grain, ParallelFunction function, void* userdata);
 size_t utf8_decode(const char *s, const char *e, unsigned *pch);